@@ -167,7 +167,6 @@ void InitObject(float springLength,int totalmass)
 
 	ropeObj.vstart = (g_ropeObj.empty() ? 0 : g_ropeObj.back().vend+1);
 	ropeObj.vend = ropeObj.vstart+(vn-1);
-	vector<vector<int>> clusters;
 
 	for (int index=0;index<totalmass;index++)
 	{
@@ -196,31 +195,16 @@ void InitObject(float springLength,int totalmass)
 	//	c3.push_back(v);
 	//}clusters.push_back(c3);
 
-	for(int i = 0;i<masses.size()-regionSize+1;i++)
-	{
-		int v = i;
-		vector<int> c;
-		for(int startPos= i; startPos < i+regionSize; startPos++)
-		{
-			c.push_back(startPos);
-		}
-		clusters.push_back(c);
-		
-	}
-
 	cout<<"masses size "<<masses.size()<<endl;
 	for(int i = 0;i<masses.size();i++)
 	{
 		ropeObj.ropeDeform->AddVertex(masses[i],0.1);
 	}
 
-	//cluster
-	for(int i = 0; i< (int)clusters.size(); ++i)
-	{
-		ropeObj.ropeDeform->AddCluster(clusters[i]);
-	}
+	//cluster : overlapping regions [i, i+regionSize) along the chain
+	ropeObj.ropeDeform->SetChainRegion(regionSize);
 
-	cout <<"cluster size::::::::::::::::::::::::::::::::"<<clusters.size()<<endl;
+	cout <<"cluster size::::::::::::::::::::::::::::::::"<<masses.size()-regionSize+1<<endl;
 	// Shape Matching̐ݒ
 
 	ropeObj.ropeDeform->SetSimulationSpace(g_v3EnvMin, g_v3EnvMax);
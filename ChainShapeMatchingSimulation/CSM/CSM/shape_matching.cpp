@@ -26,6 +26,8 @@ ShapeMatching ::ShapeMatching(int obj)
 
 	m_Collision = 0;
 
+	m_iChainWidth = 0;
+
 	Clear();
 }
 
@@ -58,6 +60,7 @@ void ShapeMatching :: Clear()
 	m_vFix.clear();
 	m_vNumCluster.clear();
 	m_vCluster.clear();
+	m_iChainWidth = 0;
 }
 
 //add vertices
@@ -92,6 +95,44 @@ void ShapeMatching::AddCluster(const vector<int> &list)
 		int i= cl.Node[l];
 		m_vNumCluster[i]++;
 	}
+
+	m_iChainWidth = 0;
+}
+
+//use the regions of the chain [r, r+width) (r = 0..n-width) instead of the clusters
+//the cost of a step does not depend on the width (linear deformation only, the quadratic one falls back to explicit clusters)
+void ShapeMatching::SetChainRegion(int width)
+{
+	m_vCluster.clear();
+	m_iChainWidth = width;
+
+	int n = m_iNumOfVertices;
+	int w = (width < n ? width : n);
+	for(int i = 0; i < n; ++i)
+	{
+		int r0 = (i-w+1 > 0 ? i-w+1 : 0);
+		int r1 = (i < n-w ? i : n-w);
+		m_vNumCluster[i] = r1-r0+1;
+	}
+}
+
+//explicit clusters of the chain regions [r, r+width) (m_vNumCluster is already set in SetChainRegion)
+void ShapeMatching::makeChainClusters(void)
+{
+	int n = m_iNumOfVertices;
+	int w = (m_iChainWidth < n ? m_iChainWidth : n);
+	for(int r = 0; r+w <= n; ++r)
+	{
+		Cluster cl;
+		cl.NumNode = w;
+		cl.Node.resize(w);
+		cl.Disp.resize(w,Vec3(0.0));
+		for(int l = 0; l < w; ++l)
+		{
+			cl.Node[l] = r+l;
+		}
+		m_vCluster.push_back(cl);
+	}
 }
 
 //externall forces add to the vertex(gravity.etc)
@@ -309,7 +350,7 @@ void ShapeMatching::shapeMatchingFun(Cluster &cl, double dt)
 		}
 
 		//calculate the goal position,and move
-		for(int l = 0; l < m_iNumOfVertices; ++l){
+		for(int l = 0; l < cl.NumNode; ++l){
 			int i = cl.Node[l];
 
 			if(m_vFix[i]) continue;
@@ -329,6 +370,120 @@ void ShapeMatching::shapeMatchingFun(Cluster &cl, double dt)
 	}
 }
 
+//chain shape matching with the prefix sums
+//center of gravity, Apq and Aqq of a region are computed from the differences of the prefix sums,
+//and the displacement of a vertex is the sum of RL and cm-RL*cm_org over the regions including it
+void ShapeMatching::chainShapeMatching(double dt)
+{
+	int n = m_iNumOfVertices;
+	int w = (m_iChainWidth < n ? m_iChainWidth : n);
+	if(w <= 1) return;
+	int nr = n-w+1;								//number of the regions
+
+	//prefix sums of the vertices
+	m_vChainSum.resize(n+1);
+	ChainSum &s0 = m_vChainSum[0];
+	s0.M = s0.Mf = 0.0;
+	s0.Mx = s0.Mxf = s0.Mq = s0.Mqf = Vec3(0.0);
+	s0.Mxq.SetValue(0.0);
+	s0.Mqq.SetValue(0.0);
+	for(int i = 0; i < n; ++i)
+	{
+		const ChainSum &a = m_vChainSum[i];
+		ChainSum &b = m_vChainSum[i+1];
+		const Vec3 &x = m_vNewPos[i];
+		const Vec3 &q = m_vOrgPos[i];
+		double m = m_vMass[i];
+		double mf = (m_vFix[i] ? m*30.0f : m);
+
+		b.M = a.M+m;
+		b.Mf = a.Mf+mf;
+		b.Mx = a.Mx+x*m;
+		b.Mxf = a.Mxf+x*mf;
+		b.Mq = a.Mq+q*m;
+		b.Mqf = a.Mqf+q*mf;
+		for(int j = 0; j < 3; ++j){
+			for(int k = 0; k < 3; ++k){
+				b.Mxq(j,k) = a.Mxq(j,k)+m*x[j]*q[k];
+				b.Mqq(j,k) = a.Mqq(j,k)+m*q[j]*q[k];
+			}
+		}
+	}
+
+	//Apq = m(x-cm)(x0-cm_org)^T = mx x0^T - cm(mx0)^T - (mx)cm_org^T + M cm cm_org^T
+	//Aqq = m(x0-cm_org)(x0-cm_org)^T
+	m_vChainRegion.resize(nr);
+	for(int r = 0; r < nr; ++r)
+	{
+		const ChainSum &a = m_vChainSum[r];
+		const ChainSum &b = m_vChainSum[r+w];
+		ChainRegion &cr = m_vChainRegion[r];
+
+		double M = b.M-a.M;
+		double Mf = b.Mf-a.Mf;
+		Vec3 mx = b.Mx-a.Mx;
+		Vec3 mq = b.Mq-a.Mq;
+		cr.cm = (b.Mxf-a.Mxf)/Mf;
+		cr.cm_org = (b.Mqf-a.Mqf)/Mf;
+
+		const Vec3 &cm = cr.cm;
+		const Vec3 &co = cr.cm_org;
+		for(int j = 0; j < 3; ++j){
+			for(int k = 0; k < 3; ++k){
+				cr.Apq(j,k) = (b.Mxq(j,k)-a.Mxq(j,k))-cm[j]*mq[k]-mx[j]*co[k]+M*cm[j]*co[k];
+				cr.Aqq(j,k) = (b.Mqq(j,k)-a.Mqq(j,k))-co[j]*mq[k]-mq[j]*co[k]+M*co[j]*co[k];
+			}
+		}
+	}
+
+	//rotations of all the regions, RL=A+(1-)R
+	m_vChainSumRL.resize(nr+1);
+	m_vChainSumT.resize(nr+1);
+	m_vChainSumRL[0].SetValue(0.0);
+	m_vChainSumT[0] = Vec3(0.0);
+	for(int r = 0; r < nr; ++r)
+	{
+		const ChainRegion &cr = m_vChainRegion[r];
+
+		rxMatrix3 R,S;
+		PolarDecomposition(cr.Apq,R,S);
+
+		rxMatrix3 A;
+		A = cr.Apq*cr.Aqq.Inverse();
+		if(m_bVolumeConservation)
+		{
+			double det = fabs(A.Determinant());
+			if(det > RX_FEQ_EPS)
+			{
+				det = 1.0/sqrt(det);
+				if(det>2.0) det = 2.0f;
+				A *=det;
+			}
+		}
+
+		rxMatrix3 RL = m_fBeta*A+(1.0-m_fBeta)*R;
+
+		m_vChainSumRL[r+1] = m_vChainSumRL[r]+RL;
+		m_vChainSumT[r+1] = m_vChainSumT[r]+(cr.cm-RL*cr.cm_org);
+	}
+
+	//goal position of the region r is RL_r*x0+(cm_r-RL_r*cm_org_r), average the displacements over the regions r0..r1
+	for(int i = 0; i < n; ++i)
+	{
+		if(m_vFix[i]) continue;
+
+		int r0 = (i-w+1 > 0 ? i-w+1 : 0);
+		int r1 = (i < nr-1 ? i : nr-1);
+		double c = (double)(r1-r0+1);
+
+		rxMatrix3 RL = m_vChainSumRL[r1+1]-m_vChainSumRL[r0];
+		Vec3 t = m_vChainSumT[r1+1]-m_vChainSumT[r0];
+		Vec3 goal_sum = RL*m_vOrgPos[i]+t;
+
+		m_vNewPos[i] += (goal_sum-m_vNewPos[i]*c)*(m_fAlpha/c);
+	}
+}
+
 //integrate the position an speed
 void ShapeMatching::integrate(double dt)
 {
@@ -346,7 +501,18 @@ void ShapeMatching::Update()
 	calExternalForces(m_fDt);
 	calCollision(m_fDt);
 	
-	if(m_vCluster.empty())
+	//the prefix sums of the chain only cover the linear deformation,
+	//so the quadratic deformation uses the chain regions as explicit clusters
+	if(m_iChainWidth > 0 && !m_bLinearDeformation && m_vCluster.empty())
+	{
+		makeChainClusters();
+	}
+
+	if(m_iChainWidth > 0 && m_bLinearDeformation)
+	{
+		chainShapeMatching(m_fDt);
+	}
+	else if(m_vCluster.empty())
 	{
 		Cluster cl;
 		cl.Node.resize(m_iNumOfVertices);
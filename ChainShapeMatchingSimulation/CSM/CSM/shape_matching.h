@@ -33,6 +33,22 @@ public:
 		vector<Vec3> Disp;			// the positon of the note
 	};
 
+	//prefix sums of the vertices for the chain regions (entry i is the sum of the vertices 0..i-1)
+	struct ChainSum
+	{
+		double M, Mf;				//m, m' (m' : mass for the center of gravity, m*30 for the fixed vertices)
+		Vec3 Mx, Mxf;				//mx, m'x (x : new position)
+		Vec3 Mq, Mqf;				//mx0, m'x0 (x0 : original position)
+		rxMatrix3 Mxq, Mqq;			//mx x0^T, mx0 x0^T
+	};
+
+	//matrices of a chain region
+	struct ChainRegion
+	{
+		rxMatrix3 Apq, Aqq;
+		Vec3 cm, cm_org;
+	};
+
 protected:
 	//shape data
 	int m_iNumOfVertices;							// number of all the particles 
@@ -48,6 +64,13 @@ protected:
 	vector<int> m_vNumCluster;						//the number of the cluster
 	vector<Cluster> m_vCluster;						//cluster
 
+	//chain regions (vertices [r, r+width) for r = 0..n-width, used instead of m_vCluster if width > 0)
+	int m_iChainWidth;
+	vector<ChainSum> m_vChainSum;					//prefix sums of the vertices (n+1)
+	vector<ChainRegion> m_vChainRegion;				//matrices of each region
+	vector<rxMatrix3> m_vChainSumRL;				//prefix sums of RL of the regions (regions+1)
+	vector<Vec3> m_vChainSumT;						//prefix sums of cm-RL*cm_org of the regions (regions+1)
+
 	//simulation parameters
 	double m_fDt;									//time step
 	Vec3 m_vMin,m_vMax;								//simutation space
@@ -72,6 +95,7 @@ public :
 	void Clear();
 	void AddVertex(const Vec3 &pos, double mass);
 	void AddCluster(const vector<int> &list);
+	void SetChainRegion(int width);
 
 	void Update();
 
@@ -97,6 +121,8 @@ protected:
 	void calExternalForces(double dt);
 	void calCollision(double dt);
 	void shapeMatchingFun(Cluster &cl, double dt);
+	void chainShapeMatching(double dt);
+	void makeChainClusters(void);
 	void integrate(double dt);
 
 	void clamp(Vec3 &pos) const
@@ -1,39 +1,44 @@
 #include "Wall.h"
-
-
-std::vector<Wall> walls;
-
-//Init the values of the walls
-void initWalls() {
-	//The side walls
-	Vec3 center1(-1.0f, 0.0f, 0.0f);
-	Vec3 normal1(1.0f, 0.0f, 0.0f);
-	float xlength = 1.0f;
-	float ylength = 1.0f;
-
-	Vec3 center2(1.0f, 0.0f, 0.0f);
-	Vec3 normal2(-1.0f, 0.0f, 0.0f);
-	Wall w1(center1,normal1,xlength,ylength);
-	Wall w2(center2,normal2,xlength,ylength);
-
-	//The bottom wall
-	Vec3 center3(0.0f, -1.0f, 0.0f);
-	Vec3 normal3(0.0f, 1.0f, 0.0f);
-	Wall w3(center3,normal3,xlength,xlength);
-
-	//The front wall
-	Vec3 center4(0.0f, 0.0f,1.0);
-	Vec3 normal4(0.0f, 0.0f,-1.0f);
-	Wall w4(center4,normal4,xlength,xlength);
-
-	//The back wall
-	Vec3 center5(0.0f, 0.0f, -1.0f);
-	Vec3 normal5(0.0f, 0.0f,1.0f);
-	Wall w5(center5,normal5,xlength,xlength);
-
-	walls.push_back(w1);
-	walls.push_back(w2);
-	walls.push_back(w4);
-	walls.push_back(w5);
-	walls.push_back(w3);
-}
\ No newline at end of file
+#include <stdio.h>
+
+
+//Read walls and boxes from a file (see Wall.h for the format)
+//returns the number of objects, or -1 if the file can't be opened
+int loadWalls(const char *filename, std::vector<Wall> &walls, std::vector<Box> &boxes) {
+	FILE *fp = fopen(filename, "r");
+	if(fp == NULL) {
+		printf("Can't open %s\n", filename);
+		return -1;
+	}
+
+	walls.clear();
+	boxes.clear();
+
+	char line[512];
+	int num = 0;
+	while(fgets(line, sizeof(line), fp) != NULL) {
+		char type[32];
+		if(sscanf(line, "%31s", type) != 1 || type[0] == '#') {
+			continue;
+		}
+
+		float v[9];
+		std::string t(type);
+		if(t == "wall" && sscanf(line, "%*s %f %f %f %f %f %f %f %f",
+								 &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) == 8) {
+			walls.push_back(Wall(Vec3(v[0], v[1], v[2]), Vec3(v[3], v[4], v[5]), v[6], v[7]));
+			num++;
+		}
+		else if(t == "box" && sscanf(line, "%*s %f %f %f %f %f %f",
+									 &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 6) {
+			boxes.push_back(Box(Vec3(v[0], v[1], v[2]), Vec3(v[3], v[4], v[5])));
+			num++;
+		}
+		else {
+			printf("Unknown line in %s : %s", filename, line);
+		}
+	}
+
+	fclose(fp);
+	return num;
+}
@@ -1,9 +1,20 @@
-
 /*
  * Class definition for a Wall
+ *
+ * a wall is a plane (rectangle if xlength, ylength > 0) and the fluid is on
+ * the side of the normal. a box is an axis-aligned solid obstacle.
+ *
+ * wall file format (one object per line, '#' starts a comment)
+ *   wall cx cy cz nx ny nz xlength ylength
+ *   box  minx miny minz maxx maxy maxz
  */
 
+#ifndef _WALL_H
+#define _WALL_H
+
+#ifndef SPH_HEADLESS
 #include <GL/glut.h>
+#endif
 #include <vector>
 #include <string>
 
@@ -16,6 +27,7 @@ public:
 	Wall() {
 		center = Vec3(0.0f,0.0f,0.0f);
         normal = Vec3(0.0f,0.0f,0.0f);
+        xaxis = Vec3(0.0f,0.0f,0.0f);
         xlength = 0.0f;
 		ylength = 0.0f;
     }
@@ -23,9 +35,13 @@ public:
     //Explicit constructor
 	Wall(Vec3 ncenter, Vec3 nnormal, float nxlength, float nylength) {
 		center = ncenter;
-		normal = nnormal;
+		normal = Unit(nnormal);
 		xlength = nxlength;
 		ylength = nylength;
+
+		//in-plane axis for xlength (ylength is along cross(normal, xaxis))
+		Vec3 up = (fabs(normal[1]) < 0.9 ? Vec3(0.0, 1.0, 0.0) : Vec3(1.0, 0.0, 0.0));
+		xaxis = Unit(cross(up, normal));
     }
 
     //Destructor
@@ -34,6 +50,23 @@ public:
 //private:
     Vec3 normal;
     Vec3 center;
-	float xlength;
+    Vec3 xaxis;
+	float xlength;		//size of the rectangle (<= 0 : infinite)
 	float ylength;
-};
\ No newline at end of file
+};
+
+class Box {
+public:
+	Box() {}
+	Box(Vec3 nminp, Vec3 nmaxp) {
+		minp = nminp;
+		maxp = nmaxp;
+	}
+
+	Vec3 minp;
+	Vec3 maxp;
+};
+
+int loadWalls(const char *filename, std::vector<Wall> &walls, std::vector<Box> &boxes);
+
+#endif	//_WALL_H
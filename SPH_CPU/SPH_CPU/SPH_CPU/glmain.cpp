@@ -188,9 +188,9 @@ void render_particles()
 	for(uint i=0; i<sph->num_particle; i++)
 	{
 		glBegin(GL_POINTS);
-		glVertex3f(sph->mem[i].current_pos.x*sim_ratio.x+real_world_origin.x, 
-			sph->mem[i].current_pos.y*sim_ratio.y+real_world_origin.y,
-			sph->mem[i].current_pos.z*sim_ratio.z+real_world_origin.z);
+		glVertex3f(sph->pos[i].x*sim_ratio.x+real_world_origin.x, 
+			sph->pos[i].y*sim_ratio.y+real_world_origin.y,
+			sph->pos[i].z*sim_ratio.z+real_world_origin.z);
 		glEnd();
 
 		//glBegin(GL_LINE_STRIP);
@@ -209,11 +209,13 @@ void render_particles()
 		glBegin(GL_LINE_STRIP);
 	//	std::vector<std::vector<Particle>>::iterator k = sph->particleTrack.begin();
 		//if(sph->mem[i].previous_pos[9]){
-			for(int index=0;index<10;index++)
+			//trails are stored per particle id, so i is used as the id here
+			for(int age=(int)sph->trail.num_frames()-1;age>=0;age--)
 			{
-				glVertex3f(sph->mem[i].previous_pos[index].x *sim_ratio.x+real_world_origin.x, 
-					sph->mem[i].previous_pos[index].y *sim_ratio.x+real_world_origin.y, 
-					sph->mem[i].previous_pos[index].z *sim_ratio.x+real_world_origin.z 
+				const Vec3_f &prev=sph->trail.get(age, i);
+				glVertex3f(prev.x *sim_ratio.x+real_world_origin.x, 
+					prev.y *sim_ratio.x+real_world_origin.y, 
+					prev.z *sim_ratio.x+real_world_origin.z 
 					);
 
 			}
@@ -302,6 +304,13 @@ void keyboard_func(unsigned char key, int x, int y)
 	 sph->init_system();
 	}
 
+	//export the particle trails as polylines
+	if(key == 't')
+	{
+		int n=sph->trail.export_obj("trail.obj");
+		printf("Export %d trails (%u frames) to trail.obj\n", n, sph->trail.num_frames());
+	}
+
 	if(key == 'w')
 	{
 		zTrans += 0.3f;
@@ -377,6 +386,11 @@ int main(int argc, char **argv)
     glutCreateWindow("SPH Fluid 3D");
 
 	init_sph_system();
+	//walls and boxes of the scene (default : the tank in SPHSystem::init_walls)
+	if(argc > 1)
+	{
+		sph->load_obstacles(argv[1]);
+	}
 	init();
 	init_ratio();
 	set_shaders();
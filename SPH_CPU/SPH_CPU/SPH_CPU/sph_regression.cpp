@@ -0,0 +1,132 @@
+/*
+	Regression check of the optimized density/force passes
+
+	runs a block of particles for some steps, then computes the density
+	and the acceleration of the same particles with the optimized path
+	(comp_dens_pres/comp_force_adv) and with the original single-threaded
+	pow() path (comp_dens_pres_ref/comp_force_adv_ref) and compares them.
+	an error is the difference divided by the largest absolute value of
+	the column (density, or one component of the acceleration).
+
+	this file has its own main(), so it is excluded from the SPH_CPU
+	project build. CMakeLists.txt builds it with sph_system.cpp,
+	sph_trail.cpp and Wall.cpp (SPH_HEADLESS, OpenMP) and runs it as
+	a ctest test.
+
+	usage : sph_regression [steps]
+	returns 0 if all errors are within the tolerance, 1 otherwise
+*/
+
+#include "sph_system.h"
+#include "sph_header.h"
+
+#include <cmath>
+
+const float REG_TOLERANCE=1.0e-4f;		//relative to the largest value of the column
+
+//largest absolute value of a column
+static float max_abs(const std::vector<float> &v)
+{
+	float m=0.0f;
+	for(uint i=0; i<v.size(); i++)
+	{
+		m=std::max(m, fabs(v[i]));
+	}
+	return m;
+}
+
+//compare a column with the reference, returns true if all errors are within the tolerance
+static bool check_column(const char *name, const std::vector<float> &v, const std::vector<float> &ref)
+{
+	float scale=max_abs(ref);
+	float err=0.0f;
+	uint worst=0;
+
+	for(uint i=0; i<ref.size(); i++)
+	{
+		float e=fabs(v[i]-ref[i]);
+		if(e > err)
+		{
+			err=e;
+			worst=i;
+		}
+	}
+
+	if(scale > 0.0f)
+	{
+		err/=scale;
+	}
+
+	bool ok=(err <= REG_TOLERANCE);
+	printf("%-6s : max error %e (particle %u, %g / ref %g) : %s\n", name, err, worst, v[worst], ref[worst], (ok ? "ok" : "FAILED"));
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	int steps=(argc > 1 ? atoi(argv[1]) : 20);
+
+	SPHSystem sph;
+
+	//a block of fluid in the corner of the world, falling and hitting the walls
+	Vec3_f vel;
+	Vec3_f pos;
+	vel.x=0.0f;
+	vel.y=0.0f;
+	vel.z=0.0f;
+	for(pos.x=0.02f; pos.x<0.3f; pos.x+=0.016f)
+	{
+		for(pos.y=0.0f; pos.y<0.5f; pos.y+=0.016f)
+		{
+			for(pos.z=0.0f; pos.z<0.6f; pos.z+=0.016f)
+			{
+				sph.add_particle(pos, vel);
+			}
+		}
+	}
+
+	sph.sys_running=1;
+	for(int i=0; i<steps; i++)
+	{
+		sph.update();
+	}
+	printf("%u particles, %d steps\n", sph.num_particle, steps);
+
+	//optimized path
+	sph.comp_forces(false);
+	std::vector<float> dens=sph.dens;
+	std::vector<float> acc[3];
+	for(int k=0; k<3; k++)
+	{
+		acc[k].resize(sph.num_particle);
+	}
+	for(uint i=0; i<sph.num_particle; i++)
+	{
+		acc[0][i]=sph.acc[i].x;
+		acc[1][i]=sph.acc[i].y;
+		acc[2][i]=sph.acc[i].z;
+	}
+
+	//reference path (build_table keeps the cell order, so the indices match)
+	sph.comp_forces(true);
+	std::vector<float> acc_ref[3];
+	for(int k=0; k<3; k++)
+	{
+		acc_ref[k].resize(sph.num_particle);
+	}
+	for(uint i=0; i<sph.num_particle; i++)
+	{
+		acc_ref[0][i]=sph.acc[i].x;
+		acc_ref[1][i]=sph.acc[i].y;
+		acc_ref[2][i]=sph.acc[i].z;
+	}
+
+	bool ok=true;
+	ok=check_column("dens", dens, sph.dens) && ok;
+	ok=check_column("acc.x", acc[0], acc_ref[0]) && ok;
+	ok=check_column("acc.y", acc[1], acc_ref[1]) && ok;
+	ok=check_column("acc.z", acc[2], acc_ref[2]) && ok;
+
+	printf("%s\n", (ok ? "passed" : "FAILED"));
+	return (ok ? 0 : 1);
+}
@@ -7,8 +7,7 @@
 
 SPHSystem::SPHSystem()
 {
-	count = 0;
-	max_particle=30000;
+	max_particle=4000000;
 	num_particle=0;
 
 	kernel=0.04f;
@@ -49,8 +48,11 @@ SPHSystem::SPHSystem()
 	self_dens=mass*poly6_value*pow(kernel, 6);
 	self_lplc_color=lplc_poly6*mass*kernel_2*(0-3/4*kernel_2);
 
-	mem=(Particle *)malloc(sizeof(Particle)*max_particle);
-	cell=(Particle **)malloc(sizeof(Particle *)*tot_cell);
+	//the last entry is for the particles outside the grid
+	cell_start.resize(tot_cell+1, 0);
+	cell_end.resize(tot_cell+1, 0);
+
+	init_walls();
 
 	sys_running=0;
 
@@ -63,6 +65,7 @@ SPHSystem::SPHSystem()
 	printf("Grid Height: %u\n", grid_size.y);
 	printf("Grid Length: %u\n", grid_size.z);
 	printf("Total Cell : %u\n", tot_cell);
+	printf("Max Particle: %u\n", max_particle);
 	printf("Poly6 Kernel: %f\n", poly6_value);
 	printf("Spiky Kernel: %f\n", spiky_value);
 	printf("Visco Kernel: %f\n", visco_value);
@@ -71,8 +74,6 @@ SPHSystem::SPHSystem()
 
 SPHSystem::~SPHSystem()
 {
-	free(mem);
-	free(cell);
 }
 
 void SPHSystem::update()
@@ -88,38 +89,29 @@ void SPHSystem::update()
 	comp_force_adv();
 	advection();
 
+	trail.record(pos, id, num_particle);
+}
 
+//one density/force pass on the current particles without advection
+void SPHSystem::comp_forces(bool reference)
+{
+	build_table();
 
-	if(count<10)
+	if(reference)
 	{
-		for(uint i=0; i<num_particle; i++)
-		{
-		Particle *p;
-		p=&(mem[i]); 
-		p->previous_pos[count]= p->current_pos;
-		
-		}
-		count++;
+		comp_dens_pres_ref();
+		comp_force_adv_ref();
 	}
 	else
 	{
-		for(uint i=0; i<num_particle; i++)
-		{
-		Particle *p;
-		p=&(mem[i]); 
-		for(int index=0;index<9;index++)
-			{
-				p->previous_pos[index] =p->previous_pos[index+1];
-			}
-			p->previous_pos[9]= p->current_pos;
-		}
+		comp_dens_pres();
+		comp_force_adv();
 	}
-					std::cout<<"      dfasdfdfsadfsa"<<mem[8].current_pos.x<<std::endl;
-					std::cout<<"      sssssssssssssssssssssssssssssss"<<mem[8].previous_pos[8].x<<std::endl;
 }
 
 void SPHSystem::draw()
 {
+#ifndef SPH_HEADLESS
 	glPointSize(1.0f);
 	glColor3f(0.2f, 0.6f, 1.0f);
 
@@ -133,6 +125,7 @@ void SPHSystem::draw()
 	//		}
 	//	glEnd();
 	//}
+#endif
 }
 
 
@@ -163,69 +156,264 @@ void SPHSystem::init_system()
 }
 
 //set position and velocity to a particles 
-void SPHSystem::add_particle(Vec3_f pos, Vec3_f vel)
+void SPHSystem::add_particle(Vec3_f p, Vec3_f v)
 {
-	Particle *p=&(mem[num_particle]);
-
-	p->id=num_particle;
+	if(num_particle >= max_particle)
+	{
+		return;
+	}
 
-	p->current_pos=pos;
-	p->previous_pos[0] = pos;
+	Vec3_f zero;
+	zero.x=0.0f;
+	zero.y=0.0f;
+	zero.z=0.0f;
 
-	//p->previous_pos[0]=pos;
-	p->vel=vel;
-	//x,y,z of the acceleration
-	p->acc.x=0.0f;
-	p->acc.y=0.0f;
-	p->acc.z=0.0f;
+	id.push_back(num_particle);
 
-	p->ev.x=0.0f;
-	p->ev.y=0.0f;
-	p->ev.z=0.0f;
+	pos.push_back(p);
+	trail.add_particle(p);
 
-	p->dens=rest_density;
-	p->pres=0.0f;
+	vel.push_back(v);
+	//x,y,z of the acceleration
+	acc.push_back(zero);
+	ev.push_back(zero);
 
-	p->next=NULL;
+	dens.push_back(rest_density);
+	pres.push_back(0.0f);
+	color_grad.push_back(0.0f);
 
 	num_particle++;
 }
 
 //build table based on the hash  value of each cell
+//particles are sorted into cell order with a counting sort
 void SPHSystem::build_table()
 {
-	Particle *p;
-	uint hash;
+	int n=(int)num_particle;
 
-	for(uint i=0; i<tot_cell; i++)
+	particle_hash.resize(num_particle);
+	sort_index.resize(num_particle);
+
+	#pragma omp parallel for
+	for(int i=0; i<n; i++)
 	{
-		cell[i]=NULL;
+		uint hash=calc_cell_hash(calc_cell_pos(pos[i]));
+		particle_hash[i]=(hash == 0xffffffff ? tot_cell : hash);
+	}
+
+	//count the particles in each cell
+	for(uint i=0; i<=tot_cell; i++)
+	{
+		cell_end[i]=0;
 	}
 
 	for(uint i=0; i<num_particle; i++)
 	{
-		p=&(mem[i]);
-		hash=calc_cell_hash(calc_cell_pos(p->current_pos));
+		cell_end[particle_hash[i]]++;
+	}
 
-		if(cell[hash] == NULL)
-		{
-			p->next=NULL;
-			cell[hash]=p;
-		}
-		else
+	//start of each cell (prefix sum of the counts)
+	uint start=0;
+	for(uint i=0; i<=tot_cell; i++)
+	{
+		cell_start[i]=start;
+		start+=cell_end[i];
+		cell_end[i]=cell_start[i];
+	}
+
+	//scatter (keeps the previous order within a cell)
+	for(uint i=0; i<num_particle; i++)
+	{
+		sort_index[cell_end[particle_hash[i]]++]=i;
+	}
+
+	//only the data carried over from the previous step has to be reordered
+	reorder(pos, temp_vec3);
+	reorder(vel, temp_vec3);
+	reorder(ev, temp_vec3);
+	reorder(id, temp_uint);
+}
+
+//hashes of the (up to 27) cells around cell_pos, returns the number of cells
+int SPHSystem::calc_near_cells(Vec3_i cell_pos, uint *hash)
+{
+	Vec3_i near_pos;
+	int num=0;
+
+	for(int x=-1; x<=1; x++)
+	{
+		for(int y=-1; y<=1; y++)
 		{
-			p->next=cell[hash];
-			cell[hash]=p;
+			for(int z=-1; z<=1; z++)
+			{
+				near_pos.x=cell_pos.x+x;
+				near_pos.y=cell_pos.y+y;
+				near_pos.z=cell_pos.z+z;
+
+				uint h=calc_cell_hash(near_pos);
+				if(h != 0xffffffff && cell_start[h] != cell_end[h])
+				{
+					hash[num++]=h;
+				}
+			}
 		}
 	}
+
+	return num;
 }
 
 //calculate the density and pressure
+//the loop runs over the cells in parallel and each particle only writes its own entries
 void SPHSystem::comp_dens_pres()
 {
-	Particle *p;
-	Particle *np;
+	float mass_poly6=mass*poly6_value;
+	float inv_rest_density=1.0f/rest_density;
+	int ncell=(int)tot_cell+1;
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for(int c=0; c<ncell; c++)
+	{
+		uint near_hash[27];
+		int num_near=0;
+
+		for(uint i=cell_start[c]; i<cell_end[c]; i++)
+		{
+			Vec3_f p=pos[i];
+
+			//particles in a grid cell share the neighbor cells (the ones outside the grid do not)
+			if(i == cell_start[c] || c == (int)tot_cell)
+			{
+				num_near=calc_near_cells(calc_cell_pos(p), near_hash);
+			}
+
+			float d=0.0f;
+			//find all the particles near the particle
+			for(int k=0; k<num_near; k++)
+			{
+				uint hash=near_hash[k];
+				for(uint j=cell_start[hash]; j<cell_end[hash]; j++)
+				{
+					float rx=pos[j].x-p.x;
+					float ry=pos[j].y-p.y;
+					float rz=pos[j].z-p.z;
+					float r2=rx*rx+ry*ry+rz*rz;
+
+					if(r2<INF || r2>=kernel_2)
+					{
+						continue;
+					}
+
+					float q=kernel_2-r2;
+					d+=q*q*q;
+				}
+			}
+
+			dens[i]=mass_poly6*d+self_dens;
+
+			//Tait equation (gamma=7)
+			float x=dens[i]*inv_rest_density;
+			float x2=x*x;
+			float x4=x2*x2;
+			pres[i]=(x4*x2*x - 1) *gas_constant;
+		}
+	}
+}
+
+//calculte forces 
+//the loop runs over the cells in parallel and each particle only writes its own entries
+void SPHSystem::comp_force_adv()
+{
+	int ncell=(int)tot_cell+1;
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for(int c=0; c<ncell; c++)
+	{
+		uint near_hash[27];
+		int num_near=0;
+
+		for(uint i=cell_start[c]; i<cell_end[c]; i++)
+		{
+			Vec3_f p=pos[i];
+			Vec3_f e=ev[i];
+			float pi=pres[i];
+			Vec3_f a;
+			Vec3_f grad_color;
+			float lplc_color;
+
+			if(i == cell_start[c] || c == (int)tot_cell)
+			{
+				num_near=calc_near_cells(calc_cell_pos(p), near_hash);
+			}
+
+			a.x=0.0f;
+			a.y=0.0f;
+			a.z=0.0f;
+
+			grad_color.x=0.0f;
+			grad_color.y=0.0f;
+			grad_color.z=0.0f;
+			lplc_color=0.0f;
+
+			for(int k=0; k<num_near; k++)
+			{
+				uint hash=near_hash[k];
+				for(uint j=cell_start[hash]; j<cell_end[hash]; j++)
+				{
+					float rx=p.x-pos[j].x;
+					float ry=p.y-pos[j].y;
+					float rz=p.z-pos[j].z;
+					float r2=rx*rx+ry*ry+rz*rz;
+
+					if(r2 < kernel_2 && r2 > INF)
+					{
+						float r=sqrt(r2);
+						float V=mass/dens[j]/2;
+						float kernel_r=kernel-r;
+
+						//pressure (spiky), the direction rel_pos/r is folded into the factor
+						float temp_force=V * (pi+pres[j]) * spiky_value * kernel_r * kernel_r / r;
+						a.x-=rx*temp_force;
+						a.y-=ry*temp_force;
+						a.z-=rz*temp_force;
+
+						//viscosity
+						temp_force=V * viscosity * visco_value * kernel_r;
+						a.x+=(ev[j].x-e.x)*temp_force; 
+						a.y+=(ev[j].y-e.y)*temp_force; 
+						a.z+=(ev[j].z-e.z)*temp_force; 
+
+						//color field
+						float q=kernel_2-r2;
+						float temp=(-1) * grad_poly6 * V * q * q;
+						grad_color.x += temp * rx;
+						grad_color.y += temp * ry;
+						grad_color.z += temp * rz;
+
+						//(r2-3/4*q) of the original code : 3/4 is an integer division, so the term is r2
+						lplc_color += lplc_poly6 * V * q * r2;
+					}
+				}
+			}
+
+			lplc_color+=self_lplc_color/dens[i];
+			color_grad[i]=sqrt(grad_color.x*grad_color.x+grad_color.y*grad_color.y+grad_color.z*grad_color.z);
+
+			if(color_grad[i] > surf_norm)
+			{
+				float s=surf_coe * lplc_color / color_grad[i];
+				a.x+=s * grad_color.x;
+				a.y+=s * grad_color.y;
+				a.z+=s * grad_color.z;
+			}
 
+			acc[i]=a;
+		}
+	}
+}
+
+//reference version of comp_dens_pres (the original single-threaded pow() path, kept for regression checks)
+void SPHSystem::comp_dens_pres_ref()
+{
 	Vec3_i cell_pos;
 	Vec3_i near_pos;
 	uint hash;
@@ -235,11 +423,10 @@ void SPHSystem::comp_dens_pres()
 
 	for(uint i=0; i<num_particle; i++)
 	{
-		p=&(mem[i]); 
-		cell_pos=calc_cell_pos(p->current_pos);
+		Vec3_f p=pos[i];
+		cell_pos=calc_cell_pos(p);
 
-		p->dens=0.0f;
-		p->pres=0.0f;
+		float d=0.0f;
 		//find all the particles near the particle
 		for(int x=-1; x<=1; x++)
 		{
@@ -257,39 +444,32 @@ void SPHSystem::comp_dens_pres()
 						continue;
 					}
 
-					np=cell[hash];
-					while(np != NULL)
+					for(uint j=cell_start[hash]; j<cell_end[hash]; j++)
 					{
-						rel_pos.x=np->current_pos.x-p->current_pos.x;
-						rel_pos.y=np->current_pos.y-p->current_pos.y;
-						rel_pos.z=np->current_pos.z-p->current_pos.z;
+						rel_pos.x=pos[j].x-p.x;
+						rel_pos.y=pos[j].y-p.y;
+						rel_pos.z=pos[j].z-p.z;
 						r2=rel_pos.x*rel_pos.x+rel_pos.y*rel_pos.y+rel_pos.z*rel_pos.z;
 
 						if(r2<INF || r2>=kernel_2)
 						{
-							np=np->next;
 							continue;
 						}
 
-						p->dens=p->dens + mass * poly6_value * pow(kernel_2-r2, 3);
-
-						np=np->next;
+						d=d + mass * poly6_value * pow(kernel_2-r2, 3);
 					}
 				}
 			}
 		}
 
-		p->dens=p->dens+self_dens;
-		p->pres=(pow(p->dens / rest_density, 7) - 1) *gas_constant;
+		dens[i]=d+self_dens;
+		pres[i]=(pow(dens[i] / rest_density, 7) - 1) *gas_constant;
 	}
 }
 
-//calculte forces 
-void SPHSystem::comp_force_adv()
+//reference version of comp_force_adv (the original single-threaded pow() path, kept for regression checks)
+void SPHSystem::comp_force_adv_ref()
 {
-	Particle *p;
-	Particle *np;
-
 	Vec3_i cell_pos;
 	Vec3_i near_pos;
 	uint hash;
@@ -311,12 +491,13 @@ void SPHSystem::comp_force_adv()
 
 	for(uint i=0; i<num_particle; i++)
 	{
-		p=&(mem[i]); 
-		cell_pos=calc_cell_pos(p->current_pos);
+		Vec3_f p=pos[i];
+		Vec3_f a;
+		cell_pos=calc_cell_pos(p);
 
-		p->acc.x=0.0f;
-		p->acc.y=0.0f;
-		p->acc.z=0.0f;
+		a.x=0.0f;
+		a.y=0.0f;
+		a.z=0.0f;
 
 		grad_color.x=0.0f;
 		grad_color.y=0.0f;
@@ -339,35 +520,34 @@ void SPHSystem::comp_force_adv()
 						continue;
 					}
 
-					np=cell[hash];
-					while(np != NULL)
+					for(uint j=cell_start[hash]; j<cell_end[hash]; j++)
 					{
-						rel_pos.x=p->current_pos.x-np->current_pos.x;
-						rel_pos.y=p->current_pos.y-np->current_pos.y;
-						rel_pos.z=p->current_pos.z-np->current_pos.z;
+						rel_pos.x=p.x-pos[j].x;
+						rel_pos.y=p.y-pos[j].y;
+						rel_pos.z=p.z-pos[j].z;
 						r2=rel_pos.x*rel_pos.x+rel_pos.y*rel_pos.y+rel_pos.z*rel_pos.z;
 
 						if(r2 < kernel_2 && r2 > INF)
 						{
 							r=sqrt(r2);
-							V=mass/np->dens/2;
+							V=mass/dens[j]/2;
 							kernel_r=kernel-r;
 
 							pres_kernel=spiky_value * kernel_r * kernel_r;
-							temp_force=V * (p->pres+np->pres) * pres_kernel;
-							p->acc.x=p->acc.x-rel_pos.x*temp_force/r;
-							p->acc.y=p->acc.y-rel_pos.y*temp_force/r;
-							p->acc.z=p->acc.z-rel_pos.z*temp_force/r;
+							temp_force=V * (pres[i]+pres[j]) * pres_kernel;
+							a.x=a.x-rel_pos.x*temp_force/r;
+							a.y=a.y-rel_pos.y*temp_force/r;
+							a.z=a.z-rel_pos.z*temp_force/r;
 
-							rel_vel.x=np->ev.x-p->ev.x;
-							rel_vel.y=np->ev.y-p->ev.y;
-							rel_vel.z=np->ev.z-p->ev.z;
+							rel_vel.x=ev[j].x-ev[i].x;
+							rel_vel.y=ev[j].y-ev[i].y;
+							rel_vel.z=ev[j].z-ev[i].z;
 
 							visc_kernel=visco_value*(kernel-r);
 							temp_force=V * viscosity * visc_kernel;
-							p->acc.x=p->acc.x + rel_vel.x*temp_force; 
-							p->acc.y=p->acc.y + rel_vel.y*temp_force; 
-							p->acc.z=p->acc.z + rel_vel.z*temp_force; 
+							a.x=a.x + rel_vel.x*temp_force; 
+							a.y=a.y + rel_vel.y*temp_force; 
+							a.z=a.z + rel_vel.z*temp_force; 
 
 							float temp=(-1) * grad_poly6 * V * pow(kernel_2-r2, 2);
 							grad_color.x += temp * rel_pos.x;
@@ -375,103 +555,301 @@ void SPHSystem::comp_force_adv()
 							grad_color.z += temp * rel_pos.z;
 							lplc_color += lplc_poly6 * V * (kernel_2-r2) * (r2-3/4*(kernel_2-r2));
 						}
-
-						np=np->next;
 					}
 				}
 			}
 		}
 
-		lplc_color+=self_lplc_color/p->dens;
-		p->surf_norm=sqrt(grad_color.x*grad_color.x+grad_color.y*grad_color.y+grad_color.z*grad_color.z);
+		lplc_color+=self_lplc_color/dens[i];
+		color_grad[i]=sqrt(grad_color.x*grad_color.x+grad_color.y*grad_color.y+grad_color.z*grad_color.z);
 
-		if(p->surf_norm > surf_norm)
+		if(color_grad[i] > surf_norm)
 		{
-			p->acc.x+=surf_coe * lplc_color * grad_color.x / p->surf_norm;
-			p->acc.y+=surf_coe * lplc_color * grad_color.y / p->surf_norm;
-			p->acc.z+=surf_coe * lplc_color * grad_color.z / p->surf_norm;
+			a.x+=surf_coe * lplc_color * grad_color.x / color_grad[i];
+			a.y+=surf_coe * lplc_color * grad_color.y / color_grad[i];
+			a.z+=surf_coe * lplc_color * grad_color.z / color_grad[i];
 		}
+
+		acc[i]=a;
 	}
 }
 
 //calculate the advection of the fluid 移流项
 void SPHSystem::advection()
 {
-	Particle *p;
-	Vec3 wall_normal;
-	wall_normal.data[0] =-1.0;
-	for(uint i=0; i<num_particle; i++)
+	int n=(int)num_particle;
+
+	#pragma omp parallel for
+	for(int i=0; i<n; i++)
 	{
-		p=&(mem[i]);
+		Vec3_f &x=pos[i];
+		Vec3_f &v=vel[i];
+		const Vec3_f &a=acc[i];
+		float d=dens[i];
+
+		v.x=v.x+a.x*time_step/d+gravity.x*time_step;
+		v.y=v.y+a.y*time_step/d+gravity.y*time_step;
+		v.z=v.z+a.z*time_step/d+gravity.z*time_step;
+
+		x.x=x.x+v.x*time_step;
+		x.y=x.y+v.y*time_step;
+		x.z=x.z+v.z*time_step;
+	}
 
-		//float m_dot = dot(wall_normal, (p->pos-Vec3_f(0.6,0.325,0.34)));
+	collision();
 
-		p->vel.x=p->vel.x+p->acc.x*time_step/p->dens+gravity.x*time_step;
-		p->vel.y=p->vel.y+p->acc.y*time_step/p->dens+gravity.y*time_step;
-		p->vel.z=p->vel.z+p->acc.z*time_step/p->dens+gravity.z*time_step;
+	#pragma omp parallel for
+	for(int i=0; i<n; i++)
+	{
+		Vec3_f &e=ev[i];
+		const Vec3_f &v=vel[i];
 
-		p->current_pos.x=p->current_pos.x+p->vel.x*time_step;
-		p->current_pos.y=p->current_pos.y+p->vel.y*time_step;
-		p->current_pos.z=p->current_pos.z+p->vel.z*time_step;
-	
+		e.x=(e.x+v.x)/2;
+		e.y=(e.y+v.y)/2;
+		e.z=(e.z+v.z)/2;
+	}
+}
 
+//default tank : the domain walls and an opening window at x=0.64
+void SPHSystem::init_walls()
+{
+	std::vector<Wall> w;
+	std::vector<Box> b;
 
-		//if(p->pos.x >= world_size.x-BOUNDARY)
-		//{
-		//	p->vel.x=p->vel.x*wall_damping;
-		//	p->pos.x=world_size.x-BOUNDARY;
-		//}
-		Vec3 impulse = normalize(wall_normal);
-		impulse *= (1.0f+0.0f)*dot(wall_normal, Vec3(p->vel.x,p->vel.y,p->vel.z));
+	w.push_back(Wall(Vec3(0.64, 0.325, 0.34), Vec3(-1.0, 0.0, 0.0), 0.18f, 0.15f));
+	w.push_back(Wall(Vec3(0.0, 0.0, 0.0), Vec3(1.0, 0.0, 0.0), 0.0f, 0.0f));
+	w.push_back(Wall(Vec3(0.0, world_size.y-BOUNDARY, 0.0), Vec3(0.0, -1.0, 0.0), 0.0f, 0.0f));
+	w.push_back(Wall(Vec3(0.0, 0.0, 0.0), Vec3(0.0, 1.0, 0.0), 0.0f, 0.0f));
+	w.push_back(Wall(Vec3(0.0, 0.0, world_size.z-BOUNDARY), Vec3(0.0, 0.0, -1.0), 0.0f, 0.0f));
+	w.push_back(Wall(Vec3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, 1.0), 0.0f, 0.0f));
 
-		if(p->current_pos.x >=0.64)
-		{
-			if(p->current_pos.y>0.25&&p->current_pos.y<0.4&&p->current_pos.z>0.25&&p->current_pos.z<0.43)
-			{
-			  p->vel.x=p->vel.x*wall_damping;
-				//p->vel.x = -1*(float)impulse.data[0];
-				//p->vel.y = -1*(float)impulse.data[1];
-				//p->vel.z = -1*(float)impulse.data[2];
-			p->current_pos.x=0.6;
-			}
-		}
+	set_obstacles(w, b);
+}
 
-		if(p->current_pos.x < 0.0f)
-		{
-			p->vel.x=p->vel.x*wall_damping;
-			p->current_pos.x=0.0f;
-		}
+//read walls and boxes from a file (the current ones are kept if it fails)
+int SPHSystem::load_obstacles(const char *filename)
+{
+	std::vector<Wall> w;
+	std::vector<Box> b;
+	int num=loadWalls(filename, w, b);
+	if(num < 0)
+	{
+		return num;
+	}
+
+	set_obstacles(w, b);
+	printf("Obstacles : %u walls, %u boxes (%s)\n", (uint)walls.size(), (uint)boxes.size(), filename);
+	return num;
+}
+
+void SPHSystem::set_obstacles(const std::vector<Wall> &w, const std::vector<Box> &b)
+{
+	walls=w;
+	boxes=b;
+	bin_obstacles();
+}
 
-		if(p->current_pos.y >= world_size.y-BOUNDARY)
+//list the grid cells whose particles can touch each wall or box
+//the margin is one cell, so particles may move up to cell_size in a step
+//particles outside the grid (the last cell) are tested against every obstacle
+void SPHSystem::bin_obstacles()
+{
+	uint nwall=(uint)walls.size();
+	uint nbox=(uint)boxes.size();
+
+	wall_planes.resize(nwall);
+	box_planes.resize(nbox);
+	obstacle_cells.assign(nwall+nbox, std::vector<uint>());
+
+	for(uint w=0; w<nwall; w++)
+	{
+		const Wall &wall=walls[w];
+		Vec3 yaxis=cross(wall.normal, wall.xaxis);
+		WallPlane &wp=wall_planes[w];
+		for(int k=0; k<3; k++)
 		{
-			p->vel.y=p->vel.y*wall_damping;
-			p->current_pos.y=world_size.y-BOUNDARY;
+			wp.c[k]=(float)wall.center[k];
+			wp.n[k]=(float)wall.normal[k];
+			wp.u[k]=(float)wall.xaxis[k];
+			wp.v[k]=(float)yaxis[k];
 		}
+		wp.hx=0.5f*wall.xlength;
+		wp.hy=0.5f*wall.ylength;
+	}
 
-		if(p->current_pos.y < 0.0f)
+	for(uint b=0; b<nbox; b++)
+	{
+		for(int k=0; k<3; k++)
 		{
-			p->vel.y=p->vel.y*wall_damping;
-			p->current_pos.y=0.0f;
+			box_planes[b].minp[k]=(float)boxes[b].minp[k];
+			box_planes[b].maxp[k]=(float)boxes[b].maxp[k];
 		}
+	}
+
+	float r=cell_size*0.866f;		//radius of a cell
+	float margin=r+cell_size;
 
-		if(p->current_pos.z >= world_size.z-BOUNDARY)
+	for(uint z=0; z<grid_size.z; z++)
+	{
+		for(uint y=0; y<grid_size.y; y++)
 		{
-			p->vel.z=p->vel.z*wall_damping;
-			p->current_pos.z=world_size.z-BOUNDARY;
+			for(uint x=0; x<grid_size.x; x++)
+			{
+				uint hash=(z*grid_size.y+y)*grid_size.x+x;
+				float cc[3];
+				cc[0]=(x+0.5f)*cell_size;
+				cc[1]=(y+0.5f)*cell_size;
+				cc[2]=(z+0.5f)*cell_size;
+
+				for(uint w=0; w<nwall; w++)
+				{
+					const WallPlane &wp=wall_planes[w];
+					float rc[3]={cc[0]-wp.c[0], cc[1]-wp.c[1], cc[2]-wp.c[2]};
+					float d=rc[0]*wp.n[0]+rc[1]*wp.n[1]+rc[2]*wp.n[2];
+					float du=rc[0]*wp.u[0]+rc[1]*wp.u[1]+rc[2]*wp.u[2];
+					float dv=rc[0]*wp.v[0]+rc[1]*wp.v[1]+rc[2]*wp.v[2];
+					if(d > margin)
+					{
+						continue;
+					}
+					if((wp.hx > 0.0f && fabs(du) > wp.hx+margin) || (wp.hy > 0.0f && fabs(dv) > wp.hy+margin))
+					{
+						continue;
+					}
+					obstacle_cells[w].push_back(hash);
+				}
+
+				for(uint b=0; b<nbox; b++)
+				{
+					const BoxPlanes &bp=box_planes[b];
+					bool overlap=true;
+					for(int k=0; k<3; k++)
+					{
+						if(cc[k]+margin < bp.minp[k] || cc[k]-margin > bp.maxp[k])
+						{
+							overlap=false;
+						}
+					}
+					if(overlap)
+					{
+						obstacle_cells[nwall+b].push_back(hash);
+					}
+				}
+			}
 		}
+	}
+
+	for(uint i=0; i<nwall+nbox; i++)
+	{
+		obstacle_cells[i].push_back(tot_cell);
+	}
+}
+
+//collision with the walls and boxes
+//each obstacle only tests the particles in its cells (particles are in cell order after build_table)
+void SPHSystem::collision()
+{
+	int nwall=(int)walls.size();
+	int nobj=nwall+(int)boxes.size();
 
-		if(p->current_pos.z < 0.0f)
+	for(int w=0; w<nobj; w++)
+	{
+		const std::vector<uint> &cells=obstacle_cells[w];
+		int ncell=(int)cells.size();
+
+		#pragma omp parallel for schedule(dynamic, 4)
+		for(int k=0; k<ncell; k++)
 		{
-			p->vel.z=p->vel.z*wall_damping;
-			p->current_pos.z=0.0f;
+			uint c=cells[k];
+			if(cell_start[c] == cell_end[c])
+			{
+				continue;
+			}
+
+			if(w < nwall)
+			{
+				collide_wall(wall_planes[w], cell_start[c], cell_end[c]);
+			}
+			else
+			{
+				collide_box(box_planes[w-nwall], cell_start[c], cell_end[c]);
+			}
 		}
+	}
+}
 
+//particles behind the wall are moved onto the plane and the normal velocity is damped
+//the loop has no branches (every particle is written, with a zero correction if it does not hit) so it can be vectorized
+void SPHSystem::collide_wall(const WallPlane &wp, uint start, uint end)
+{
+	//a half size <= 0 means an infinite wall
+	float hx=(wp.hx > 0.0f ? wp.hx : 1e30f);
+	float hy=(wp.hy > 0.0f ? wp.hy : 1e30f);
+	float damp=wall_damping-1.0f;
 
-		p->ev.x=(p->ev.x+p->vel.x)/2;
-		p->ev.y=(p->ev.y+p->vel.y)/2;
-		p->ev.z=(p->ev.z+p->vel.z)/2;
+	for(uint i=start; i<end; i++)
+	{
+		float rx=pos[i].x-wp.c[0];
+		float ry=pos[i].y-wp.c[1];
+		float rz=pos[i].z-wp.c[2];
+		float d=rx*wp.n[0]+ry*wp.n[1]+rz*wp.n[2];
+		float du=fabs(rx*wp.u[0]+ry*wp.u[1]+rz*wp.u[2]);
+		float dv=fabs(rx*wp.v[0]+ry*wp.v[1]+rz*wp.v[2]);
+
+		bool hit=(d < 0.0f) & (du <= hx) & (dv <= hy);
+		float vn=(vel[i].x*wp.n[0]+vel[i].y*wp.n[1]+vel[i].z*wp.n[2])*damp;
+		d=(hit ? d : 0.0f);
+		vn=(hit ? vn : 0.0f);
+
+		pos[i].x-=d*wp.n[0];
+		pos[i].y-=d*wp.n[1];
+		pos[i].z-=d*wp.n[2];
+		vel[i].x+=vn*wp.n[0];
+		vel[i].y+=vn*wp.n[1];
+		vel[i].z+=vn*wp.n[2];
 	}
+}
 
+//particles inside the box are moved to the nearest face and the velocity along its axis is damped
+//the loop has no branches (every particle is written, unchanged if it is outside) so it can be vectorized
+void SPHSystem::collide_box(const BoxPlanes &bp, uint start, uint end)
+{
+	float x0=bp.minp[0], x1=bp.maxp[0];
+	float y0=bp.minp[1], y1=bp.maxp[1];
+	float z0=bp.minp[2], z1=bp.maxp[2];
+	float damp=wall_damping;
+
+	for(uint i=start; i<end; i++)
+	{
+		float x=pos[i].x;
+		float y=pos[i].y;
+		float z=pos[i].z;
+
+		bool inside=(x > x0) & (x < x1) & 
+					(y > y0) & (y < y1) & 
+					(z > z0) & (z < z1);
+
+		//distance to the nearer face of each axis and the coordinate of that face (min face wins a tie)
+		float px=x-x0, dx=x0;
+		float py=y-y0, dy=y0;
+		float pz=z-z0, dz=z0;
+		bool c;
+		c=(x1-x < px); dx=(c ? x1 : dx); px=(c ? x1-x : px);
+		c=(y1-y < py); dy=(c ? y1 : dy); py=(c ? y1-y : py);
+		c=(z1-z < pz); dz=(c ? z1 : dz); pz=(c ? z1-z : pz);
+
+		//nearest axis (x wins a tie with y and z, y wins a tie with z)
+		bool ax=inside & (px <= py) & (px <= pz);
+		bool ay=inside & !((px <= py) & (px <= pz)) & (py <= pz);
+		bool az=inside & !ax & !ay;
+
+		pos[i].x=(ax ? dx : x);
+		pos[i].y=(ay ? dy : y);
+		pos[i].z=(az ? dz : z);
+		vel[i].x*=(ax ? damp : 1.0f);
+		vel[i].y*=(ay ? damp : 1.0f);
+		vel[i].z*=(az ? damp : 1.0f);
+	}
 }
 
 Vec3_i SPHSystem::calc_cell_pos(Vec3_f p)
@@ -491,9 +869,6 @@ uint SPHSystem::calc_cell_hash(Vec3_i cell_pos)
 		return (uint)0xffffffff;
 	}
 
-	cell_pos.x = cell_pos.x & (grid_size.x-1);  
-    cell_pos.y = cell_pos.y & (grid_size.y-1);  
-	cell_pos.z = cell_pos.z & (grid_size.z-1);  
-
+	//cell_pos is already in the grid (masking by grid_size-1 only worked for power-of-two sizes)
 	return ((uint)(cell_pos.z))*grid_size.y*grid_size.x + ((uint)(cell_pos.y))*grid_size.x + (uint)(cell_pos.x);
 }
@@ -1,43 +1,33 @@
 /*
 	Basic SPH fluid system
 
+	particle data is stored as separate arrays (SoA) and sorted into
+	cell order every step with a counting sort, so the neighbor search
+	reads each of the 27 neighbor cells as one contiguous range
+	[cell_start[hash], cell_end[hash]).
 */
 
 #ifndef _SPHSYSTEM_H
 #define _SPHSYSTEM_H
 
+//glew.h has to come before gl.h, which Wall.h pulls in through glut.h
+//SPH_HEADLESS builds (sph_regression) do not use OpenGL
+#ifndef SPH_HEADLESS
+#include <GL/glew.h>
+#include <GL/glut.h>
+#endif
+
 #include "sph_type.h"
+#include "sph_trail.h"
+#include "Wall.h"
 
 #include "rx_utility.h"				//Vector classes
 #include "rx_matrix.h"
-#include <GL\glew.h>
-#include <GL\glut.h>
-#include <queue>
-
-class Particle
-{
-public:
-	uint id;
-	Vec3_f current_pos;			//position
-	Vec3_f previous_pos[10];		//previous position
-	//std::queue<Vec3_f> previous_pos;
-
-	Vec3_f vel;			//velocity
-	Vec3_f acc;			//acceleration
-	Vec3_f ev;
-
-	float dens;			//density
-	float pres;			//pressure
-
-	float surf_norm;
-
-	Particle *next;
-};
+#include <vector>
 
 class SPHSystem
 {
 public:
-	int count ;
 	uint max_particle;
 	uint num_particle;
 
@@ -49,9 +39,6 @@ public:
 	uint3 grid_size;
 	uint tot_cell;			//total number of the cells
 
-	std::vector<Particle> particleUnion;
-	std::vector<std::vector<Particle>> particleTrack;
-
 	Vec3_f gravity;
 	float wall_damping;
 	float rest_density;
@@ -72,8 +59,26 @@ public:
 	float self_dens;
 	float self_lplc_color;
 
-	Particle *mem;
-	Particle **cell;
+	//particle data (index i is the position in cell order, not the particle id)
+	std::vector<Vec3_f> pos;		//position
+	std::vector<Vec3_f> vel;		//velocity
+	std::vector<Vec3_f> acc;		//acceleration
+	std::vector<Vec3_f> ev;
+	std::vector<float> dens;		//density
+	std::vector<float> pres;		//pressure
+	std::vector<float> color_grad;	//length of the color field gradient
+	std::vector<uint> id;			//id of the particle (index in the order of add_particle)
+
+	//previous positions of each particle id (ring buffer)
+	TrailBuffer trail;
+
+	//obstacles (change them with set_obstacles or load_obstacles)
+	std::vector<Wall> walls;
+	std::vector<Box> boxes;
+
+	//grid (particles in the cell hash are [cell_start[hash], cell_end[hash]), hash=tot_cell is outside the grid)
+	std::vector<uint> cell_start;
+	std::vector<uint> cell_end;
 
 	uint sys_running;
 
@@ -81,20 +86,69 @@ public:
 	SPHSystem();
 	~SPHSystem();
 	void update();
+	void comp_forces(bool reference);	//density/force only (reference=true : original pow() path, for regression checks)
 	void init_system();
 	void add_particle(Vec3_f pos,Vec3_f vel);
 	void draw();
 
+	void init_walls();
+	int load_obstacles(const char *filename);
+	void set_obstacles(const std::vector<Wall> &w, const std::vector<Box> &b);
+
 private:
 	void build_table();
 	void comp_dens_pres();
 	void comp_force_adv();
+	void comp_dens_pres_ref();
+	void comp_force_adv_ref();
 	void advection();
+	void collision();
 
 private:
 	Vec3_i calc_cell_pos(Vec3_f p);
 	uint calc_cell_hash(Vec3_i cell_pos);
+	int calc_near_cells(Vec3_i cell_pos, uint *hash);
+
+	//float copies of the obstacles for the collision loops
+	struct WallPlane
+	{
+		float c[3];			//center
+		float n[3];			//normal
+		float u[3], v[3];	//in-plane axes
+		float hx, hy;		//half sizes (<= 0 : infinite)
+	};
+	struct BoxPlanes
+	{
+		float minp[3], maxp[3];
+	};
+
+	void bin_obstacles();
+	void collide_wall(const WallPlane &wp, uint start, uint end);
+	void collide_box(const BoxPlanes &bp, uint start, uint end);
+
+	//reorder an array to the cell order computed in build_table
+	template<class T>
+	void reorder(std::vector<T> &data, std::vector<T> &temp)
+	{
+		int n=(int)num_particle;
+		temp.resize(num_particle);
+		#pragma omp parallel for
+		for(int i=0; i<n; i++)
+		{
+			temp[i]=data[sort_index[i]];
+		}
+		data.swap(temp);
+	}
+
+	std::vector<uint> particle_hash;	//cell hash of each particle
+	std::vector<uint> sort_index;		//sort_index[i] : previous index of the i-th particle in cell order
+	std::vector<Vec3_f> temp_vec3;		//work buffers for reorder
+	std::vector<uint> temp_uint;
+
+	std::vector<WallPlane> wall_planes;
+	std::vector<BoxPlanes> box_planes;
+	std::vector< std::vector<uint> > obstacle_cells;	//cells tested for each wall, then each box
 };
 
 
-#endif	//_SPHSYSTEM_H
\ No newline at end of file
+#endif	//_SPHSYSTEM_H
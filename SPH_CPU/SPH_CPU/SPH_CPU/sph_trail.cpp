@@ -0,0 +1,142 @@
+#include "sph_trail.h"
+#include "sph_header.h"
+
+TrailBuffer::TrailBuffer()
+{
+	depth=TRAIL_LENGTH;
+	head=0;
+	frames=0;
+	num=0;
+	capacity=0;
+}
+
+//change the number of frames (recorded frames are discarded)
+void TrailBuffer::set_depth(uint k)
+{
+	if(k < 1)
+	{
+		k=1;
+	}
+
+	depth=k;
+	head=0;
+	frames=0;
+	data.resize(depth*capacity);
+}
+
+void TrailBuffer::clear()
+{
+	head=0;
+	frames=0;
+	num=0;
+}
+
+//grow the entries per frame, keeping the recorded frames
+void TrailBuffer::reserve(uint n)
+{
+	if(n <= capacity)
+	{
+		return;
+	}
+
+	uint new_capacity=(capacity ? capacity : 1024);
+	while(new_capacity < n)
+	{
+		new_capacity*=2;
+	}
+
+	std::vector<Vec3_f> new_data(depth*new_capacity);
+	for(uint f=0; f<depth; f++)
+	{
+		for(uint i=0; i<num; i++)
+		{
+			new_data[f*new_capacity+i]=data[f*capacity+i];
+		}
+	}
+
+	data.swap(new_data);
+	capacity=new_capacity;
+}
+
+//a new particle starts with its position in every frame
+void TrailBuffer::add_particle(Vec3_f p)
+{
+	reserve(num+1);
+
+	for(uint f=0; f<depth; f++)
+	{
+		data[f*capacity+num]=p;
+	}
+
+	num++;
+}
+
+//store the positions of the current frame (pos[i] belongs to particle id[i])
+void TrailBuffer::record(const std::vector<Vec3_f> &pos, const std::vector<uint> &id, uint n)
+{
+	if(frames)
+	{
+		head=(head+1)%depth;
+	}
+
+	Vec3_f *slot=&(data[head*capacity]);
+	for(uint i=0; i<n; i++)
+	{
+		slot[id[i]]=pos[i];
+	}
+
+	if(frames < depth)
+	{
+		frames++;
+	}
+}
+
+//write the trails as polylines (obj "l" elements, oldest to newest)
+//step : export every step-th particle
+int TrailBuffer::export_obj(const char *filename, uint step) const
+{
+	if(frames < 2)
+	{
+		return 0;
+	}
+
+	FILE *fp=fopen(filename, "w");
+	if(fp == NULL)
+	{
+		printf("Can't open %s\n", filename);
+		return 0;
+	}
+
+	if(step < 1)
+	{
+		step=1;
+	}
+
+	fprintf(fp, "# particle trails : %u frames\n", frames);
+
+	int lines=0;
+	for(uint i=0; i<num; i+=step)
+	{
+		for(int age=(int)frames-1; age>=0; age--)
+		{
+			const Vec3_f &p=get(age, i);
+			fprintf(fp, "v %f %f %f\n", p.x, p.y, p.z);
+		}
+		lines++;
+	}
+
+	//vertex indices start from 1
+	uint v=1;
+	for(int l=0; l<lines; l++)
+	{
+		fprintf(fp, "l");
+		for(uint k=0; k<frames; k++)
+		{
+			fprintf(fp, " %u", v++);
+		}
+		fprintf(fp, "\n");
+	}
+
+	fclose(fp);
+	return lines;
+}
@@ -0,0 +1,54 @@
+/*
+	trajectory history of the particles
+
+	positions of the last `depth` frames are kept in one ring buffer
+	(frame-major, `capacity` entries per frame, indexed by particle id).
+	record() only writes the current positions into the slot after head,
+	so nothing is shifted or copied per step.
+*/
+
+#ifndef _SPHTRAIL_H
+#define _SPHTRAIL_H
+
+#include "sph_type.h"
+#include <vector>
+
+#define TRAIL_LENGTH 10				//default number of frames kept for each particle
+
+class TrailBuffer
+{
+public:
+	TrailBuffer();
+
+	void set_depth(uint k);
+	void clear();
+
+	void add_particle(Vec3_f p);
+	void record(const std::vector<Vec3_f> &pos, const std::vector<uint> &id, uint n);
+
+	//position of particle id, age frames before the newest one (age < num_frames())
+	const Vec3_f &get(uint age, uint id) const
+	{
+		uint frame=(head+depth-age)%depth;
+		return data[frame*capacity+id];
+	}
+
+	uint get_depth() const { return depth; }
+	uint num_frames() const { return frames; }
+	uint num_particles() const { return num; }
+
+	int export_obj(const char *filename, uint step=1) const;
+
+private:
+	void reserve(uint n);
+
+	uint depth;			//number of frames in the buffer
+	uint head;			//slot of the newest frame
+	uint frames;		//number of recorded frames (<= depth)
+	uint num;			//number of particles
+	uint capacity;		//entries allocated per frame
+
+	std::vector<Vec3_f> data;
+};
+
+#endif	//_SPHTRAIL_H
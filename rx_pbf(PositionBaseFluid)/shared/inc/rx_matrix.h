@@ -284,9 +284,10 @@ public:
 		real scp[4];
 		for(i = 0; i < 4; ++i){
 			scp[i] = real(fabs(s[i][0]));
-			for(j=1; j < 4; ++j)
+			for(j=1; j < 4; ++j){
 				if(real(fabs(s[i][j])) > scp[i]) scp[i] = real(fabs(s[i][j]));
-				if(scp[i] == 0.0) return minv; // singular matrix!
+			}
+			if(scp[i] == 0.0) return minv; // singular matrix!
 		}
 		
 		int pivot_to;
@@ -296,31 +297,32 @@ public:
 			pivot_to = i;
 			scp_max = real(fabs(s[i][i]/scp[i]));
 			// find out which row should be on top
-			for(p = i+1; p < 4; ++p)
+			for(p = i+1; p < 4; ++p){
 				if(real(fabs(s[p][i]/scp[p])) > scp_max){
 					scp_max = real(fabs(s[p][i]/scp[p])); pivot_to = p;
 				}
-				// Pivot if necessary
-				if(pivot_to != i)
-				{
-					tmprow = s[i];
-					s[i] = s[pivot_to];
-					s[pivot_to] = tmprow;
-					real tmpscp;
-					tmpscp = scp[i];
-					scp[i] = scp[pivot_to];
-					scp[pivot_to] = tmpscp;
-				}
-				
-				real mji;
-				// perform gaussian elimination
-				for(j = i+1; j < 4; ++j)
-				{
-					mji = s[j][i]/s[i][i];
-					s[j][i] = 0.0;
-					for(jj=i+1; jj<8; jj++)
-						s[j][jj] -= mji*s[i][jj];
-				}
+			}
+			// Pivot if necessary
+			if(pivot_to != i)
+			{
+				tmprow = s[i];
+				s[i] = s[pivot_to];
+				s[pivot_to] = tmprow;
+				real tmpscp;
+				tmpscp = scp[i];
+				scp[i] = scp[pivot_to];
+				scp[pivot_to] = tmpscp;
+			}
+			
+			real mji;
+			// perform gaussian elimination
+			for(j = i+1; j < 4; ++j)
+			{
+				mji = s[j][i]/s[i][i];
+				s[j][i] = 0.0;
+				for(jj=i+1; jj<8; jj++)
+					s[j][jj] -= mji*s[i][jj];
+			}
 		}
 
 		if(s[3][3] == 0.0) return minv; // singular matrix!
@@ -2417,7 +2419,7 @@ inline bool operator==(const rxMatrixN<T,N> &m1, const rxMatrixN<T,N> &m2)
 {
 	for(int i = 0; i < N; ++i){
 		for(int j = 0; j < N; ++j){
-			if(m1(i,j) != mat(i,j)){
+			if(m1(i,j) != m2(i,j)){
 				return false;
 			}
 		}
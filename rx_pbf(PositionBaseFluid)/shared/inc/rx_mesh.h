@@ -22,8 +22,10 @@
 #include <map>
 #include <set>
 
+#ifndef RX_HEADLESS
 #include <GL/glew.h>
 #include <GL/glut.h>
+#endif
 
 #include "rx_utility.h"
 
@@ -126,12 +128,14 @@ public:
 	//! fXgN^
 	~rxPolygons(){}
 
+#ifndef RX_HEADLESS
 	//! `
 	void Draw(int draw = 0x04, double dn = 0.02, bool col = true);
 
 protected:
 	//! doubleł̍ގݒ
 	void glMaterialdv(GLenum face, GLenum pname, const GLdouble *params);
+#endif
 };
 
 
@@ -249,6 +253,7 @@ bool AffineVertices(rxPolygons &polys, Vec3 cen, Vec3 ext, Vec3 ang);
 int CalMeshDiv(Vec3 &minp, Vec3 maxp, int nmax, double &h, int n[3], double extend = 0.05);
 int CalMeshDiv(Vec3 &minp, Vec3 maxp, double h, int n[3], double extend = 0.05);
 
+#ifndef RX_HEADLESS
 //! bV`pVBOm
 bool AssignArrayBuffers(int max_verts, int dim, GLuint &uVrtVBO, GLuint &uNrmVBO, GLuint &uTriVBO);
 
@@ -259,10 +264,12 @@ bool SetArrayFromFBO(GLuint uVrtVBO, GLuint uNrmVBO, GLuint uTriVBO,
 //! zXgzɃf[^ݒ
 bool SetFBOFromArray(GLuint uVrtVBO, GLuint uNrmVBO, GLuint uTriVBO, 
 					 vector<Vec3> &vrts, vector<Vec3> &nrms, vector<rxFace> &face);
+#endif
 
 
 
 
+#ifndef RX_HEADLESS
 //-----------------------------------------------------------------------------
 // MARK:|S̕`
 //-----------------------------------------------------------------------------
@@ -413,6 +420,7 @@ inline void rxPolygons::Draw(int draw, double dn, bool col)
 		}
 	}
 }
+#endif	// #ifndef RX_HEADLESS
 
 
 //-----------------------------------------------------------------------------
@@ -931,7 +939,7 @@ inline bool ReadString(ifstream &file, string &name, int max_size)
  * @param[inout] ps bVXg
  * @param[inout] ns @Xg
  */
-static void ReverseNormals(const vector<Vec3> &vs, vector<int> &ps, vector<Vec3> &ns)
+inline void ReverseNormals(const vector<Vec3> &vs, vector<int> &ps, vector<Vec3> &ns)
 {
 	if(ps.empty()) return;
 
@@ -970,7 +978,7 @@ static void ReverseNormals(const vector<Vec3> &vs, vector<int> &ps, vector<Vec3>
  * @param[inout] ps bVXg
  * @param[inout] ns @Xg
  */
-static void CalNormals(const vector<Vec3> &vs, vector<int> &ps, vector<Vec3> &ns)
+inline void CalNormals(const vector<Vec3> &vs, vector<int> &ps, vector<Vec3> &ns)
 {
 	if(ps.empty()) return;
 
@@ -998,7 +1006,7 @@ static void CalNormals(const vector<Vec3> &vs, vector<int> &ps, vector<Vec3> &ns
  * @param[out] nrms @
  * @param[out] nnrms @(=_)
  */
-static void CalVertexNormals(const vector<Vec3> &vrts, int nvrts, vector<rxTriangle> &tris, int ntris, 
+inline void CalVertexNormals(const vector<Vec3> &vrts, int nvrts, vector<rxTriangle> &tris, int ntris, 
 							 vector<Vec3> &vnrms)
 {
 	int nnrms = nvrts;
@@ -1042,7 +1050,7 @@ static void CalVertexNormals(const vector<Vec3> &vrts, int nvrts, vector<rxTrian
  * @param[out] nrms @
  * @param[out] nnrms @(=_)
  */
-static void CalVertexNormals(const vector<Vec3> &vrts, int nvrts, vector<rxFace> &tris, int ntris, 
+inline void CalVertexNormals(const vector<Vec3> &vrts, int nvrts, vector<rxFace> &tris, int ntris, 
 							 vector<Vec3> &vnrms)
 {
 	int nnrms = nvrts;
@@ -1080,7 +1088,7 @@ static void CalVertexNormals(const vector<Vec3> &vrts, int nvrts, vector<rxFace>
  * _@vZ
  * @param[in] polys |S
  */
-static void CalVertexNormals(rxPolygons &polys)
+inline void CalVertexNormals(rxPolygons &polys)
 {
 	//(const vector<Vec3> &vrts, uint nvrts, vector<rxTriangle> &tris, uint ntris, vector<Vec3> &nrms)
 	int pn = (int)polys.faces.size();
@@ -1129,7 +1137,7 @@ static void CalVertexNormals(rxPolygons &polys)
  * @param[in] vrts 􉽏񖳂̃|S_
  * @param[inout] nrms |S@ꂼ̒_@ƂĊi[Ă
  */
-static void CalVertexNormalWithoutGeometry(const vector<Vec3> &vrts, vector<Vec3> &nrms)
+inline void CalVertexNormalWithoutGeometry(const vector<Vec3> &vrts, vector<Vec3> &nrms)
 {
 	int n = (int)vrts.size();
 
@@ -1186,7 +1194,7 @@ static void CalVertexNormalWithoutGeometry(const vector<Vec3> &vrts, vector<Vec3
  * @param[inout] vrts 􉽏񖳂̃|S_
  * @param[out] idxs 􉽏
  */
-static void CalVertexGeometry(vector<Vec3> &vrts, vector< vector<int> > &idxs)
+inline void CalVertexGeometry(vector<Vec3> &vrts, vector< vector<int> > &idxs)
 {
 	int nv = (int)vrts.size();
 	int np = nv/3;	// Op`|S
@@ -1195,8 +1203,6 @@ static void CalVertexGeometry(vector<Vec3> &vrts, vector< vector<int> > &idxs)
 	idxs.resize(np);
 	for(int i = 0; i < np; ++i) idxs[i].resize(3);
 
-	int same_vrts[256];	// d_̃CfbNXi[
-
 	vector<Vec3> compacted_vrts;	// dȂ_i[Rei
 
 	// dς݃tOi[Rei̊mۂƏ
@@ -1219,7 +1225,6 @@ static void CalVertexGeometry(vector<Vec3> &vrts, vector< vector<int> > &idxs)
 		compacted_vrts.push_back(pos0);
 		idxs[i/3][i%3] = nvrts;
 
-		same_vrts[0] = i;
 		int cnt = 1;
 		find_vrts[i] = 1;
 		for(int j = 0; j < nv; ++j){
@@ -1230,7 +1235,6 @@ static void CalVertexGeometry(vector<Vec3> &vrts, vector< vector<int> > &idxs)
 			// ߂_d_Ƃ
 			if(norm2(pos0-pos1) < eps2){
 				find_vrts[j] = 1;
-				same_vrts[cnt] = j;
 
 				idxs[j/3][j%3] = nvrts;	// compacted_vrts̃CfbNX
 
@@ -1326,7 +1330,7 @@ inline void EulerToMatrix16(Vec3 ang, double mat[16])
  * @param[in] ext AABB̕ӂ̒(1/2)
  * @param[in] ang ]xNg
  */
-static bool AffineVertices(rxPolygons &polys, Vec3 cen, Vec3 ext, Vec3 ang)
+inline bool AffineVertices(rxPolygons &polys, Vec3 cen, Vec3 ext, Vec3 ang)
 {
 	int vn = (int)polys.vertices.size();
 	if(vn <= 1) return false;
@@ -1436,7 +1440,6 @@ inline bool FitVertices(const Vec3 &ctr, const Vec3 &sl,
 	ctr0 = (maxp+minp)/2.0;
 
 	int max_axis = ( ( (sl0[0] > sl0[1]) && (sl0[0] > sl0[2]) ) ? 0 : ( (sl0[1] > sl0[2]) ? 1 : 2 ) );
-	int min_axis = ( ( (sl0[0] < sl0[1]) && (sl0[0] < sl0[2]) ) ? 0 : ( (sl0[1] < sl0[2]) ? 1 : 2 ) );
 	double size_conv = sl[max_axis]/sl0[max_axis];
 
 	// SĂ̒_bboxɂ킹ĕϊ
@@ -1545,11 +1548,9 @@ inline int CalMeshDiv(Vec3 &minp, const Vec3 maxp, const int nmax, double &h, in
 	l *= 1.0+extend;
 
 	double max_l = 0;
-	int max_axis = 0;
 	for(int i = 0; i < 3; ++i){
 		if(l[i] > max_l){
 			max_l = l[i];
-			max_axis = i;
 		}
 	}
 
@@ -1586,6 +1587,7 @@ inline int CalMeshDiv(Vec3 &minp, Vec3 maxp, double h, int n[3], double extend)
 	return 0;
 }
 
+#ifndef RX_HEADLESS
 /*!
  * bV`pVBOm
  * @param[in] max_verts ő咸_
@@ -1732,7 +1734,7 @@ inline bool SetArrayFromFBO(GLuint uVrtVBO, GLuint uNrmVBO, GLuint uTriVBO,
 
 	return true;
 }
-
+#endif	// #ifndef RX_HEADLESS
 
 
 
@@ -0,0 +1,565 @@
+/*!
+  @file rx_profiler.h
+
+  @brief Ƃ̌vZԂ̌v(vt@C)
+		 - XR[vPʂ̌v(][)P̍\NbN(RX_GET_TIME)Ōv
+		 - L^̓XbhƂ̃obt@ɍŝŁCOpenMP̈̕łg
+		 - Xebv(BeginStep`EndStep)ƂɊe][̎ԂWvCz(qXgOCp[Z^C)߂
+		 - Chrome trace`JSON(chrome://tracingȂǂŕ\)ƏWvʂCSVɏo
+
+  @date   2026-10
+*/
+// FILE -- rx_profiler.h --
+
+#ifndef _RX_PROFILER_H_
+#define _RX_PROFILER_H_
+
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include "rx_timer.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// `
+//-----------------------------------------------------------------------------
+#ifndef RX_NO_PROFILER
+#define RX_USE_PROFILER
+#endif
+
+const int RX_PROF_MAX_ZONES = 128;			//!< o^łő][
+const int RX_PROF_MAX_COUNTERS = 64;		//!< o^łőJE^
+const int RX_PROF_MAX_EVENTS = 1 << 20;		//!< Chrome tracepɋL^1Xbh̍őCxg
+const int RX_PROF_HIST_BINS = 24;			//!< qXgÕr(rb[2^(b-1), 2^b)s, Ō̃r͂ȏシׂ)
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+// vt@C
+//-----------------------------------------------------------------------------
+class rxProfiler
+{
+	//! v1񕪂̋L^(Chrome tracep)
+	struct rxProfEvent
+	{
+		int zone;
+		int step;
+		RXTIME start, end;
+	};
+
+	//! XbhƂ̋L^
+	struct rxProfThread
+	{
+		vector<rxProfEvent> events;		//!< Cxg
+		vector<double> step_time;		//!< ݂̃Xebvł̊e][̎[s]
+		vector<int> step_calls;			//!< ݂̃Xebvł̊e][̌Ăяo
+		vector<double> counters;		//!< eJE^̒l
+		vector<double> step_counters;	//!< ݂̃Xebvł̊eJE^̒l
+		int dropped;					//!< őCxg𒴂ċL^ȂCxg
+	};
+
+	//! ][Ƃ̏Wv
+	struct rxProfZoneStat
+	{
+		string name;
+		long long calls;				//!< Ăяo
+		vector<float> samples;			//!< XebvƂ̎[s](XebvOȂΌĂяo)
+	};
+
+	//! JE^̃XebvƂ̒l(Chrome tracep)
+	struct rxProfCounterSample
+	{
+		int counter;
+		RXTIME time;
+		double value;
+	};
+
+protected:
+	bool m_bEnabled;					//!< vON/OFF
+	int m_iMaxEvents;					//!< 1Xbh̍őCxg
+	double m_fT2S;						//!< ԒPʂbPʂւ̕ϊW
+	RXTIME m_tOrigin;					//!< vJn(Chrome trace̎̌_)
+	RXTIME m_tMark;						//!< Splitp̒O̎
+
+	int m_iStep;						//!< ݂̃Xebvԍ
+	bool m_bInStep;						//!< BeginStep`EndStep̊ԂȂtrue
+	int m_iNumSteps;					//!< WvXebv
+
+	vector<rxProfThread> m_vThreads;	//!< XbhƂ̋L^
+	vector<rxProfZoneStat> m_vZones;	//!< ][Ƃ̏Wv
+	map<string, int> m_mapZones;		//!< ][CfbNXւ̃}bv
+	vector<string> m_vCounters;			//!< JE^
+	map<string, int> m_mapCounters;		//!< JE^CfbNXւ̃}bv
+	vector<rxProfCounterSample> m_vCounterSamples;	//!< XebvƂ̃JE^l
+
+	rxProfiler() : m_bEnabled(false), m_iMaxEvents(RX_PROF_MAX_EVENTS), m_iStep(0), m_bInStep(false), m_iNumSteps(0)
+	{
+		m_fT2S = RX_GET_TIME2SEC();
+		m_tOrigin = m_tMark = RX_GET_TIME();
+	}
+
+public:
+	//! vt@C(Ŝ1)
+	static rxProfiler& Get(void)
+	{
+		static rxProfiler prof;
+		return prof;
+	}
+
+	/*!
+	 * vON/OFF
+	 *  - ONɂƂɂ܂ł̋L^͔j(XbhςƂONɂ)
+	 *  - XbhƂ̃obt@͂Ŋmۂ̂ŁC̈̊OŌĂԂ
+	 * @param[in] on trueŌvJn
+	 * @param[in] max_events 1Xbh̍őCxg(0ȂChrome tracep̃Cxg͋L^Ȃ)
+	 */
+	void Enable(bool on, int max_events = RX_PROF_MAX_EVENTS)
+	{
+		if(on){
+			m_iMaxEvents = (max_events > 0 ? max_events : 0);
+			Clear();
+		}
+		m_bEnabled = on;
+	}
+	bool IsEnabled(void) const { return m_bEnabled; }
+
+	/*!
+	 * L^̔j(o^ς݂̃][CJE^͎c)
+	 */
+	void Clear(void)
+	{
+		int nt = 1;
+#ifdef _OPENMP
+		nt = omp_get_max_threads();
+#endif
+		m_vThreads.assign(nt, rxProfThread());
+		for(int t = 0; t < nt; ++t){
+			rxProfThread &th = m_vThreads[t];
+			th.step_time.assign(RX_PROF_MAX_ZONES, 0.0);
+			th.step_calls.assign(RX_PROF_MAX_ZONES, 0);
+			th.counters.assign(RX_PROF_MAX_COUNTERS, 0.0);
+			th.step_counters.assign(RX_PROF_MAX_COUNTERS, 0.0);
+			th.dropped = 0;
+		}
+		for(int i = 0; i < (int)m_vZones.size(); ++i){
+			m_vZones[i].calls = 0;
+			m_vZones[i].samples.clear();
+		}
+		m_vCounterSamples.clear();
+		m_iNumSteps = 0;
+		m_bInStep = false;
+		m_tOrigin = m_tMark = RX_GET_TIME();
+	}
+
+	/*!
+	 * ][̓o^
+	 * @param[in] name ][
+	 * @return ][̃CfbNX(o^𒴂-1)
+	 */
+	int ZoneId(const char *name)
+	{
+		int id = -1;
+		#pragma omp critical (rx_profiler_zone)
+		{
+			map<string, int>::iterator i = m_mapZones.find(name);
+			if(i != m_mapZones.end()){
+				id = i->second;
+			}
+			else if((int)m_vZones.size() < RX_PROF_MAX_ZONES){
+				id = (int)m_vZones.size();
+				rxProfZoneStat z;
+				z.name = name;
+				z.calls = 0;
+				m_vZones.push_back(z);
+				m_mapZones[name] = id;
+			}
+		}
+		return id;
+	}
+
+	/*!
+	 * JE^̓o^
+	 * @param[in] name JE^
+	 * @return JE^̃CfbNX(o^𒴂-1)
+	 */
+	int CounterId(const char *name)
+	{
+		int id = -1;
+		#pragma omp critical (rx_profiler_counter)
+		{
+			map<string, int>::iterator i = m_mapCounters.find(name);
+			if(i != m_mapCounters.end()){
+				id = i->second;
+			}
+			else if((int)m_vCounters.size() < RX_PROF_MAX_COUNTERS){
+				id = (int)m_vCounters.size();
+				m_vCounters.push_back(name);
+				m_mapCounters[name] = id;
+			}
+		}
+		return id;
+	}
+
+	/*!
+	 * vԂ̋L^
+	 * @param[in] zone ][̃CfbNX
+	 * @param[in] t0,t1 JnEI(RX_GET_TIME)
+	 */
+	void Record(int zone, RXTIME t0, RXTIME t1)
+	{
+		if(!m_bEnabled || zone < 0) return;
+		rxProfThread &th = m_vThreads[threadIndex()];
+
+		if((int)th.events.size() < m_iMaxEvents){
+			rxProfEvent e;
+			e.zone = zone;
+			e.step = m_iStep;
+			e.start = t0;
+			e.end = t1;
+			th.events.push_back(e);
+		}
+		else if(m_iMaxEvents){
+			th.dropped++;
+		}
+
+		double t = (double)(t1-t0)*m_fT2S;
+		if(m_bInStep){
+			th.step_time[zone] += t;
+			th.step_calls[zone]++;
+		}
+		else{
+			// XebvO(o͏Ȃ)͌ĂяoƂ̎Ԃ1TvƂ
+			#pragma omp critical (rx_profiler_zone)
+			{
+				m_vZones[zone].calls++;
+				m_vZones[zone].samples.push_back((float)t);
+			}
+		}
+	}
+
+	/*!
+	 * JE^ւ̉Z(XbhƂɉZďo͎ɍv)
+	 * @param[in] counter JE^̃CfbNX
+	 * @param[in] value Zl
+	 */
+	void Count(int counter, double value)
+	{
+		if(!m_bEnabled || counter < 0) return;
+		rxProfThread &th = m_vThreads[threadIndex()];
+		th.counters[counter] += value;
+		th.step_counters[counter] += value;
+	}
+
+	/*!
+	 * ؂莞̐ݒ(SplitŒŐ؂肩̎Ԃv)
+	 */
+	void Mark(void)
+	{
+		m_tMark = RX_GET_TIME();
+	}
+
+	/*!
+	 * Ő؂肩̎Ԃ][ƂċL^ċ؂XV(RXTIMERp)
+	 * @param[in] name ][
+	 */
+	void Split(const string &name)
+	{
+		RXTIME t = RX_GET_TIME();
+		if(m_bEnabled) Record(ZoneId(name.c_str()), m_tMark, t);
+		m_tMark = t;
+	}
+
+	/*!
+	 * Xebv̊Jn
+	 * @param[in] step Xebvԍ
+	 */
+	void BeginStep(int step)
+	{
+		m_iStep = step;
+		m_bInStep = m_bEnabled;
+		m_tMark = RX_GET_TIME();
+	}
+
+	/*!
+	 * Xebv̏I
+	 *  - Xebv̊e][̎(SXbh̍v)1TvƂďWv
+	 */
+	void EndStep(void)
+	{
+		if(!m_bEnabled || !m_bInStep) return;
+		m_bInStep = false;
+
+		int nz = (int)m_vZones.size();
+		for(int z = 0; z < nz; ++z){
+			double t = 0.0;
+			int calls = 0;
+			for(int k = 0; k < (int)m_vThreads.size(); ++k){
+				t += m_vThreads[k].step_time[z];
+				calls += m_vThreads[k].step_calls[z];
+				m_vThreads[k].step_time[z] = 0.0;
+				m_vThreads[k].step_calls[z] = 0;
+			}
+			if(calls){
+				m_vZones[z].calls += calls;
+				m_vZones[z].samples.push_back((float)t);
+			}
+		}
+
+		RXTIME tend = RX_GET_TIME();
+		for(int c = 0; c < (int)m_vCounters.size(); ++c){
+			double v = 0.0;
+			for(int k = 0; k < (int)m_vThreads.size(); ++k){
+				v += m_vThreads[k].step_counters[c];
+				m_vThreads[k].step_counters[c] = 0.0;
+			}
+			if(m_iMaxEvents){
+				rxProfCounterSample s;
+				s.counter = c;
+				s.time = tend;
+				s.value = v;
+				m_vCounterSamples.push_back(s);
+			}
+		}
+
+		m_iNumSteps++;
+	}
+
+	int GetNumSteps(void) const { return m_iNumSteps; }
+
+	/*!
+	 * Chrome trace`(JSON)ŏo
+	 *  - evԂ"X"(complete)CxgCXebvƂ̃JE^l"C"CxgƂ
+	 * @param[in] fn o̓t@C
+	 */
+	bool WriteChromeTrace(const string &fn)
+	{
+		FILE *fp = fopen(fn.c_str(), "w");
+		if(!fp){
+			cout << fn << " couldn't open." << endl;
+			return false;
+		}
+
+		double t2us = m_fT2S*1.0e6;
+		bool first = true;
+		int dropped = 0;
+		fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		for(int k = 0; k < (int)m_vThreads.size(); ++k){
+			const rxProfThread &th = m_vThreads[k];
+			dropped += th.dropped;
+			if(th.events.empty()) continue;
+
+			fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", (first ? "" : ",\n"), k, k);
+			first = false;
+			for(int i = 0; i < (int)th.events.size(); ++i){
+				const rxProfEvent &e = th.events[i];
+				fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"rx\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"step\":%d}}",
+						jsonName(m_vZones[e.zone].name).c_str(), k, (double)(e.start-m_tOrigin)*t2us, (double)(e.end-e.start)*t2us, e.step);
+			}
+		}
+		for(int i = 0; i < (int)m_vCounterSamples.size(); ++i){
+			const rxProfCounterSample &s = m_vCounterSamples[i];
+			string name = jsonName(m_vCounters[s.counter]);
+			fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"%s\":%.17g}}",
+					(first ? "" : ",\n"), name.c_str(), (double)(s.time-m_tOrigin)*t2us, name.c_str(), s.value);
+			first = false;
+		}
+		fprintf(fp, "\n]}\n");
+		fclose(fp);
+
+		if(dropped){
+			cout << dropped << " profiling events exceeding the limit were not written to " << fn << "." << endl;
+		}
+		return true;
+	}
+
+	/*!
+	 * WvʂCSVŏo
+	 *  - zones : Xebv(Tv)CĂяo񐔁CvEρEŏEőElE95p[Z^C[ms]ƃqXgO
+	 *  - counters : XbhƂ̃JE^̍vl(thread-1̍s͑SXbh̍v)
+	 * @param[in] fn o̓t@C
+	 */
+	bool WriteCSV(const string &fn)
+	{
+		ofstream fout(fn.c_str());
+		if(!fout){
+			cout << fn << " couldn't open." << endl;
+			return false;
+		}
+
+		fout << "type,name,thread,samples,calls,total_ms,mean_ms,min_ms,max_ms,p50_ms,p95_ms";
+		for(int b = 0; b < RX_PROF_HIST_BINS; ++b){
+			if(b == RX_PROF_HIST_BINS-1){
+				fout << ",hist_ge" << (1LL << (b-1)) << "us";
+			}
+			else{
+				fout << ",hist_lt" << (1LL << b) << "us";
+			}
+		}
+		fout << "\n";
+
+		char buf[256];
+		for(int z = 0; z < (int)m_vZones.size(); ++z){
+			const rxProfZoneStat &zs = m_vZones[z];
+			int n = (int)zs.samples.size();
+			if(!n) continue;
+
+			vector<float> s = zs.samples;
+			sort(s.begin(), s.end());
+			double total = 0.0;
+			int hist[RX_PROF_HIST_BINS];
+			for(int b = 0; b < RX_PROF_HIST_BINS; ++b) hist[b] = 0;
+			for(int i = 0; i < n; ++i){
+				total += s[i];
+				hist[histBin(s[i])]++;
+			}
+
+			sprintf(buf, "%.6f,%.6f,%.6f,%.6f,%.6f,%.6f", total*1e3, total*1e3/n, s[0]*1e3, s[n-1]*1e3,
+					percentile(s, 0.5)*1e3, percentile(s, 0.95)*1e3);
+			fout << "zone," << csvName(zs.name) << ",-1," << n << "," << zs.calls << "," << buf;
+			for(int b = 0; b < RX_PROF_HIST_BINS; ++b){
+				fout << "," << hist[b];
+			}
+			fout << "\n";
+		}
+
+		for(int c = 0; c < (int)m_vCounters.size(); ++c){
+			double sum = 0.0;
+			for(int k = 0; k < (int)m_vThreads.size(); ++k){
+				double v = m_vThreads[k].counters[c];
+				sum += v;
+				if(v != 0.0){
+					sprintf(buf, "%.17g", v);
+					fout << "counter," << csvName(m_vCounters[c]) << "," << k << ",,," << buf << "\n";
+				}
+			}
+			sprintf(buf, "%.17g", sum);
+			fout << "counter," << csvName(m_vCounters[c]) << ",-1,,," << buf << "\n";
+		}
+
+		return true;
+	}
+
+protected:
+	//! ݂̃Xbh̃obt@̃CfbNX
+	int threadIndex(void) const
+	{
+		int t = 0;
+#ifdef _OPENMP
+		t = omp_get_thread_num();
+#endif
+		return (t < (int)m_vThreads.size() ? t : 0);
+	}
+
+	//! qXgÕr
+	static int histBin(double t)
+	{
+		double us = t*1.0e6;
+		int b = 0;
+		while(b < RX_PROF_HIST_BINS-1 && us >= (double)(1LL << b)) b++;
+		return b;
+	}
+
+	//! \[gς݂̒l̃p[Z^C(`)
+	static double percentile(const vector<float> &s, double q)
+	{
+		double x = q*(s.size()-1);
+		int i = (int)x;
+		if(i >= (int)s.size()-1) return s.back();
+		return s[i]+(x-i)*(s[i+1]-s[i]);
+	}
+
+	//! JSONp̃GXP[v
+	static string jsonName(const string &name)
+	{
+		string str;
+		for(int i = 0; i < (int)name.size(); ++i){
+			if(name[i] == '"' || name[i] == '\\') str += '\\';
+			str += name[i];
+		}
+		return str;
+	}
+
+	//! CSṼtB[hp(J}p܂ނƂ͈pň͂)
+	static string csvName(const string &name)
+	{
+		if(name.find_first_of(",\"") == string::npos) return name;
+		string str = "\"";
+		for(int i = 0; i < (int)name.size(); ++i){
+			if(name[i] == '"') str += '"';
+			str += name[i];
+		}
+		return str+"\"";
+	}
+};
+
+
+//-----------------------------------------------------------------------------
+// XR[vPʂ̌v
+//-----------------------------------------------------------------------------
+class rxProfZone
+{
+	int m_iZone;
+	RXTIME m_t0;
+
+public:
+	/*!
+	 * RXgN^(vJn)
+	 * @param[in] name ][
+	 * @param[inout] id o^ς݂̃][̃CfbNX(-1Ȃo^ĂɊi[)
+	 */
+	rxProfZone(const char *name, int &id) : m_iZone(-1)
+	{
+		rxProfiler &prof = rxProfiler::Get();
+		if(!prof.IsEnabled()) return;
+		if(id < 0) id = prof.ZoneId(name);
+		m_iZone = id;
+		m_t0 = RX_GET_TIME();
+	}
+
+	//! fXgN^(vI)
+	~rxProfZone()
+	{
+		if(m_iZone >= 0) rxProfiler::Get().Record(m_iZone, m_t0, RX_GET_TIME());
+	}
+};
+
+
+//-----------------------------------------------------------------------------
+// }N
+//  - RXPROF_ZONE("name") : ̃XR[v̏I܂łv
+//  - RXPROF_COUNT("name", v) : JE^vZ
+//-----------------------------------------------------------------------------
+#define RXPROF_CAT2(a, b) a##b
+#define RXPROF_CAT(a, b) RXPROF_CAT2(a, b)
+
+#ifdef RX_USE_PROFILER
+#define RXPROF_ZONE(x) static int RXPROF_CAT(rxprof_id_, __LINE__) = -1; rxProfZone RXPROF_CAT(rxprof_zone_, __LINE__)(x, RXPROF_CAT(rxprof_id_, __LINE__))
+#define RXPROF_COUNT(x, v) do{ static int RXPROF_CAT(rxprof_cid_, __LINE__) = -1; rxProfiler &p = rxProfiler::Get(); \
+							if(p.IsEnabled()){ if(RXPROF_CAT(rxprof_cid_, __LINE__) < 0) RXPROF_CAT(rxprof_cid_, __LINE__) = p.CounterId(x); \
+							p.Count(RXPROF_CAT(rxprof_cid_, __LINE__), (double)(v)); } }while(0)
+#define RXPROF_SPLIT(x) rxProfiler::Get().Split(x)
+#define RXPROF_MARK rxProfiler::Get().Mark()
+#else
+#define RXPROF_ZONE(x)
+#define RXPROF_COUNT(x, v)
+#define RXPROF_SPLIT(x) ((void)0)
+#define RXPROF_MARK ((void)0)
+#endif
+
+
+
+#endif // #ifdef _RX_PROFILER_H_
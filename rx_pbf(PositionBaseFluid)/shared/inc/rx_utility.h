@@ -30,6 +30,8 @@
 
 #include "rx_vec.h"
 
+using namespace std;
+
 
 //--------------------------------------------------------------------
 // 萔
@@ -15,8 +15,27 @@
 //-----------------------------------------------------------------------------
 // CN[ht@C
 //-----------------------------------------------------------------------------
+#ifndef RX_HEADLESS
 #include "vector_types.h"
 #include "vector_functions.h"
+#else
+// CUDAgȂꍇ(wbhXs)̃zXgpxNg^
+struct float2{ float x, y; };
+struct float3{ float x, y, z; };
+struct float4{ float x, y, z, w; };
+struct int2{ int x, y; };
+struct int3{ int x, y, z; };
+struct int4{ int x, y, z, w; };
+struct uint2{ unsigned int x, y; };
+struct uint3{ unsigned int x, y, z; };
+struct uint4{ unsigned int x, y, z, w; };
+struct uchar4{ unsigned char x, y, z, w; };
+inline float2 make_float2(float x, float y){ float2 v = {x, y}; return v; }
+inline float3 make_float3(float x, float y, float z){ float3 v = {x, y, z}; return v; }
+inline float4 make_float4(float x, float y, float z, float w){ float4 v = {x, y, z, w}; return v; }
+inline int3 make_int3(int x, int y, int z){ int3 v = {x, y, z}; return v; }
+inline uint3 make_uint3(unsigned int x, unsigned int y, unsigned int z){ uint3 v = {x, y, z}; return v; }
+#endif
 
 
 //-----------------------------------------------------------------------------
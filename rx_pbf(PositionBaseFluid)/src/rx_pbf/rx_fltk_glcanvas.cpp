@@ -79,6 +79,8 @@ double g_fTBQuat[4] = {1, 0, 0, 0};	//!< 
 	
 int g_iIterations = 1;				//!< C
 double g_fEta = 0.0;				//!< xϓ
+int g_iNeighborBuilds = 0;			//!< ߖTXg쐬
+int g_iSubsteps = 1;				//!< TuXebv
 
 // `
 rxGLSL g_glslPointSprite;			//!< GLSLg`
@@ -193,6 +195,7 @@ rxFlGLWindow::rxFlGLWindow(int x_, int y_, int w_, int h_, const char* l, void *
 	m_iMeshN[0] = 64;					// bVObh
 	m_iMeshN[1] = 64;
 	m_iMeshN[2] = 64;
+	m_bMeshSparse = false;				// CPUł̃bVɑaȃubNObhg
 
 	m_vMeshBoundaryExt = Vec3(1.0);		// bVE{bNX̊eӂ̒1/2
 	m_vMeshBoundaryCen = Vec3(0.0);		// bVE{bNX̒SW
@@ -259,6 +262,13 @@ rxFlGLWindow::~rxFlGLWindow()
 	if(m_uNrmVBO) glDeleteBuffers(1, &m_uNrmVBO);
 
 	if(m_pPS) delete m_pPS;
+
+	// vt@Cʂ̏o
+	rxProfiler &prof = rxProfiler::Get();
+	if(prof.IsEnabled() && prof.GetNumSteps()){
+		prof.WriteChromeTrace(RX_DEFAULT_RESULT_DIR+"profile_trace.json");
+		prof.WriteCSV(RX_DEFAULT_RESULT_DIR+"profile.csv");
+	}
 }
 
 
@@ -499,7 +509,7 @@ void rxFlGLWindow::Display(void)
 			DivideString(m_pPS->GetParticleInfo(0), strs);
 		}
 		else{
-			DivideString(m_pPS->GetParticleInfo(m_iPickedParticle), strs);
+			DivideString(m_pPS->GetParticleInfo(m_pPS->GetParticleIndex(m_iPickedParticle)), strs);
 		}
 		DrawStrings(strs, m_iWinW, m_iWinH, 0, 0);
 	}
@@ -565,7 +575,8 @@ bool rxFlGLWindow::PickParticle(int x, int y)
 	}
 	else{
 		std::sort(hits.begin(), hits.end(), CompFuncPickInfo);
-		m_iPickedParticle = hits[0].name-1;
+		// ёւŔzCfbNXςĂp[eBNw悤ɊOIDŕێ
+		m_iPickedParticle = m_pPS->GetParticleId(hits[0].name-1);
 		RXCOUT << "picked particle : " << m_iPickedParticle << endl;
 		return true;
 	}
@@ -880,7 +891,9 @@ void rxFlGLWindow::Idle(void)
 	}
 	else{
 		RXTIMER_RESET;
+		rxProfiler::Get().BeginStep(m_iCurrentStep);
 		StepPS(m_fDt);
+		rxProfiler::Get().EndStep();
 	}
 
 	if(m_iPickedParticle != -1){
@@ -891,6 +904,7 @@ void rxFlGLWindow::Idle(void)
 	// ̕\ʃbV
 	//
 	if(m_iSimuSetting & RX_SPH_MESH){
+		RXPROF_ZONE("surface mesh");
 		CalMeshSPH(m_iMeshMaxN, m_fMeshThr);
 	}
 	RXTIMER("mesh mc");
@@ -1469,9 +1483,6 @@ void rxFlGLWindow::SetMeshCreation(void)
  */
 bool rxFlGLWindow::calMeshSPH_CPU(int nmax, double thr)
 {
-	// p[eBNߖTTpψObhɊi[
-	m_pPS->SetParticlesToCell();
-
 	Vec3 minp = m_pPS->GetMin();
 	Vec3 maxp = m_pPS->GetMax();
 
@@ -1493,8 +1504,18 @@ bool rxFlGLWindow::calMeshSPH_CPU(int nmax, double thr)
 		m_pMCMeshCPU = new rxMCMeshCPU;
 	}
 
-	// bV
-	m_pMCMeshCPU->CreateMesh(&RXSPH::GetImplicit_s, m_pPS, minp, h, n, thr, m_Poly.vertices, m_Poly.normals, m_Poly.faces);
+	// p[eBNObh_̉A֐lvZăbV(Obh_̓Z+1)
+	int nv[3] = {n[0]+1, n[1]+1, n[2]+1};
+	if(m_bMeshSparse){
+		rxSparseBrickGrid grid;
+		m_pPS->CalImplicitFieldSparse(nv, minp, Vec3(h), grid);
+		m_pMCMeshCPU->CreateMeshSparse(grid, thr, m_Poly.vertices, m_Poly.normals, m_Poly.faces);
+	}
+	else{
+		vector<RXREAL> field(nv[0]*nv[1]*nv[2]);
+		m_pPS->CalImplicitField(nv, minp, Vec3(h), &field[0]);
+		m_pMCMeshCPU->CreateMeshV(&field[0], minp, h, n, thr, m_Poly.vertices, m_Poly.normals, m_Poly.faces);
+	}
 
 	m_iNumVrts = (int)m_Poly.vertices.size();
 	m_iNumTris = (int)m_Poly.faces.size();
@@ -1598,10 +1619,12 @@ void rxFlGLWindow::InitSPH(rxSceneConfig &sph_scene)
 		if(sph_scene.LoadSpaceFromFile()){
 			rxEnviroment sph_env = sph_scene.GetEnv();
 			((RXSPH*)m_pPS)->Initialize(sph_env);
+			rxProfiler::Get().Enable(sph_env.profile != 0);
 
 			m_fDt = sph_env.dt;
 			m_iVertexStore = sph_env.mesh_vertex_store;
 			m_iMeshMaxN = sph_env.mesh_max_n;
+			m_bMeshSparse = (sph_env.mesh_sparse != 0);
 
 			if(sph_env.use_inlet){
 				m_iSimuSetting |= RX_SPH_INLET;
@@ -1778,7 +1801,10 @@ vector<string> rxFlGLWindow::SetDrawString(void)
 
 	// 
 	str.push_back("");
-	str.back() << "Iterations : " << g_iIterations;
+	str.back() << "Iterations : " << g_iIterations << " (neighbor builds : " << g_iNeighborBuilds << ")";
+	if(g_iSubsteps > 1){
+		str.back() << ", Substeps : " << g_iSubsteps;
+	}
 	str.push_back("");
 	str.back() << "Eta : " << g_fEta;
 	str.push_back("Artificial pressure : ");
@@ -1958,7 +1984,7 @@ void rxFlGLWindow::SetParticleColorType(int type)
 	case RXP_COLOR_RAMP:	 ps_type = rxParticleSystemBase::RX_RAMP; break;
 	}
 	m_pPS->SetColorType(ps_type);
-	m_pPS->SetColorVBO(m_iPickedParticle);
+	m_pPS->SetColorVBO(m_pPS->GetParticleIndex(m_iPickedParticle));
 	m_iColorType = type;
 }
 
@@ -2063,7 +2089,7 @@ void rxFlGLWindow::RenderSphScene(void)
 
 		if(m_iPickedParticle != -1){
 			RXREAL prad = m_pPS->GetParticleRadius();
-			int k = m_iPickedParticle;
+			int k = m_pPS->GetParticleIndex(m_iPickedParticle);
 			RXREAL *data = m_pPS->GetArrayVBO(rxParticleSystemBase::RX_POSITION);
 			Vec3 pos(data[DIM*k+0], data[DIM*k+1], data[DIM*k+2]);
 			glDisable(GL_LIGHTING);
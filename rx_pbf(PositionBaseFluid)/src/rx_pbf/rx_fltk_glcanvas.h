@@ -259,6 +259,7 @@ protected:
 
 	int m_iMeshMaxN;				//!< bVObh(EƂ̕)
 	int m_iMeshN[3];				//!< bVObh
+	bool m_bMeshSparse;				//!< CPUł̃bVɑaȃubNObhg
 
 	Vec3 m_vMeshBoundaryExt;		//!< bVE{bNX̊eӂ̒1/2
 	Vec3 m_vMeshBoundaryCen;		//!< bVE{bNX̒SW
@@ -283,7 +284,7 @@ protected:
 	rxMCMeshGPU *m_pMCMeshGPU;
 
 
-	int m_iPickedParticle;			//!< }EXsbNꂽp[eBN
+	int m_iPickedParticle;			//!< }EXsbNꂽp[eBN(OID)
 	int m_iSelBufferSize;			//!< ZNVobt@̃TCY
 	GLuint* m_pSelBuffer;			//!< ZNVobt@
 
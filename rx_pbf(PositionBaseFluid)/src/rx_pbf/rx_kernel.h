@@ -107,7 +107,7 @@ inline T KernelPoly6G(double r, double h, double a, T rij)
  * @param[in] d (1,2,3)
  * @return vVA̒l
  */
-inline double KernelPoly6L(double r, double h, double a, double d)
+inline double KernelPoly6L(double r, double h, double a, double /*d*/)
 {
 	if(r >= 0.0 && r <= h){
 		double q = h*h-r*r;
@@ -210,7 +210,7 @@ inline T KernelSpikyG(double r, double h, double a, T rij)
  * @param[in] d (1,2,3)
  * @return vVA̒l
  */
-inline double KernelSpikyL(double r, double h, double a, double d)
+inline double KernelSpikyL(double r, double h, double a, double /*d*/)
 {
 	if(r > 0.0 && r <= h){
 		double q = h-r;
@@ -313,7 +313,7 @@ inline T KernelViscG(double r, double h, double a, T rij)
  * @param[in] d (1,2,3)
  * @return vVA̒l
  */
-inline double KernelViscL(double r, double h, double a, double d)
+inline double KernelViscL(double r, double h, double a, double /*d*/)
 {
 	if(r > 0.0 && r <= h){
 		return a*(h-r);
@@ -439,5 +439,203 @@ inline double KernelSplineL(double r, double h, double a, double d)
 }
 
 
+//-----------------------------------------------------------------------------
+// ob`vZ
+//  - ̋ߖTq(N)ɑ΂J[ll/z܂Ƃ߂ČvZ
+//  - I(OZq)ɂŒ蒷[vȂ̂ŁCRpCSIMD
+//    (SSE/AVX2/AVX-512, /arch:AVX2-mavx2ŗL)ɓWJł
+//  - T = float/double, N = 4/8/16
+//-----------------------------------------------------------------------------
+//! ob`vZ̃ftHg
+#ifndef RX_KERNEL_BATCH
+#define RX_KERNEL_BATCH 8
+#endif
+
+/*!
+ * ߖTqubN(SoA)
+ *  - r,x,y,zvfƂ̔zŎCȂvf͉e͈͊ŐŖ߂
+ */
+template<class T, int N>
+struct rxKernelBlock
+{
+	T r[N];				//!< 
+	T x[N], y[N], z[N];	//!< ΈʒuxNg(Sq-ߖTq)
+	int idx[N];			//!< ߖTq̃CfbNX
+	int n;				//!< Lȗvf
+
+	//! c̗vfJ[l̉e͈͊O(rpad)Ŗ߂
+	void Pad(T rpad)
+	{
+		for(int l = n; l < N; ++l){
+			r[l] = rpad;
+			x[l] = y[l] = z[l] = (T)0;
+			idx[l] = -1;
+		}
+	}
+};
+
+
+/*!
+ * Poly6J[l֐l̃ob`vZ
+ * @param[in] r (N)
+ * @param[in] h La
+ * @param[in] a J[lW
+ * @param[out] w ֐l(N)
+ */
+template<class T, int N>
+inline void KernelPoly6Batch(const T *r, T h, T a, T *w)
+{
+	T h2 = h*h;
+	for(int l = 0; l < N; ++l){
+		T q = h2-r[l]*r[l];
+		q = (q > (T)0 ? q : (T)0);
+		w[l] = a*q*q*q;
+	}
+}
+
+/*!
+ * Poly6J[l֐zl̃ob`vZ
+ * @param[in] r (N)
+ * @param[in] x,y,z ΈʒuxNg(N)
+ * @param[in] h La
+ * @param[in] a J[lW
+ * @param[out] gx,gy,gz zl(N)
+ */
+template<class T, int N>
+inline void KernelPoly6GBatch(const T *r, const T *x, const T *y, const T *z, T h, T a, T *gx, T *gy, T *gz)
+{
+	T h2 = h*h;
+	for(int l = 0; l < N; ++l){
+		T q = h2-r[l]*r[l];
+		q = (q > (T)0 ? q : (T)0);
+		T c = a*q*q;
+		gx[l] = c*x[l];
+		gy[l] = c*y[l];
+		gz[l] = c*z[l];
+	}
+}
+
+/*!
+ * SpikyJ[l֐l̃ob`vZ
+ * @param[in] r (N)
+ * @param[in] h La
+ * @param[in] a J[lW
+ * @param[out] w ֐l(N)
+ */
+template<class T, int N>
+inline void KernelSpikyBatch(const T *r, T h, T a, T *w)
+{
+	for(int l = 0; l < N; ++l){
+		T q = h-r[l];
+		q = (q > (T)0 ? q : (T)0);
+		w[l] = a*q*q*q;
+	}
+}
+
+/*!
+ * SpikyJ[l֐zl̃ob`vZ
+ *  - r = 0 ̗vf0(XJ[łƓ)
+ * @param[in] r (N)
+ * @param[in] x,y,z ΈʒuxNg(N)
+ * @param[in] h La
+ * @param[in] a J[lW
+ * @param[out] gx,gy,gz zl(N)
+ */
+template<class T, int N>
+inline void KernelSpikyGBatch(const T *r, const T *x, const T *y, const T *z, T h, T a, T *gx, T *gy, T *gz)
+{
+	for(int l = 0; l < N; ++l){
+		T q = h-r[l];
+		T ri = (r[l] > (T)0 ? r[l] : (T)1);
+		T c = (r[l] > (T)0 && q >= (T)0) ? a*q*q/ri : (T)0;
+		gx[l] = c*x[l];
+		gy[l] = c*y[l];
+		gz[l] = c*z[l];
+	}
+}
+
+/*!
+ * SplineJ[l֐l̃ob`vZ
+ * @param[in] r (N)
+ * @param[in] h La
+ * @param[in] a J[lW
+ * @param[out] w ֐l(N)
+ */
+template<class T, int N>
+inline void KernelSplineBatch(const T *r, T h, T a, T *w)
+{
+	T ih = (T)1/h;
+	for(int l = 0; l < N; ++l){
+		T q = r[l]*ih;
+		T p = (T)2-q;
+		T w0 = (T)1-(T)1.5*q*q+(T)0.75*q*q*q;
+		T w1 = (T)0.25*p*p*p;
+		w[l] = (q <= (T)1) ? a*w0 : ((q <= (T)2) ? a*w1 : (T)0);
+	}
+}
+
+/*!
+ * SplineJ[l֐zl̃ob`vZ
+ * @param[in] r (N)
+ * @param[in] x,y,z ΈʒuxNg(N)
+ * @param[in] h La
+ * @param[in] a J[lW
+ * @param[out] gx,gy,gz zl(N)
+ */
+template<class T, int N>
+inline void KernelSplineGBatch(const T *r, const T *x, const T *y, const T *z, T h, T a, T *gx, T *gy, T *gz)
+{
+	T ih = (T)1/h;
+	for(int l = 0; l < N; ++l){
+		T q = r[l]*ih;
+		T p = (T)2-q;
+		T qi = (q > (T)0 ? q : (T)1);
+		T c0 = a*(q-(T)4/(T)3);
+		T c1 = -a*p*p/(qi*(T)3);
+		T c = (q < (T)1) ? c0 : ((q < (T)2) ? c1 : (T)0);
+		gx[l] = c*x[l];
+		gy[l] = c*y[l];
+		gz[l] = c*z[l];
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// RpC̃J[lIpNX
+//  - ev[gœnƂŁCߖTqƂ̊֐|C^ĂяoȂ
+//-----------------------------------------------------------------------------
+//! Poly6J[l
+struct rxKernelPoly6
+{
+	static double Coef(double h, int type){ return KernelCoefPoly6(h, 3, type); }
+	template<class T, int N> static void W(const T *r, T h, T a, T *w){ KernelPoly6Batch<T, N>(r, h, a, w); }
+	template<class T, int N> static void GW(const rxKernelBlock<T, N> &b, T h, T a, T *gx, T *gy, T *gz)
+	{
+		KernelPoly6GBatch<T, N>(b.r, b.x, b.y, b.z, h, a, gx, gy, gz);
+	}
+};
+
+//! SpikyJ[l
+struct rxKernelSpiky
+{
+	static double Coef(double h, int type){ return KernelCoefSpiky(h, 3, type); }
+	template<class T, int N> static void W(const T *r, T h, T a, T *w){ KernelSpikyBatch<T, N>(r, h, a, w); }
+	template<class T, int N> static void GW(const rxKernelBlock<T, N> &b, T h, T a, T *gx, T *gy, T *gz)
+	{
+		KernelSpikyGBatch<T, N>(b.r, b.x, b.y, b.z, h, a, gx, gy, gz);
+	}
+};
+
+//! SplineJ[l
+struct rxKernelSpline
+{
+	static double Coef(double h, int type){ return KernelCoefSpline(h, 3, type); }
+	template<class T, int N> static void W(const T *r, T h, T a, T *w){ KernelSplineBatch<T, N>(r, h, a, w); }
+	template<class T, int N> static void GW(const rxKernelBlock<T, N> &b, T h, T a, T *gx, T *gy, T *gz)
+	{
+		KernelSplineGBatch<T, N>(b.r, b.x, b.y, b.z, h, a, gx, gy, gz);
+	}
+};
+
 
 #endif	// _RX_KERNEL_H_
\ No newline at end of file
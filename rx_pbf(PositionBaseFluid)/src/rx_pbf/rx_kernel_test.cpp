@@ -0,0 +1,178 @@
+/*!
+  @file rx_kernel_test.cpp
+
+  @brief ob`ŃJ[l(rx_kernel.h)̃eXg
+		 - KernelPoly6/Spiky/SplineBatch,GBatch̒lƌzXJ[łƔr
+		 - T = float/double, N = 4/8/16
+		 - r = 0, r = h(Spline2h)CvfNɖȂubN(Pad)܂
+		 - SĈv0CłȂ1Ԃ
+
+  @date   2026-10
+*/
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "rx_kernel.h"
+
+
+//-----------------------------------------------------------------------------
+// 萔Eϐ
+//-----------------------------------------------------------------------------
+const double KT_H = 0.1;			//!< La
+static int g_iNumFail = 0;			//!< s
+
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+/*!
+ * e덷()
+ */
+template<class T> inline double KernelTestEps(void){ return 1.0e-12; }
+template<> inline double KernelTestEps<float>(void){ return 2.0e-5; }
+
+/*!
+ * l̔r
+ * @param[in] name eXg
+ * @param[in] v,ref vZlƎQƒl
+ * @param[in] scale 덷̊ƂȂl̑傫
+ * @param[in] eps e덷()
+ */
+static bool KernelTestCheck(const char *name, double v, double ref, double scale, double eps)
+{
+	if(fabs(v-ref) <= eps*scale) return true;
+	if(g_iNumFail < 20){
+		printf("  %s : %e (ref %e)\n", name, v, ref);
+	}
+	g_iNumFail++;
+	return false;
+}
+
+/*!
+ * eXgp̋̃Xg
+ *  - 0, h, 2h(Splinẻe͈͂̋E), ͈͊OƁC̊Ԃ̒l
+ * @param[in] rmax e͈
+ */
+static std::vector<double> KernelTestDistances(double rmax)
+{
+	std::vector<double> r;
+	r.push_back(0.0);
+	r.push_back(KT_H);
+	r.push_back(2.0*KT_H);
+	r.push_back(rmax*1.5);
+	srand(1234);
+	for(int i = 0; i < 61; ++i){
+		r.push_back(rmax*1.1*rand()/(double)RAND_MAX);
+	}
+	return r;
+}
+
+/*!
+ * 1̃J[l̃eXg
+ *  - XJ[łQƒlƂN̃ubNŔr
+ *  - Ō̃ubN͗vfNɂȂ悤ɂPadŖ߂
+ * @param[in] name J[l
+ * @param[in] rmax e͈(Spline2h)
+ * @param[in] fw,fg XJ[ł̊֐lƌz
+ */
+template<class K, class T, int N>
+static void KernelTest(const char *name, double rmax, double (*fw)(double, double, double), Vec3 (*fg)(double, double, double, Vec3))
+{
+	int nfail0 = g_iNumFail;
+	double a = K::Coef(KT_H, 1);
+	double ag = K::Coef(KT_H, 2);
+
+	std::vector<double> rs = KernelTestDistances(rmax);
+	int n = (int)rs.size();
+
+	// lƌz̑傫(덷̊)
+	double wmax = 0.0, gmax = 0.0;
+	for(int i = 0; i < n; ++i){
+		double w = fabs(fw(rs[i], KT_H, a));
+		double g = norm(fg(rs[i], KT_H, ag, Vec3(rs[i], 0.0, 0.0)));
+		if(w > wmax) wmax = w;
+		if(g > gmax) gmax = g;
+	}
+
+	for(int i0 = 0; i0 < n; i0 += N){
+		rxKernelBlock<T, N> b;
+		b.n = (n-i0 < N ? n-i0 : N);
+		for(int l = 0; l < b.n; ++l){
+			// ΈʒuxNg͋r̕낢ς
+			double r = rs[i0+l];
+			Vec3 d = Unit(Vec3(1.0+0.3*l, -0.5+0.2*l, 0.7-0.1*l));
+			Vec3 rij = d*r;
+			b.r[l] = (T)r;
+			b.x[l] = (T)rij[0]; b.y[l] = (T)rij[1]; b.z[l] = (T)rij[2];
+			b.idx[l] = i0+l;
+		}
+		b.Pad((T)(rmax*2.0));
+
+		T w[N], gx[N], gy[N], gz[N];
+		K::template W<T, N>(b.r, (T)KT_H, (T)a, w);
+		K::template GW<T, N>(b, (T)KT_H, (T)ag, gx, gy, gz);
+
+		for(int l = 0; l < N; ++l){
+			double wref = 0.0;
+			Vec3 gref(0.0);
+			if(l < b.n){
+				// QƒlfloatɊۂ߂ƃxNgvZ
+				Vec3 rij((double)b.x[l], (double)b.y[l], (double)b.z[l]);
+				wref = fw((double)b.r[l], KT_H, a);
+				gref = fg((double)b.r[l], KT_H, ag, rij);
+			}
+
+			char buf[128];
+			sprintf(buf, "%s W[%d] r=%g", name, i0+l, (double)b.r[l]);
+			KernelTestCheck(buf, w[l], wref, wmax, KernelTestEps<T>());
+			for(int k = 0; k < 3; ++k){
+				T g = (k == 0 ? gx[l] : (k == 1 ? gy[l] : gz[l]));
+				sprintf(buf, "%s GW[%d].%d r=%g", name, i0+l, k, (double)b.r[l]);
+				KernelTestCheck(buf, g, gref[k], gmax, KernelTestEps<T>());
+			}
+		}
+	}
+
+	printf("%-8s %-6s N=%2d : %s\n", name, (sizeof(T) == sizeof(float) ? "float" : "double"), N, (g_iNumFail == nfail0 ? "ok" : "FAILED"));
+}
+
+// XJ[(ev[g֐Vec3Ŏ̉)
+static Vec3 KernelPoly6GVec(double r, double h, double a, Vec3 rij){ return KernelPoly6G(r, h, a, rij); }
+static Vec3 KernelSpikyGVec(double r, double h, double a, Vec3 rij){ return KernelSpikyG(r, h, a, rij); }
+static Vec3 KernelSplineGVec(double r, double h, double a, Vec3 rij){ return KernelSplineG(r, h, a, rij); }
+
+/*!
+ * SẴJ[l̃eXg(^T, N)
+ */
+template<class T, int N>
+static void KernelTestAll(void)
+{
+	KernelTest<rxKernelPoly6, T, N>("Poly6", KT_H, KernelPoly6, KernelPoly6GVec);
+	KernelTest<rxKernelSpiky, T, N>("Spiky", KT_H, KernelSpiky, KernelSpikyGVec);
+	KernelTest<rxKernelSpline, T, N>("Spline", 2.0*KT_H, KernelSpline, KernelSplineGVec);
+}
+
+
+/*!
+ * C֐
+ */
+int main(int argc, char *argv[])
+{
+	KernelTestAll<float, 4>();
+	KernelTestAll<float, 8>();
+	KernelTestAll<float, 16>();
+	KernelTestAll<double, 4>();
+	KernelTestAll<double, 8>();
+	KernelTestAll<double, 16>();
+
+	if(g_iNumFail){
+		printf("%d failures\n", g_iNumFail);
+		return 1;
+	}
+	return 0;
+}
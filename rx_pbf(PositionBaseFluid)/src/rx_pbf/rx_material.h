@@ -15,7 +15,9 @@
 // CN[ht@C
 //-----------------------------------------------------------------------------
 #include "rx_utility.h"
+#ifndef RX_HEADLESS
 #include "GL/glut.h"
+#endif
 
 
 using namespace std;
@@ -65,6 +67,7 @@ public:
 		m_fShin = shin;
 	}
 
+#ifndef RX_HEADLESS
 	void SetColor(const GLfloat diff[4], 
 				  const GLfloat spec[4], 
 				  const GLfloat ambi[4], 
@@ -77,6 +80,7 @@ public:
 		m_vEmit = Vec4(emit[0], emit[1], emit[2], emit[3]);
 		m_fShin = shine;
 	}
+#endif
 
 	void SetColor(const Vec3 &diff, const Vec3 &spec, const Vec3 &ambi, const Vec3 &emit, const double &shin)
 	{
@@ -112,6 +116,7 @@ public:
 		m_fScale = scale;
  	}
 
+#ifndef RX_HEADLESS
 	void SetGL(void)
 	{
 		GLfloat mat_diff[] = { (float)(m_fDiffS*m_vDiff[0]), (float)(m_fDiffS*m_vDiff[1]), (float)(m_fDiffS*m_vDiff[2]), (float)m_vDiff[3] };
@@ -141,6 +146,7 @@ public:
 
 		glColor4fv(mat_diff);
 	}
+#endif
 
 	// ANZX\bh
 	Vec4 GetDiff(void) const { return m_vDiff*m_fDiffS; }
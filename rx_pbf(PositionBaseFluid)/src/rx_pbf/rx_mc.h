@@ -22,8 +22,10 @@
 #include <cstdlib>
 
 // OpenGL
+#ifndef RX_HEADLESS
 #include <GL/glew.h>
 #include <GL/glut.h>
+#endif
 
 // STL
 #include <map>
@@ -34,6 +36,7 @@
 
 #include "rx_utility.h"
 #include "rx_mesh.h"
+#include "rx_sparse_grid.h"
 
 #include "rx_cu_common.cuh"
 
@@ -76,6 +79,29 @@ struct RxScalarField
 	Vec3 fMin;
 };
 
+//! zɕXuƂ̍Ɨ̈(GenerateSurface̕񉻗p)
+struct RxMCSlab
+{
+	uint z0, z1;				//!< SZz͈[z0,z1)
+	uint zv1;					//!< SObh_w͈̔[z0,zv1)(Ō̃Xuz1+1)
+	vector<int> edgeCache;		//!< S钸_w̃GbW̓l_̃Xuԍ(ȂGbW-1)
+	vector<Vec3> vertices;		//!< XuŐl_
+	vector<int> triangles;		//!< XuŐOp`(Ŝł̒_ԍ)
+	uint offset;				//!< Ŝł̒_ԍ̊Jnʒu
+};
+
+//! aȃubNObh̃ubNƂ̍Ɨ̈(GenerateSurfaceSparse̕񉻗p)
+struct RxMCBrick
+{
+	int origin[3];				//!< ubN̍ŏ̃Obh_̈ʒu
+	int neighbor[8];			//!< g+x,+y,+z̗אڃubÑCfbNX(rbg0,1,2x,y,z̃ItZbg,mۂȂ-1)
+	vector<RXREAL> field;		//!< אڃubN̒l܂߂(RX_BRICK_SIZE+1)^3̃Obh_̒l(lʂʂȂ΋)
+	vector<int> edgeCache;		//!< ubÑObh_LтGbW̓l_̃ubNԍ(ȂGbW-1)
+	vector<Vec3> vertices;		//!< ubNŐl_
+	vector<int> triangles;		//!< ubNŐOp`(Ŝł̒_ԍ)
+	uint offset;				//!< Ŝł̒_ԍ̊Jnʒu
+};
+
 
 //-----------------------------------------------------------------------------
 // rxMCMeshCPUNX
@@ -97,6 +123,10 @@ public:
 	bool CreateMeshV(RXREAL *field, Vec3 min_p, double h, int n[3], RXREAL threshold, 
 					 vector<Vec3> &vrts, vector<Vec3> &nrms, vector<rxFace> &face);
 
+	//! aȃubNObhOp`bV𐶐
+	bool CreateMeshSparse(const rxSparseBrickGrid &grid, RXREAL threshold, 
+						  vector<Vec3> &vrts, vector<Vec3> &nrms, vector<rxFace> &face);
+
 	//! Tv{[瓙lʃbV
 	void GenerateSurface(const RxScalarField sf, RXREAL *field, RXREAL threshold, 
 						 vector<Vec3> &vrts, vector<Vec3> &nrms, vector<int> &tris);
@@ -105,6 +135,10 @@ public:
 	void GenerateSurfaceV(const RxScalarField sf, RXREAL (*func)(double, double, double, void*), void* func_ptr, RXREAL threshold, 
 						  vector<Vec3> &vrts, vector<Vec3> &nrms, vector<int> &tris);
 
+	//! aȃubNObh瓙lʃbV(mۂꂽubÑZ)
+	void GenerateSurfaceSparse(const rxSparseBrickGrid &grid, RXREAL threshold, 
+							   vector<Vec3> &vrts, vector<Vec3> &nrms, vector<int> &tris);
+
 	//! ֐瓙lʃbV
 	void GenerateSurfaceF(const RxScalarField sf, RXREAL (*func)(double, double, double, void*), void* func_ptr, RXREAL threshold, 
 						  vector<Vec3> &vrts, vector<Vec3> &nrms, vector<int> &tris);
@@ -165,6 +199,14 @@ protected:
 	//! ObhGbW[̉A֐l^Ԃœl_vZ
 	RxVertexID Interpolate(double fX1, double fY1, double fZ1, double fX2, double fY2, double fZ2, RXREAL tVal1, RXREAL tVal2);
 
+	//! XuƂ̓l_COp`|S̐(Tv{[)
+	void CalculateSlabVertices(RxMCSlab &slab);
+	void CalculateSlabTriangles(vector<RxMCSlab> &slabs, int s);
+
+	//! ubNƂ̓l_COp`|S̐(aȃubNObh)
+	void CalculateBrickVertices(const rxSparseBrickGrid &grid, vector<RxMCBrick> &bricks, int b);
+	void CalculateBrickTriangles(vector<RxMCBrick> &bricks, int b);
+
 	//! _CbV􉽏o͌`Ŋi[
 	void RenameVerticesAndTriangles(vector<Vec3> &vrts, uint &nvrts, vector<int> &tris, uint &ntris);
 
@@ -271,7 +313,9 @@ public:
 	void Clean(void);
 
 	//! FBOɃf[^ݒ
+#ifndef RX_HEADLESS
 	bool SetDataToFBO(GLuint uVrtVBO, GLuint uNrmVBO, GLuint uTriVBO);
+#endif
 
 	//! zXgzɃf[^ݒ
 	bool SetDataToArray(vector<Vec3> &vrts, vector<Vec3> &nrms, vector<rxFace> &face);
@@ -357,7 +401,7 @@ public:
  * @param[out] nrms bV_@
  * @param[out] tris bV􉽏(_ڑ)
  */
-static void GenerateValueArray(RXREAL **field, RXREAL (*func)(void*, double, double, double), void* func_ptr, const RxScalarField sf)
+static inline void GenerateValueArray(RXREAL **field, RXREAL (*func)(void*, double, double, double), void* func_ptr, const RxScalarField sf)
 {
 	int nx, ny, nz;
 	nx = sf.iNum[0]+1;
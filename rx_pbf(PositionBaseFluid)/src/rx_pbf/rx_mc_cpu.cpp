@@ -17,6 +17,22 @@
 #include <math.h>
 #include "rx_mc.h"
 #include "rx_mc_tables.h"
+#include "rx_profiler.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// 萔
+//-----------------------------------------------------------------------------
+//! Z̃GbWԍ -> GbWObh_̃ZItZbg(x,y,z)ƃGbW̕
+static const uint RX_MC_EDGE_OFFSET[12][4] = {
+	{0, 0, 0, 1}, {0, 1, 0, 0}, {1, 0, 0, 1}, {0, 0, 0, 0}, 
+	{0, 0, 1, 1}, {0, 1, 1, 0}, {1, 0, 1, 1}, {0, 0, 1, 0}, 
+	{0, 0, 0, 2}, {0, 1, 0, 2}, {1, 1, 0, 2}, {1, 0, 0, 2}
+};
 
 
 
@@ -85,10 +101,8 @@ bool rxMCMeshCPU::CreateMesh(RXREAL (*func)(double, double, double, void*), void
 	GenerateSurfaceV(sf, func, func_ptr, threshold, vrts, nrms, tris);
 
 	if(IsSurfaceValid()){
-		int nv = (int)GetNumVertices();
 		int nm = (int)GetNumTriangles();
 		int nn = (int)GetNumNormals();
-		//cout << "mesh was created : " << nv << ", " << nm << ", " << nn << endl;
 
 		// @]
 		for(int i = 0; i < nn; ++i){
@@ -129,6 +143,7 @@ bool rxMCMeshCPU::CreateMesh(RXREAL (*func)(double, double, double, void*), void
 bool rxMCMeshCPU::CreateMeshV(RXREAL *field, Vec3 min_p, double h, int n[3], RXREAL threshold, 
 								  vector<Vec3> &vrts, vector<Vec3> &nrms, vector<rxFace> &face)
 {
+	RXPROF_ZONE("marching cubes");
 	if(field == NULL) return false;
 
 	RxScalarField sf;
@@ -142,10 +157,49 @@ bool rxMCMeshCPU::CreateMeshV(RXREAL *field, Vec3 min_p, double h, int n[3], RXR
 	GenerateSurface(sf, field, threshold, vrts, nrms, tris);
 
 	if(IsSurfaceValid()){
-		int nv = (int)GetNumVertices();
 		int nm = (int)GetNumTriangles();
 		int nn = (int)GetNumNormals();
-		//cout << "mesh was created : " << nv << ", " << nm << ", " << nn << endl;
+
+		// @]
+		for(int i = 0; i < nn; ++i){
+			nrms[i] *= -1.0;
+		}
+
+		face.resize(nm);
+		for(int i = 0; i < nm; ++i){
+			face[i].vert_idx.resize(3);
+			for(int j = 0; j < 3; ++j){
+				face[i][j] = tris[3*i+(2-j)];
+			}
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+
+/*!
+ * aȃubNObhOp`bV𐶐
+ * @param[in] grid aȃubNObh(Obh_CŏWC擾)
+ * @param[in] threshold l(A֐l̒l̂ƂbV)
+ * @param[out] vrts _W
+ * @param[out] nrms _@
+ * @param[out] tris bV
+ * @retval true  bV
+ * @retval false bVs
+ */
+bool rxMCMeshCPU::CreateMeshSparse(const rxSparseBrickGrid &grid, RXREAL threshold, 
+								   vector<Vec3> &vrts, vector<Vec3> &nrms, vector<rxFace> &face)
+{
+	RXPROF_ZONE("marching cubes");
+	vector<int> tris;
+	GenerateSurfaceSparse(grid, threshold, vrts, nrms, tris);
+
+	if(IsSurfaceValid()){
+		int nm = (int)GetNumTriangles();
+		int nn = (int)GetNumNormals();
 
 		// @]
 		for(int i = 0; i < nn; ++i){
@@ -169,6 +223,10 @@ bool rxMCMeshCPU::CreateMeshV(RXREAL *field, Vec3 min_p, double h, int n[3], RXR
 
 /*!
  * bV
+ *  - Obhz̃Xuɕĕɏ
+ *  - 1pXڂŊeXuS钸_w̃GbW̓l_߂ăXũGbWLbVɓo^C
+ *    2pXڂŃZƂɎOp`|S𐶐(XuẼZ͎̃XũLbVQ)
+ *  - _̓GbWIDC|S̓ZɕԂ̂ŁCGbWIDL[ƂmapgĂƂƓbVɂȂ
  * @param[in] sf Obh
  * @param[in] field Tv{[
  * @param[in] threshold 臒l
@@ -192,129 +250,390 @@ void rxMCMeshCPU::GenerateSurface(const RxScalarField sf, RXREAL *field, RXREAL
 	m_Grid.fMin = sf.fMin;
 	m_ptScalarField = field;
 
-	uint slice0 = (m_Grid.iNum[0] + 1);
-	uint slice1 = slice0*(m_Grid.iNum[1] + 1);
+	uint nz = m_Grid.iNum[2];
+	if(m_Grid.iNum[0] == 0 || m_Grid.iNum[1] == 0 || nz == 0){
+		vrts.clear(); nrms.clear(); tris.clear();
+		m_bValidSurface = true;
+		return;
+	}
+
+	// Xu(Xbh̐{ɂĕׂ𕪎U)
+	int ns = 1;
+#ifdef _OPENMP
+	ns = 4*omp_get_max_threads();
+#endif
+	if(ns > (int)nz) ns = (int)nz;
+
+	vector<RxMCSlab> slabs(ns);
+	for(int s = 0; s < ns; ++s){
+		slabs[s].z0 = (uint)(((long long)nz*s)/ns);
+		slabs[s].z1 = (uint)(((long long)nz*(s+1))/ns);
+		slabs[s].zv1 = (s == ns-1 ? nz+1 : slabs[s].z1);
+	}
+
+	// GbW̓l_̌vZ
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int s = 0; s < ns; ++s){
+		CalculateSlabVertices(slabs[s]);
+	}
+
+	// XuƂ̒_ԍ̊Jnʒu
+	uint nv = 0;
+	for(int s = 0; s < ns; ++s){
+		slabs[s].offset = nv;
+		nv += (uint)slabs[s].vertices.size();
+	}
 
-	// lʂ̐
-	for(uint z = 0; z < m_Grid.iNum[2]; ++z){
-		for(uint y = 0; y < m_Grid.iNum[1]; ++y){
-			for(uint x = 0; x < m_Grid.iNum[0]; ++x){
+	// Op`|S̐
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int s = 0; s < ns; ++s){
+		CalculateSlabTriangles(slabs, s);
+	}
+
+	// XuƂ̌ʂA
+	vector<uint> toffset(ns+1, 0);
+	for(int s = 0; s < ns; ++s){
+		toffset[s+1] = toffset[s]+(uint)slabs[s].triangles.size();
+	}
+	vrts.resize(nv);
+	tris.resize(toffset[ns]);
+
+	#pragma omp parallel for
+	for(int s = 0; s < ns; ++s){
+		const RxMCSlab &slab = slabs[s];
+		if(!slab.vertices.empty()) std::copy(slab.vertices.begin(), slab.vertices.end(), vrts.begin()+slab.offset);
+		if(!slab.triangles.empty()) std::copy(slab.triangles.begin(), slab.triangles.end(), tris.begin()+toffset[s]);
+	}
+
+	m_nVertices = nv;
+	m_nTriangles = toffset[ns]/3;
+
+	CalculateNormals(vrts, m_nVertices, tris, m_nTriangles, nrms, m_nNormals);
+
+	m_bValidSurface = true;
+}
+
+/*!
+ * XuS钸_w̃GbW̓l_vZ
+ *  - Obh_(x,y,z)+x,+y,+zɐLт3{̃GbW(GbWID3*_ID+0,1,2)S
+ *  - l_͌̎ōŏɓo^ĂZEGbWԍƓŕԂ(Wlv邽)
+ * @param[inout] slab Xu
+ */
+void rxMCMeshCPU::CalculateSlabVertices(RxMCSlab &slab)
+{
+	uint nx = m_Grid.iNum[0], ny = m_Grid.iNum[1], nz = m_Grid.iNum[2];
+	uint slice0 = nx+1;
+	uint slice1 = slice0*(ny+1);
+
+	slab.vertices.clear();
+	slab.edgeCache.assign(3*(slab.zv1-slab.z0)*slice1, -1);
+
+	const RXREAL *f = m_ptScalarField;
+	for(uint z = slab.z0; z < slab.zv1; ++z){
+		for(uint y = 0; y <= ny; ++y){
+			for(uint x = 0; x <= nx; ++x){
+				uint idx = z*slice1+y*slice0+x;
+				bool in0 = (f[idx] < m_tIsoLevel);
+				int *cache = &slab.edgeCache[3*((z-slab.z0)*slice1+y*slice0+x)];
+
+				// +x̃GbW(GbWԍ3,7,1,5)
+				if(x < nx && in0 != (f[idx+1] < m_tIsoLevel)){
+					uint e = (y < ny) ? (z < nz ? 3 : 7) : (z < nz ? 1 : 5);
+					RxVertexID pt = CalculateIntersection(x, (y < ny ? y : ny-1), (z < nz ? z : nz-1), e);
+					cache[0] = (int)slab.vertices.size();
+					slab.vertices.push_back(Vec3(pt.x, pt.y, pt.z));
+				}
+
+				// +ỹGbW(GbWԍ0,4,2,6)
+				if(y < ny && in0 != (f[idx+slice0] < m_tIsoLevel)){
+					uint e = (x < nx) ? (z < nz ? 0 : 4) : (z < nz ? 2 : 6);
+					RxVertexID pt = CalculateIntersection((x < nx ? x : nx-1), y, (z < nz ? z : nz-1), e);
+					cache[1] = (int)slab.vertices.size();
+					slab.vertices.push_back(Vec3(pt.x, pt.y, pt.z));
+				}
+
+				// +z̃GbW(GbWԍ8,9,11,10)
+				if(z < nz && in0 != (f[idx+slice1] < m_tIsoLevel)){
+					uint e = (x < nx) ? (y < ny ? 8 : 9) : (y < ny ? 11 : 10);
+					RxVertexID pt = CalculateIntersection((x < nx ? x : nx-1), (y < ny ? y : ny-1), z, e);
+					cache[2] = (int)slab.vertices.size();
+					slab.vertices.push_back(Vec3(pt.x, pt.y, pt.z));
+				}
+			}
+		}
+	}
+}
+
+/*!
+ * XũZ̎Op`|S𐶐
+ *  - Z(z+1)̒_wXu̒SOȂ玟̃XũGbWLbVQƂ
+ * @param[inout] slabs SXu(_ԍ̊JnʒuvZς)
+ * @param[in] s Xu
+ */
+void rxMCMeshCPU::CalculateSlabTriangles(vector<RxMCSlab> &slabs, int s)
+{
+	RxMCSlab &slab = slabs[s];
+	uint nx = m_Grid.iNum[0], ny = m_Grid.iNum[1];
+	uint slice0 = nx+1;
+	uint slice1 = slice0*(ny+1);
+
+	slab.triangles.clear();
+
+	const RXREAL *f = m_ptScalarField;
+	for(uint z = slab.z0; z < slab.z1; ++z){
+		for(uint y = 0; y < ny; ++y){
+			for(uint x = 0; x < nx; ++x){
 				// Obh̒_zue[uQƗpCfbNX̌vZ
+				uint idx = z*slice1+y*slice0+x;
 				uint tableIndex = 0;
-				if(m_ptScalarField[z*slice1 + y*slice0 + x] < m_tIsoLevel)
-					tableIndex |= 1;
-				if(m_ptScalarField[z*slice1 + (y+1)*slice0 + x] < m_tIsoLevel)
-					tableIndex |= 2;
-				if(m_ptScalarField[z*slice1 + (y+1)*slice0 + (x+1)] < m_tIsoLevel)
-					tableIndex |= 4;
-				if(m_ptScalarField[z*slice1 + y*slice0 + (x+1)] < m_tIsoLevel)
-					tableIndex |= 8;
-				if(m_ptScalarField[(z+1)*slice1 + y*slice0 + x] < m_tIsoLevel)
-					tableIndex |= 16;
-				if(m_ptScalarField[(z+1)*slice1 + (y+1)*slice0 + x] < m_tIsoLevel)
-					tableIndex |= 32;
-				if(m_ptScalarField[(z+1)*slice1 + (y+1)*slice0 + (x+1)] < m_tIsoLevel)
-					tableIndex |= 64;
-				if(m_ptScalarField[(z+1)*slice1 + y*slice0 + (x+1)] < m_tIsoLevel)
-					tableIndex |= 128;
-
-				if(edgeTable[tableIndex] != 0){
-					// GbW̒_Zo
-					if(edgeTable[tableIndex] & 8){
-						RxVertexID pt = CalculateIntersection(x, y, z, 3);
-						uint id = GetEdgeID(x, y, z, 3);
-						m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-					}
-					if(edgeTable[tableIndex] & 1){
-						RxVertexID pt = CalculateIntersection(x, y, z, 0);
-						uint id = GetEdgeID(x, y, z, 0);
-						m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-					}
-					if(edgeTable[tableIndex] & 256){
-						RxVertexID pt = CalculateIntersection(x, y, z, 8);
-						uint id = GetEdgeID(x, y, z, 8);
-						m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-					}
-					
-					if(x == m_Grid.iNum[0] - 1){
-						if(edgeTable[tableIndex] & 4){
-							RxVertexID pt = CalculateIntersection(x, y, z, 2);
-							uint id = GetEdgeID(x, y, z, 2);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-						if(edgeTable[tableIndex] & 2048){
-							RxVertexID pt = CalculateIntersection(x, y, z, 11);
-							uint id = GetEdgeID(x, y, z, 11);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-					}
-					if(y == m_Grid.iNum[1] - 1){
-						if(edgeTable[tableIndex] & 2){
-							RxVertexID pt = CalculateIntersection(x, y, z, 1);
-							uint id = GetEdgeID(x, y, z, 1);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-						if(edgeTable[tableIndex] & 512){
-							RxVertexID pt = CalculateIntersection(x, y, z, 9);
-							uint id = GetEdgeID(x, y, z, 9);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-					}
-					if(z == m_Grid.iNum[2] - 1){
-						if(edgeTable[tableIndex] & 16){
-							RxVertexID pt = CalculateIntersection(x, y, z, 4);
-							uint id = GetEdgeID(x, y, z, 4);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-						if(edgeTable[tableIndex] & 128){
-							RxVertexID pt = CalculateIntersection(x, y, z, 7);
-							uint id = GetEdgeID(x, y, z, 7);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-					}
-					if((x==m_Grid.iNum[0] - 1) && (y==m_Grid.iNum[1] - 1))
-						if(edgeTable[tableIndex] & 1024){
-							RxVertexID pt = CalculateIntersection(x, y, z, 10);
-							uint id = GetEdgeID(x, y, z, 10);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-					if((x==m_Grid.iNum[0] - 1) && (z==m_Grid.iNum[2] - 1))
-						if(edgeTable[tableIndex] & 64){
-							RxVertexID pt = CalculateIntersection(x, y, z, 6);
-							uint id = GetEdgeID(x, y, z, 6);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-					if((y==m_Grid.iNum[1] - 1) && (z==m_Grid.iNum[2] - 1))
-						if(edgeTable[tableIndex] & 32){
-							RxVertexID pt = CalculateIntersection(x, y, z, 5);
-							uint id = GetEdgeID(x, y, z, 5);
-							m_i2pt3idVertices.insert(ID2VertexID::value_type(id, pt));
-						}
-					
-					// |S
-					for(uint i = 0; triTable[tableIndex][i] != 255; i += 3){
-						RxTriangle triangle;
-						uint pointID0, pointID1, pointID2;
-						pointID0 = GetEdgeID(x, y, z, triTable[tableIndex][i]);
-						pointID1 = GetEdgeID(x, y, z, triTable[tableIndex][i+1]);
-						pointID2 = GetEdgeID(x, y, z, triTable[tableIndex][i+2]);
-						triangle.pointID[0] = pointID0;
-						triangle.pointID[1] = pointID1;
-						triangle.pointID[2] = pointID2;
-						m_trivecTriangles.push_back(triangle);
-					}
+				if(f[idx] < m_tIsoLevel)						tableIndex |= 1;
+				if(f[idx+slice0] < m_tIsoLevel)					tableIndex |= 2;
+				if(f[idx+slice0+1] < m_tIsoLevel)				tableIndex |= 4;
+				if(f[idx+1] < m_tIsoLevel)						tableIndex |= 8;
+				if(f[idx+slice1] < m_tIsoLevel)					tableIndex |= 16;
+				if(f[idx+slice1+slice0] < m_tIsoLevel)			tableIndex |= 32;
+				if(f[idx+slice1+slice0+1] < m_tIsoLevel)		tableIndex |= 64;
+				if(f[idx+slice1+1] < m_tIsoLevel)				tableIndex |= 128;
+
+				if(edgeTable[tableIndex] == 0) continue;
+
+				// |S
+				for(uint i = 0; triTable[tableIndex][i] != 255; ++i){
+					const uint *eo = RX_MC_EDGE_OFFSET[triTable[tableIndex][i]];
+					uint vz = z+eo[2];
+					const RxMCSlab &vs = (vz < slab.zv1 ? slab : slabs[s+1]);
+					int id = vs.edgeCache[3*((vz-vs.z0)*slice1+(y+eo[1])*slice0+(x+eo[0]))+eo[3]];
+					slab.triangles.push_back((int)vs.offset+id);
 				}
 			}
 		}
 	}
+}
+
+/*!
+ * aȃubNObh瓙lʃbV
+ *  - mۂꂽubNƂɕɏ(mۂ̃ubÑObh_̒l0Ȃ̂ŁC臒l͐ł邱)
+ *  - 1pXڂŊeubNאڃubN̒l܂߂(B+1)^3̃Obh_̒lW߁C
+ *    ubÑObh_LтGbW̓l_߂(lʂʂȂubN͂ŏO)
+ *  - 2pXڂŃZƂɎOp`|S𐶐(ubNẼGbW͗אڃubÑLbVQ)
+ * @param[in] grid aȃubNObh
+ * @param[in] threshold 臒l
+ * @param[out] vrts bV_
+ * @param[out] nrms bV_@
+ * @param[out] tris bV􉽏(_ڑ)
+ */
+void rxMCMeshCPU::GenerateSurfaceSparse(const rxSparseBrickGrid &grid, RXREAL threshold, 
+										vector<Vec3> &vrts, vector<Vec3> &nrms, vector<int> &tris)
+{
+	if(m_bValidSurface){
+		DeleteSurface();
+	}
 
+	m_tIsoLevel = threshold;
+	for(int l = 0; l < 3; ++l){
+		m_Grid.iNum[l] = (grid.GetN(l) > 0 ? grid.GetN(l)-1 : 0);
+	}
+	m_Grid.fWidth = grid.GetDim();
+	m_Grid.fMin = grid.GetMin();
+	m_ptScalarField = NULL;
+
+	int nb = grid.GetNumBricks();
+	if(m_Grid.iNum[0] == 0 || m_Grid.iNum[1] == 0 || m_Grid.iNum[2] == 0 || nb == 0){
+		vrts.clear(); nrms.clear(); tris.clear();
+		m_bValidSurface = true;
+		return;
+	}
+
+	vector<RxMCBrick> bricks(nb);
+
+	// GbW̓l_̌vZ
+	#pragma omp parallel for schedule(dynamic, 4)
+	for(int b = 0; b < nb; ++b){
+		CalculateBrickVertices(grid, bricks, b);
+	}
+
+	// ubNƂ̒_ԍ̊Jnʒu
+	uint nv = 0;
+	for(int b = 0; b < nb; ++b){
+		bricks[b].offset = nv;
+		nv += (uint)bricks[b].vertices.size();
+	}
+
+	// Op`|S̐
+	#pragma omp parallel for schedule(dynamic, 4)
+	for(int b = 0; b < nb; ++b){
+		CalculateBrickTriangles(bricks, b);
+	}
+
+	// ubNƂ̌ʂA
+	vector<uint> toffset(nb+1, 0);
+	for(int b = 0; b < nb; ++b){
+		toffset[b+1] = toffset[b]+(uint)bricks[b].triangles.size();
+	}
+	vrts.resize(nv);
+	tris.resize(toffset[nb]);
+
+	#pragma omp parallel for
+	for(int b = 0; b < nb; ++b){
+		const RxMCBrick &brick = bricks[b];
+		if(!brick.vertices.empty()) std::copy(brick.vertices.begin(), brick.vertices.end(), vrts.begin()+brick.offset);
+		if(!brick.triangles.empty()) std::copy(brick.triangles.begin(), brick.triangles.end(), tris.begin()+toffset[b]);
+	}
+
+	m_nVertices = nv;
+	m_nTriangles = toffset[nb]/3;
 
-	RenameVerticesAndTriangles(vrts, m_nVertices, tris, m_nTriangles);
 	CalculateNormals(vrts, m_nVertices, tris, m_nTriangles, nrms, m_nNormals);
 
 	m_bValidSurface = true;
 }
 
+/*!
+ * ubÑObh_LтGbW̓l_vZ
+ *  - Ԃ̌CalculateSlabVerticesƓɂ(ȃObhƓWlɂȂ悤)
+ * @param[in] grid aȃubNObh
+ * @param[inout] bricks SubN̍Ɨ̈
+ * @param[in] b ubN
+ */
+void rxMCMeshCPU::CalculateBrickVertices(const rxSparseBrickGrid &grid, vector<RxMCBrick> &bricks, int b)
+{
+	const int B = RX_BRICK_SIZE;
+	const int S = RX_BRICK_SIZE+1;
+	RxMCBrick &brick = bricks[b];
+	brick.vertices.clear();
+
+	const int *bc = grid.GetBrickCoord(b);
+	for(int l = 0; l < 3; ++l) brick.origin[l] = bc[l]*B;
+
+	const RXREAL *data[8];
+	for(int o = 0; o < 8; ++o){
+		brick.neighbor[o] = grid.FindBrick(bc[0]+(o & 1), bc[1]+((o >> 1) & 1), bc[2]+((o >> 2) & 1));
+		data[o] = (brick.neighbor[o] >= 0 ? grid.GetBrickData(brick.neighbor[o]) : 0);
+	}
+
+	// אڃubN܂߂Obh_̒lW߂
+	brick.field.resize(S*S*S);
+	int nin = 0;
+	for(int z = 0; z < S; ++z){
+		for(int y = 0; y < S; ++y){
+			for(int x = 0; x < S; ++x){
+				int o = (x/B)|((y/B) << 1)|((z/B) << 2);
+				RXREAL val = (data[o] ? data[o][rxSparseBrickGrid::NodeIndex(x%B, y%B, z%B)] : (RXREAL)0);
+				brick.field[(z*S+y)*S+x] = val;
+				if(val < m_tIsoLevel) nin++;
+			}
+		}
+	}
+
+	// lʂʂȂubN
+	if(nin == 0 || nin == S*S*S){
+		vector<RXREAL>().swap(brick.field);
+		return;
+	}
+
+	int nx = (int)m_Grid.iNum[0], ny = (int)m_Grid.iNum[1], nz = (int)m_Grid.iNum[2];
+	int ox = brick.origin[0], oy = brick.origin[1], oz = brick.origin[2];
+	brick.edgeCache.assign(3*RX_BRICK_NODES, -1);
+
+	const RXREAL *f = &brick.field[0];
+	for(int z = 0; z < B && oz+z <= nz; ++z){
+		for(int y = 0; y < B && oy+y <= ny; ++y){
+			for(int x = 0; x < B && ox+x <= nx; ++x){
+				int idx = (z*S+y)*S+x;
+				RXREAL f0 = f[idx];
+				bool in0 = (f0 < m_tIsoLevel);
+				int *cache = &brick.edgeCache[3*rxSparseBrickGrid::NodeIndex(x, y, z)];
+				Vec3 p0 = m_Grid.fMin+Vec3(ox+x, oy+y, oz+z)*m_Grid.fWidth;
+
+				// +x̃GbW(Z̃GbWԍ3,7Ȃ+x̒_)
+				if(ox+x < nx && in0 != (f[idx+1] < m_tIsoLevel)){
+					Vec3 p1 = p0+Vec3(m_Grid.fWidth[0], 0.0, 0.0);
+					RxVertexID pt = (oy+y < ny) ? Interpolate(p1[0], p1[1], p1[2], p0[0], p0[1], p0[2], f[idx+1], f0)
+												: Interpolate(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2], f0, f[idx+1]);
+					cache[0] = (int)brick.vertices.size();
+					brick.vertices.push_back(Vec3(pt.x, pt.y, pt.z));
+				}
+
+				// +ỹGbW(Z̃GbWԍ2,6Ȃ+y̒_)
+				if(oy+y < ny && in0 != (f[idx+S] < m_tIsoLevel)){
+					Vec3 p1 = p0+Vec3(0.0, m_Grid.fWidth[1], 0.0);
+					RxVertexID pt = (ox+x < nx) ? Interpolate(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2], f0, f[idx+S])
+												: Interpolate(p1[0], p1[1], p1[2], p0[0], p0[1], p0[2], f[idx+S], f0);
+					cache[1] = (int)brick.vertices.size();
+					brick.vertices.push_back(Vec3(pt.x, pt.y, pt.z));
+				}
+
+				// +z̃GbW
+				if(oz+z < nz && in0 != (f[idx+S*S] < m_tIsoLevel)){
+					Vec3 p1 = p0+Vec3(0.0, 0.0, m_Grid.fWidth[2]);
+					RxVertexID pt = Interpolate(p0[0], p0[1], p0[2], p1[0], p1[1], p1[2], f0, f[idx+S*S]);
+					cache[2] = (int)brick.vertices.size();
+					brick.vertices.push_back(Vec3(pt.x, pt.y, pt.z));
+				}
+			}
+		}
+	}
+}
+
+/*!
+ * ubÑZ̎Op`|S𐶐
+ *  - GbWObh_אڃubNɂ΂̃ubÑGbWLbVQƂ
+ * @param[inout] bricks SubN̍Ɨ̈(_ԍ̊JnʒuvZς)
+ * @param[in] b ubN
+ */
+void rxMCMeshCPU::CalculateBrickTriangles(vector<RxMCBrick> &bricks, int b)
+{
+	const int B = RX_BRICK_SIZE;
+	const int S = RX_BRICK_SIZE+1;
+	RxMCBrick &brick = bricks[b];
+	brick.triangles.clear();
+	if(brick.field.empty()) return;
+
+	// ubNŏZ(Obh̒[̃ubNł͏ȂȂ)
+	int nc[3];
+	for(int l = 0; l < 3; ++l){
+		nc[l] = RX_MIN(B, (int)m_Grid.iNum[l]-brick.origin[l]);
+	}
+
+	const RXREAL *f = &brick.field[0];
+	for(int z = 0; z < nc[2]; ++z){
+		for(int y = 0; y < nc[1]; ++y){
+			for(int x = 0; x < nc[0]; ++x){
+				// Obh̒_zue[uQƗpCfbNX̌vZ
+				int idx = (z*S+y)*S+x;
+				uint tableIndex = 0;
+				if(f[idx] < m_tIsoLevel)				tableIndex |= 1;
+				if(f[idx+S] < m_tIsoLevel)				tableIndex |= 2;
+				if(f[idx+S+1] < m_tIsoLevel)			tableIndex |= 4;
+				if(f[idx+1] < m_tIsoLevel)				tableIndex |= 8;
+				if(f[idx+S*S] < m_tIsoLevel)			tableIndex |= 16;
+				if(f[idx+S*S+S] < m_tIsoLevel)			tableIndex |= 32;
+				if(f[idx+S*S+S+1] < m_tIsoLevel)		tableIndex |= 64;
+				if(f[idx+S*S+1] < m_tIsoLevel)			tableIndex |= 128;
+
+				if(edgeTable[tableIndex] == 0) continue;
+
+				// |S
+				//  - l_ubNmۂĂȂ(SplatParticles̃n[̊O)Z͔΂
+				int ntv = 0;
+				int tv[15];
+				for(uint i = 0; triTable[tableIndex][i] != 255; ++i){
+					const uint *eo = RX_MC_EDGE_OFFSET[triTable[tableIndex][i]];
+					int vx = x+eo[0], vy = y+eo[1], vz = z+eo[2];
+					int nb = brick.neighbor[(vx/B)|((vy/B) << 1)|((vz/B) << 2)];
+					if(nb < 0 || bricks[nb].edgeCache.empty()) break;
+					const RxMCBrick &vb = bricks[nb];
+					int id = vb.edgeCache[3*rxSparseBrickGrid::NodeIndex(vx%B, vy%B, vz%B)+eo[3]];
+					if(id < 0) break;
+					tv[ntv++] = (int)vb.offset+id;
+				}
+				if(triTable[tableIndex][ntv] != 255) continue;
+				brick.triangles.insert(brick.triangles.end(), tv, tv+ntv);
+			}
+		}
+	}
+}
+
 /*!
  * bV(Tv{[쐬)
  * @param[in] sf Obh
@@ -335,7 +654,9 @@ void rxMCMeshCPU::GenerateSurfaceV(const RxScalarField sf, RXREAL (*func)(double
 	Vec3 minp = sf.fMin;
 	Vec3 d = sf.fWidth;
 
+	// TvO(func͕Xbh瓯ɌĂ΂)
 	RXREAL *field = new RXREAL[nx*ny*nz];
+	#pragma omp parallel for schedule(dynamic, 1)
 	for(int k = 0; k < nz; ++k){
 		for(int j = 0; j < ny; ++j){
 			for(int i = 0; i < nx; ++i){
@@ -378,9 +699,6 @@ void rxMCMeshCPU::GenerateSurfaceF(const RxScalarField sf, RXREAL (*func)(double
 	m_fpScalarFunc = func;
 	m_pScalarFuncPtr = func_ptr;
 
-	uint slice0 = (m_Grid.iNum[0] + 1);
-	uint slice1 = slice0*(m_Grid.iNum[1] + 1);
-
 	double dx = m_Grid.fWidth[0];
 	double dy = m_Grid.fWidth[1];
 	double dz = m_Grid.fWidth[2];
@@ -19,12 +19,18 @@
 
 #include <algorithm>
 
+#ifndef RX_HEADLESS
 #include <GL/glut.h>
+#endif
 #include <vector>
 #include <set>
 
 #include "rx_pcube.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 using namespace std;
 
@@ -34,6 +40,9 @@ typedef unsigned int uint;
 	#define RXREAL float
 #endif
 
+//! \[g1pXňőrbg
+#define RX_NN_RADIX_BITS 11
+
 
 //-----------------------------------------------------------------------------
 //! nbVlɂ\[gp̍\
@@ -66,6 +75,49 @@ struct rxNeigh
 };
 
 
+//-----------------------------------------------------------------------------
+//! Sp[eBN̋ߖTXg(CSR`)
+//  - ep[eBN̋ߖT1̘Azɂ܂Ƃ߂Ċi[
+//  - č\z͊mۍς݂̃̂܂܍ėp
+//-----------------------------------------------------------------------------
+struct rxNeighList
+{
+	vector<uint> Offset;				//!< ep[eBN̋ߖT̊Jnʒu(p[eBN+1)
+	vector<rxNeigh> Neighs;				//!< Sp[eBN̋ߖT
+	vector< vector<rxNeigh> > Buf;		//!< \z̕ubNƂ̈ꎞobt@
+
+	//! p[eBN
+	int Size(void) const { return Offset.empty() ? 0 : (int)Offset.size()-1; }
+
+	//! p[eBNi̋ߖT
+	int Num(int i) const { return (int)(Offset[i+1]-Offset[i]); }
+
+	//! p[eBNi̋ߖT̐擪ƏI[
+	rxNeigh* Begin(int i){ return Neighs.empty() ? 0 : &Neighs[0]+Offset[i]; }
+	rxNeigh* End(int i){ return Neighs.empty() ? 0 : &Neighs[0]+Offset[i+1]; }
+	const rxNeigh* Begin(int i) const { return Neighs.empty() ? 0 : &Neighs[0]+Offset[i]; }
+	const rxNeigh* End(int i) const { return Neighs.empty() ? 0 : &Neighs[0]+Offset[i+1]; }
+
+	//! p[eBNijԖڂ̋ߖT
+	rxNeigh& At(int i, int j){ return Neighs[Offset[i]+j]; }
+
+	//! ߖT̃NA(͉Ȃ)
+	void Clear(void)
+	{
+		Offset.assign(1, 0);
+		Neighs.clear();
+	}
+
+	//! mۍς݃܂߂ĉ
+	void Release(void)
+	{
+		vector<uint>().swap(Offset);
+		vector<rxNeigh>().swap(Neighs);
+		vector< vector<rxNeigh> >().swap(Buf);
+	}
+};
+
+
 //-----------------------------------------------------------------------------
 //! rxNNGridNX - Obh@ɂߖTT(3D)
 //-----------------------------------------------------------------------------
@@ -78,6 +130,8 @@ public:
 		//uint* hSortedIndex;			//!< nbVlŃ\[gp[eBNCfbNX
 		//uint* hGridParticleHash;	//!< ep[eBÑObhnbVl
 		rxHashSort* hSortedIndex;
+		rxHashSort* hSortTmp;		//!< \[gp̍Ɨ̈
+		RXREAL* hSortedPos;			//!< \[gɕׂp[eBNW(xyz)
 		uint* hCellStart;			//!< \[gXg̊eZ̃X^[gCfbNX
 		uint* hCellEnd;				//!< \[gXg̊eZ̃GhCfbNX
 		uint  uNumCells;			//!< Z
@@ -102,12 +156,20 @@ protected:
 
 	int m_iSorted;					//!< xł\[gꂽǂ̃tO
 
+	const RXREAL *m_pSortedSrc;		//!< hSortedPos̃Rs[̍Wz
+	uint m_uNumSorted;				//!< O\[gp[eBN
+	vector<uint> m_vRadixCount;		//!< \[g̃ubNƂ̃qXgO
+
+	vector< vector<uint> > m_vPolyCells;	//!< e|SdȂ镪Z̃nbV(ꕔ̃|So^ƂɎg)
+
 public:
 	//! ftHgRXgN^
 	rxNNGrid(int dim) : m_iDim(dim)
 	{
 		m_hCellData.uNumCells = 0;
 		m_hCellData.hSortedIndex = 0;
+		m_hCellData.hSortTmp = 0;
+		m_hCellData.hSortedPos = 0;
 		//m_hCellData.hGridParticleHash = 0;
 		m_hCellData.hCellStart = 0;
 		m_hCellData.hCellEnd = 0;
@@ -119,12 +181,16 @@ public:
 		m_hCellData.uNumPolyHash = 0;
 
 		m_iSorted = 0;
+		m_pSortedSrc = 0;
+		m_uNumSorted = 0;
 	}
 
 	//! fXgN^
 	~rxNNGrid()
 	{
 		if(m_hCellData.hSortedIndex) delete [] m_hCellData.hSortedIndex;
+		if(m_hCellData.hSortTmp) delete [] m_hCellData.hSortTmp;
+		if(m_hCellData.hSortedPos) delete [] m_hCellData.hSortedPos;
 		//if(m_hCellData.hGridParticleHash) delete [] m_hCellData.hGridParticleHash;
 		if(m_hCellData.hCellStart) delete [] m_hCellData.hCellStart;
 		if(m_hCellData.hCellEnd) delete [] m_hCellData.hCellEnd;
@@ -142,13 +208,16 @@ public:
 	// Zփp[eBNi[
 	void SetObjectToCell(RXREAL *p, uint n);
 	void SetObjectToCellV(Vec3 *p, uint n);
+	void UpdateObjectToCell(RXREAL *p, uint n, const unsigned char *moved);
 
 	// Zփ|Si[
 	void SetPolygonsToCell(RXREAL *vrts, int nv, int* tris, int nt);
+	void UpdatePolygonsInCell(RXREAL *vrts, int nv, int* tris, int nt, int start, int num);
 
 	// ߖT擾
 	void GetNN_Direct(Vec3 pos, RXREAL *p, uint n, vector<rxNeigh> &neighs, RXREAL h = -1.0);
 	void GetNN(Vec3 pos, RXREAL *p, uint n, vector<rxNeigh> &neighs, RXREAL h = -1.0);
+	void GetNNList(RXREAL *p, uint n, rxNeighList &nl, RXREAL h = -1.0);
 	void GetNNV(Vec3 pos, Vec3 *p, uint n, vector<rxNeigh> &neighs, RXREAL h = -1.0);
 
 	// Z̃|S擾
@@ -158,20 +227,43 @@ public:
 	bool IsPolygonsInCell(int gi, int gj, int gk);
 
 	// OpenGL`
+#ifndef RX_HEADLESS
 	void DrawCell(int i, int j, int k);
 	void DrawCells(Vec3 col, Vec3 col2, int sel = 0, RXREAL *p = 0);
 	void DrawCellsV(Vec3 col, Vec3 col2, int sel = 0, Vec3 *p = 0);
+#endif
 
 	// ObhnbV̌vZ
 	uint CalGridHash(int x, int y, int z);
 	uint CalGridHash(Vec3 pos);
 
+	// Z͈̔
+	void CalCellBounds(uint grid_hash, Vec3 &minp, Vec3 &maxp);
+
+	// ߖTTŒׂ镪Z
+	int GetNeighborCells(Vec3 pos, RXREAL h, vector<uint> &cells);
+
 public:
 	rxCell& GetCellData(void){ return m_hCellData; }
 
+	// Õ\[g(Z̕т͂̏ԂɈˑ̂ŁC`FbN|CgĊJƂɖ߂)
+	void GetSortedOrder(vector<uint> &order) const;
+	void SetSortedOrder(const vector<uint> &order);
+
 protected:
+	// ObhnbVɂ\[gƃZ͈͂̌
+	void sortByHash(uint n);
+	void findCellStart(uint n);
+
+	// |SƏdȂŽƃZƂ̃|SXg̍쐬
+	void calPolygonCells(const RXREAL *vrts, const int *tris, int i, vector<uint> &cells);
+	void buildPolygonCells(void);
+
+
 	// ZߖTp[eBN擾
 	void getNeighborsInCell(Vec3 pos, RXREAL *p, int gi, int gj, int gk, vector<rxNeigh> &neighs, RXREAL h);
+	void getNNSorted(Vec3 pos, vector<rxNeigh> &neighs, RXREAL h);
+	void getNeighborsInCellSorted(Vec3 pos, int gi, int gj, int gk, vector<rxNeigh> &neighs, RXREAL h);
 	void getNeighborsInCellV(Vec3 pos, Vec3 *p, int gi, int gj, int gk, vector<rxNeigh> &neighs, RXREAL h);
 };
 
@@ -218,13 +310,22 @@ inline void rxNNGrid::Setup(Vec3 vMin, Vec3 vMax, double h, int n)
 	cout << "  width  : " << m_fCellWidth[0] << "x" << m_fCellWidth[1] << endl;
 
 	// Obh\̂̔zm
+	if(m_hCellData.hSortedIndex) delete [] m_hCellData.hSortedIndex;
+	if(m_hCellData.hSortTmp) delete [] m_hCellData.hSortTmp;
+	if(m_hCellData.hSortedPos) delete [] m_hCellData.hSortedPos;
+	if(m_hCellData.hCellStart) delete [] m_hCellData.hCellStart;
+	if(m_hCellData.hCellEnd) delete [] m_hCellData.hCellEnd;
+	if(m_hCellData.hPolyCellStart) delete [] m_hCellData.hPolyCellStart;
+	if(m_hCellData.hPolyCellEnd) delete [] m_hCellData.hPolyCellEnd;
+
 	m_hCellData.hSortedIndex = new rxHashSort[n];
+	m_hCellData.hSortTmp = new rxHashSort[n];
+	m_hCellData.hSortedPos = new RXREAL[3*n];
 	//m_hCellData.hSortedIndex = new uint[n];
 	//m_hCellData.hGridParticleHash = new uint[n];
 	m_hCellData.hCellStart = new uint[m_hCellData.uNumCells];
 	m_hCellData.hCellEnd = new uint[m_hCellData.uNumCells];
 
-	int mem_size1 = n*sizeof(uint);
 	int mem_size2 = m_hCellData.uNumCells*sizeof(uint);
 	memset(m_hCellData.hSortedIndex, 0, n*sizeof(rxHashSort));
 	//memset(m_hCellData.hGridParticleHash, 0, mem_size1);
@@ -236,105 +337,68 @@ inline void rxNNGrid::Setup(Vec3 vMin, Vec3 vMax, double h, int n)
 
 	memset(m_hCellData.hPolyCellStart, 0xffffffff, mem_size2);
 	memset(m_hCellData.hPolyCellEnd, 0, mem_size2);
+	m_vPolyCells.clear();
 
 	m_iSorted = 0;
+	m_pSortedSrc = 0;
+	m_uNumSorted = 0;
 }
 
 /*!
  * p[eBN𕪊ZɊi[
  *  - p[eBN̑ObhnbVvZĊi[
+ *  - nbVl̊\[g()ŕׂ̂ŁCZ̏Ԃ͑Õ\[gۂ
+ *  - \[gɕׂW̃Rs[ĂCGetNNListł͂Aɓǂ
  * @param[in] p i[Sp[eBN̍WLqz
  * @param[in] n p[eBN
  */
 inline void rxNNGrid::SetObjectToCell(RXREAL *p, uint n)
 {
-	int mem_size1 = n*sizeof(uint);
 	int mem_size2 = m_hCellData.uNumCells*sizeof(uint);
-	//if(!m_iSorted) memset(m_hCellData.hSortedIndex, 0, mem_size1);
-	if(!m_iSorted) memset(m_hCellData.hSortedIndex, 0, n*sizeof(rxHashSort));
-	//memset(m_hCellData.hGridParticleHash, 0, mem_size1);
 	memset(m_hCellData.hCellStart, 0xffffffff, mem_size2);
 	memset(m_hCellData.hCellEnd, 0xffffffff, mem_size2);
 
+	m_pSortedSrc = 0;
 	if(n == 0) return;
 
-	if(m_iSorted){
-		// ep[eBÑObhnbV̌vZ
-		for(uint ip = 0; ip < n; ++ip){
-			int i = m_hCellData.hSortedIndex[ip].value;
-			Vec3 pos;
-			pos[0] = p[m_iDim*i+0];
-			pos[1] = p[m_iDim*i+1];
-			pos[2] = p[m_iDim*i+2];
-
-			// nbVlvZ
-			uint hash = CalGridHash(pos);
-			m_hCellData.hSortedIndex[ip].hash = hash;
-			//m_hCellData.hGridParticleHash[ip] = hash;
-		}
-	}
-	else{
-		// ep[eBÑObhnbV̌vZ
-		for(uint i = 0; i < n; ++i){
-			Vec3 pos;
-			pos[0] = p[m_iDim*i+0];
-			pos[1] = p[m_iDim*i+1];
-			pos[2] = p[m_iDim*i+2];
-
-			// nbVlvZ
-			uint hash = CalGridHash(pos);
-
-			m_hCellData.hSortedIndex[i].value = i;
-			m_hCellData.hSortedIndex[i].hash = hash;
-			//m_hCellData.hSortedIndex[i] = i;
-			//m_hCellData.hGridParticleHash[i] = hash;
-		}
+	// ep[eBÑObhnbV̌vZ
+	//  - 2ڈȍ~͑Õ\[gɂǂ邱ƂōWzւ̃ANZXǏ
+	//  - p[eBNςƂ͑ȌԂ͎gȂ̂ōŏ
+	rxHashSort *hs = m_hCellData.hSortedIndex;
+	int sorted = (m_iSorted && n == m_uNumSorted);
+	#pragma omp parallel for
+	for(int ip = 0; ip < (int)n; ++ip){
+		int i = (sorted ? (int)hs[ip].value : ip);
+
+		Vec3 pos;
+		pos[0] = p[m_iDim*i+0];
+		pos[1] = p[m_iDim*i+1];
+		pos[2] = p[m_iDim*i+2];
+
+		hs[ip].value = i;
+		hs[ip].hash = CalGridHash(pos);
 	}
 
 	// ObhnbVŃ\[g
-	//vector<rxHashSort> hash_and_value;
-	//hash_and_value.resize(n);
-	//for(uint i = 0; i < n; ++i){
-	//	//hash_and_value[i].hash = m_hCellData.hGridParticleHash[i];
-	//	//hash_and_value[i].value  = m_hCellData.hSortedIndex[i];
-	//	hash_and_value[i]  = m_hCellData.hSortedIndex[i];
-	//}
-	//std::sort(hash_and_value.begin(), hash_and_value.end(), LessHash);
-	//for(uint i = 0; i < n; ++i){
-	//	//m_hCellData.hSortedIndex[i] = hash_and_value[i].value;
-	//	//m_hCellData.hGridParticleHash[i] = hash_and_value[i].hash;
-	//	m_hCellData.hSortedIndex[i] = hash_and_value[i];
-	//}
-	std::sort(m_hCellData.hSortedIndex, m_hCellData.hSortedIndex+n, LessHash);
+	sortByHash(n);
 
 	m_iSorted = 1;
+	m_uNumSorted = n;
 
-	// p[eBNz\[gꂽԂɕёւC
 	// eZ̎n܂ƏĨCfbNX
-	for(uint i = 0; i < n; i++){
-		//int hash = m_hCellData.hGridParticleHash[i];
-		int hash = m_hCellData.hSortedIndex[i].hash;
-
-		if(i == 0){
-			m_hCellData.hCellStart[hash] = i;
-			m_hCellData.hCellEnd[hash] = i;
-		}
-		else{
-			//int prev_hash = m_hCellData.hGridParticleHash[i-1];
-			int prev_hash = m_hCellData.hSortedIndex[i-1].hash;
-
-			if(i == 0 || hash != prev_hash){
-				m_hCellData.hCellStart[hash] = i;
-				if(i > 0){
-					m_hCellData.hCellEnd[prev_hash] = i;
-				}
-			}
-
-			if(i == n-1){
-				m_hCellData.hCellEnd[hash] = i+1;
-			}
-		}
+	findCellStart(n);
+
+	// W\[gꂽԂɕёւăRs[
+	hs = m_hCellData.hSortedIndex;
+	RXREAL *sp = m_hCellData.hSortedPos;
+	#pragma omp parallel for
+	for(int ip = 0; ip < (int)n; ++ip){
+		uint i = hs[ip].value;
+		sp[3*ip+0] = p[m_iDim*i+0];
+		sp[3*ip+1] = p[m_iDim*i+1];
+		sp[3*ip+2] = p[m_iDim*i+2];
 	}
+	m_pSortedSrc = p;
 }
 
 /*!
@@ -345,89 +409,227 @@ inline void rxNNGrid::SetObjectToCell(RXREAL *p, uint n)
  */
 inline void rxNNGrid::SetObjectToCellV(Vec3 *p, uint n)
 {
-	int mem_size1 = n*sizeof(uint);
 	int mem_size2 = m_hCellData.uNumCells*sizeof(uint);
-	//if(!m_iSorted) memset(m_hCellData.hSortedIndex, 0, mem_size1);
-	if(!m_iSorted) memset(m_hCellData.hSortedIndex, 0, n*sizeof(rxHashSort));
-	//memset(m_hCellData.hGridParticleHash, 0, mem_size1);
 	memset(m_hCellData.hCellStart, 0xffffffff, mem_size2);
 	memset(m_hCellData.hCellEnd, 0xffffffff, mem_size2);
 
+	m_pSortedSrc = 0;
 	if(n == 0) return;
 	
-	if(m_iSorted){
-		// ep[eBÑObhnbV̌vZ
-		for(uint ip = 0; ip < n; ++ip){
-			int i = m_hCellData.hSortedIndex[ip].value;
-
-			// nbVlvZ
-			uint hash = CalGridHash(p[i]);
-
-			m_hCellData.hSortedIndex[ip].hash = hash;
-			//m_hCellData.hGridParticleHash[ip] = hash;
-		}
-	}
-	else{
-		// ep[eBÑObhnbV̌vZ
-		for(uint i = 0; i < n; ++i){
-			// nbVlvZ
-			uint hash = CalGridHash(p[i]);
-
-			m_hCellData.hSortedIndex[i].value = i;
-			m_hCellData.hSortedIndex[i].hash = hash;
-			//m_hCellData.hSortedIndex[i] = i;
-			//m_hCellData.hGridParticleHash[i] = hash;
-		}
+	// ep[eBÑObhnbV̌vZ
+	rxHashSort *hs = m_hCellData.hSortedIndex;
+	int sorted = (m_iSorted && n == m_uNumSorted);
+	#pragma omp parallel for
+	for(int ip = 0; ip < (int)n; ++ip){
+		int i = (sorted ? (int)hs[ip].value : ip);
+		hs[ip].value = i;
+		hs[ip].hash = CalGridHash(p[i]);
 	}
 
 	// ObhnbVŃ\[g
-	//vector<rxHashSort> hash_and_value;
-	//hash_and_value.resize(n);
-	//for(uint i = 0; i < n; ++i){
-	//	//hash_and_value[i].hash = m_hCellData.hGridParticleHash[i];
-	//	//hash_and_value[i].value  = m_hCellData.hSortedIndex[i];
-	//	hash_and_value[i]  = m_hCellData.hSortedIndex[i];
-	//}
-	//std::sort(hash_and_value.begin(), hash_and_value.end(), LessHash);
-	//for(uint i = 0; i < n; ++i){
-	//	//m_hCellData.hSortedIndex[i] = hash_and_value[i].value;
-	//	//m_hCellData.hGridParticleHash[i] = hash_and_value[i].hash;
-	//	m_hCellData.hSortedIndex[i] = hash_and_value[i];
-	//}
-	std::sort(m_hCellData.hSortedIndex, m_hCellData.hSortedIndex+n, LessHash);
+	sortByHash(n);
 
 	m_iSorted = 1;
+	m_uNumSorted = n;
 
-	// p[eBNz\[gꂽԂɕёւC
 	// eZ̎n܂ƏĨCfbNX
-	for(uint i = 0; i < n; i++){
-		//int hash = m_hCellData.hGridParticleHash[i];
-		int hash = m_hCellData.hSortedIndex[i].hash;
+	findCellStart(n);
+}
 
-		if(i == 0){
-			m_hCellData.hCellStart[hash] = i;
-			m_hCellData.hCellEnd[hash] = i;
+/*!
+ * ꕔ̃p[eBNړƂ̕Zւ̍Ċi[
+ *  - ړĂȂp[eBN͑Õ\[g(nbVl̏)̂܂܎gC
+ *    ړp[eBNnbVvZă\[ĝƃ}[W
+ *  - Õ\[gȂC܂̓p[eBNςƂSetObjectToCellőŜi[
+ * @param[in] p Sp[eBN̍WLqz
+ * @param[in] n p[eBN
+ * @param[in] moved ep[eBNړǂ̃tO(n)
+ */
+inline void rxNNGrid::UpdateObjectToCell(RXREAL *p, uint n, const unsigned char *moved)
+{
+	if(!m_iSorted || n != m_uNumSorted || n == 0){
+		SetObjectToCell(p, n);
+		return;
+	}
+
+	// Õ\[ĝ܂܁CړĂȂ̂ƈړ̂ɕ
+	rxHashSort *hs = m_hCellData.hSortedIndex;
+	rxHashSort *hs_static = m_hCellData.hSortTmp;
+	vector<rxHashSort> hs_moved;
+	uint ns = 0;
+	for(uint ip = 0; ip < n; ++ip){
+		if(moved[hs[ip].value]){
+			hs_moved.push_back(hs[ip]);
 		}
 		else{
-			//int prev_hash = m_hCellData.hGridParticleHash[i-1];
-			int prev_hash = m_hCellData.hSortedIndex[i-1].hash;
+			hs_static[ns++] = hs[ip];
+		}
+	}
+	if(hs_moved.empty() && m_pSortedSrc == p) return;
+
+	// ړp[eBÑnbVvZă\[g
+	int nm = (int)hs_moved.size();
+	#pragma omp parallel for
+	for(int j = 0; j < nm; ++j){
+		uint i = hs_moved[j].value;
+		Vec3 pos;
+		pos[0] = p[m_iDim*i+0];
+		pos[1] = p[m_iDim*i+1];
+		pos[2] = p[m_iDim*i+2];
+		hs_moved[j].hash = CalGridHash(pos);
+	}
+	stable_sort(hs_moved.begin(), hs_moved.end(), LessHash);
 
-			if(i == 0 || hash != prev_hash){
-				m_hCellData.hCellStart[hash] = i;
-				if(i > 0){
-					m_hCellData.hCellEnd[prev_hash] = i;
-				}
+	// }[W(Zł͈ړĂȂ̂)
+	merge(hs_static, hs_static+ns, hs_moved.begin(), hs_moved.end(), hs, LessHash);
+
+	// eZ̎n܂ƏĨCfbNX
+	int mem_size2 = m_hCellData.uNumCells*sizeof(uint);
+	memset(m_hCellData.hCellStart, 0xffffffff, mem_size2);
+	memset(m_hCellData.hCellEnd, 0xffffffff, mem_size2);
+	findCellStart(n);
+
+	// W\[gꂽԂɕёւăRs[
+	RXREAL *sp = m_hCellData.hSortedPos;
+	#pragma omp parallel for
+	for(int ip = 0; ip < (int)n; ++ip){
+		uint i = hs[ip].value;
+		sp[3*ip+0] = p[m_iDim*i+0];
+		sp[3*ip+1] = p[m_iDim*i+1];
+		sp[3*ip+2] = p[m_iDim*i+2];
+	}
+	m_pSortedSrc = p;
+}
+
+/*!
+ * Õ\[g̎擾
+ * @param[out] order \[gipԖڂ̃p[eBÑCfbNX(\[gȂ)
+ */
+inline void rxNNGrid::GetSortedOrder(vector<uint> &order) const
+{
+	order.clear();
+	if(!m_iSorted) return;
+	order.resize(m_uNumSorted);
+	for(uint ip = 0; ip < m_uNumSorted; ++ip){
+		order[ip] = m_hCellData.hSortedIndex[ip].value;
+	}
+}
+
+/*!
+ * Õ\[g̐ݒ
+ *  - SetObjectToCell͂̏Ԃ\[g(hSortedPosȂǂ͎SetObjectToCellō蒼)
+ * @param[in] order GetSortedOrderŎ擾
+ */
+inline void rxNNGrid::SetSortedOrder(const vector<uint> &order)
+{
+	m_pSortedSrc = 0;
+	m_iSorted = (order.empty() ? 0 : 1);
+	m_uNumSorted = (uint)order.size();
+	for(uint ip = 0; ip < m_uNumSorted; ++ip){
+		m_hCellData.hSortedIndex[ip].value = order[ip];
+	}
+}
+
+/*!
+ * ObhnbVɂLSD\[g
+ *  - ZۂɎgnbṼrbg߁CRX_NN_RADIX_BITSȉ̌ɕă\[g
+ *  - p[eBNAubNɕCubNƂ̃qXgOŕɐU蕪
+ *  - \[gȂ̂Ōʂ̓ubN(Xbh)ɂȂ
+ * @param[in] n p[eBN
+ */
+inline void rxNNGrid::sortByHash(uint n)
+{
+	// nbVlɎgĂrbg1pX̃rbg
+	int bits = 1;
+	while(bits < 32 && ((m_hCellData.uNumCells-1) >> bits)) bits++;
+	int passes = (bits+RX_NN_RADIX_BITS-1)/RX_NN_RADIX_BITS;
+	int rbits = (bits+passes-1)/passes;
+	uint nbins = 1 << rbits;
+	uint mask = nbins-1;
+
+	int nb = 1;
+#ifdef _OPENMP
+	nb = omp_get_max_threads();
+#endif
+	if(nb > (int)n) nb = (int)n;
+
+	m_vRadixCount.resize(nb*nbins);
+	uint *cnt = &m_vRadixCount[0];
+
+	rxHashSort *src = m_hCellData.hSortedIndex;
+	rxHashSort *dst = m_hCellData.hSortTmp;
+	for(int pass = 0; pass < passes; ++pass){
+		int shift = pass*rbits;
+		memset(cnt, 0, nb*nbins*sizeof(uint));
+
+		// ubNƂ̃qXgO
+		#pragma omp parallel for
+		for(int b = 0; b < nb; ++b){
+			uint start = (uint)(((unsigned long long)n*b)/nb);
+			uint end   = (uint)(((unsigned long long)n*(b+1))/nb);
+			uint *c = cnt+b*nbins;
+			for(uint i = start; i < end; ++i){
+				c[(src[i].hash >> shift) & mask]++;
 			}
+		}
+
+		// elEeubN̏݊Jnʒu(lDClȂubN)
+		uint sum = 0;
+		for(uint d = 0; d < nbins; ++d){
+			for(int b = 0; b < nb; ++b){
+				uint c = cnt[b*nbins+d];
+				cnt[b*nbins+d] = sum;
+				sum += c;
+			}
+		}
 
-			if(i == n-1){
-				m_hCellData.hCellEnd[hash] = i+1;
+		// U蕪
+		#pragma omp parallel for
+		for(int b = 0; b < nb; ++b){
+			uint start = (uint)(((unsigned long long)n*b)/nb);
+			uint end   = (uint)(((unsigned long long)n*(b+1))/nb);
+			uint *c = cnt+b*nbins;
+			for(uint i = start; i < end; ++i){
+				dst[c[(src[i].hash >> shift) & mask]++] = src[i];
 			}
 		}
+
+		rxHashSort *tmp = src; src = dst; dst = tmp;
+	}
+
+	// Ɨ̈ƓւČʂhSortedIndex
+	m_hCellData.hSortedIndex = src;
+	m_hCellData.hSortTmp = dst;
+}
+
+/*!
+ * \[gς݂̃nbV񂩂eZ̎n܂ƏĨCfbNX
+ *  - eZ̎n܂ƏI͂ꂼ1i炵܂Ȃ̂ŕɏł
+ * @param[in] n p[eBN
+ */
+inline void rxNNGrid::findCellStart(uint n)
+{
+	const rxHashSort *hs = m_hCellData.hSortedIndex;
+	#pragma omp parallel for
+	for(int i = 0; i < (int)n; ++i){
+		uint hash = hs[i].hash;
+
+		if(i == 0 || hash != hs[i-1].hash){
+			m_hCellData.hCellStart[hash] = i;
+			if(i > 0){
+				m_hCellData.hCellEnd[hs[i-1].hash] = i;
+			}
+		}
+
+		if(i == (int)n-1){
+			m_hCellData.hCellEnd[hash] = n;
+		}
 	}
 }
 
 /*!
  * |S𕪊ZɊi[
+ *  - |SƂɏdȂZɒׁCZƂ̃|SXg
  * @param[in] vrts |S_
  * @param[in] nv _
  * @param[in] tris bV
@@ -435,127 +637,176 @@ inline void rxNNGrid::SetObjectToCellV(Vec3 *p, uint n)
  */
 inline void rxNNGrid::SetPolygonsToCell(RXREAL *vrts, int nv, int* tris, int nt)
 {
-	int mem_size2 = m_hCellData.uNumCells*sizeof(uint);
-	memset(m_hCellData.hPolyCellStart, 0xffffffff, mem_size2);
-	memset(m_hCellData.hPolyCellEnd, 0, mem_size2);
+	m_vPolyCells.clear();
+	m_vPolyCells.resize(nt);
 
-	int num_hash = 0;
-
-	// e|S̃ObhnbV̌vZ
-	vector<uint> tri_hash, tri_idx;
-	vector<Vec3> tri_vrts, tri_vrts_c;
-	tri_vrts.resize(3);
-	tri_vrts_c.resize(3);
+	#pragma omp parallel for schedule(dynamic, 64)
 	for(int i = 0; i < nt; i++){
-		for(int j = 0; j < 3; ++j){
-			Vec3 pos;
-			pos[0] = vrts[3*tris[3*i+j]+0];
-			pos[1] = vrts[3*tris[3*i+j]+1];
-			pos[2] = vrts[3*tris[3*i+j]+2];
-			tri_vrts[j] = pos;
-		}
+		calPolygonCells(vrts, tris, i, m_vPolyCells[i]);
+	}
 
-		Vec3 nrm = Unit(cross(tri_vrts[1]-tri_vrts[0], tri_vrts[2]-tri_vrts[0]));
+	buildPolygonCells();
+}
 
-		// |SBBox
-		Vec3 bmin, bmax;
-		bmin = tri_vrts[0];
-		bmax = tri_vrts[0];
-		for(int j = 1; j < 3; ++j){
-			for(int k = 0; k < 3; ++k){
-				if(tri_vrts[j][k] < bmin[k]) bmin[k] = tri_vrts[j][k];
-				if(tri_vrts[j][k] > bmax[k]) bmax[k] = tri_vrts[j][k];
-			}
-		}
+/*!
+ * ꕔ̃|S𕪊ZɊi[
+ *  - ړő̂̃|S͈[start, start+num)dȂZ𒲂גC
+ *    ̃|S͑ǑʂgăZƂ̃|SXg蒼
+ *  - O񂩂|SĂ΁CVɒׂ
+ * @param[in] vrts |S_
+ * @param[in] nv _
+ * @param[in] tris bV
+ * @param[in] nt bV
+ * @param[in] start,num i[|S͈̔
+ */
+inline void rxNNGrid::UpdatePolygonsInCell(RXREAL *vrts, int nv, int* tris, int nt, int start, int num)
+{
+	int n0 = (int)m_vPolyCells.size();
+	if(n0 > nt){
+		// |Sꍇ͑Ŝ蒼
+		SetPolygonsToCell(vrts, nv, tris, nt);
+		return;
+	}
+	m_vPolyCells.resize(nt);
 
-		// BBoxƏdȂZ
-		bmin -= m_v3EnvMin;
-		bmax -= m_v3EnvMin;
+	start = RX_CLAMP(start, 0, nt);
+	int end = RX_MIN(start+num, nt);
 
-		// ZCfbNX̎Zo
-		int bmin_gidx[3], bmax_gidx[3];
-		for(int k = 0; k < 3; ++k){
-			bmin_gidx[k] = bmin[k]/m_fCellWidth[k];
-			bmax_gidx[k] = bmax[k]/m_fCellWidth[k];
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int i = start; i < end; i++){
+		calPolygonCells(vrts, tris, i, m_vPolyCells[i]);
+	}
+	#pragma omp parallel for schedule(dynamic, 64)
+	for(int i = RX_MAX(n0, end); i < nt; i++){
+		calPolygonCells(vrts, tris, i, m_vPolyCells[i]);
+	}
 
-			bmin_gidx[k] = RX_CLAMP(bmin_gidx[k], 0, m_iGridSize[k]-1);
-			bmax_gidx[k] = RX_CLAMP(bmax_gidx[k], 0, m_iGridSize[k]-1);
+	buildPolygonCells();
+}
+
+/*!
+ * |SƏdȂ镪Z𒲂ׂ
+ * @param[in] vrts |S_
+ * @param[in] tris bV
+ * @param[in] i |SCfbNX
+ * @param[out] cells dȂZ̃ObhnbV
+ */
+inline void rxNNGrid::calPolygonCells(const RXREAL *vrts, const int *tris, int i, vector<uint> &cells)
+{
+	cells.clear();
+
+	vector<Vec3> tri_vrts(3), tri_vrts_c(3);
+	for(int j = 0; j < 3; ++j){
+		Vec3 pos;
+		pos[0] = vrts[3*tris[3*i+j]+0];
+		pos[1] = vrts[3*tris[3*i+j]+1];
+		pos[2] = vrts[3*tris[3*i+j]+2];
+		tri_vrts[j] = pos;
+	}
+
+	Vec3 nrm = Unit(cross(tri_vrts[1]-tri_vrts[0], tri_vrts[2]-tri_vrts[0]));
+
+	// |SBBox
+	Vec3 bmin, bmax;
+	bmin = tri_vrts[0];
+	bmax = tri_vrts[0];
+	for(int j = 1; j < 3; ++j){
+		for(int k = 0; k < 3; ++k){
+			if(tri_vrts[j][k] < bmin[k]) bmin[k] = tri_vrts[j][k];
+			if(tri_vrts[j][k] > bmax[k]) bmax[k] = tri_vrts[j][k];
 		}
+	}
 
-		// eZɃ|S܂܂邩`FbN
-		Vec3 len = Vec3(m_fCellWidth[0], m_fCellWidth[1], m_fCellWidth[2]);
-		Vec3 cen(0.0);
-		for(int x = bmin_gidx[0]; x <= bmax_gidx[0]; ++x){
-			for(int y = bmin_gidx[1]; y <= bmax_gidx[1]; ++y){
-				for(int z = bmin_gidx[2]; z <= bmax_gidx[2]; ++z){
-					cen = m_v3EnvMin+Vec3(x+0.5, y+0.5, z+0.5)*len;
+	// BBoxƏdȂZ
+	bmin -= m_v3EnvMin;
+	bmax -= m_v3EnvMin;
 
-					for(int j = 0; j < 3; ++j){
-						tri_vrts_c[j] = (tri_vrts[j]-cen)/len;
-					}
+	// ZCfbNX̎Zo
+	int bmin_gidx[3], bmax_gidx[3];
+	for(int k = 0; k < 3; ++k){
+		bmin_gidx[k] = bmin[k]/m_fCellWidth[k];
+		bmax_gidx[k] = bmax[k]/m_fCellWidth[k];
 
-					if(RXFunc::polygon_intersects_cube(tri_vrts_c, nrm)){
-						// nbVlvZ
-						uint hash = CalGridHash(x, y, z);
+		bmin_gidx[k] = RX_CLAMP(bmin_gidx[k], 0, m_iGridSize[k]-1);
+		bmax_gidx[k] = RX_CLAMP(bmax_gidx[k], 0, m_iGridSize[k]-1);
+	}
 
-						tri_idx.push_back((uint)i);
-						tri_hash.push_back(hash);
+	// eZɃ|S܂܂邩`FbN
+	Vec3 len = Vec3(m_fCellWidth[0], m_fCellWidth[1], m_fCellWidth[2]);
+	Vec3 cen(0.0);
+	for(int x = bmin_gidx[0]; x <= bmax_gidx[0]; ++x){
+		for(int y = bmin_gidx[1]; y <= bmax_gidx[1]; ++y){
+			for(int z = bmin_gidx[2]; z <= bmax_gidx[2]; ++z){
+				cen = m_v3EnvMin+Vec3(x+0.5, y+0.5, z+0.5)*len;
 
-						//m_hCellData.hPolyCellStart[hash] = 0;
+				for(int j = 0; j < 3; ++j){
+					tri_vrts_c[j] = (tri_vrts[j]-cen)/len;
+				}
 
-						num_hash++;
-					}
+				if(RXFunc::polygon_intersects_cube(tri_vrts_c, nrm)){
+					cells.push_back(CalGridHash(x, y, z));
 				}
 			}
 		}
 	}
+}
 
-	m_hCellData.uNumPolyHash = (uint)num_hash;
-
-	int mem_size1 = m_hCellData.uNumPolyHash*sizeof(uint);
-	m_hCellData.hSortedPolyIdx = new uint[m_hCellData.uNumPolyHash];
-	m_hCellData.hGridPolyHash = new uint[m_hCellData.uNumPolyHash];
-	memcpy(m_hCellData.hSortedPolyIdx, &tri_idx[0], mem_size1);
-	memcpy(m_hCellData.hGridPolyHash, &tri_hash[0], mem_size1);
+/*!
+ * e|SdȂZ̃XgZƂ̃|SXg쐬
+ *  - ObhnbVɂv\[gȂ̂ŁCZ̃|S̓CfbNXɕ
+ */
+inline void rxNNGrid::buildPolygonCells(void)
+{
+	uint ncells = m_hCellData.uNumCells;
+	int nt = (int)m_vPolyCells.size();
+
+	// ZƂ̃|S(hPolyCellEndƗ̈Ɏg)
+	uint *cnt = m_hCellData.hPolyCellEnd;
+	memset(cnt, 0, ncells*sizeof(uint));
+	uint num_hash = 0;
+	for(int i = 0; i < nt; ++i){
+		const vector<uint> &cells = m_vPolyCells[i];
+		for(int j = 0; j < (int)cells.size(); ++j){
+			cnt[cells[j]]++;
+		}
+		num_hash += (uint)cells.size();
+	}
 
-	// ObhnbVŃ\[g
-	vector<rxHashSort> hash_and_value;
-	hash_and_value.resize(m_hCellData.uNumPolyHash);
-	for(int i = 0; i < (int)m_hCellData.uNumPolyHash; ++i){
-		hash_and_value[i].hash  = m_hCellData.hGridPolyHash[i];
-		hash_and_value[i].value = m_hCellData.hSortedPolyIdx[i];
+	if(num_hash != m_hCellData.uNumPolyHash || !m_hCellData.hSortedPolyIdx){
+		if(m_hCellData.hSortedPolyIdx) delete [] m_hCellData.hSortedPolyIdx;
+		if(m_hCellData.hGridPolyHash) delete [] m_hCellData.hGridPolyHash;
+		m_hCellData.hSortedPolyIdx = new uint[RX_MAX(num_hash, 1U)];
+		m_hCellData.hGridPolyHash = new uint[RX_MAX(num_hash, 1U)];
 	}
-	std::sort(hash_and_value.begin(), hash_and_value.end(), LessHash);
-	for(int i = 0; i < (int)m_hCellData.uNumPolyHash; ++i){
-		m_hCellData.hSortedPolyIdx[i] = hash_and_value[i].value;
-		m_hCellData.hGridPolyHash[i]  = hash_and_value[i].hash;
+	m_hCellData.uNumPolyHash = num_hash;
+
+	// eZ̎n܂ƏĨCfbNX
+	uint offset = 0;
+	for(uint c = 0; c < ncells; ++c){
+		uint n = cnt[c];
+		m_hCellData.hPolyCellStart[c] = (n ? offset : 0xffffffff);
+		m_hCellData.hPolyCellEnd[c] = offset;	// i[ʒuƂĎgCi[ɏĨCfbNXɂȂ
+		offset += n;
 	}
 
-	// p[eBNz\[gꂽԂɕёւC
-	// eZ̎n܂ƏĨCfbNX
-	for(uint i = 0; i < m_hCellData.uNumPolyHash; ++i){
-		uint hash = m_hCellData.hGridPolyHash[i];
-
-		if(i == 0){
-			m_hCellData.hPolyCellStart[hash] = i;
+	// |SCfbNXɃZɊi[
+	for(int i = 0; i < nt; ++i){
+		const vector<uint> &cells = m_vPolyCells[i];
+		for(int j = 0; j < (int)cells.size(); ++j){
+			uint hash = cells[j];
+			uint idx = m_hCellData.hPolyCellEnd[hash]++;
+			m_hCellData.hSortedPolyIdx[idx] = (uint)i;
+			m_hCellData.hGridPolyHash[idx] = hash;
 		}
-		else{
-			uint prev_hash = m_hCellData.hGridPolyHash[i-1];
-
-			if(i == 0 || hash != prev_hash){
-				m_hCellData.hPolyCellStart[hash] = i;
-				if(i > 0){
-					m_hCellData.hPolyCellEnd[prev_hash] = i;
-				}
-			}
+	}
 
-			if(i == nt-1){
-				m_hCellData.hPolyCellEnd[hash] = i+1;
-			}
-		}
+	// ̃Z̏ĨCfbNX0(]ʂ)
+	for(uint c = 0; c < ncells; ++c){
+		if(m_hCellData.hPolyCellStart[c] == 0xffffffff) m_hCellData.hPolyCellEnd[c] = 0;
 	}
 }
 
+
 /*!
  * ߖTqT()
  * @param[in] pos TS
@@ -614,6 +865,110 @@ inline void rxNNGrid::GetNN(Vec3 pos, RXREAL *p, uint n, vector<rxNeigh> &neighs
 	}
 }
 
+/*!
+ * ߖTTŒׂ镪Z̎擾
+ *  - GetNNƓ͈͂̃Z̃ObhnbVԂ
+ * @param[in] pos TS
+ * @param[in] h La
+ * @param[out] cells ObhnbV(ǉĂ)
+ * @return ǉZ
+ */
+inline int rxNNGrid::GetNeighborCells(Vec3 pos, RXREAL h, vector<uint> &cells)
+{
+	int x = (pos[0]-m_v3EnvMin[0])/m_fCellWidth[0];
+	int y = (pos[1]-m_v3EnvMin[1])/m_fCellWidth[1];
+	int z = (pos[2]-m_v3EnvMin[2])/m_fCellWidth[2];
+
+	int cnt = 0;
+	int numArdGrid = (int)(h/m_fCellWidth[0])+1;
+	for(int k = -numArdGrid; k <= numArdGrid; ++k){
+		for(int j = -numArdGrid; j <= numArdGrid; ++j){
+			for(int i = -numArdGrid; i <= numArdGrid; ++i){
+				int i1 = x+i;
+				int j1 = y+j;
+				int k1 = z+k;
+				if(i1 < 0 || i1 >= m_iGridSize[0] || j1 < 0 || j1 >= m_iGridSize[1] || k1 < 0 || k1 >= m_iGridSize[2]){
+					continue;
+				}
+				cells.push_back(CalGridHash(i1, j1, k1));
+				cnt++;
+			}
+		}
+	}
+	return cnt;
+}
+
+/*!
+ * Sp[eBN̋ߖTqT
+ *  - p[eBNAubNɕĕɒTCʂCSR`̋ߖTXgɂ܂Ƃ߂
+ *  - ߖT̊i[̓p[eBNƂ GetNN Ɠ
+ *  - OSetObjectToCellƓWzȂC\[gɕׂW̃Rs[T
+ * @param[in] p p[eBNʒu
+ * @param[in] n p[eBN
+ * @param[out] nl ߖTXg
+ * @param[in] h La
+ */
+inline void rxNNGrid::GetNNList(RXREAL *p, uint n, rxNeighList &nl, RXREAL h)
+{
+	nl.Offset.resize(n+1);
+	nl.Offset[0] = 0;
+	if(n == 0){
+		nl.Neighs.clear();
+		return;
+	}
+
+	// ubN(Xbh̐{ɂĕׂ𕪎U)
+	int nb = 1;
+#ifdef _OPENMP
+	nb = 4*omp_get_max_threads();
+#endif
+	if(nb > (int)n) nb = (int)n;
+	if((int)nl.Buf.size() < nb) nl.Buf.resize(nb);
+
+	bool use_sorted = (p == m_pSortedSrc && n == m_uNumSorted);
+
+	// ubNƂɋߖTTCp[eBNi̋ߖTOffset[i+1]ɈꎞIɊi[
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int b = 0; b < nb; ++b){
+		int start = (int)(((long long)n*b)/nb);
+		int end   = (int)(((long long)n*(b+1))/nb);
+
+		vector<rxNeigh> &buf = nl.Buf[b];
+		buf.clear();
+		for(int i = start; i < end; ++i){
+			Vec3 pos;
+			pos[0] = p[m_iDim*i+0];
+			pos[1] = p[m_iDim*i+1];
+			pos[2] = p[m_iDim*i+2];
+
+			uint prev = (uint)buf.size();
+			if(use_sorted){
+				getNNSorted(pos, buf, h);
+			}
+			else{
+				GetNN(pos, p, n, buf, h);
+			}
+			nl.Offset[i+1] = (uint)buf.size()-prev;
+		}
+	}
+
+	// ߖT̗ݐϘaŊep[eBN̊Jnʒu߂
+	for(uint i = 0; i < n; ++i){
+		nl.Offset[i+1] += nl.Offset[i];
+	}
+	nl.Neighs.resize(nl.Offset[n]);
+
+	// ubNƂ̃obt@AzɃRs[
+	#pragma omp parallel for
+	for(int b = 0; b < nb; ++b){
+		int start = (int)(((long long)n*b)/nb);
+		const vector<rxNeigh> &buf = nl.Buf[b];
+		if(!buf.empty()){
+			memcpy(&nl.Neighs[nl.Offset[start]], &buf[0], buf.size()*sizeof(rxNeigh));
+		}
+	}
+}
+
 /*!
  * Z̗qߖTo
  * @param[in] pos TS
@@ -653,6 +1008,71 @@ inline void rxNNGrid::getNeighborsInCell(Vec3 pos, RXREAL *p, int gi, int gj, in
 	}
 }
 
+/*!
+ * \[gɕׂW̃Rs[gߖTqT
+ *  - ߖT̊i[CGetNNƓɂȂ
+ * @param[in] pos TS
+ * @param[out] neighs Tʊi[ߖTRei
+ * @param[in] h La
+ */
+inline void rxNNGrid::getNNSorted(Vec3 pos, vector<rxNeigh> &neighs, RXREAL h)
+{
+	// ZCfbNX̎Zo
+	int x = (pos[0]-m_v3EnvMin[0])/m_fCellWidth[0];
+	int y = (pos[1]-m_v3EnvMin[1])/m_fCellWidth[1];
+	int z = (pos[2]-m_v3EnvMin[2])/m_fCellWidth[2];
+
+	int numArdGrid = (int)(h/m_fCellWidth[0])+1;
+	for(int k = -numArdGrid; k <= numArdGrid; ++k){
+		for(int j = -numArdGrid; j <= numArdGrid; ++j){
+			for(int i = -numArdGrid; i <= numArdGrid; ++i){
+				int i1 = x+i;
+				int j1 = y+j;
+				int k1 = z+k;
+				if(i1 < 0 || i1 >= m_iGridSize[0] || j1 < 0 || j1 >= m_iGridSize[1] || k1 < 0 || k1 >= m_iGridSize[2]){
+					continue;
+				}
+
+				getNeighborsInCellSorted(pos, i1, j1, k1, neighs, h);
+			}
+		}
+	}
+}
+
+/*!
+ * Z̗qߖTo(\[gɕׂW̃Rs[g)
+ * @param[in] pos TS
+ * @param[in] gi,gj,gk ΏەZ
+ * @param[out] neighs Tʊi[ߖTRei
+ * @param[in] h La
+ */
+inline void rxNNGrid::getNeighborsInCellSorted(Vec3 pos, int gi, int gj, int gk, vector<rxNeigh> &neighs, RXREAL h)
+{
+	RXREAL h2 = h*h;
+
+	uint grid_hash = CalGridHash(gi, gj, gk);
+
+	uint start_index = m_hCellData.hCellStart[grid_hash];
+	if(start_index != 0xffffffff){	// ZłȂ̃`FbN
+		uint end_index = m_hCellData.hCellEnd[grid_hash];
+		const RXREAL *sp = m_hCellData.hSortedPos;
+		for(uint j = start_index; j < end_index; ++j){
+			Vec3 xij;
+			xij[0] = pos[0]-sp[3*j+0];
+			xij[1] = pos[1]-sp[3*j+1];
+			xij[2] = pos[2]-sp[3*j+2];
+
+			rxNeigh neigh;
+			neigh.Dist2 = norm2(xij);
+
+			if(neigh.Dist2 <= h2){
+				neigh.Idx = m_hCellData.hSortedIndex[j].value;
+				neighs.push_back(neigh);
+			}
+		}
+	}
+}
+
 /*!
  * ߖTqT
  * @param[in] pos TS
@@ -800,7 +1220,6 @@ inline bool rxNNGrid::IsPolygonsInCell(int gi, int gj, int gk)
 		int cnt = 0;
 		uint end_index = m_hCellData.hPolyCellEnd[grid_hash];
 		for(uint j = start_index; j < end_index; ++j){
-			uint idx = m_hCellData.hSortedPolyIdx[j];
 			cnt++;
 			break;
 		}
@@ -839,7 +1258,26 @@ inline uint rxNNGrid::CalGridHash(Vec3 pos)
 	return CalGridHash(x, y, z);
 }
 
+/*!
+ * Z͈̔͂̌vZ
+ *  - [̃Zɂ͔͈͊Öʒu܂Ƃ߂(CalGridHashŃNv)̂ŁCOɂ͖ɍL
+ * @param[in] grid_hash ObhnbVl
+ * @param[out] minp,maxp Z̍ŏEőW
+ */
+inline void rxNNGrid::CalCellBounds(uint grid_hash, Vec3 &minp, Vec3 &maxp)
+{
+	int g[3];
+	g[0] = grid_hash%m_iGridSize[0];
+	g[1] = (grid_hash/m_iGridSize[0])%m_iGridSize[1];
+	g[2] = grid_hash/(m_iGridSize[0]*m_iGridSize[1]);
+	for(int k = 0; k < 3; ++k){
+		minp[k] = (g[k] == 0 ? -RX_FEQ_INF : m_v3EnvMin[k]+g[k]*m_fCellWidth[k]);
+		maxp[k] = (g[k] == m_iGridSize[k]-1 ? RX_FEQ_INF : m_v3EnvMin[k]+(g[k]+1)*m_fCellWidth[k]);
+	}
+}
+
 
+#ifndef RX_HEADLESS
 //-----------------------------------------------------------------------------
 // OpenGL`
 //-----------------------------------------------------------------------------
@@ -1008,5 +1446,6 @@ inline void rxNNGrid::DrawCellsV(Vec3 col, Vec3 col2, int sel, Vec3 *p)
 
 	glPopMatrix();
 }
+#endif // #ifndef RX_HEADLESS
 
 #endif // #ifndef _RX_NNSEARCH_H_
\ No newline at end of file
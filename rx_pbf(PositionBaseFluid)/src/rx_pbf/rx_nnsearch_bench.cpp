@@ -0,0 +1,152 @@
+/*!
+  @file rx_nnsearch_bench.cpp
+
+  @brief ߖTTObh\z̃x`}[N
+		 - rxNNGrid::SetObjectToCell(\[g)Ə]std::sortɂ\zr
+		 - 10k, 100k, 1Mp[eBNłꂼv
+		 - rh(Linux) :
+		   g++ -O2 -fopenmp -I. -I../../shared/inc rx_nnsearch_bench.cpp -o rx_nnsearch_bench -lglut -lGL
+
+  @date 2026-10
+*/
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+#include <cstdlib>
+#include <cstring>
+
+#include "rx_nnsearch.h"
+#include "rx_timer.h"
+
+
+//-----------------------------------------------------------------------------
+// 萔
+//-----------------------------------------------------------------------------
+const int DIM = 4;
+const int BENCH_REPEAT = 10;		//!< v̌JԂ
+
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+/*!
+ * oߎ[s]
+ */
+inline double BenchTime(void)
+{
+#ifdef _OPENMP
+	return omp_get_wtime();
+#else
+	return RX_GET_TIME()*RX_GET_TIME2SEC();
+#endif
+}
+
+/*!
+ * ]std::sortɂObh\z
+ *  - ύXOrxNNGrid::SetObjectToCellƓ(nbVvZCstd::sortCZ͈͂̌)
+ * @param[in] grid ߖTTObh(nbVvZp)
+ * @param[in] p p[eBNW
+ * @param[in] n p[eBN
+ * @param[out] hs nbVƌ̃CfbNX
+ * @param[out] cstart,cend eZ̎n܂ƏĨCfbNX
+ * @param[in] ncells Z
+ */
+static void SetObjectToCellStdSort(rxNNGrid &grid, RXREAL *p, uint n, rxHashSort *hs, uint *cstart, uint *cend, uint ncells)
+{
+	memset(cstart, 0xffffffff, ncells*sizeof(uint));
+	memset(cend, 0xffffffff, ncells*sizeof(uint));
+
+	for(uint i = 0; i < n; ++i){
+		Vec3 pos(p[DIM*i+0], p[DIM*i+1], p[DIM*i+2]);
+		hs[i].value = i;
+		hs[i].hash = grid.CalGridHash(pos);
+	}
+
+	std::sort(hs, hs+n, LessHash);
+
+	for(uint i = 0; i < n; i++){
+		uint hash = hs[i].hash;
+		if(i == 0 || hash != hs[i-1].hash){
+			cstart[hash] = i;
+			if(i > 0) cend[hs[i-1].hash] = i;
+		}
+		if(i == n-1) cend[hash] = n;
+	}
+}
+
+/*!
+ * p[eBNnł̌v
+ *  - 1̗̓Ƀ_ɔzuCLa̓p[eBN20x傫
+ * @param[in] n p[eBN
+ */
+static void Bench(uint n)
+{
+	RXREAL *p = new RXREAL[DIM*n];
+	srand(12345);
+	for(uint i = 0; i < n; ++i){
+		for(int k = 0; k < 3; ++k) p[DIM*i+k] = rand()/(RXREAL)RAND_MAX;
+		p[DIM*i+3] = 0.0;
+	}
+
+	double h = pow(20.0*3.0/(4.0*RX_PI*n), 1.0/3.0);
+
+	rxNNGrid grid(DIM);
+	grid.Setup(Vec3(0.0), Vec3(1.0), h, n);
+	rxNNGrid::rxCell &cell = grid.GetCellData();
+	uint ncells = cell.uNumCells;
+
+	rxHashSort *hs = new rxHashSort[n];
+	uint *cstart = new uint[ncells];
+	uint *cend = new uint[ncells];
+
+	// std::sort
+	double t0 = BenchTime();
+	for(int r = 0; r < BENCH_REPEAT; ++r){
+		SetObjectToCellStdSort(grid, p, n, hs, cstart, cend, ncells);
+	}
+	double t_std = (BenchTime()-t0)/BENCH_REPEAT;
+
+	// \[g(1ڂ͏\[gCȍ~͑ȌԂg\[g)
+	t0 = BenchTime();
+	for(int r = 0; r < BENCH_REPEAT; ++r){
+		grid.SetObjectToCell(p, n);
+	}
+	double t_radix = (BenchTime()-t0)/BENCH_REPEAT;
+
+	// ʂ̊mF(Z͈͂ƊeZɊ܂܂p[eBNv邩)
+	bool ok = true;
+	for(uint c = 0; c < ncells && ok; ++c){
+		if(cstart[c] != cell.hCellStart[c] || cend[c] != cell.hCellEnd[c]) ok = false;
+	}
+	for(uint i = 0; i < n && ok; ++i){
+		if(hs[i].hash != cell.hSortedIndex[i].hash) ok = false;
+	}
+
+	cout << "n = " << n << ", cells = " << ncells << endl;
+	cout << "  std::sort : " << t_std*1.0e3 << " [ms]" << endl;
+	cout << "  radix     : " << t_radix*1.0e3 << " [ms]" << endl;
+	cout << "  speedup   : " << t_std/t_radix << (ok ? "" : "  (MISMATCH)") << endl;
+
+	delete [] p;
+	delete [] hs;
+	delete [] cstart;
+	delete [] cend;
+}
+
+
+/*!
+ * C֐
+ */
+int main(int argc, char *argv[])
+{
+#ifdef _OPENMP
+	cout << "threads : " << omp_get_max_threads() << endl;
+#endif
+
+	Bench(10000);
+	Bench(100000);
+	Bench(1000000);
+
+	return 0;
+}
@@ -0,0 +1,698 @@
+/*!
+  @file rx_particle_cache.cpp
+
+  @brief p[eBNLbV(oCi,t[CfbNXt)̎
+
+  @date   2026-10
+*/
+
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+#include "rx_particle_cache.h"
+
+#include <cstring>
+#include <cstddef>
+#include <cfloat>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// `
+//-----------------------------------------------------------------------------
+#ifndef RXCOUT
+	#define RXCOUT std::cout
+#endif
+
+static const char RX_PCACHE_MAGIC[4] = {'R', 'X', 'P', 'C'};
+static const char RX_PCACHE_FRAME_MAGIC[4] = {'R', 'X', 'F', 'R'};
+
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+/*!
+ * TCY4oCgEɐ؂グ
+ */
+static inline rxuint64 RxPCacheAlign4(rxuint64 n)
+{
+	return (n+3) & ~(rxuint64)3;
+}
+
+/*!
+ * ʎq̒iK
+ * @param[in] encoding i[`
+ * @return iK(float32̏ꍇ0)
+ */
+static inline uint RxPCacheLevels(uint encoding)
+{
+	return (encoding == RX_PCACHE_QUANT16 ? 65535 : (encoding == RX_PCACHE_QUANT8 ? 255 : 0));
+}
+
+/*!
+ * t[ubN1`l̃f[^TCY
+ * @param[in] ch `l
+ * @param[in] n p[eBN
+ * @return oCg(4oCgEɑ)
+ */
+static inline rxuint64 RxPCacheChannelSize(const rxPCacheChannel &ch, uint n)
+{
+	rxuint64 m = (rxuint64)n*ch.ncomp;
+	switch(ch.encoding){
+	case RX_PCACHE_QUANT16:	return RxPCacheAlign4(2*sizeof(float)*ch.ncomp+m*2);
+	case RX_PCACHE_QUANT8:	return RxPCacheAlign4(2*sizeof(float)*ch.ncomp+m);
+	default:				return m*sizeof(float);
+	}
+}
+
+/*!
+ * t[ubNŜ̃TCY(8oCgEɑ)
+ * @param[in] chs `l
+ * @param[in] n p[eBN
+ * @return oCg
+ */
+static inline rxuint64 RxPCacheFrameSize(const vector<rxPCacheChannel> &chs, uint n)
+{
+	rxuint64 size = sizeof(rxPCacheFrameHeader);
+	for(int c = 0; c < (int)chs.size(); ++c){
+		size += RxPCacheChannelSize(chs[c], n);
+	}
+	return (size+7) & ~(rxuint64)7;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// rxParticleCacheWriter̎
+//-----------------------------------------------------------------------------
+/*!
+ * RXgN^
+ */
+rxParticleCacheWriter::rxParticleCacheWriter()
+{
+	m_uOffset = 0;
+	m_iMaxQueue = 8;
+	m_bOpen = false;
+	m_bQuit = false;
+}
+
+/*!
+ * fXgN^
+ */
+rxParticleCacheWriter::~rxParticleCacheWriter()
+{
+	Close();
+	for(int i = 0; i < (int)m_vPool.size(); ++i){
+		delete m_vPool[i];
+	}
+	m_vPool.clear();
+}
+
+/*!
+ * `l̒ǉ
+ *  - Open̑OɌĂԂ
+ * @param[in] name `l(15܂)
+ * @param[in] ncomp 
+ * @param[in] encoding i[`(rxPCacheEncoding)
+ * @return `l̃CfbNX(s-1)
+ */
+int rxParticleCacheWriter::AddChannel(const string &name, int ncomp, int encoding)
+{
+	if(m_bOpen || ncomp <= 0 || name.empty() || (int)name.size() >= RX_PCACHE_NAME_LEN) return -1;
+	if(GetChannelIndex(name) >= 0) return -1;
+
+	rxPCacheChannel ch;
+	memset(&ch, 0, sizeof(ch));
+	strncpy(ch.name, name.c_str(), RX_PCACHE_NAME_LEN-1);
+	ch.ncomp = ncomp;
+	ch.encoding = encoding;
+	m_vChannels.push_back(ch);
+
+	return (int)m_vChannels.size()-1;
+}
+
+/*!
+ * `lCfbNX
+ * @param[in] name `l
+ * @return `l̃CfbNX(Ȃ-1)
+ */
+int rxParticleCacheWriter::GetChannelIndex(const string &name) const
+{
+	for(int c = 0; c < (int)m_vChannels.size(); ++c){
+		if(name == m_vChannels[c].name) return c;
+	}
+	return -1;
+}
+
+/*!
+ * LbVt@CJď݃XbhJn
+ * @param[in] fn t@C
+ * @param[in] max_queue ݑ҂̍őt[(𒴂BeginFrameő҂)
+ * @return t@CJtrue
+ */
+bool rxParticleCacheWriter::Open(const string &fn, int max_queue)
+{
+	Close();
+
+	m_fOut.open(fn.c_str(), ios::out|ios::binary|ios::trunc);
+	if(!m_fOut){
+		RXCOUT << fn << " couldn't open." << endl;
+		return false;
+	}
+	m_strFileName = fn;
+	m_iMaxQueue = (max_queue > 0 ? max_queue : 1);
+	m_vIndex.clear();
+
+	// wb_(CfbNẌʒuCloseŏ)
+	rxPCacheHeader hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, RX_PCACHE_MAGIC, 4);
+	hdr.version = RX_PCACHE_VERSION;
+	hdr.num_channels = (uint)m_vChannels.size();
+	m_fOut.write((char*)&hdr, sizeof(hdr));
+	if(!m_vChannels.empty()){
+		m_fOut.write((char*)&m_vChannels[0], sizeof(rxPCacheChannel)*m_vChannels.size());
+	}
+	m_uOffset = sizeof(hdr)+sizeof(rxPCacheChannel)*m_vChannels.size();
+
+	m_bQuit = false;
+	m_bOpen = true;
+	m_Thread = thread(&rxParticleCacheWriter::run, this);
+
+	return true;
+}
+
+/*!
+ * ݑ҂̃t[ׂďoĂt@C
+ *  - ɃCfbNXe[u݁Cwb_ɂ̈ʒuL^
+ */
+void rxParticleCacheWriter::Close(void)
+{
+	if(!m_bOpen) return;
+
+	{
+		unique_lock<mutex> lock(m_Mutex);
+		m_bQuit = true;
+	}
+	m_CondPush.notify_all();
+	m_Thread.join();
+
+	// CfbNXe[u
+	rxuint64 index_offset = m_uOffset;
+	if(!m_vIndex.empty()){
+		m_fOut.write((char*)&m_vIndex[0], sizeof(rxPCacheIndex)*m_vIndex.size());
+	}
+
+	// wb_̍XV
+	rxuint64 num_frames = m_vIndex.size();
+	m_fOut.seekp(offsetof(rxPCacheHeader, index_offset), ios::beg);
+	m_fOut.write((char*)&index_offset, sizeof(rxuint64));
+	m_fOut.write((char*)&num_frames, sizeof(rxuint64));
+	m_fOut.close();
+
+	RXCOUT << m_strFileName << " : " << num_frames << " frames, " << (index_offset+sizeof(rxPCacheIndex)*num_frames) << " bytes" << endl;
+
+	m_bOpen = false;
+}
+
+/*!
+ * ݗpt[obt@̎擾
+ *  - ݑ҂max_queuet[ɒBĂꍇ͏݃Xbhǂ܂ő҂
+ * @param[in] frame t[ԍ
+ * @param[in] time V~[V
+ * @param[in] num_particles p[eBN
+ * @return t[obt@(EndFrameŕԂ)
+ */
+rxParticleCacheFrame* rxParticleCacheWriter::BeginFrame(int frame, double time, uint num_particles)
+{
+	rxParticleCacheFrame *f = 0;
+	{
+		unique_lock<mutex> lock(m_Mutex);
+		while((int)m_qFrames.size() >= m_iMaxQueue){
+			m_CondPop.wait(lock);
+		}
+		if(!m_vPool.empty()){
+			f = m_vPool.back();
+			m_vPool.pop_back();
+		}
+	}
+	if(!f) f = new rxParticleCacheFrame;
+
+	f->frame = frame;
+	f->time = time;
+	f->num_particles = num_particles;
+	f->data.resize(m_vChannels.size());
+	for(int c = 0; c < (int)m_vChannels.size(); ++c){
+		f->data[c].resize((size_t)num_particles*m_vChannels[c].ncomp);
+	}
+
+	return f;
+}
+
+/*!
+ * t[݃L[ɒǉ
+ * @param[in] f BeginFrameŎ擾t[obt@
+ */
+void rxParticleCacheWriter::EndFrame(rxParticleCacheFrame *f)
+{
+	if(!f) return;
+	if(!m_bOpen){
+		delete f;
+		return;
+	}
+	{
+		unique_lock<mutex> lock(m_Mutex);
+		m_qFrames.push_back(f);
+	}
+	m_CondPush.notify_one();
+}
+
+/*!
+ * ݑ҂̃t[ȂȂ܂ő҂
+ */
+void rxParticleCacheWriter::Flush(void)
+{
+	unique_lock<mutex> lock(m_Mutex);
+	while(!m_qFrames.empty()){
+		m_CondPop.wait(lock);
+	}
+}
+
+/*!
+ * ݃Xbh
+ *  - L[̐擪t[oĂL[O(Flush̓L[ɂȂΏ݊)
+ */
+void rxParticleCacheWriter::run(void)
+{
+	for(;;){
+		rxParticleCacheFrame *f = 0;
+		{
+			unique_lock<mutex> lock(m_Mutex);
+			while(m_qFrames.empty() && !m_bQuit){
+				m_CondPush.wait(lock);
+			}
+			if(m_qFrames.empty()) break;
+			f = m_qFrames.front();
+		}
+
+		writeFrame(*f);
+
+		{
+			unique_lock<mutex> lock(m_Mutex);
+			m_qFrames.pop_front();
+			m_vPool.push_back(f);
+		}
+		m_CondPop.notify_all();
+	}
+}
+
+/*!
+ * 1t[̃GR[hƏ
+ * @param[in] f t[f[^
+ */
+void rxParticleCacheWriter::writeFrame(const rxParticleCacheFrame &f)
+{
+	uint n = f.num_particles;
+	rxuint64 size = RxPCacheFrameSize(m_vChannels, n);
+
+	m_vBuf.clear();
+	m_vBuf.reserve((size_t)size);
+
+	rxPCacheFrameHeader fh;
+	memset(&fh, 0, sizeof(fh));
+	memcpy(fh.magic, RX_PCACHE_FRAME_MAGIC, 4);
+	fh.frame = f.frame;
+	fh.num_particles = n;
+	fh.time = f.time;
+	m_vBuf.insert(m_vBuf.end(), (unsigned char*)&fh, (unsigned char*)&fh+sizeof(fh));
+
+	for(int c = 0; c < (int)m_vChannels.size(); ++c){
+		encodeChannel(m_vChannels[c], f.data[c], n);
+	}
+	m_vBuf.resize((size_t)size, 0);
+
+	m_fOut.write((char*)&m_vBuf[0], m_vBuf.size());
+
+	rxPCacheIndex idx;
+	memset(&idx, 0, sizeof(idx));
+	idx.frame = f.frame;
+	idx.num_particles = n;
+	idx.offset = m_uOffset;
+	idx.size = size;
+	idx.time = f.time;
+	m_vIndex.push_back(idx);
+
+	m_uOffset += size;
+}
+
+/*!
+ * 1`l̃f[^GR[hăobt@ɒǉ
+ *  - ʎqꍇ͐Ƃmin,max擪ɒuC[min,max]𓙕lŊi[
+ * @param[in] ch `l
+ * @param[in] src `lf[^(n*ncomp)
+ * @param[in] n p[eBN
+ */
+void rxParticleCacheWriter::encodeChannel(const rxPCacheChannel &ch, const vector<float> &src, uint n)
+{
+	size_t start = m_vBuf.size();
+	m_vBuf.resize(start+(size_t)RxPCacheChannelSize(ch, n), 0);
+	unsigned char *dst = &m_vBuf[start];
+	int nc = ch.ncomp;
+	const float *s = (src.empty() ? 0 : &src[0]);
+
+	uint levels = RxPCacheLevels(ch.encoding);
+	if(!levels){
+		if(n) memcpy(dst, s, (size_t)n*nc*sizeof(float));
+		return;
+	}
+
+	vector<float> vmin(nc, FLT_MAX), vmax(nc, -FLT_MAX);
+	for(uint i = 0; i < n; ++i){
+		for(int k = 0; k < nc; ++k){
+			float v = s[i*nc+k];
+			if(v < vmin[k]) vmin[k] = v;
+			if(v > vmax[k]) vmax[k] = v;
+		}
+	}
+	if(!n){
+		vmin.assign(nc, 0.0f);
+		vmax.assign(nc, 0.0f);
+	}
+	memcpy(dst, &vmin[0], nc*sizeof(float));
+	memcpy(dst+nc*sizeof(float), &vmax[0], nc*sizeof(float));
+	dst += 2*nc*sizeof(float);
+
+	vector<float> scale(nc);
+	for(int k = 0; k < nc; ++k){
+		scale[k] = (vmax[k] > vmin[k] ? levels/(vmax[k]-vmin[k]) : 0.0f);
+	}
+
+	if(ch.encoding == RX_PCACHE_QUANT16){
+		unsigned short *q = (unsigned short*)dst;
+		for(uint i = 0; i < n; ++i){
+			for(int k = 0; k < nc; ++k){
+				q[i*nc+k] = (unsigned short)((s[i*nc+k]-vmin[k])*scale[k]+0.5f);
+			}
+		}
+	}
+	else{
+		unsigned char *q = dst;
+		for(uint i = 0; i < n; ++i){
+			for(int k = 0; k < nc; ++k){
+				q[i*nc+k] = (unsigned char)((s[i*nc+k]-vmin[k])*scale[k]+0.5f);
+			}
+		}
+	}
+}
+
+
+
+//-----------------------------------------------------------------------------
+// rxParticleCacheReader̎
+//-----------------------------------------------------------------------------
+/*!
+ * RXgN^
+ */
+rxParticleCacheReader::rxParticleCacheReader()
+{
+	m_pData = 0;
+	m_uSize = 0;
+#ifdef _WIN32
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMap = 0;
+#else
+	m_iFile = -1;
+#endif
+}
+
+/*!
+ * fXgN^
+ */
+rxParticleCacheReader::~rxParticleCacheReader()
+{
+	Close();
+}
+
+/*!
+ * LbVt@C}bvĊJ
+ *  - CfbNXe[u(ݓrŏI)t@C̓t[ubN𑖍ăCfbNX
+ * @param[in] fn t@C
+ * @return Jtrue
+ */
+bool rxParticleCacheReader::Open(const string &fn)
+{
+	Close();
+
+#ifdef _WIN32
+	m_hFile = CreateFileA(fn.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(m_hFile == INVALID_HANDLE_VALUE){
+		RXCOUT << fn << " couldn't open." << endl;
+		return false;
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx(m_hFile, &size);
+	m_uSize = (rxuint64)size.QuadPart;
+	if(m_uSize){
+		m_hMap = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(m_hMap) m_pData = (const unsigned char*)MapViewOfFile(m_hMap, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	m_iFile = open(fn.c_str(), O_RDONLY);
+	if(m_iFile < 0){
+		RXCOUT << fn << " couldn't open." << endl;
+		return false;
+	}
+	struct stat st;
+	fstat(m_iFile, &st);
+	m_uSize = (rxuint64)st.st_size;
+	if(m_uSize){
+		void *p = mmap(0, (size_t)m_uSize, PROT_READ, MAP_PRIVATE, m_iFile, 0);
+		m_pData = (p == MAP_FAILED ? 0 : (const unsigned char*)p);
+	}
+#endif
+
+	if(!m_pData || m_uSize < sizeof(rxPCacheHeader)){
+		RXCOUT << fn << " : couldn't map the file." << endl;
+		Close();
+		return false;
+	}
+
+	// wb_
+	rxPCacheHeader hdr;
+	memcpy(&hdr, m_pData, sizeof(hdr));
+	if(memcmp(hdr.magic, RX_PCACHE_MAGIC, 4) != 0 || hdr.version != RX_PCACHE_VERSION){
+		RXCOUT << fn << " is not a particle cache file." << endl;
+		Close();
+		return false;
+	}
+
+	rxuint64 start = sizeof(hdr)+sizeof(rxPCacheChannel)*hdr.num_channels;
+	if(start > m_uSize){
+		Close();
+		return false;
+	}
+	m_vChannels.resize(hdr.num_channels);
+	if(hdr.num_channels){
+		memcpy(&m_vChannels[0], m_pData+sizeof(hdr), sizeof(rxPCacheChannel)*hdr.num_channels);
+	}
+
+	// CfbNXe[u
+	if(hdr.index_offset && hdr.index_offset+sizeof(rxPCacheIndex)*hdr.num_frames <= m_uSize){
+		m_vIndex.resize((size_t)hdr.num_frames);
+		if(hdr.num_frames){
+			memcpy(&m_vIndex[0], m_pData+hdr.index_offset, sizeof(rxPCacheIndex)*hdr.num_frames);
+		}
+	}
+	else{
+		RXCOUT << fn << " : no frame index, scanning frames." << endl;
+		rebuildIndex(start);
+	}
+
+	return true;
+}
+
+/*!
+ * t@C
+ */
+void rxParticleCacheReader::Close(void)
+{
+#ifdef _WIN32
+	if(m_pData) UnmapViewOfFile(m_pData);
+	if(m_hMap) CloseHandle(m_hMap);
+	if(m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMap = 0;
+#else
+	if(m_pData) munmap((void*)m_pData, (size_t)m_uSize);
+	if(m_iFile >= 0) close(m_iFile);
+	m_iFile = -1;
+#endif
+	m_pData = 0;
+	m_uSize = 0;
+	m_vChannels.clear();
+	m_vIndex.clear();
+}
+
+/*!
+ * t[ubN擪瑖ăCfbNX쐬
+ * @param[in] start ŏ̃t[ubN̈ʒu
+ * @return 1t[ȏ㌩true
+ */
+bool rxParticleCacheReader::rebuildIndex(rxuint64 start)
+{
+	m_vIndex.clear();
+	rxuint64 offset = start;
+	while(offset+sizeof(rxPCacheFrameHeader) <= m_uSize){
+		rxPCacheFrameHeader fh;
+		memcpy(&fh, m_pData+offset, sizeof(fh));
+		if(memcmp(fh.magic, RX_PCACHE_FRAME_MAGIC, 4) != 0) break;
+
+		rxuint64 size = RxPCacheFrameSize(m_vChannels, fh.num_particles);
+		if(offset+size > m_uSize) break;
+
+		rxPCacheIndex idx;
+		memset(&idx, 0, sizeof(idx));
+		idx.frame = fh.frame;
+		idx.num_particles = fh.num_particles;
+		idx.offset = offset;
+		idx.size = size;
+		idx.time = fh.time;
+		m_vIndex.push_back(idx);
+
+		offset += size;
+	}
+	return !m_vIndex.empty();
+}
+
+/*!
+ * `lCfbNX
+ * @param[in] name `l
+ * @return `l̃CfbNX(Ȃ-1)
+ */
+int rxParticleCacheReader::GetChannelIndex(const string &name) const
+{
+	for(int c = 0; c < (int)m_vChannels.size(); ++c){
+		if(name == m_vChannels[c].name) return c;
+	}
+	return -1;
+}
+
+/*!
+ * t[ԍCfbNXe[üʒu
+ * @param[in] frame t[ԍ
+ * @return CfbNXe[üʒu(Ȃ-1)
+ */
+int rxParticleCacheReader::FindFrame(int frame) const
+{
+	// t[ԍ͏ŏ܂̂ʂȂ̂ŁC܂ʒu𒲂ׂ
+	if(frame >= 0 && frame < (int)m_vIndex.size() && m_vIndex[frame].frame == frame) return frame;
+	for(int i = 0; i < (int)m_vIndex.size(); ++i){
+		if(m_vIndex[i].frame == frame) return i;
+	}
+	return -1;
+}
+
+/*!
+ * t[ubÑ`lf[^̈ʒu
+ * @param[in] i CfbNXe[üʒu
+ * @param[in] c `l̃CfbNX
+ * @return t@C擪̃ItZbg
+ */
+rxuint64 rxParticleCacheReader::channelOffset(int i, int c) const
+{
+	const rxPCacheIndex &idx = m_vIndex[i];
+	rxuint64 offset = idx.offset+sizeof(rxPCacheFrameHeader);
+	for(int k = 0; k < c; ++k){
+		offset += RxPCacheChannelSize(m_vChannels[k], idx.num_particles);
+	}
+	return offset;
+}
+
+/*!
+ * `lf[^floatzƂĎ擾
+ * @param[in] i CfbNXe[üʒu
+ * @param[in] c `l̃CfbNX
+ * @param[out] dst `lf[^(num_particles*ncomp)
+ * @return true
+ */
+bool rxParticleCacheReader::ReadChannel(int i, int c, vector<float> &dst) const
+{
+	if(!m_pData || i < 0 || i >= (int)m_vIndex.size() || c < 0 || c >= (int)m_vChannels.size()) return false;
+
+	const rxPCacheChannel &ch = m_vChannels[c];
+	uint n = m_vIndex[i].num_particles;
+	int nc = ch.ncomp;
+	const unsigned char *src = m_pData+channelOffset(i, c);
+
+	dst.resize((size_t)n*nc);
+	if(dst.empty()) return true;
+
+	uint levels = RxPCacheLevels(ch.encoding);
+	if(!levels){
+		memcpy(&dst[0], src, dst.size()*sizeof(float));
+		return true;
+	}
+
+	vector<float> vmin(nc), dv(nc);
+	memcpy(&vmin[0], src, nc*sizeof(float));
+	memcpy(&dv[0], src+nc*sizeof(float), nc*sizeof(float));
+	for(int k = 0; k < nc; ++k){
+		dv[k] = (dv[k]-vmin[k])/levels;
+	}
+	src += 2*nc*sizeof(float);
+
+	if(ch.encoding == RX_PCACHE_QUANT16){
+		const unsigned short *q = (const unsigned short*)src;
+		for(uint j = 0; j < n; ++j){
+			for(int k = 0; k < nc; ++k){
+				dst[j*nc+k] = vmin[k]+q[j*nc+k]*dv[k];
+			}
+		}
+	}
+	else{
+		for(uint j = 0; j < n; ++j){
+			for(int k = 0; k < nc; ++k){
+				dst[j*nc+k] = vmin[k]+src[j*nc+k]*dv[k];
+			}
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * `lf[^floatzƂĎ擾
+ * @param[in] i CfbNXe[üʒu
+ * @param[in] name `l
+ * @param[out] dst `lf[^(num_particles*ncomp)
+ * @return true
+ */
+bool rxParticleCacheReader::ReadChannel(int i, const string &name, vector<float> &dst) const
+{
+	return ReadChannel(i, GetChannelIndex(name), dst);
+}
+
+/*!
+ * float32`l̃f[^𒼐ڎQ
+ * @param[in] i CfbNXe[üʒu
+ * @param[in] c `l̃CfbNX
+ * @return }bvꂽf[^ւ̃|C^(ʎq`l͈͊Ȍꍇ0)
+ */
+const float* rxParticleCacheReader::GetChannelPointer(int i, int c) const
+{
+	if(!m_pData || i < 0 || i >= (int)m_vIndex.size() || c < 0 || c >= (int)m_vChannels.size()) return 0;
+	if(m_vChannels[c].encoding != RX_PCACHE_FLOAT32) return 0;
+	return (const float*)(m_pData+channelOffset(i, c));
+}
@@ -0,0 +1,228 @@
+/*!
+  @file rx_particle_cache.h
+
+  @brief p[eBNLbV(oCi,t[CfbNXt)
+		 - 1t@Cɕt[i[C̃CfbNXe[uCӂ̃t[ɒڃANZXł
+		 - `l(ʒu,x,xȂ)Ƃfloat32/16bitʎq/8bitʎqI\
+		 - ݂̓obNOEhXbhōs(rxParticleCacheWriter)
+		 - ǂݍ݂̓t@C}bvčs(rxParticleCacheReader)
+
+		 t@C\(gGfBA)
+		 - wb_         : rxPCacheHeader + rxPCacheChannel x `l
+		 - t[ubN : rxPCacheFrameHeader + `lƂ̃f[^(ʎq͐Ƃmin,max̌ɐl)
+		 - CfbNX     : rxPCacheIndex x t[ (wb_index_offsetw)
+
+  @date   2026-10
+*/
+
+
+#ifndef _RX_PARTICLE_CACHE_H_
+#define _RX_PARTICLE_CACHE_H_
+
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+// STL
+#include <vector>
+#include <string>
+#include <deque>
+
+#include <iostream>
+#include <fstream>
+
+// C++11 Xbh
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+//-----------------------------------------------------------------------------
+// `
+//-----------------------------------------------------------------------------
+using namespace std;
+typedef unsigned int uint;
+
+#ifndef RXREAL
+	#define RXREAL float
+#endif
+
+#if defined(_MSC_VER)
+	typedef unsigned __int64 rxuint64;
+#else
+	#include <stdint.h>
+	typedef uint64_t rxuint64;
+#endif
+
+const uint RX_PCACHE_VERSION = 1;
+const int  RX_PCACHE_NAME_LEN = 16;
+
+//! `l̊i[`
+enum rxPCacheEncoding
+{
+	RX_PCACHE_FLOAT32 = 0,	//!< 32bit_(̂܂)
+	RX_PCACHE_QUANT16,		//!< Ƃmin,maxŐK16bitɗʎq
+	RX_PCACHE_QUANT8,		//!< Ƃmin,maxŐK8bitɗʎq
+};
+
+//! t@Cwb_
+struct rxPCacheHeader
+{
+	char magic[4];			//!< "RXPC"
+	uint version;			//!< tH[}bg̃o[W
+	uint num_channels;		//!< `l
+	uint reserved;
+	rxuint64 index_offset;	//!< CfbNXe[üʒu(0Ȃ疢̃t@C)
+	rxuint64 num_frames;	//!< t[
+};
+
+//! `l
+struct rxPCacheChannel
+{
+	char name[RX_PCACHE_NAME_LEN];	//!< `l("pos","vel","dens"Ȃ)
+	uint ncomp;						//!< 
+	uint encoding;					//!< i[`(rxPCacheEncoding)
+};
+
+//! t[ubÑwb_
+struct rxPCacheFrameHeader
+{
+	char magic[4];			//!< "RXFR"
+	int frame;				//!< t[ԍ
+	uint num_particles;		//!< p[eBN
+	uint reserved;
+	double time;			//!< V~[V
+};
+
+//! CfbNXe[u̗vf
+struct rxPCacheIndex
+{
+	int frame;				//!< t[ԍ
+	uint num_particles;		//!< p[eBN
+	rxuint64 offset;		//!< t[ubN̈ʒu(t@C擪)
+	rxuint64 size;			//!< t[ubÑTCY
+	double time;			//!< V~[V
+};
+
+
+//-----------------------------------------------------------------------------
+// 1t[̃f[^
+//-----------------------------------------------------------------------------
+class rxParticleCacheFrame
+{
+public:
+	int frame;					//!< t[ԍ
+	double time;				//!< V~[V
+	uint num_particles;			//!< p[eBN
+	vector< vector<float> > data;	//!< `lƂ̃f[^(num_particles*ncomp)
+
+public:
+	rxParticleCacheFrame() : frame(0), time(0.0), num_particles(0) {}
+};
+
+
+//-----------------------------------------------------------------------------
+// p[eBNLbV̏(񓯊)
+//-----------------------------------------------------------------------------
+class rxParticleCacheWriter
+{
+protected:
+	vector<rxPCacheChannel> m_vChannels;	//!< `l
+	vector<rxPCacheIndex> m_vIndex;			//!< t[CfbNX
+
+	ofstream m_fOut;						//!< o̓t@C
+	string m_strFileName;					//!< o̓t@C
+	rxuint64 m_uOffset;						//!< ݂݈̏ʒu
+
+	thread m_Thread;						//!< ݃Xbh
+	mutex m_Mutex;
+	condition_variable m_CondPush;			//!< t[ǉ̒ʒm
+	condition_variable m_CondPop;			//!< t[݊̒ʒm
+	deque<rxParticleCacheFrame*> m_qFrames;	//!< ݑ҂t[
+	vector<rxParticleCacheFrame*> m_vPool;	//!< ėpt[obt@
+	int m_iMaxQueue;						//!< ݑ҂̍őt[
+	bool m_bOpen;
+	bool m_bQuit;
+
+	vector<unsigned char> m_vBuf;			//!< GR[hpobt@(݃Xbĥ݂g)
+
+public:
+	rxParticleCacheWriter();
+	~rxParticleCacheWriter();
+
+	//! `l̒ǉ(Open̑OɌĂ)
+	int AddChannel(const string &name, int ncomp, int encoding = RX_PCACHE_FLOAT32);
+
+	bool Open(const string &fn, int max_queue = 8);
+	void Close(void);
+	bool IsOpen(void) const { return m_bOpen; }
+
+	int GetNumChannels(void) const { return (int)m_vChannels.size(); }
+	int GetChannelIndex(const string &name) const;
+	const rxPCacheChannel& GetChannel(int c) const { return m_vChannels[c]; }
+
+	//! ݗpt[obt@擾(`lƂ̔znum_particles*ncompɊmۍς)
+	rxParticleCacheFrame* BeginFrame(int frame, double time, uint num_particles);
+
+	//! t[݃L[ɒǉ(ȍ~frame͏݃XbhL)
+	void EndFrame(rxParticleCacheFrame *frame);
+
+	//! L[ɂȂ܂ő҂
+	void Flush(void);
+
+protected:
+	void run(void);
+	void writeFrame(const rxParticleCacheFrame &f);
+	void encodeChannel(const rxPCacheChannel &ch, const vector<float> &src, uint n);
+};
+
+
+//-----------------------------------------------------------------------------
+// p[eBNLbV̓ǂݍ(}bv)
+//-----------------------------------------------------------------------------
+class rxParticleCacheReader
+{
+protected:
+	const unsigned char *m_pData;			//!< }bvꂽt@C̐擪
+	rxuint64 m_uSize;						//!< t@CTCY
+
+#ifdef _WIN32
+	void *m_hFile, *m_hMap;
+#else
+	int m_iFile;
+#endif
+
+	vector<rxPCacheChannel> m_vChannels;	//!< `l
+	vector<rxPCacheIndex> m_vIndex;			//!< t[CfbNX
+
+public:
+	rxParticleCacheReader();
+	~rxParticleCacheReader();
+
+	bool Open(const string &fn);
+	void Close(void);
+	bool IsOpen(void) const { return m_pData != 0; }
+
+	int GetNumFrames(void) const { return (int)m_vIndex.size(); }
+	int GetNumChannels(void) const { return (int)m_vChannels.size(); }
+	int GetChannelIndex(const string &name) const;
+	const rxPCacheChannel& GetChannel(int c) const { return m_vChannels[c]; }
+	const rxPCacheIndex& GetFrameInfo(int i) const { return m_vIndex[i]; }
+
+	//! t[ԍCfbNXe[üʒu(Ȃ-1)
+	int FindFrame(int frame) const;
+
+	//! `lf[^floatzƂĎ擾(ʎqĂΕ)
+	bool ReadChannel(int i, int c, vector<float> &dst) const;
+	bool ReadChannel(int i, const string &name, vector<float> &dst) const;
+
+	//! float32`l̃f[^𒼐ڎQ(Rs[Ȃ,ʎq`lł0)
+	const float* GetChannelPointer(int i, int c) const;
+
+protected:
+	bool rebuildIndex(rxuint64 start);
+	rxuint64 channelOffset(int i, int c) const;
+};
+
+
+#endif // #ifndef _RX_PARTICLE_CACHE_H_
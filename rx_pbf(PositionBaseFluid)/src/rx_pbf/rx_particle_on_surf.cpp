@@ -40,15 +40,36 @@ rxParticleOnSurf::rxParticleOnSurf()
 	m_fDelta = 0.7;
 
 	m_pFuncPtr = 0;
+	m_fpFunc = 0;
+	m_fpFuncBatch = 0;
 }
 
 /*!
  * p[eBN
  * @param[in] vrts p[eBNʒu
  * @param[in] rad p[eBNa
+ * @param[in] minp,maxp p[eBN݂͈
+ * @param[in] func A֐lƌzvZ֐(1_Ă΂)
+ * @param[in] func_ptr funcɓn|C^
  */
 void rxParticleOnSurf::Initialize(const vector<Vec3> &vrts, double rad, Vec3 minp, Vec3 maxp, 
 								   Vec4 (*func)(void*, double, double, double), void* func_ptr)
+{
+	Initialize(vrts, rad, minp, maxp, (void (*)(void*, const RXREAL*, int, int, Vec4*))0, func_ptr);
+	m_fpFunc = func;
+}
+
+/*!
+ * p[eBN
+ *  - A֐l͑Sp[eBN܂Ƃ߂1̌ĂяoŌvZ
+ * @param[in] vrts p[eBNʒu
+ * @param[in] rad p[eBNa
+ * @param[in] minp,maxp p[eBN݂͈
+ * @param[in] func A֐lƌz܂Ƃ߂ČvZ֐(Wz,W̗vf,_,)
+ * @param[in] func_ptr funcɓn|C^
+ */
+void rxParticleOnSurf::Initialize(const vector<Vec3> &vrts, double rad, Vec3 minp, Vec3 maxp, 
+								   void (*func)(void*, const RXREAL*, int, int, Vec4*), void* func_ptr)
 {
 	m_fParticleRadius = rad;
 	m_fEffectiveRadius = 3.0*m_fParticleRadius;
@@ -57,12 +78,14 @@ void rxParticleOnSurf::Initialize(const vector<Vec3> &vrts, double rad, Vec3 min
 
 	m_uNumParticles = (uint)vrts.size();
 
-	m_fpFunc = func;
+	m_fpFunc = 0;
+	m_fpFuncBatch = func;
 	m_pFuncPtr = func_ptr;
 
 	// m
 	m_vPos.resize(m_uNumParticles*DIM, 0.0);
 	m_vPs.resize(m_uNumParticles);
+	m_vFv.resize(m_uNumParticles);
 
 
 	// p[eBNʒu
@@ -86,6 +109,25 @@ void rxParticleOnSurf::Finalize(void)
 {
 	m_vPos.clear();
 	m_vPs.clear();
+	m_vFv.clear();
+}
+
+/*!
+ * Sp[eBNʒuł̉A֐lƌžvZ
+ *  - ܂Ƃ߂ČvZ֐ݒ肳Ă1񂾂Ăяo
+ */
+void rxParticleOnSurf::calImplicit(void)
+{
+	if(!m_uNumParticles) return;
+
+	if(m_fpFuncBatch){
+		m_fpFuncBatch(m_pFuncPtr, &m_vPos[0], DIM, (int)m_uNumParticles, &m_vFv[0]);
+	}
+	else{
+		for(uint i = 0; i < m_uNumParticles; ++i){
+			m_vFv[i] = m_fpFunc(m_pFuncPtr, m_vPos[DIM*i+0], m_vPos[DIM*i+1], m_vPos[DIM*i+2]);
+		}
+	}
 }
 
 /*!
@@ -97,7 +139,8 @@ void rxParticleOnSurf::updateSigma(double dt)
 {
 	RXREAL h = m_fEffectiveRadius;
 
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 pos0(m_vPos[DIM*i+0], m_vPos[DIM*i+1], m_vPos[DIM*i+2]);
 		RXREAL si = m_vPs[i].Sigma;
 
@@ -144,7 +187,8 @@ void rxParticleOnSurf::applyRepulsion2(double dt)
 	// repulsion radius ̍XV
 	updateSigma(dt);
 
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 pos0(m_vPos[DIM*i+0], m_vPos[DIM*i+1], m_vPos[DIM*i+2]);
 		RXREAL si = m_vPs[i].Sigma;
 
@@ -188,7 +232,8 @@ void rxParticleOnSurf::applyRepulsion(double dt)
 	// ߖTTZփp[eBNi[ & ߖTT
 	SetParticlesToCell();
 
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 pos0(m_vPos[DIM*i+0], m_vPos[DIM*i+1], m_vPos[DIM*i+2]);
 		RXREAL si = m_vPs[i].Sigma;
 
@@ -224,12 +269,15 @@ void rxParticleOnSurf::applyFloating(double dt, double &v_avg)
 	v_avg = 0.0;
 	if(!m_uNumParticles) return;
 
-	RXREAL h = m_fEffectiveRadius;
-	for(uint i = 0; i < m_uNumParticles; ++i){
-		Vec3 p(m_vPos[DIM*i+0], m_vPos[DIM*i+1], m_vPos[DIM*i+2]);	// ݂̃p[eBNW
+	// p[eBNWɂA֐lƂ̌z擾
+	calImplicit();
+
+	double v2 = 0.0;
+	#pragma omp parallel for reduction(+:v2)
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 ve = m_vPs[i].Ep;	// ɂ鑬x
 
-		Vec4 fv = m_fpFunc(m_pFuncPtr, p[0], p[1], p[2]);	// p[eBNWɂA֐lƂ̌z擾
+		const Vec4 &fv = m_vFv[i];
 		Vec3 fx(fv[0], fv[1], fv[2]);	// z
 		RXREAL f = fv[3];				// A֐l
 
@@ -242,9 +290,9 @@ void rxParticleOnSurf::applyFloating(double dt, double &v_avg)
 
 		m_vPs[i].Vel = v;
 
-		v_avg += norm2(v*dt);
+		v2 += norm2(v*dt);
 	}
-	v_avg /= m_uNumParticles;
+	v_avg = v2/m_uNumParticles;
 }
 
 /*!
@@ -258,18 +306,21 @@ void rxParticleOnSurf::testFissionDeath(void)
 	// ߖTTZփp[eBNi[ & ߖTT
 	SetParticlesToCell();
 
-	int num_remove = 0, num_fission = 0;
+	// p[eBNWɂA֐lƂ̌z擾
+	calImplicit();
+
+	// tԂɋ߂p[eBN̔GlMĎvZ(tԂłȂ-1)
+	int n = (int)m_uNumParticles;
 	RXREAL h = m_fEffectiveRadius;
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	vector<double> energy(n);
+	#pragma omp parallel for
+	for(int i = 0; i < n; ++i){
 		Vec3 p(m_vPos[DIM*i+0], m_vPos[DIM*i+1], m_vPos[DIM*i+2]);	// p[eBNW
 		Vec3 v = m_vPs[i].Vel;	// p[eBNx
 		RXREAL si = m_vPs[i].Sigma;	// a
 
-		RXREAL vp = norm(v);
-
-		// p[eBNtԂɋ߂ǂ
-		if(vp < m_fGamma*si){
-			// GlMĎvZ
+		energy[i] = -1.0;
+		if(norm(v) < m_fGamma*si){
 			double D = 0.0;
 			for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
 				int j = itr->Idx;
@@ -283,6 +334,18 @@ void rxParticleOnSurf::testFissionDeath(void)
 					D += Eij;			// GlM
 				}
 			}
+			energy[i] = D;
+		}
+	}
+
+	// /폜̔(̏ԂςȂ悤Ƀp[eBNɏ)
+	int num_remove = 0, num_fission = 0;
+	for(int i = 0; i < n; ++i){
+		RXREAL si = m_vPs[i].Sigma;	// a
+
+		// p[eBNtԂɋ߂ǂ
+		if(energy[i] >= 0.0){
+			double D = energy[i];
 			RXREAL R = RXFunc::Frand();	// [0,1]̗
 
 			// Ђ傫 or GlM[K؂ŃЂKlȏ  (p[eBNǉ)
@@ -295,36 +358,31 @@ void rxParticleOnSurf::testFissionDeath(void)
 				m_vPs[i].Flag = 2;	// 폜tOON
 				num_remove++;
 			}
-
 		}
 
 		// \ʂ痣ꂷp[eBN폜
-		Vec4 fv = m_fpFunc(m_pFuncPtr, p[0], p[1], p[2]);	// p[eBNWɂA֐lƂ̌z擾
-		RXREAL f = fv[3];				// A֐l
+		RXREAL f = m_vFv[i][3];				// A֐l
 		if(fabs(f) > 2.0*m_fSmax){
 			m_vPs[i].Flag = 2;	// 폜tOON
 			num_remove++;
 		}
 	}
 
-	// p[eBN폜
+	// p[eBN폜(cp[eBNOɋl߂)
 	if(num_remove){
-		int cnt = 0;
-		vector<rxSurfParticle>::iterator itr = m_vPs.begin();
-		vector<RXREAL>::iterator jtr = m_vPos.begin();
-		while(itr != m_vPs.end()){
-			if(itr->Flag == 2){
-				itr = m_vPs.erase(itr);
-				jtr = m_vPos.erase(jtr, jtr+DIM);
-				cnt++;
-			}
-			else{
-				++itr;
-				jtr += DIM;
+		int m = 0;
+		for(int i = 0; i < n; ++i){
+			if(m_vPs[i].Flag == 2) continue;
+			if(m != i){
+				m_vPs[m] = m_vPs[i];
+				for(int l = 0; l < DIM; ++l) m_vPos[DIM*m+l] = m_vPos[DIM*i+l];
 			}
+			m++;
 		}
-		m_uNumParticles = (int)m_vPs.size();
-		//cout << cnt << " particles are removed." << endl;
+		m_vPs.resize(m);
+		m_vPos.resize(DIM*m);
+		m_uNumParticles = m;
+		//cout << n-m << " particles are removed." << endl;
 	}
 }
 
@@ -336,7 +394,7 @@ void rxParticleOnSurf::testFissionDeath(void)
  */
 void rxParticleOnSurf::Update(double dt, int &num_iter, RXREAL &eps)
 {
-	double v_avg;
+	double v_avg = 0.0;
 	int k;
 	for(k = 0; k < num_iter; ++k){
 		// ɂ鑬x̌vZ
@@ -405,6 +463,7 @@ void rxParticleOnSurf::SetParticlesToCell(RXREAL *prts, int n, RXREAL h)
 
 	// ߖTqT
 	if(h < 0.0) h = m_fEffectiveRadius;
+	#pragma omp parallel for
 	for(int i = 0; i < (int)m_uNumParticles; i++){
 		m_vNeighs[i].clear();
 		GetNearestNeighbors(i, prts, m_vNeighs[i], h);
@@ -27,6 +27,10 @@
 #include "rx_utility.h"
 #include "rx_nnsearch.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 //-----------------------------------------------------------------------------
 // `
@@ -86,6 +90,8 @@ protected:
 
 	void *m_pFuncPtr;
 	Vec4 (*m_fpFunc)(void*, double, double, double);
+	void (*m_fpFuncBatch)(void*, const RXREAL*, int, int, Vec4*);	//!< _̉A֐lƌz܂Ƃ߂ČvZ֐(W,W̗vf,_,)
+	vector<Vec4> m_vFv;				//!< p[eBNʒuł̉A֐zƒl(0`2:z,3:l)
 
 	rxNNGrid *m_pNNGrid;			//!< ObhɂߖTT
 	vector< vector<rxNeigh> > m_vNeighs;	//!< ߖTp[eBN
@@ -100,6 +106,8 @@ public:
 	// p[eBN&j
 	void Initialize(const vector<Vec3> &vrts, double rad, Vec3 minp, Vec3 maxp, 
 					Vec4 (*func)(void*, double, double, double), void* func_ptr);
+	void Initialize(const vector<Vec3> &vrts, double rad, Vec3 minp, Vec3 maxp, 
+					void (*func)(void*, const RXREAL*, int, int, Vec4*), void* func_ptr);
 	void Finalize(void);
 
 	//! p[eBN
@@ -128,6 +136,9 @@ protected:
 	//!< p[eBN/j̔
 	void testFissionDeath(void);
 
+	//! Sp[eBNʒuł̉A֐lƌžvZ(m_vFvɊi[)
+	void calImplicit(void);
+
 public:
 	// ߖT擾
 	void GetNearestNeighbors(Vec3 pos, vector<rxNeigh> &neighs, RXREAL h = -1.0);
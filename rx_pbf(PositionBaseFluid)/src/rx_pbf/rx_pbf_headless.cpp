@@ -0,0 +1,312 @@
+/*!
+  @file rx_pbf_headless.cpp
+
+  @brief OpenGL/FLTKgȂob`s
+		 - V[t@CǂݍrxPBDSPHNt[vZCp[eBNƕ\ʃbVt@Cɏo͂
+		 - RX_HEADLESS`ărh(CMakeLists.txtQ)
+		 - g : rx_pbf_headless scene.cfg [-f t[] [-s 1t[̃Xebv] [-o o̓tH_]
+		                                      [-m] [-mn bV𑜓x] [-mt bV臒l] [-ms] [-np] [-j Xbh]
+		                                      [-c] [-cq ʎqrbg] [-cp `FbN|CgԊu] [-r `FbN|Cgt@C] [-p]
+
+  @date   2026-10
+*/
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+#include "rx_sph_config.h"
+#include "rx_mc.h"
+
+
+//-----------------------------------------------------------------------------
+// O[oϐ
+//-----------------------------------------------------------------------------
+int g_iIterations = 0;			//!< C
+double g_fEta = 0.0;			//!< xϓ
+int g_iNeighborBuilds = 0;		//!< ߖTXg쐬
+int g_iSubsteps = 0;			//!< TuXebv
+rxTimerAvg g_Time;				//!< vZԌvp(RXTIMER)
+
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+/*!
+ * bVOBJt@CƂĕۑ
+ *  - rxOBJ(rx_model.lib)ɈˑȂ悤ɒڏo
+ * @param[in] fn t@C
+ * @param[in] vrts,nrms _Wƒ_@
+ * @param[in] faces |S
+ * @return ۑɐtrue
+ */
+static bool SaveMeshOBJ(const string &fn, const vector<Vec3> &vrts, const vector<Vec3> &nrms, const vector<rxFace> &faces)
+{
+	ofstream fout(fn.c_str(), ios::out);
+	if(!fout) return false;
+
+	bool use_nrm = (nrms.size() == vrts.size());
+	for(int i = 0; i < (int)vrts.size(); ++i){
+		fout << "v " << vrts[i][0] << " " << vrts[i][1] << " " << vrts[i][2] << "\n";
+	}
+	if(use_nrm){
+		for(int i = 0; i < (int)nrms.size(); ++i){
+			fout << "vn " << nrms[i][0] << " " << nrms[i][1] << " " << nrms[i][2] << "\n";
+		}
+	}
+	for(int i = 0; i < (int)faces.size(); ++i){
+		fout << "f";
+		for(int j = 0; j < (int)faces[i].vert_idx.size(); ++j){
+			int v = faces[i].vert_idx[j]+1;
+			if(use_nrm){
+				fout << " " << v << "//" << v;
+			}
+			else{
+				fout << " " << v;
+			}
+		}
+		fout << "\n";
+	}
+
+	return true;
+}
+
+/*!
+ * \ʃbV̐ƕۑ(MC@,CPU)
+ * @param[in] ps p[eBNVXe
+ * @param[in] nmax bVObh𑜓x(ő)
+ * @param[in] thr bV臒l
+ * @param[in] sparse aȃubNObhg
+ * @param[in] fn o̓t@C
+ * @return |S
+ */
+static int SaveSurfaceMesh(rxParticleSystemBase *ps, int nmax, double thr, bool sparse, const string &fn)
+{
+	Vec3 minp = ps->GetMin();
+	Vec3 maxp = ps->GetMax();
+
+	double h;
+	int n[3];
+	CalMeshDiv(minp, maxp, nmax, h, n, 0.05);
+
+	// p[eBNObh_̉A֐lvZ(Obh_̓Z+1)
+	int nv[3] = {n[0]+1, n[1]+1, n[2]+1};
+	vector<Vec3> vrts, nrms;
+	vector<rxFace> faces;
+	rxMCMeshCPU mc;
+	if(sparse){
+		rxSparseBrickGrid grid;
+		ps->CalImplicitFieldSparse(nv, minp, Vec3(h), grid);
+		mc.CreateMeshSparse(grid, thr, vrts, nrms, faces);
+	}
+	else{
+		vector<RXREAL> field(nv[0]*nv[1]*nv[2]);
+		ps->CalImplicitField(nv, minp, Vec3(h), &field[0]);
+		mc.CreateMeshV(&field[0], minp, h, n, thr, vrts, nrms, faces);
+	}
+
+	if(!SaveMeshOBJ(fn, vrts, nrms, faces)){
+		RXCOUT << fn << " couldn't open." << endl;
+	}
+
+	return (int)faces.size();
+}
+
+/*!
+ * g̕\
+ */
+static void Usage(const char *name)
+{
+	cout << "usage: " << name << " scene.cfg [options]" << endl;
+	cout << "  -f n   : number of frames (default 100)" << endl;
+	cout << "  -s n   : simulation steps per frame (default 1)" << endl;
+	cout << "  -o dir : output directory (default " << RX_DEFAULT_RESULT_DIR << ")" << endl;
+	cout << "  -m     : output surface meshes (obj)" << endl;
+	cout << "  -mn n  : max. grid resolution for meshing (default mesh_res_max in the scene)" << endl;
+	cout << "  -mt t  : threshold for meshing (default 750)" << endl;
+	cout << "  -ms    : use a sparse brick grid for meshing (default mesh_sparse in the scene)" << endl;
+	cout << "  -np    : no particle output" << endl;
+	cout << "  -j n   : number of threads (default num_threads in the scene)" << endl;
+	cout << "  -c     : output particles to a single cache file (sph_particles.rxpc) instead of dat files" << endl;
+	cout << "  -cq b  : quantize velocity and density in the cache to b (8 or 16) bits" << endl;
+	cout << "  -cp n  : save a checkpoint (checkpoint.rxcp) every n frames" << endl;
+	cout << "  -r fn  : resume from the checkpoint file" << endl;
+	cout << "  -p     : profile each step and write profile_trace.json (chrome trace) and profile.csv" << endl;
+}
+
+
+//-----------------------------------------------------------------------------
+// C֐
+//-----------------------------------------------------------------------------
+/*!
+ * C[`
+ * @param[in] argc R}hC̐
+ * @param[in] argv R}hC
+ */
+int main(int argc, char *argv[])
+{
+	if(argc < 2){
+		Usage(argv[0]);
+		return 1;
+	}
+
+	string scene_file = argv[1];
+	int frames = 100;
+	int steps = 1;
+	string out_dir = RX_DEFAULT_RESULT_DIR;
+	bool out_mesh = false;
+	bool out_particles = true;
+	int mesh_n = -1;
+	double mesh_thr = 750.0;
+	int mesh_sparse = -1;
+	int threads = -1;
+	bool out_cache = false;
+	int cache_bits = 32;
+	int cp_span = 0;
+	string cp_file;
+	bool profile = false;
+
+	for(int i = 2; i < argc; ++i){
+		string opt = argv[i];
+		bool has_arg = (i+1 < argc);
+		if(opt == "-f" && has_arg)		 frames = atoi(argv[++i]);
+		else if(opt == "-s" && has_arg)	 steps = atoi(argv[++i]);
+		else if(opt == "-o" && has_arg)	 out_dir = argv[++i];
+		else if(opt == "-m")			 out_mesh = true;
+		else if(opt == "-mn" && has_arg) mesh_n = atoi(argv[++i]);
+		else if(opt == "-mt" && has_arg) mesh_thr = atof(argv[++i]);
+		else if(opt == "-ms")			 mesh_sparse = 1;
+		else if(opt == "-np")			 out_particles = false;
+		else if(opt == "-j" && has_arg)	 threads = atoi(argv[++i]);
+		else if(opt == "-c")			 out_cache = true;
+		else if(opt == "-cq" && has_arg) cache_bits = atoi(argv[++i]);
+		else if(opt == "-cp" && has_arg) cp_span = atoi(argv[++i]);
+		else if(opt == "-r" && has_arg)	 cp_file = argv[++i];
+		else if(opt == "-p")			 profile = true;
+		else{
+			Usage(argv[0]);
+			return 1;
+		}
+	}
+	if(!out_dir.empty() && out_dir[out_dir.size()-1] != '/') out_dir += "/";
+
+	if(!ExistFile(scene_file)){
+		RXCOUT << scene_file << " couldn't find." << endl;
+		return 1;
+	}
+
+	// \ȍ(VBO͎gȂ)
+	rxPBDSPH *ps = new rxPBDSPH(false);
+
+	rxSceneConfig scene;
+	scene.SetCurrentSceneFile(scene_file);
+	scene.Set(ps);
+	if(!scene.LoadSpaceFromFile()){
+		delete ps;
+		return 1;
+	}
+
+	rxEnviroment env = scene.GetEnv();
+	if(threads > 0) env.num_threads = threads;
+	if(mesh_n <= 0) mesh_n = env.mesh_max_n;
+	if(mesh_sparse < 0) mesh_sparse = env.mesh_sparse;
+	ps->Initialize(env);
+
+	// p[eBNCő̂̔zu
+	ps->Reset(rxParticleSystemBase::RX_CONFIG_NONE);
+	scene.LoadSceneFromFile();
+	ps->InitBoundary();
+
+	// `FbN|Cg̍ĊJ
+	int step = 0;
+	if(!cp_file.empty() && !ps->LoadCheckpoint(cp_file, step)){
+		delete ps;
+		return 1;
+	}
+	int start_frame = step/steps;
+
+	if(out_particles || out_mesh || cp_span > 0 || profile) MkDir(out_dir);
+
+	// p[eBNLbV(݂͕ʃXbh)
+	rxParticleCacheWriter cache;
+	if(out_particles && out_cache){
+		int enc = (cache_bits == 8 ? RX_PCACHE_QUANT8 : (cache_bits == 16 ? RX_PCACHE_QUANT16 : RX_PCACHE_FLOAT32));
+		cache.AddChannel("pos", 3, RX_PCACHE_FLOAT32);
+		cache.AddChannel("vel", 3, enc);
+		cache.AddChannel("dens", 1, enc);
+		string fn = (start_frame ? CreateFileName(out_dir+"sph_particles_", "rxpc", start_frame, 5) : out_dir+"sph_particles.rxpc");
+		if(!cache.Open(fn)) out_cache = false;
+	}
+
+	// vt@C(Xbh܂ɗLɂ)
+	rxProfiler &prof = rxProfiler::Get();
+	prof.Enable(profile);
+
+	// V~[V
+	RXREAL dt = env.dt;
+	long long total_iters = 0, total_builds = 0, total_steps = 0, total_substeps = 0;
+	double t0 = RX_GET_TIME();
+	for(int frame = start_frame; frame < frames; ++frame){
+		int builds = 0, substeps = 0;
+		for(int s = 0; s < steps; ++s){
+			prof.BeginStep(step);
+			ps->Update(dt, step);
+			prof.EndStep();
+			step++;
+
+			builds += g_iNeighborBuilds;
+			substeps += g_iSubsteps;
+			total_iters += g_iIterations;
+			total_steps++;
+		}
+		total_builds += builds;
+		total_substeps += substeps;
+
+		if(out_particles){
+			if(out_cache){
+				ps->OutputParticles(cache, frame);
+			}
+			else{
+				ps->OutputParticles(CreateFileName(out_dir+"sph_particles_", "dat", frame, 5));
+			}
+		}
+
+		int npolys = 0;
+		if(out_mesh){
+			RXPROF_ZONE("surface mesh");
+			npolys = SaveSurfaceMesh(ps, mesh_n, mesh_thr, mesh_sparse != 0, CreateFileName(out_dir+"sph_", "obj", frame, 5));
+		}
+
+		RXCOUT << "frame " << frame << " : step = " << step << ", particles = " << ps->GetNumParticles()
+			   << ", iterations = " << g_iIterations << ", eta = " << g_fEta << ", neighbor builds = " << builds
+			   << ", substeps = " << substeps;
+		if(out_mesh) cout << ", polygons = " << npolys;
+		cout << endl;
+
+		// `FbN|Cg(ݓrŒfĂÕt@Cc悤Ɉꎞt@Cu)
+		if(cp_span > 0 && (frame+1)%cp_span == 0){
+			string fn = out_dir+"checkpoint.rxcp";
+			if(ps->SaveCheckpoint(fn+".tmp", step)){
+				remove(fn.c_str());
+				rename((fn+".tmp").c_str(), fn.c_str());
+			}
+		}
+	}
+	cache.Close();
+	double t1 = RX_GET_TIME();
+	RXCOUT << "total : " << (t1-t0)*RX_GET_TIME2SEC() << " [s]" << endl;
+	if(total_steps){
+		RXCOUT << "average per step : iterations = " << (double)total_iters/total_steps 
+			   << ", neighbor builds = " << (double)total_builds/total_steps 
+			   << ", substeps = " << (double)total_substeps/total_steps << endl;
+	}
+
+	if(profile){
+		prof.WriteChromeTrace(out_dir+"profile_trace.json");
+		prof.WriteCSV(out_dir+"profile.csv");
+		RXCOUT << "profile : " << out_dir << "profile_trace.json, " << out_dir << "profile.csv (" << prof.GetNumSteps() << " steps)" << endl;
+	}
+
+	delete ps;
+
+	return 0;
+}
@@ -19,6 +19,34 @@
 //-----------------------------------------------------------------------------
 double g_fSurfThr[2] = {0.25, 0.35};
 
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+/*!
+ * 10rbg̐3rbgɓWJ
+ * @param[in] v 10rbg̐
+ * @return WJ̒l
+ */
+static inline uint RxExpandBits10(uint v)
+{
+	v = (v*0x00010001u) & 0xFF0000FFu;
+	v = (v*0x00000101u) & 0x0F00F00Fu;
+	v = (v*0x00000011u) & 0xC30C30C3u;
+	v = (v*0x00000005u) & 0x49249249u;
+	return v;
+}
+
+/*!
+ * 3Morton(Z-order)
+ * @param[in] x,y,z e̐W([0,1023])
+ * @return 30rbgMorton
+ */
+static inline uint RxMortonCode3(uint x, uint y, uint z)
+{
+	return (RxExpandBits10(x) << 2) | (RxExpandBits10(y) << 1) | RxExpandBits10(z);
+}
+
 //-----------------------------------------------------------------------------
 // rxParticleSystemBaseNX̎
 //-----------------------------------------------------------------------------
@@ -29,11 +57,12 @@ double g_fSurfThr[2] = {0.25, 0.35};
  */
 bool rxParticleSystemBase::Set(const vector<Vec3> &ppos, const vector<Vec3> &pvel)
 {
-	if(ppos.empty() || (int)ppos.size() != m_uNumParticles){
+	if(ppos.empty() || ppos.size() != m_uNumParticles){
 		return false;
 	}
 
-	int p = 0;
+	clearParticleIds();
+
 	for(uint i = 0; i < m_uNumParticles; ++i){
 		Vec3 p0 = ppos[i];
 		Vec3 v0 = pvel[i];
@@ -64,11 +93,12 @@ bool rxParticleSystemBase::Set(const vector<Vec3> &ppos, const vector<Vec3> &pve
  */
 void rxParticleSystemBase::Reset(rxParticleConfig config)
 {
+	clearParticleIds();
+
 	switch(config){
 	default:
 	case RX_CONFIG_RANDOM:
 		{
-			int p = 0;
 			for(uint i = 0; i < m_uNumParticles; ++i){
 				Vec3 p0 = 2*Vec3(RX_FRAND(), RX_FRAND(), RX_FRAND())-0.5;
 				for(uint j = 0; j < 3; ++j){
@@ -148,13 +178,14 @@ void rxParticleSystemBase::AddSphere(int start, RXREAL *pos, RXREAL *vel, int r,
 				RXREAL l = sqrtf(dx[0]*dx[0]+dx[1]*dx[1]+dx[2]*dx[2]);
 				RXREAL jitter = spacing*0.01f;
 				if((l <= spacing*r) && (index < m_uNumParticles)) {
+					uint idx = particleSlot(index);
 					for(uint j = 0; j < 3; ++j){
-						m_hPos[DIM*index+j] = pos[j]+dx[j]+(RX_FRAND()*2.0f-1.0f)*jitter;
-						m_hVel[DIM*index+j] = vel[j];
+						m_hPos[DIM*idx+j] = pos[j]+dx[j]+(RX_FRAND()*2.0f-1.0f)*jitter;
+						m_hVel[DIM*idx+j] = vel[j];
 					}
 					if(DIM == 4){
-						m_hPos[DIM*index+3] = 0.0f;
-						m_hVel[DIM*index+3] = 0.0f;
+						m_hPos[DIM*idx+3] = 0.0f;
+						m_hVel[DIM*idx+3] = 0.0f;
 					}
 
 					index++;
@@ -172,8 +203,15 @@ void rxParticleSystemBase::AddSphere(int start, RXREAL *pos, RXREAL *vel, int r,
 		m_uNumParticles += count;
 	}
 
-	SetArrayVBO(RX_POSITION, m_hPos, start, index);
-	SetArrayVBO(RX_VELOCITY, m_hVel, start, index);
+	if(m_vIdx.empty()){
+		SetArrayVBO(RX_POSITION, m_hPos, start, index);
+		SetArrayVBO(RX_VELOCITY, m_hVel, start, index);
+	}
+	else{
+		// ёւ͏ݐ悪AĂȂ̂őŜXV
+		SetArrayVBO(RX_POSITION, m_hPos, 0, m_uNumParticles);
+		SetArrayVBO(RX_VELOCITY, m_hVel, 0, m_uNumParticles);
+	}
 
 	SetParticlesToCell();
 
@@ -222,13 +260,14 @@ void rxParticleSystemBase::AddBox(int start, Vec3 cen, Vec3 ext, Vec3 vel, RXREA
 				dx[1] = y*spacing;
 				dx[2] = z*spacing;
 
+				uint idx = particleSlot(index);
 				for(uint j = 0; j < 3; ++j){
-					m_hPos[DIM*index+j] = cen[j]+dx[j]+(RX_FRAND()*2.0f-1.0f)*jitter;
-					m_hVel[DIM*index+j] = vel[j];
+					m_hPos[DIM*idx+j] = cen[j]+dx[j]+(RX_FRAND()*2.0f-1.0f)*jitter;
+					m_hVel[DIM*idx+j] = vel[j];
 				}
 				if(DIM == 4){
-					m_hPos[DIM*index+3] = 0.0f;
-					m_hVel[DIM*index+3] = 0.0f;
+					m_hPos[DIM*idx+3] = 0.0f;
+					m_hVel[DIM*idx+3] = 0.0f;
 				}
 
 				index++;
@@ -307,13 +346,15 @@ int rxParticleSystemBase::addParticles(int &start, rxInletLine line)
 				over = true;
 			}
 
+			// startindex͊OIDȂ̂ŁCёւ͑ΉzCfbNXɏ
+			uint idx = particleSlot(index);
 			for(int k = 0; k < 3; ++k){
-				m_hPos[DIM*index+k] = line.pos1[k]+rel[k]*(i+0.5)/n+(RX_FRAND()*2.0f-1.0f)*jitter;
-				m_hVel[DIM*index+k] = line.vel[k];
+				m_hPos[DIM*idx+k] = line.pos1[k]+rel[k]*(i+0.5)/n+(frand()*2.0f-1.0f)*jitter;
+				m_hVel[DIM*idx+k] = line.vel[k];
 			}
 			if(DIM == 4){
-				m_hPos[DIM*index+3] = 0.0f;
-				m_hVel[DIM*index+3] = 0.0f;
+				m_hPos[DIM*idx+3] = 0.0f;
+				m_hVel[DIM*idx+3] = 0.0f;
 			}
 			index++;
 			count++;
@@ -363,6 +404,7 @@ int rxParticleSystemBase::addParticles(int &start, rxInletLine line)
  */
 RXREAL rxParticleSystemBase::SetColorVBOFromArray(RXREAL *hVal, int d, bool use_max, RXREAL vmax)
 {
+#ifndef RX_HEADLESS
 	if(m_bUseOpenGL){
 		RXREAL l = 1.0;
 
@@ -398,6 +440,7 @@ RXREAL rxParticleSystemBase::SetColorVBOFromArray(RXREAL *hVal, int d, bool use_
 
 		return max_val;
 	}
+#endif
 
 	return (RXREAL)0.0;
 }
@@ -409,6 +452,7 @@ RXREAL rxParticleSystemBase::SetColorVBOFromArray(RXREAL *hVal, int d, bool use_
  */
 int rxParticleSystemBase::OutputParticles(string fn)
 {
+	RXPROF_ZONE("output particles");
 	ofstream fout;
 	fout.open(fn.c_str(), ios::out|ios::binary);
 	if(!fout){
@@ -418,18 +462,18 @@ int rxParticleSystemBase::OutputParticles(string fn)
 	m_hPos = GetArrayVBO(RX_POSITION);
 	m_hVel = GetArrayVBO(RX_VELOCITY);
 
-	fout.write((char*)&m_uNumParticles, sizeof(uint));
-	//fout << m_uNumParticles << endl;
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	// ёւ̉e󂯂Ȃ悤ɊOID̏ŋl߂Ăxɏo
+	uint n = m_uNumParticles;
+	vector<RXREAL> buf(6*n);
+	for(uint id = 0; id < n; ++id){
+		uint i = particleSlot(id);
 		for(int j = 0; j < 3; ++j){
-			fout.write((char*)&m_hPos[DIM*i+j], sizeof(RXREAL));
-		}
-	}
-	for(uint i = 0; i < m_uNumParticles; ++i){
-		for(int j = 0; j < 3; ++j){
-			fout.write((char*)&m_hVel[DIM*i+j], sizeof(RXREAL));
+			buf[3*id+j] = m_hPos[DIM*i+j];
+			buf[3*(n+id)+j] = m_hVel[DIM*i+j];
 		}
 	}
+	fout.write((char*)&n, sizeof(uint));
+	if(n) fout.write((char*)&buf[0], buf.size()*sizeof(RXREAL));
 
 	fout.close();
 
@@ -445,6 +489,7 @@ int rxParticleSystemBase::OutputParticles(string fn)
  */
 int rxParticleSystemBase::InputParticles(string fn)
 {
+	RXPROF_ZONE("input particles");
 	ifstream fin;
 	fin.open(fn.c_str(), ios::in|ios::binary);
 	if(!fin){
@@ -456,6 +501,8 @@ int rxParticleSystemBase::InputParticles(string fn)
 	fin.read((char*)&n, sizeof(uint));
 	m_uNumParticles = n;
 
+	clearParticleIds();
+
 	for(uint i = 0; i < n; ++i){
 		for(int j = 0; j < 3; ++j){
 			fin.read((char*)&m_hPos[DIM*i+j], sizeof(RXREAL));
@@ -478,3 +525,378 @@ int rxParticleSystemBase::InputParticles(string fn)
 	
 	return 1;
 }
+
+
+/*!
+ * p[eBNLbVɏo
+ *  - LbṼ`l"pos","vel","frc","dens"̂̂ɑΉzOID̏ŏ
+ *  - t@Cւ݂̏̓LbV̏݃XbhōŝŁCł̓Rs[̂
+ * @param[in] cache o͐LbV(Openς)
+ * @param[in] frame t[ԍ
+ */
+int rxParticleSystemBase::OutputParticles(rxParticleCacheWriter &cache, int frame)
+{
+	RXPROF_ZONE("output particles");
+	if(!cache.IsOpen()) return 0;
+
+	uint n = m_uNumParticles;
+	rxParticleCacheFrame *f = cache.BeginFrame(frame, m_fTime, n);
+
+	for(int c = 0; c < cache.GetNumChannels(); ++c){
+		const rxPCacheChannel &ch = cache.GetChannel(c);
+		string name = ch.name;
+
+		RXREAL *src = 0;
+		int d = DIM;
+		if(name == "pos")		src = GetArrayVBO(RX_POSITION);
+		else if(name == "vel")	src = GetArrayVBO(RX_VELOCITY);
+		else if(name == "frc")	src = GetArrayVBO(RX_FORCE);
+		else if(name == "dens"){ src = GetArrayVBO(RX_DENSITY); d = 1; }
+
+		int nc = RX_MIN((int)ch.ncomp, d);
+		float *dst = (f->data[c].empty() ? 0 : &f->data[c][0]);
+		if(!src || !dst){
+			f->data[c].assign(f->data[c].size(), 0.0f);
+			continue;
+		}
+
+		#pragma omp parallel for
+		for(int id = 0; id < (int)n; ++id){
+			uint i = particleSlot(id);
+			for(int k = 0; k < (int)ch.ncomp; ++k){
+				dst[id*ch.ncomp+k] = (k < nc ? (float)src[d*i+k] : 0.0f);
+			}
+		}
+	}
+
+	cache.EndFrame(f);
+
+	return 1;
+}
+
+/*!
+ * LbVp[eBNǂݍ
+ * @param[in] cache LbV(Openς)
+ * @param[in] frame t[ԍ
+ */
+int rxParticleSystemBase::InputParticles(const rxParticleCacheReader &cache, int frame)
+{
+	RXPROF_ZONE("input particles");
+	int i = cache.FindFrame(frame);
+	if(i < 0) return 0;
+
+	uint n = cache.GetFrameInfo(i).num_particles;
+	if(n > m_uMaxParticles){
+		RXCOUT << "the number of particles in the cache exceeds the max. number." << endl;
+		return 0;
+	}
+
+	vector<float> pos, vel;
+	if(!cache.ReadChannel(i, "pos", pos)) return 0;
+	int npc = cache.GetChannel(cache.GetChannelIndex("pos")).ncomp;
+	int nvc = (cache.ReadChannel(i, "vel", vel) ? cache.GetChannel(cache.GetChannelIndex("vel")).ncomp : 0);
+
+	m_uNumParticles = n;
+	clearParticleIds();
+
+	for(uint j = 0; j < n; ++j){
+		for(int k = 0; k < 3; ++k){
+			m_hPos[DIM*j+k] = (k < npc ? pos[j*npc+k] : 0.0f);
+			m_hVel[DIM*j+k] = (k < nvc ? vel[j*nvc+k] : 0.0f);
+		}
+	}
+	m_fTime = (RXREAL)cache.GetFrameInfo(i).time;
+
+	SetArrayVBO(RX_POSITION, m_hPos, 0, m_uNumParticles);
+	SetArrayVBO(RX_VELOCITY, m_hVel, 0, m_uNumParticles);
+
+	return 1;
+}
+
+
+/*!
+ * `FbN|Cg̕ۑ
+ *  - p[eBNz(z̏Ԃ̂܂)COID̑ΉCEp[eBNCCƗ̏ԁCƃXebv
+ *    oCiŏoChNX̏ԂwriteCheckpointŒǉ
+ *  - V[̐ÓIȐݒ(Ě`CQ̎ނƑ傫C|S)͊܂܂Ȃ̂ŁC
+ *    ĊJ͓V[ݒ肵ĂLoadCheckpointĂ
+ * @param[in] fn o̓t@C
+ * @param[in] step ݂̃Xebv
+ * @return ۑłtrue
+ */
+bool rxParticleSystemBase::SaveCheckpoint(const string &fn, int step)
+{
+	RXPROF_ZONE("save checkpoint");
+	ofstream fout;
+	fout.open(fn.c_str(), ios::out|ios::binary);
+	if(!fout){
+		RXCOUT << fn << " couldn't open." << endl;
+		return false;
+	}
+
+	uint n = m_uNumParticles;
+	uint nb = m_uNumBParticles;
+
+	fout.write("RXCP", 4);
+	WriteBinary(fout, RX_CHECKPOINT_VERSION);
+	WriteBinary(fout, (uint)DIM);
+	WriteBinary(fout, (uint)sizeof(RXREAL));
+	WriteBinary(fout, m_uMaxParticles);
+	WriteBinary(fout, n);
+	WriteBinary(fout, nb);
+	WriteBinary(fout, m_fTime);
+	WriteBinary(fout, step);
+
+	// C
+	WriteBinary(fout, m_iInletStart);
+	WriteBinary(fout, m_uRandState);
+	WriteBinary(fout, (uint)m_vInletLines.size());
+	for(int i = 0; i < (int)m_vInletLines.size(); ++i){
+		const rxInletLine &l = m_vInletLines[i];
+		WriteBinaryArray(fout, l.pos1.data, 3);
+		WriteBinaryArray(fout, l.pos2.data, 3);
+		WriteBinaryArray(fout, l.vel.data, 3);
+		WriteBinaryArray(fout, l.up.data, 3);
+		WriteBinary(fout, l.accum);
+		WriteBinary(fout, l.span);
+		WriteBinary(fout, l.spacing);
+	}
+
+	// OID̑Ή
+	WriteBinary(fout, m_iReorderSpan);
+	WriteBinary(fout, (uint)m_vId.size());
+	WriteBinaryArray(fout, m_vId.empty() ? (uint*)0 : &m_vId[0], m_vId.size());
+	WriteBinary(fout, (uint)m_vIdx.size());
+	WriteBinaryArray(fout, m_vIdx.empty() ? (uint*)0 : &m_vIdx[0], m_vIdx.size());
+
+	// p[eBN
+	m_hPos = GetArrayVBO(RX_POSITION);
+	m_hVel = GetArrayVBO(RX_VELOCITY);
+	WriteBinaryArray(fout, m_hPos, (size_t)DIM*n);
+	WriteBinaryArray(fout, m_hVel, (size_t)DIM*n);
+
+	// Ep[eBN
+	WriteBinaryArray(fout, m_hPosB, (size_t)DIM*nb);
+	WriteBinary(fout, (int)(m_hVolB ? 1 : 0));
+	if(m_hVolB) WriteBinaryArray(fout, m_hVolB, (size_t)nb);
+
+	// hNX̏
+	if(!writeCheckpoint(fout)){
+		RXCOUT << fn << " : couldn't save the solver state." << endl;
+		return false;
+	}
+
+	fout.write("RXCP", 4);
+	fout.close();
+
+	RXCOUT << "saved the checkpoint to " << fn << " (step " << step << ")" << endl;
+
+	return true;
+}
+
+/*!
+ * `FbN|Cg̍ĊJ
+ *  - InitializeƓV[̐ݒsɌĂ
+ * @param[in] fn `FbN|Cgt@C
+ * @param[out] step ۑ̃Xebv(Updateɓnl)
+ * @return ǂݍ߂true
+ */
+bool rxParticleSystemBase::LoadCheckpoint(const string &fn, int &step)
+{
+	RXPROF_ZONE("load checkpoint");
+	ifstream fin;
+	fin.open(fn.c_str(), ios::in|ios::binary);
+	if(!fin){
+		RXCOUT << fn << " couldn't find." << endl;
+		return false;
+	}
+
+	char magic[4];
+	fin.read(magic, 4);
+	if(strncmp(magic, "RXCP", 4) != 0 || ReadBinary<uint>(fin) != RX_CHECKPOINT_VERSION){
+		RXCOUT << fn << " is not a checkpoint file." << endl;
+		return false;
+	}
+	if(ReadBinary<uint>(fin) != (uint)DIM || ReadBinary<uint>(fin) != (uint)sizeof(RXREAL)){
+		RXCOUT << fn << " : the data type is different from the current build." << endl;
+		return false;
+	}
+
+	uint maxp = ReadBinary<uint>(fin);
+	uint n = ReadBinary<uint>(fin);
+	uint nb = ReadBinary<uint>(fin);
+	if(n > m_uMaxParticles || maxp > m_uMaxParticles){
+		RXCOUT << fn << " : the max. number of particles (" << maxp << ") exceeds the current setting (" << m_uMaxParticles << ")." << endl;
+		return false;
+	}
+	m_fTime = ReadBinary<RXREAL>(fin);
+	step = ReadBinary<int>(fin);
+
+	// C
+	m_iInletStart = ReadBinary<int>(fin);
+	m_uRandState = ReadBinary<unsigned long long>(fin);
+	m_vInletLines.resize(ReadBinary<uint>(fin));
+	for(int i = 0; i < (int)m_vInletLines.size(); ++i){
+		rxInletLine &l = m_vInletLines[i];
+		ReadBinaryArray(fin, l.pos1.data, 3);
+		ReadBinaryArray(fin, l.pos2.data, 3);
+		ReadBinaryArray(fin, l.vel.data, 3);
+		ReadBinaryArray(fin, l.up.data, 3);
+		l.accum = ReadBinary<int>(fin);
+		l.span = ReadBinary<int>(fin);
+		l.spacing = ReadBinary<double>(fin);
+	}
+
+	// OID̑Ή
+	m_iReorderSpan = ReadBinary<int>(fin);
+	m_vId.resize(ReadBinary<uint>(fin));
+	ReadBinaryArray(fin, m_vId.empty() ? (uint*)0 : &m_vId[0], m_vId.size());
+	m_vIdx.resize(ReadBinary<uint>(fin));
+	ReadBinaryArray(fin, m_vIdx.empty() ? (uint*)0 : &m_vIdx[0], m_vIdx.size());
+	if(m_vId.size() != m_vIdx.size() || (!m_vId.empty() && m_vId.size() != maxp)){
+		RXCOUT << fn << " is broken." << endl;
+		return false;
+	}
+
+	// ۑőp[eBN傫ꍇC͍Pʑ(܂gĂȂID)
+	if(!m_vId.empty() && maxp < m_uMaxParticles){
+		m_vId.resize(m_uMaxParticles);
+		m_vIdx.resize(m_uMaxParticles);
+		for(uint i = maxp; i < m_uMaxParticles; ++i){
+			m_vId[i] = i;
+			m_vIdx[i] = i;
+		}
+	}
+
+	// p[eBN
+	m_uNumParticles = n;
+	ReadBinaryArray(fin, m_hPos, (size_t)DIM*n);
+	ReadBinaryArray(fin, m_hVel, (size_t)DIM*n);
+
+	// Ep[eBN(قȂꍇ͊mۂ)
+	if(nb != m_uNumBParticles){
+		if(m_hPosB) delete [] m_hPosB;
+		if(m_hVolB) delete [] m_hVolB;
+		m_hPosB = (nb ? new RXREAL[DIM*nb] : 0);
+		m_hVolB = (nb ? new RXREAL[nb] : 0);
+		m_uNumBParticles = nb;
+	}
+	ReadBinaryArray(fin, m_hPosB, (size_t)DIM*nb);
+	if(ReadBinary<int>(fin)){
+		if(!m_hVolB && nb) m_hVolB = new RXREAL[nb];
+		ReadBinaryArray(fin, m_hVolB, (size_t)nb);
+	}
+
+	// hNX̏
+	if(!fin || !readCheckpoint(fin)){
+		RXCOUT << fn << " : couldn't restore the solver state." << endl;
+		return false;
+	}
+
+	fin.read(magic, 4);
+	if(!fin || strncmp(magic, "RXCP", 4) != 0){
+		RXCOUT << fn << " is broken." << endl;
+		return false;
+	}
+	fin.close();
+
+	SetArrayVBO(RX_POSITION, m_hPos, 0, m_uNumParticles);
+	SetArrayVBO(RX_VELOCITY, m_hVel, 0, m_uNumParticles);
+	SetColorVBO(m_iColorType, -1);
+
+	RXCOUT << "restored the checkpoint from " << fn << " (step " << step << ", " << n << " particles)" << endl;
+
+	return true;
+}
+
+
+/*!
+ * ԓIɋ߂p[eBNzł߂Ȃ悤Mortonɕёւ
+ *  - ߖTTJ[lvZł̃LbV~X炷߁CUpdateňXebvƂɌĂ
+ *  - ёւOID(GetParticleId)͕ςȂ̂ŁCsbNo͂͊OIDň
+ */
+void rxParticleSystemBase::ReorderParticles(void)
+{
+	uint n = m_uNumParticles;
+	if(n < 2) return;
+
+	// OID̏(ŏ̕ёւ܂ł͍Pʑ)
+	if(m_vId.empty()){
+		m_vId.resize(m_uMaxParticles);
+		m_vIdx.resize(m_uMaxParticles);
+		for(uint i = 0; i < m_uMaxParticles; ++i){
+			m_vId[i] = i;
+			m_vIdx[i] = i;
+		}
+	}
+
+	// MortoňvZ(e10rbgɗʎq)
+	Vec3 minp = m_v3EnvMin;
+	Vec3 dim = m_v3EnvMax-m_v3EnvMin;
+	vector< pair<uint, uint> > code(n);
+	#pragma omp parallel for
+	for(int i = 0; i < (int)n; ++i){
+		uint c[3];
+		for(int k = 0; k < 3; ++k){
+			double x = (m_hPos[DIM*i+k]-minp[k])/dim[k];
+			c[k] = (uint)RX_CLAMP(x*1024.0, 0.0, 1023.0);
+		}
+		code[i] = make_pair(RxMortonCode3(c[0], c[1], c[2]), (uint)i);
+	}
+
+	// ̏ꍇ͌̃CfbNX(ʂIɂ邽)
+	std::sort(code.begin(), code.end());
+
+	vector<uint> perm(n);
+	for(uint i = 0; i < n; ++i){
+		perm[i] = code[i].second;
+	}
+
+	// p[eBNz̕ёւ
+	permuteParticles(perm);
+
+	// OID̑ΉXV
+	vector<uint> old_id(m_vId.begin(), m_vId.begin()+n);
+	for(uint i = 0; i < n; ++i){
+		m_vId[i] = old_id[perm[i]];
+		m_vIdx[m_vId[i]] = i;
+	}
+
+	SetArrayVBO(RX_POSITION, m_hPos, 0, n);
+	SetArrayVBO(RX_VELOCITY, m_hVel, 0, n);
+	SetColorVBO(m_iColorType, -1);
+}
+
+/*!
+ * p[eBNƂ̔zёւ
+ *  - hNXœƎ̃p[eBNzꍇ̓I[o[ChĂёւ
+ * @param[in] perm ёւiԖڂɌperm[i]Ԗڂ̗vf
+ */
+void rxParticleSystemBase::permuteParticles(const vector<uint> &perm)
+{
+	permuteArray(m_hPos, DIM, perm);
+	permuteArray(m_hVel, DIM, perm);
+	if(m_hTmp) permuteArray(m_hTmp, 1, perm);
+}
+
+/*!
+ * z̕ёւ
+ * @param[inout] data z(TCYd*perm.size()ȏ)
+ * @param[in] d 1vf̒l̐
+ * @param[in] perm ёւiԖڂɌperm[i]Ԗڂ̗vf
+ */
+void rxParticleSystemBase::permuteArray(RXREAL *data, int d, const vector<uint> &perm)
+{
+	int n = (int)perm.size();
+	m_vReorderBuf.resize(d*n);
+	RXREAL *buf = &m_vReorderBuf[0];
+
+	#pragma omp parallel for
+	for(int i = 0; i < n; ++i){
+		const RXREAL *src = data+d*perm[i];
+		for(int k = 0; k < d; ++k){
+			buf[d*i+k] = src[k];
+		}
+	}
+	memcpy(data, buf, sizeof(RXREAL)*d*n);
+}
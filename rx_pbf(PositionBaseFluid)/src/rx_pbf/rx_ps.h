@@ -21,6 +21,10 @@
 
 #include "rx_sph_solid.h"
 
+#include "rx_particle_cache.h"
+
+#include "rx_sparse_grid.h"
+
 //#include <helper_functions.h>
 
 
@@ -34,6 +38,33 @@
 
 const int RX_MAX_STEPS = 10000;
 
+const uint RX_CHECKPOINT_VERSION = 5;
+
+//! Qݒ(SetBoxObstacleȂ)̃tO : Q\ʂɋEp[eBN𐶐
+const int RX_OBSTACLE_PARTICLES = 0x02;
+
+
+//-----------------------------------------------------------------------------
+// oCio(`FbN|Cgp,ǂݍ݂rx_mesh.hReadBinaryg)
+//-----------------------------------------------------------------------------
+template<class T> 
+inline void WriteBinary(ofstream &file, const T &data)
+{
+	file.write((const char*)&data, sizeof(T));
+}
+
+template<class T> 
+inline void WriteBinaryArray(ofstream &file, const T *data, size_t n)
+{
+	if(n && data) file.write((const char*)data, n*sizeof(T));
+}
+
+template<class T> 
+inline void ReadBinaryArray(ifstream &file, T *data, size_t n)
+{
+	if(n && data) file.read((char*)data, n*sizeof(T));
+}
+
 
 //-----------------------------------------------------------------------------
 // p[eBNC
@@ -126,7 +157,13 @@ protected:
 	RXREAL m_fTime;
 
 	vector<rxInletLine> m_vInletLines;	//!< C
-	int m_iInletStart;		//!< p[eBNǉJnCfbNX
+	int m_iInletStart;		//!< p[eBNǉJnCfbNX(OID)
+	unsigned long long m_uRandState;	//!< p[eBN̈ʒu̗h炬p̏(`FbN|Cgɕۑ)
+
+	vector<uint> m_vId;		//!< zCfbNX -> OID(ёւs܂ł͋ōPʑƂ݂Ȃ)
+	vector<uint> m_vIdx;	//!< OID -> zCfbNX
+	int m_iReorderSpan;		//!< Mortonёւ̃XebvԊu(0ŕёւȂ)
+	vector<RXREAL> m_vReorderBuf;	//!< ёւp̍Ɨ̈
 
 public:	
 	vector<RXREAL> m_vFuncB;
@@ -142,15 +179,17 @@ public:
 		m_bUseOpenGL(bUseOpenGL), 
 		m_hPos(0),
 		m_hVel(0), 
-		m_hTmp(0), 
 		m_hPosB(0), 
-		m_hVolB(0)
+		m_hVolB(0), 
+		m_hTmp(0)
 	{
 		m_v3Gravity = Vec3(0.0, -9.82, 0.0);
 		m_fRestitution = 0.0;
 		m_fParticleRadius = 0.1;
 		m_fTime = 0.0;
 		m_iInletStart = -1;
+		m_iReorderSpan = 0;
+		SetRandomSeed(0);
 		m_fTmpMax = 1.0;
 		m_uNumBParticles0 = 0;
 	}
@@ -176,6 +215,9 @@ public:
 	// V~[Vݒ
 	void SetGravity(RXREAL x){ m_v3Gravity = Vec3(0.0, x, 0.0); }	//!< d
 
+	//! p[eBNp̎
+	void SetRandomSeed(uint seed){ m_uRandState = 0x9E3779B97F4A7C15ULL^(unsigned long long)seed; }
+
 	// p[eBNVBO
 	unsigned int GetCurrentReadBuffer(void) const { return m_posVBO; }
 	unsigned int GetColorBuffer(void) const { return m_colorVBO; }
@@ -184,6 +226,14 @@ public:
 	void SetColorType(int type){ m_iColorType = type; }
 	int  GetColorType(void) const { return m_iColorType; }
 
+	// p[eBN̊OID(Mortonёւ̌p[eBNw)
+	uint GetParticleId(int i) const { return m_vId.empty() ? (uint)i : m_vId[i]; }
+	int  GetParticleIndex(int id) const { return (m_vIdx.empty() || id < 0) ? id : (int)m_vIdx[id]; }
+
+	// Mortonёւ̊Ԋu
+	void SetReorderSpan(int span){ m_iReorderSpan = span; }
+	int  GetReorderSpan(void) const { return m_iReorderSpan; }
+
 public:
 	// z֐
 	virtual bool Update(RXREAL dt, int step = 0) = 0;
@@ -212,6 +262,7 @@ public:
 	// A֐lvZ
 	virtual void CalImplicitField(int n[3], Vec3 minp, Vec3 d, RXREAL *hF){}
 	virtual void CalImplicitFieldDevice(int n[3], Vec3 minp, Vec3 d, RXREAL *dF){}
+	virtual void CalImplicitFieldSparse(int n[3], Vec3 minp, Vec3 d, rxSparseBrickGrid &grid){ grid.Init(n, minp, d); }
 	virtual double GetImplicit(double x, double y, double z){ return 0.0; }
 	static RXREAL GetImplicit_s(double x, double y, double z, void* p)
 	{
@@ -247,17 +298,55 @@ public:
 	int OutputParticles(string fn);
 	int InputParticles(string fn);
 
+	int OutputParticles(rxParticleCacheWriter &cache, int frame);
+	int InputParticles(const rxParticleCacheReader &cache, int frame);
+
+	void ReorderParticles(void);
+
+	// `FbN|Cg(vZ̒fƍĊJ)
+	bool SaveCheckpoint(const string &fn, int step);
+	bool LoadCheckpoint(const string &fn, int &step);
+
 protected:
+	// hNX̃V~[VԂ̓o(SaveCheckpoint/LoadCheckpointĂ΂)
+	virtual bool writeCheckpoint(ofstream &fout){ return true; }
+	virtual bool readCheckpoint(ifstream &fin){ return true; }
+
 	int  addParticles(int &start, rxInletLine line);
 
+	/*!
+	 * [0,1]̈l(xorshift64*)
+	 *  - rand()ƈďԂ\o̂ŁC`FbN|CgĊJĂɂȂ
+	 */
+	double frand(void)
+	{
+		m_uRandState ^= m_uRandState >> 12;
+		m_uRandState ^= m_uRandState << 25;
+		m_uRandState ^= m_uRandState >> 27;
+		return (double)((m_uRandState*0x2545F4914F6CDD1DULL) >> 11)/(double)((1ULL << 53)-1);
+	}
+
+	virtual void permuteParticles(const vector<uint> &perm);
+	void permuteArray(RXREAL *data, int d, const vector<uint> &perm);
+
+	//! OIDzCfbNXւ̕ϊ(p[eBNǉ̏ݐ)
+	uint particleSlot(uint id) const { return m_vIdx.empty() ? id : m_vIdx[id]; }
+
+	//! OID̑ΉNA(z擪lߒƂ)
+	void clearParticleIds(void){ m_vId.clear(); m_vIdx.clear(); }
+
 	uint createVBO(uint size)
 	{
+#ifndef RX_HEADLESS
 		GLuint vbo;
 		glGenBuffers(1, &vbo);
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
 		glBufferData(GL_ARRAY_BUFFER, size, 0, GL_DYNAMIC_DRAW);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		return vbo;
+#else
+		return 0;
+#endif
 	}
 
 };
@@ -0,0 +1,559 @@
+/*!
+  @file rx_sdf.h
+
+  @brief Op`bV̕t(SDF)Obh
+		 - bVӂׂ̍(narrow band)̃Obh_ɎOp`܂ł̋i[C
+		   ͊pxdݕt[@(//_)Ō߂
+		 - т̊O͕bVȂx̑œO`dCJbVȂO(+band)Ƃ
+		 - lƌz̓gCjAԂŌvZC_܂Ƃ߂ĕ]ob`łp
+		 - bṼnbVlƉ𑜓xL[Ƃăt@CɃLbVCN͓ǂݍނōς܂
+
+  @date   2026-10
+*/
+
+
+#ifndef _RX_SDF_H_
+#define _RX_SDF_H_
+
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+// CW
+#include <cmath>
+#include <cstring>
+#include <cfloat>
+
+// STL
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <unordered_map>
+
+#include "rx_utility.h"
+#include "rx_sph_commons.h"	// RXCOUT
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// `
+//-----------------------------------------------------------------------------
+using namespace std;
+
+#ifndef RXREAL
+	#define RXREAL float
+#endif
+
+//! ob`]1xɏ_
+#ifndef RX_SDF_BATCH
+#define RX_SDF_BATCH 8
+#endif
+
+//! LbVt@C̃o[W
+const int RX_SDF_VERSION = 1;
+
+
+//-----------------------------------------------------------------------------
+// tObh
+//-----------------------------------------------------------------------------
+class rxSDFGrid
+{
+protected:
+	int m_iN[3];							//!< Obh_
+	Vec3 m_v3Min;							//!< Obh̍ŏW
+	double m_fDx;							//!< Obh
+	double m_fBand;							//!< 𐳊mɌvZт̕(艓_́}m_fBand)
+	unsigned long long m_uHash;				//!< bṼnbVl
+
+	vector<float> m_vData;					//!< Obh_̋l(x,y,z̏ɕׂ)
+
+public:
+	rxSDFGrid() : m_fDx(0.0), m_fBand(0.0), m_uHash(0)
+	{
+		m_iN[0] = m_iN[1] = m_iN[2] = 0;
+	}
+
+	bool IsValid(void) const { return !m_vData.empty(); }
+	double GetCellWidth(void) const { return m_fDx; }
+	double GetBand(void) const { return m_fBand; }
+	unsigned long long GetHash(void) const { return m_uHash; }
+	int GetNumNodes(void) const { return m_iN[0]*m_iN[1]*m_iN[2]; }
+
+	/*!
+	 * bVƉ𑜓xnbVlvZ(FNV-1a 64bit)
+	 * @param[in] vrts _W(3vf)
+	 * @param[in] nv _
+	 * @param[in] tris Op`̒_CfbNX(3vf)
+	 * @param[in] nt Op`
+	 * @param[in] dx,band ObhƑт̕
+	 * @return nbVl
+	 */
+	static unsigned long long CalHash(const RXREAL *vrts, int nv, const int *tris, int nt, double dx, double band)
+	{
+		unsigned long long h = 14695981039346656037ULL;
+		hashBytes(h, &nv, sizeof(int));
+		hashBytes(h, &nt, sizeof(int));
+		hashBytes(h, vrts, sizeof(RXREAL)*3*nv);
+		hashBytes(h, tris, sizeof(int)*3*nt);
+		hashBytes(h, &dx, sizeof(double));
+		hashBytes(h, &band, sizeof(double));
+		return h;
+	}
+
+	/*!
+	 * LbVt@C(nbVl16i\L)
+	 * @param[in] dir ۑtH_
+	 * @param[in] hash nbVl
+	 */
+	static string GetCacheFileName(const string &dir, unsigned long long hash)
+	{
+		ostringstream ss;
+		ss << dir << "sdf_" << hex << setw(16) << setfill('0') << hash << ".sdf";
+		return ss.str();
+	}
+
+	/*!
+	 * Obh̊m(lׂ͂+band)
+	 * @param[in] minp Obh̍ŏW
+	 * @param[in] maxp Obh̍őW
+	 * @param[in] dx Obh
+	 * @param[in] band т̕
+	 */
+	void Allocate(Vec3 minp, Vec3 maxp, double dx, double band)
+	{
+		m_fDx = dx;
+		m_fBand = band;
+		m_v3Min = minp;
+		for(int l = 0; l < 3; ++l){
+			m_iN[l] = (int)ceil((maxp[l]-minp[l])/dx)+1;
+			if(m_iN[l] < 2) m_iN[l] = 2;
+		}
+		m_vData.assign((size_t)m_iN[0]*m_iN[1]*m_iN[2], (float)band);
+	}
+
+	//! Obh_̍Wƒl(OpenVDBȂǊOŌvZlݒ肷Ƃp)
+	Vec3 GetNodePos(int i, int j, int k) const { return m_v3Min+Vec3(i, j, k)*m_fDx; }
+	void SetNodeValue(int i, int j, int k, float v){ m_vData[idx(i, j, k)] = v; }
+	float GetNodeValue(int i, int j, int k) const { return m_vData[idx(i, j, k)]; }
+	void GetN(int n[3]) const { n[0] = m_iN[0]; n[1] = m_iN[1]; n[2] = m_iN[2]; }
+	void SetHash(unsigned long long hash){ m_uHash = hash; }
+
+	/*!
+	 * Op`bVSDF\z
+	 *  - Obh_RX_SDF_BUCKET^3Ƃ̃oPbgɕCѕLOp`AABBƏdȂoPbgɎOp`o^
+	 *  - oPbgƂɕɁCeObh_o^ꂽOp`܂ł̍ŒZvZ
+	 * @param[in] vrts _W(3vf)
+	 * @param[in] nv _
+	 * @param[in] tris Op`̒_CfbNX(3vf)
+	 * @param[in] nt Op`
+	 * @param[in] dx Obh
+	 * @param[in] band т̕(Obh2{̂Ƃ2{ɂ)
+	 * @return \złtrue
+	 */
+	bool Build(const RXREAL *vrts, int nv, const int *tris, int nt, double dx, double band)
+	{
+		if(!nv || !nt || dx <= 0.0) return false;
+		if(band < 2.0*dx) band = 2.0*dx;
+
+		vector<Vec3> v(nv);
+		Vec3 minp(RX_FEQ_INF), maxp(-RX_FEQ_INF);
+		for(int i = 0; i < nv; ++i){
+			v[i] = Vec3(vrts[3*i+0], vrts[3*i+1], vrts[3*i+2]);
+			for(int l = 0; l < 3; ++l){
+				if(v[i][l] < minp[l]) minp[l] = v[i][l];
+				if(v[i][l] > maxp[l]) maxp[l] = v[i][l];
+			}
+		}
+		Allocate(minp-Vec3(band+dx), maxp+Vec3(band+dx), dx, band);
+		m_uHash = CalHash(vrts, nv, tris, nt, dx, band);
+
+		// [@(,,_)
+		vector<Vec3> fn(nt), en(3*nt), vn(nv, Vec3(0.0));
+		bool closed = calPseudoNormals(v, tris, nt, fn, en, vn);
+
+		// oPbgɎOp`o^
+		const int B = 8;
+		int nb[3];
+		for(int l = 0; l < 3; ++l) nb[l] = (m_iN[l]+B-1)/B;
+		vector< vector<int> > buckets((size_t)nb[0]*nb[1]*nb[2]);
+		for(int t = 0; t < nt; ++t){
+			Vec3 tmin = v[tris[3*t]], tmax = v[tris[3*t]];
+			for(int j = 1; j < 3; ++j){
+				const Vec3 &p = v[tris[3*t+j]];
+				for(int l = 0; l < 3; ++l){
+					if(p[l] < tmin[l]) tmin[l] = p[l];
+					if(p[l] > tmax[l]) tmax[l] = p[l];
+				}
+			}
+			int b0[3], b1[3];
+			for(int l = 0; l < 3; ++l){
+				int i0 = (int)floor((tmin[l]-band-m_v3Min[l])/dx);
+				int i1 = (int)ceil((tmax[l]+band-m_v3Min[l])/dx);
+				b0[l] = RX_CLAMP(i0, 0, m_iN[l]-1)/B;
+				b1[l] = RX_CLAMP(i1, 0, m_iN[l]-1)/B;
+			}
+			for(int bz = b0[2]; bz <= b1[2]; ++bz){
+				for(int by = b0[1]; by <= b1[1]; ++by){
+					for(int bx = b0[0]; bx <= b1[0]; ++bx){
+						buckets[bx+nb[0]*(by+nb[1]*bz)].push_back(t);
+					}
+				}
+			}
+		}
+
+		// ѓ̃Obh_̕t
+		const float unset = FLT_MAX;
+		int nbt = (int)buckets.size();
+		#pragma omp parallel for schedule(dynamic, 4)
+		for(int b = 0; b < nbt; ++b){
+			int bx = b%nb[0], by = (b/nb[0])%nb[1], bz = b/(nb[0]*nb[1]);
+			const vector<int> &ts = buckets[b];
+			for(int k = bz*B; k < RX_MIN((bz+1)*B, m_iN[2]); ++k){
+				for(int j = by*B; j < RX_MIN((by+1)*B, m_iN[1]); ++j){
+					for(int i = bx*B; i < RX_MIN((bx+1)*B, m_iN[0]); ++i){
+						Vec3 p = GetNodePos(i, j, k);
+						double d2min = band*band;
+						Vec3 cpmin, pnmin;
+						bool found = false;
+						for(int m = 0; m < (int)ts.size(); ++m){
+							int t = ts[m];
+							Vec3 cp;
+							int region = closestPointTriangle(p, v[tris[3*t]], v[tris[3*t+1]], v[tris[3*t+2]], cp);
+							double d2 = norm2(p-cp);
+							if(d2 < d2min){
+								d2min = d2;
+								cpmin = cp;
+								pnmin = (region < 3 ? vn[tris[3*t+region]] : (region < 6 ? en[3*t+region-3] : fn[t]));
+								found = true;
+							}
+						}
+						float &val = m_vData[idx(i, j, k)];
+						if(found){
+							double d = sqrt(d2min);
+							val = (float)(dot(p-cpmin, pnmin) < 0.0 ? -d : d);
+						}
+						else{
+							val = unset;
+						}
+					}
+				}
+			}
+		}
+
+		// т̊O̕
+		//  - bV : ObhE͊OȂ̂ŁCxɑĒȎѓ̓_̕`d
+		//  - JbV : O`łȂ̂łׂĊOƂ
+		int nyz = m_iN[1]*m_iN[2];
+		#pragma omp parallel for
+		for(int jk = 0; jk < nyz; ++jk){
+			int j = jk%m_iN[1], k = jk/m_iN[1];
+			float sgn = 1.0f;
+			for(int i = 0; i < m_iN[0]; ++i){
+				float &val = m_vData[idx(i, j, k)];
+				if(val == unset){
+					val = sgn*(float)band;
+				}
+				else if(closed){
+					sgn = (val < 0.0f ? -1.0f : 1.0f);
+				}
+			}
+		}
+
+		RXCOUT << "sdf : " << m_iN[0] << "x" << m_iN[1] << "x" << m_iN[2] << " nodes (dx = " << dx << ", band = " << band
+			   << (closed ? ", closed" : ", open") << ")" << endl;
+		return true;
+	}
+
+	/*!
+	 * LbVt@Cւ̕ۑ
+	 * @param[in] fn t@C
+	 * @return ۑłtrue
+	 */
+	bool Save(const string &fn) const
+	{
+		if(!IsValid()) return false;
+
+		ofstream fout;
+		fout.open(fn.c_str(), ios::out|ios::binary);
+		if(!fout){
+			RXCOUT << fn << " couldn't open." << endl;
+			return false;
+		}
+
+		int ver = RX_SDF_VERSION;
+		double minp[3] = {m_v3Min[0], m_v3Min[1], m_v3Min[2]};
+		fout.write("RXSD", 4);
+		fout.write((char*)&ver, sizeof(int));
+		fout.write((char*)&m_uHash, sizeof(unsigned long long));
+		fout.write((char*)m_iN, sizeof(int)*3);
+		fout.write((char*)minp, sizeof(double)*3);
+		fout.write((char*)&m_fDx, sizeof(double));
+		fout.write((char*)&m_fBand, sizeof(double));
+		fout.write((char*)&m_vData[0], sizeof(float)*m_vData.size());
+		fout.close();
+
+		return true;
+	}
+
+	/*!
+	 * LbVt@C̓ǂݍ
+	 *  - wb_̃nbVlvȂ(bV𑜓xς)ꍇ͓ǂݍ܂Ȃ
+	 *  - l1̓ǂݍ݂ł܂Ƃ߂ĔzɎ荞
+	 * @param[in] fn t@C
+	 * @param[in] hash ҂nbVl
+	 * @return ǂݍ߂true
+	 */
+	bool Load(const string &fn, unsigned long long hash)
+	{
+		ifstream fin;
+		fin.open(fn.c_str(), ios::in|ios::binary);
+		if(!fin) return false;
+
+		char magic[4];
+		int ver = 0, n[3];
+		unsigned long long h = 0;
+		double minp[3], dx, band;
+		fin.read(magic, 4);
+		fin.read((char*)&ver, sizeof(int));
+		fin.read((char*)&h, sizeof(unsigned long long));
+		if(!fin || strncmp(magic, "RXSD", 4) != 0 || ver != RX_SDF_VERSION || h != hash){
+			return false;
+		}
+		fin.read((char*)n, sizeof(int)*3);
+		fin.read((char*)minp, sizeof(double)*3);
+		fin.read((char*)&dx, sizeof(double));
+		fin.read((char*)&band, sizeof(double));
+		if(!fin || n[0] < 2 || n[1] < 2 || n[2] < 2) return false;
+
+		vector<float> data((size_t)n[0]*n[1]*n[2]);
+		fin.read((char*)&data[0], sizeof(float)*data.size());
+		if(!fin) return false;
+
+		for(int l = 0; l < 3; ++l) m_iN[l] = n[l];
+		m_v3Min = Vec3(minp[0], minp[1], minp[2]);
+		m_fDx = dx;
+		m_fBand = band;
+		m_uHash = h;
+		m_vData.swap(data);
+
+		return true;
+	}
+
+	/*!
+	 * lƌžvZ(gCjA)
+	 *  - ObhO̓_̓Obh̍ŋߓ_̒lɃObh܂ł̋𑫂
+	 * @param[in] p vZʒu
+	 * @param[out] g z(K͂Ȃ)
+	 * @return tl
+	 */
+	RXREAL GetValueG(const Vec3 &p, Vec3 &g) const
+	{
+		RXREAL pos[3] = {(RXREAL)p[0], (RXREAL)p[1], (RXREAL)p[2]};
+		RXREAL val, grd[3];
+		GetValueGBatch(pos, 3, 1, &val, grd);
+		g = Vec3(grd[0], grd[1], grd[2]);
+		return val;
+	}
+
+	/*!
+	 * _ł̋lƌžvZ
+	 *  - RX_SDF_BATCH_CZʒu8_̒lW߂Ă(SoA)Ԃ̏d݌vZ܂Ƃ߂čs
+	 *  - ubNPʂŕɌvZ
+	 * @param[in] pos vZʒu(stridevf)
+	 * @param[in] stride 1_̗vf
+	 * @param[in] n _
+	 * @param[out] val tl(nvf)
+	 * @param[out] grd z(3nvf,0ȂvZȂ)
+	 */
+	void GetValueGBatch(const RXREAL *pos, int stride, int n, RXREAL *val, RXREAL *grd) const
+	{
+		const int B = RX_SDF_BATCH;
+		int nblocks = (n+B-1)/B;
+		RXREAL inv_dx = (RXREAL)(1.0/m_fDx);
+
+		#pragma omp parallel for if(nblocks > 1)
+		for(int b = 0; b < nblocks; ++b){
+			int s = b*B;
+			int m = RX_MIN(B, n-s);
+
+			RXREAL fx[B], fy[B], fz[B];				// Z̈ʒu(0`1)
+			RXREAL ox[B], oy[B], oz[B];				// ObhOւ̂͂ݏo
+			RXREAL c[8][B];							// Z8_̒l
+
+			// Zʒuƒ_l̎W
+			for(int l = 0; l < B; ++l){
+				if(l >= m){
+					fx[l] = fy[l] = fz[l] = 0;
+					ox[l] = oy[l] = oz[l] = 0;
+					for(int q = 0; q < 8; ++q) c[q][l] = 0;
+					continue;
+				}
+				const RXREAL *p = pos+stride*(s+l);
+				int ci[3];
+				RXREAL f[3], o[3];
+				for(int a = 0; a < 3; ++a){
+					RXREAL x = (p[a]-(RXREAL)m_v3Min[a])*inv_dx;
+					RXREAL xc = RX_CLAMP(x, (RXREAL)0, (RXREAL)(m_iN[a]-1));
+					o[a] = (x-xc)*(RXREAL)m_fDx;
+					ci[a] = RX_MIN((int)xc, m_iN[a]-2);
+					f[a] = xc-(RXREAL)ci[a];
+				}
+				fx[l] = f[0]; fy[l] = f[1]; fz[l] = f[2];
+				ox[l] = o[0]; oy[l] = o[1]; oz[l] = o[2];
+
+				const float *d = &m_vData[idx(ci[0], ci[1], ci[2])];
+				int sy = m_iN[0], sz = m_iN[0]*m_iN[1];
+				c[0][l] = d[0];    c[1][l] = d[1];
+				c[2][l] = d[sy];   c[3][l] = d[sy+1];
+				c[4][l] = d[sz];   c[5][l] = d[sz+1];
+				c[6][l] = d[sz+sy]; c[7][l] = d[sz+sy+1];
+			}
+
+			// Ԓlƌz(ȂB_܂Ƃ߂ČvZ)
+			RXREAL v[B], gx[B], gy[B], gz[B];
+			for(int l = 0; l < B; ++l){
+				RXREAL x = fx[l], y = fy[l], z = fz[l];
+				RXREAL c00 = c[0][l]+(c[1][l]-c[0][l])*x;
+				RXREAL c10 = c[2][l]+(c[3][l]-c[2][l])*x;
+				RXREAL c01 = c[4][l]+(c[5][l]-c[4][l])*x;
+				RXREAL c11 = c[6][l]+(c[7][l]-c[6][l])*x;
+				RXREAL c0 = c00+(c10-c00)*y;
+				RXREAL c1 = c01+(c11-c01)*y;
+
+				RXREAL dx0 = (c[1][l]-c[0][l])+((c[3][l]-c[2][l])-(c[1][l]-c[0][l]))*y;
+				RXREAL dx1 = (c[5][l]-c[4][l])+((c[7][l]-c[6][l])-(c[5][l]-c[4][l]))*y;
+
+				RXREAL o = sqrt(ox[l]*ox[l]+oy[l]*oy[l]+oz[l]*oz[l]);
+				v[l]  = c0+(c1-c0)*z+o;
+				gx[l] = (dx0+(dx1-dx0)*z)*inv_dx;
+				gy[l] = ((c10-c00)+((c11-c01)-(c10-c00))*z)*inv_dx;
+				gz[l] = (c1-c0)*inv_dx;
+			}
+
+			for(int l = 0; l < m; ++l){
+				val[s+l] = v[l];
+				if(grd){
+					RXREAL *g = grd+3*(s+l);
+					if(ox[l] != 0 || oy[l] != 0 || oz[l] != 0){
+						// ObhOł̓Obh痣zƂ
+						g[0] = ox[l]; g[1] = oy[l]; g[2] = oz[l];
+					}
+					else{
+						g[0] = gx[l]; g[1] = gy[l]; g[2] = gz[l];
+					}
+				}
+			}
+		}
+	}
+
+protected:
+	inline size_t idx(int i, int j, int k) const { return (size_t)i+(size_t)m_iN[0]*((size_t)j+(size_t)m_iN[1]*k); }
+
+	static void hashBytes(unsigned long long &h, const void *data, size_t n)
+	{
+		const unsigned char *p = (const unsigned char*)data;
+		for(size_t i = 0; i < n; ++i){
+			h ^= p[i];
+			h *= 1099511628211ULL;
+		}
+	}
+
+	/*!
+	 * pxdݕt[@̌vZ
+	 * @param[in] v _W
+	 * @param[in] tris,nt Op`
+	 * @param[out] fn ʖ@
+	 * @param[out] en ӂ̋[@(Op`Ƃɕ01,12,20̏)
+	 * @param[out] vn _̋[@
+	 * @return ׂĂ̕ӂ2̎Op`ŋLĂ(bVȂ)true
+	 */
+	static bool calPseudoNormals(const vector<Vec3> &v, const int *tris, int nt, vector<Vec3> &fn, vector<Vec3> &en, vector<Vec3> &vn)
+	{
+		long long nv = (long long)v.size();
+		unordered_map<long long, pair<Vec3, int> > edges;
+		for(int t = 0; t < nt; ++t){
+			const int *tv = tris+3*t;
+			fn[t] = Unit(cross(v[tv[1]]-v[tv[0]], v[tv[2]]-v[tv[0]]));
+			for(int j = 0; j < 3; ++j){
+				// _̓pŏdݕt
+				Vec3 e0 = v[tv[(j+1)%3]]-v[tv[j]], e1 = v[tv[(j+2)%3]]-v[tv[j]];
+				double l0 = norm(e0), l1 = norm(e1);
+				if(l0 > RX_FEQ_EPS && l1 > RX_FEQ_EPS){
+					double c = RX_CLAMP(dot(e0, e1)/(l0*l1), -1.0, 1.0);
+					vn[tv[j]] += acos(c)*fn[t];
+				}
+
+				// ӂLʂ̖@̘a
+				int a = RX_MIN(tv[j], tv[(j+1)%3]), b = RX_MAX(tv[j], tv[(j+1)%3]);
+				pair<Vec3, int> &e = edges[a*nv+b];
+				e.first += fn[t];
+				e.second++;
+			}
+		}
+
+		bool closed = true;
+		for(int t = 0; t < nt; ++t){
+			const int *tv = tris+3*t;
+			for(int j = 0; j < 3; ++j){
+				int a = RX_MIN(tv[j], tv[(j+1)%3]), b = RX_MAX(tv[j], tv[(j+1)%3]);
+				const pair<Vec3, int> &e = edges[a*nv+b];
+				en[3*t+j] = e.first;
+				if(e.second != 2) closed = false;
+			}
+		}
+		return closed;
+	}
+
+	/*!
+	 * _ƎOp`̍ŋߓ_
+	 * @param[in] p _
+	 * @param[in] a,b,c Op`̒_
+	 * @param[out] cp ŋߓ_
+	 * @return ŋߓ_̂̈(0`2:_a,b,c, 3`5:ab,bc,ca, 6:)
+	 */
+	static int closestPointTriangle(const Vec3 &p, const Vec3 &a, const Vec3 &b, const Vec3 &c, Vec3 &cp)
+	{
+		Vec3 ab = b-a, ac = c-a, ap = p-a;
+		double d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if(d1 <= 0.0 && d2 <= 0.0){ cp = a; return 0; }
+
+		Vec3 bp = p-b;
+		double d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if(d3 >= 0.0 && d4 <= d3){ cp = b; return 1; }
+
+		double vc = d1*d4-d3*d2;
+		if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0){
+			cp = a+ab*(d1/(d1-d3));
+			return 3;
+		}
+
+		Vec3 cpv = p-c;
+		double d5 = dot(ab, cpv), d6 = dot(ac, cpv);
+		if(d6 >= 0.0 && d5 <= d6){ cp = c; return 2; }
+
+		double vb = d5*d2-d1*d6;
+		if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0){
+			cp = a+ac*(d2/(d2-d6));
+			return 5;
+		}
+
+		double va = d3*d6-d5*d4;
+		if(va <= 0.0 && (d4-d3) >= 0.0 && (d5-d6) >= 0.0){
+			cp = b+(c-b)*((d4-d3)/((d4-d3)+(d5-d6)));
+			return 4;
+		}
+
+		double denom = 1.0/(va+vb+vc);
+		cp = a+ab*(vb*denom)+ac*(vc*denom);
+		return 6;
+	}
+};
+
+
+
+#endif // #ifndef _RX_SDF_H_
@@ -0,0 +1,166 @@
+/*!
+  @file rx_sdf_test.cpp
+
+  @brief |Ső(rxSolidPolygon)̕t̃eXg
+		 - ̂OBJt@Cő̂Cl͉(̂܂ł̕t)Ɣr
+		 - ő̂ړE]Cő̃[JW̋ꂩ琳l邩ׂ
+		 - ob`(GetDistanceRBatch)1_̌vZ(GetDistanceR)̌ʂr
+		 - Sċe덷Ȃ0CłȂ1Ԃ
+
+  @date   2026-10
+*/
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <fstream>
+
+#include "rx_sph_solid.h"
+
+
+//-----------------------------------------------------------------------------
+// 萔Eϐ
+//-----------------------------------------------------------------------------
+static int g_iNumFail = 0;			//!< s
+
+const char *RX_SDF_TEST_OBJ = "rx_sdf_test_box.obj";	//!< eXgp̒
+const Vec3 RX_SDF_TEST_EXT(0.5, 0.25, 0.4);				//!< ̂̑傫(ӂ̒1/2)
+
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+/*!
+ * ̂OBJt@Co(ʂ͊O̎lp`)
+ */
+static bool SDFTestWriteBox(const char *fn, Vec3 e)
+{
+	ofstream fout(fn);
+	if(!fout) return false;
+	for(int i = 0; i < 8; ++i){
+		int x = ((i+1)/2)%2, y = (i/2)%2, z = i/4;	// (-,-,-),(+,-,-),(+,+,-),(-,+,-),...
+		fout << "v " << (x ? e[0] : -e[0]) << " " << (y ? e[1] : -e[1]) << " " << (z ? e[2] : -e[2]) << endl;
+	}
+	fout << "f 1 4 3 2" << endl << "f 5 6 7 8" << endl;
+	fout << "f 1 2 6 5" << endl << "f 4 8 7 3" << endl;
+	fout << "f 1 5 8 4" << endl << "f 2 3 7 6" << endl;
+	return true;
+}
+
+/*!
+ * ̂܂ł̕t(͉)
+ * @param[in] q ̒S_Ƃ钼̃[JW
+ * @param[in] e ̂̑傫(ӂ̒1/2)
+ */
+static double SDFTestBoxDist(const Vec3 &q, const Vec3 &e)
+{
+	Vec3 a;
+	double out = 0.0, in = -RX_FEQ_INF;
+	for(int l = 0; l < 3; ++l){
+		a[l] = fabs(q[l])-e[l];
+		if(a[l] > 0.0) out += a[l]*a[l];
+		if(a[l] > in) in = a[l];
+	}
+	return sqrt(out)+RX_MIN(in, 0.0);
+}
+
+/*!
+ * 1̎pł̃eXg
+ *  - т̓̃_ȓ_ŁCGetDistanceRCGetDistanceRBatch̋l͉Ɣr
+ * @param[in] name eXg
+ * @param[in] solid ő
+ * @param[in] cen ̒S
+ * @param[in] rot ps(ő̃[JO[oւ̉])
+ * @param[in] h La
+ */
+static void SDFTest(const char *name, rxSolidPolygon &solid, Vec3 cen, const rxMatrix4 &rot, double h)
+{
+	const int n = 4000;
+	const RXREAL r = (RXREAL)(2.0*h);	// т̕艓_͔rȂ
+	const double tol = 0.15*h;			// Ԍ덷̋e(Obh0.5hŁCӂp̋߂ł0.25Obhx̌덷o)
+	Vec3 e = RX_SDF_TEST_EXT;
+
+	srand(1234);
+	vector<RXREAL> pos;
+	vector<double> dist;
+	while((int)dist.size() < n){
+		Vec3 q;
+		for(int l = 0; l < 3; ++l) q[l] = (e[l]+r)*(2.0*rand()/(double)RAND_MAX-1.0);
+		double d = SDFTestBoxDist(q, e);
+		if(fabs(d) > r-h) continue;
+
+		// O[oW p = rot*q+cen
+		Vec3 p;
+		for(int l = 0; l < 3; ++l) p[l] = rot(l, 0)*q[0]+rot(l, 1)*q[1]+rot(l, 2)*q[2]+cen[l];
+		for(int l = 0; l < 3; ++l) pos.push_back((RXREAL)p[l]);
+		dist.push_back(d);
+	}
+
+	vector<RXREAL> pen(n), cp(3*n);
+	solid.GetDistanceRBatch(&pos[0], 3, n, r, &pen[0], &cp[0]);
+
+	double err = 0.0, berr = 0.0;
+	int miss = 0;
+	for(int i = 0; i < n; ++i){
+		rxCollisionInfo col;
+		Vec3 p(pos[3*i], pos[3*i+1], pos[3*i+2]);
+		if(!solid.GetDistanceR(p, r, col) || pen[i] >= (RXREAL)RX_FEQ_INF){
+			miss++;
+			continue;
+		}
+		double d = col.Penetration()+r;
+		err = RX_MAX(err, fabs(d-dist[i]));
+		berr = RX_MAX(berr, fabs((double)pen[i]-col.Penetration()));
+	}
+
+	bool ok = (miss == 0 && err <= tol && berr <= 1.0e-4);
+	if(!ok) g_iNumFail++;
+
+	printf("%-8s : %d points, max error %e (tol %e), batch-scalar %e, missed %d : %s\n", name, n, err, tol, berr, miss, (ok ? "ok" : "FAILED"));
+}
+
+
+/*!
+ * C֐
+ */
+int main(int argc, char *argv[])
+{
+	if(!SDFTestWriteBox(RX_SDF_TEST_OBJ, RX_SDF_TEST_EXT)){
+		printf("failed to write %s\n", RX_SDF_TEST_OBJ);
+		return 1;
+	}
+
+	double h = 0.05;
+	Vec3 cen0(0.3, 0.1, -0.2);
+	rxSolidPolygon solid(RX_SDF_TEST_OBJ, cen0, RX_SDF_TEST_EXT, Vec3(0.0), h, 1);
+	if(!solid.GetSDF().IsValid()){
+		printf("failed to make the sdf\n");
+		return 1;
+	}
+
+	// \z̈ʒu
+	rxMatrix4 rot;
+	SDFTest("initial", solid, cen0, rot, h);
+
+	// ړƉ](z30xCx15x)
+	Vec3 cen1(-0.4, 0.35, 0.25);
+	double az = RX_PI/6.0, ax = RX_PI/12.0;
+	rxMatrix4 rz, rx;
+	rz(0, 0) = cos(az); rz(0, 1) = -sin(az);
+	rz(1, 0) = sin(az); rz(1, 1) =  cos(az);
+	rx(1, 1) = cos(ax); rx(1, 2) = -sin(ax);
+	rx(2, 1) = sin(ax); rx(2, 2) =  cos(ax);
+	rot = rz*rx;
+	solid.SetPosition(cen1);
+	solid.SetMatrix(rot);
+	SDFTest("moved", solid, cen1, rot, h);
+
+	if(g_iNumFail){
+		printf("%d failures\n", g_iNumFail);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,305 @@
+/*!
+  @file rx_sparse_grid.h
+
+  @brief aȃubNObh(\ʃbVp)
+		 - Obh_RX_BRICK_SIZE^3Ƃ̃ubNɕClubNnbVŊǗ
+		 - mۂĂȂubÑObh_̒l0ƂĈ
+		 - t̕\ʕt߂̃ubNmۂ邱ƂŁC𑜓x(512^3Ȃ)̃bVObh悤ɂ
+
+  @date   2026-10
+*/
+
+
+#ifndef _RX_SPARSE_GRID_H_
+#define _RX_SPARSE_GRID_H_
+
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+// CW
+#include <cmath>
+
+// STL
+#include <vector>
+#include <unordered_map>
+
+#include "rx_utility.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// `
+//-----------------------------------------------------------------------------
+using namespace std;
+
+#ifndef RXREAL
+	#define RXREAL float
+#endif
+
+//! ubN1ӂ̃Obh_
+const int RX_BRICK_SIZE = 8;
+const int RX_BRICK_NODES = RX_BRICK_SIZE*RX_BRICK_SIZE*RX_BRICK_SIZE;
+
+
+//-----------------------------------------------------------------------------
+// aȃubNObh
+//-----------------------------------------------------------------------------
+class rxSparseBrickGrid
+{
+protected:
+	int m_iN[3];							//!< Obh_
+	int m_iNb[3];							//!< ubN
+	Vec3 m_v3Min;							//!< Obh̍ŏW
+	Vec3 m_v3Dim;							//!< Obh
+
+	unordered_map<long long, int> m_mapBrick;	//!< ubNԍ(x,y,zvZ) -> mۂubÑCfbNX
+	vector<int> m_vBrickCoord;				//!< mۂubN̈ʒu(ubNP,3vf)
+	vector<RXREAL> m_vData;					//!< Obh_̒l(ubNƂRX_BRICK_NODESvf)
+
+public:
+	rxSparseBrickGrid()
+	{
+		m_iN[0] = m_iN[1] = m_iN[2] = 0;
+		m_iNb[0] = m_iNb[1] = m_iNb[2] = 0;
+	}
+
+	/*!
+	 * Obh̐ݒ(mۍς݂̃ubN͔j)
+	 * @param[in] n Obh_
+	 * @param[in] minp Obh̍ŏW
+	 * @param[in] d Obh
+	 */
+	void Init(const int n[3], Vec3 minp, Vec3 d)
+	{
+		for(int l = 0; l < 3; ++l){
+			m_iN[l] = n[l];
+			m_iNb[l] = (n[l]+RX_BRICK_SIZE-1)/RX_BRICK_SIZE;
+		}
+		m_v3Min = minp;
+		m_v3Dim = d;
+		Clear();
+	}
+
+	//! mۂubN̔j
+	void Clear(void)
+	{
+		m_mapBrick.clear();
+		m_vBrickCoord.clear();
+		m_vData.clear();
+	}
+
+	/*!
+	 * ubN̊m(mۍς݂Ȃ炻̃CfbNXԂ)
+	 *  - l0ŏ
+	 * @param[in] bi,bj,bk ubN̈ʒu
+	 * @return ubÑCfbNX
+	 */
+	int ActivateBrick(int bi, int bj, int bk)
+	{
+		long long key = brickKey(bi, bj, bk);
+		unordered_map<long long, int>::iterator itr = m_mapBrick.find(key);
+		if(itr != m_mapBrick.end()) return itr->second;
+
+		int b = (int)m_mapBrick.size();
+		m_mapBrick[key] = b;
+		m_vBrickCoord.push_back(bi);
+		m_vBrickCoord.push_back(bj);
+		m_vBrickCoord.push_back(bk);
+		m_vData.resize(m_vData.size()+RX_BRICK_NODES, (RXREAL)0);
+		return b;
+	}
+
+	/*!
+	 * ubŇ
+	 * @param[in] bi,bj,bk ubN̈ʒu
+	 * @return ubÑCfbNX(͈͊OmۂĂȂ-1)
+	 */
+	int FindBrick(int bi, int bj, int bk) const
+	{
+		if(bi < 0 || bi >= m_iNb[0] || bj < 0 || bj >= m_iNb[1] || bk < 0 || bk >= m_iNb[2]) return -1;
+		unordered_map<long long, int>::const_iterator itr = m_mapBrick.find(brickKey(bi, bj, bk));
+		return (itr != m_mapBrick.end() ? itr->second : -1);
+	}
+
+	/*!
+	 * Obh_̒l̎擾(mۂĂȂubNł0)
+	 * @param[in] i,j,k Obh_̈ʒu
+	 */
+	RXREAL GetValue(int i, int j, int k) const
+	{
+		int b = FindBrick(i/RX_BRICK_SIZE, j/RX_BRICK_SIZE, k/RX_BRICK_SIZE);
+		if(b < 0) return (RXREAL)0;
+		return GetBrickData(b)[NodeIndex(i%RX_BRICK_SIZE, j%RX_BRICK_SIZE, k%RX_BRICK_SIZE)];
+	}
+
+	/*!
+	 * p[eBN̊^Obh_ɉZ(XvbeBO)
+	 *  - ep[eBN̉e͈͂ɂubNmۂCubNƂɕɉZ
+	 *    (ubNƂɃp[eBNԍŉẐatomic͕svŁCʂXbhɂȂ)
+	 * @param[in] pos p[eBNW(stridevf)
+	 * @param[in] np p[eBN
+	 * @param[in] stride 1p[eBN̗vf
+	 * @param[in] h La
+	 * @param[in] mass p[eBN
+	 * @param[in] w J[l֐(,La,W)
+	 * @param[in] a J[lW
+	 */
+	void SplatParticles(const RXREAL *pos, int np, int stride, RXREAL h, RXREAL mass, 
+						double (*w)(double, double, double), double a)
+	{
+		double h2 = (double)h*h;
+
+		// ep[eBN̉e͈͂Ɋ܂܂Obh_̃CfbNX͈(͈͊Õp[eBN-1)
+		vector<int> range(6*np);
+		#pragma omp parallel for
+		for(int p = 0; p < np; ++p){
+			int *r = &range[6*p];
+			for(int l = 0; l < 3; ++l){
+				double x = pos[stride*p+l]-m_v3Min[l];
+				r[2*l]   = RX_MAX((int)ceil((x-h)/m_v3Dim[l]), 0);
+				r[2*l+1] = RX_MIN((int)floor((x+h)/m_v3Dim[l]), m_iN[l]-1);
+				if(r[2*l] > r[2*l+1]){
+					r[0] = -1;
+					break;
+				}
+			}
+		}
+
+		// ubN̊mۂƃubNƂ̃p[eBNXg(counting sort)
+		//  - e͈͂-x,-y,-z1Obh_LubNmۂ(l0̂܂)
+		//    bVł͒l̂Obh_ɓGbW̓l_-̃Obh_̃ubN߁C
+		//    ΂ߕ̗אڃubNmۂĂƂ̓l_߂Ȃ
+		vector<int> pb;
+		for(int p = 0; p < np; ++p){
+			const int *r = &range[6*p];
+			if(r[0] < 0) continue;
+			int b0[3], b1[3];
+			for(int l = 0; l < 3; ++l){
+				b0[l] = RX_MAX(r[2*l]-1, 0)/RX_BRICK_SIZE;
+				b1[l] = r[2*l+1]/RX_BRICK_SIZE;
+			}
+			for(int bk = b0[2]; bk <= b1[2]; ++bk){
+				for(int bj = b0[1]; bj <= b1[1]; ++bj){
+					for(int bi = b0[0]; bi <= b1[0]; ++bi){
+						int b = ActivateBrick(bi, bj, bk);
+
+						// e͈͂ƏdȂȂubNɂ̓p[eBNo^Ȃ
+						if((bi+1)*RX_BRICK_SIZE <= r[0] || (bj+1)*RX_BRICK_SIZE <= r[2] || (bk+1)*RX_BRICK_SIZE <= r[4]) continue;
+						pb.push_back(b);
+						pb.push_back(p);
+					}
+				}
+			}
+		}
+		int nb = GetNumBricks();
+		int npb = (int)pb.size()/2;
+		vector<int> start(nb+1, 0);
+		for(int m = 0; m < npb; ++m) start[pb[2*m]+1]++;
+		for(int b = 0; b < nb; ++b) start[b+1] += start[b];
+		vector<int> plist(npb);
+		vector<int> cnt(start.begin(), start.end()-1);
+		for(int m = 0; m < npb; ++m) plist[cnt[pb[2*m]]++] = pb[2*m+1];
+
+		// ubNƂɃJ[llZ
+		#pragma omp parallel for schedule(dynamic, 4)
+		for(int b = 0; b < nb; ++b){
+			RXREAL *f = GetBrickData(b);
+			const int *bc = GetBrickCoord(b);
+			int o[3], e[3];
+			for(int l = 0; l < 3; ++l){
+				o[l] = bc[l]*RX_BRICK_SIZE;
+				e[l] = RX_MIN(o[l]+RX_BRICK_SIZE, m_iN[l])-1;
+			}
+
+			for(int m = start[b]; m < start[b+1]; ++m){
+				int p = plist[m];
+				const int *r = &range[6*p];
+				const RXREAL *x = pos+stride*p;
+				int i0 = RX_MAX(r[0], o[0]), i1 = RX_MIN(r[1], e[0]);
+				int j0 = RX_MAX(r[2], o[1]), j1 = RX_MIN(r[3], e[1]);
+				int k0 = RX_MAX(r[4], o[2]), k1 = RX_MIN(r[5], e[2]);
+				for(int k = k0; k <= k1; ++k){
+					double dz = m_v3Min[2]+k*m_v3Dim[2]-x[2];
+					double dz2 = dz*dz;
+					for(int j = j0; j <= j1; ++j){
+						double dy = m_v3Min[1]+j*m_v3Dim[1]-x[1];
+						double dyz2 = dy*dy+dz2;
+						if(dyz2 > h2) continue;
+
+						RXREAL *fl = f+NodeIndex(0, j-o[1], k-o[2])-o[0];
+						for(int i = i0; i <= i1; ++i){
+							double dx = m_v3Min[0]+i*m_v3Dim[0]-x[0];
+							double r2 = dx*dx+dyz2;
+							if(r2 > h2) continue;
+							fl[i] += mass*w(sqrt(r2), h, a);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/*!
+	 * w͈͂̊OɂObh_̒l0ɂ
+	 * @param[in] vmin,vmax ͈
+	 */
+	void ClearOutside(Vec3 vmin, Vec3 vmax)
+	{
+		int imin[3], imax[3];
+		for(int l = 0; l < 3; ++l){
+			imin[l] = (int)ceil((vmin[l]-m_v3Min[l])/m_v3Dim[l]);
+			imax[l] = (int)floor((vmax[l]-m_v3Min[l])/m_v3Dim[l]);
+		}
+
+		int nb = GetNumBricks();
+		#pragma omp parallel for
+		for(int b = 0; b < nb; ++b){
+			RXREAL *f = GetBrickData(b);
+			const int *bc = GetBrickCoord(b);
+			int o[3] = {bc[0]*RX_BRICK_SIZE, bc[1]*RX_BRICK_SIZE, bc[2]*RX_BRICK_SIZE};
+			if(o[0] >= imin[0] && o[0]+RX_BRICK_SIZE-1 <= imax[0] && 
+			   o[1] >= imin[1] && o[1]+RX_BRICK_SIZE-1 <= imax[1] && 
+			   o[2] >= imin[2] && o[2]+RX_BRICK_SIZE-1 <= imax[2]) continue;
+
+			for(int lk = 0; lk < RX_BRICK_SIZE; ++lk){
+				for(int lj = 0; lj < RX_BRICK_SIZE; ++lj){
+					for(int li = 0; li < RX_BRICK_SIZE; ++li){
+						int i = o[0]+li, j = o[1]+lj, k = o[2]+lk;
+						if(i < imin[0] || i > imax[0] || j < imin[1] || j > imax[1] || k < imin[2] || k > imax[2]){
+							f[NodeIndex(li, lj, lk)] = (RXREAL)0;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//! ubÑObh_̃CfbNX
+	static int NodeIndex(int li, int lj, int lk){ return (lk*RX_BRICK_SIZE+lj)*RX_BRICK_SIZE+li; }
+
+	RXREAL* GetBrickData(int b){ return &m_vData[(size_t)b*RX_BRICK_NODES]; }
+	const RXREAL* GetBrickData(int b) const { return &m_vData[(size_t)b*RX_BRICK_NODES]; }
+	const int* GetBrickCoord(int b) const { return &m_vBrickCoord[3*b]; }
+
+	int GetNumBricks(void) const { return (int)m_vBrickCoord.size()/3; }
+	int GetN(int l) const { return m_iN[l]; }
+	int GetNumBricks(int l) const { return m_iNb[l]; }
+	Vec3 GetMin(void) const { return m_v3Min; }
+	Vec3 GetDim(void) const { return m_v3Dim; }
+
+	//! Obh_̒lɎgĂ郁[byte]
+	size_t GetMemorySize(void) const { return m_vData.size()*sizeof(RXREAL); }
+
+protected:
+	long long brickKey(int bi, int bj, int bk) const
+	{
+		return ((long long)bk*m_iNb[1]+bj)*m_iNb[0]+bi;
+	}
+};
+
+
+#endif // #ifndef _RX_SPARSE_GRID_H_
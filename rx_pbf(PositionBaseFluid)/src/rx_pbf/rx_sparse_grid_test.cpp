@@ -0,0 +1,143 @@
+/*!
+  @file rx_sparse_grid_test.cpp
+
+  @brief aȃubNObh(rx_sparse_grid.h)̃bṼeXg
+		 - p[eBNȃObh̃bV(CreateMeshV)ƒ_EOp`r
+		 - ubN̊p̋߂Ƀp[eBNC΂ߕ̗אڃubNmۂꍇ܂
+		 - SĈv0CłȂ1Ԃ
+
+  @date   2026-10
+*/
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include "rx_kernel.h"
+#include "rx_mc.h"
+
+
+//-----------------------------------------------------------------------------
+// 萔Eϐ
+//-----------------------------------------------------------------------------
+static int g_iNumFail = 0;			//!< s
+
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+//! Op`𒸓_W̑gŕ\(_ԍ̕tɂ炸r邽)
+struct SGTestTri
+{
+	double v[9];
+	bool operator<(const SGTestTri &t) const { return std::lexicographical_compare(v, v+9, t.v, t.v+9); }
+	bool operator==(const SGTestTri &t) const { return std::equal(v, v+9, t.v); }
+};
+
+/*!
+ * bVrp̎Op`Xgɕϊ
+ *  - Op`̒_͍W̏ɕׁCOp`\[g
+ */
+static vector<SGTestTri> SparseGridTestTris(const vector<Vec3> &vrts, const vector<rxFace> &faces)
+{
+	vector<SGTestTri> tris(faces.size());
+	for(int i = 0; i < (int)faces.size(); ++i){
+		Vec3 p[3];
+		for(int j = 0; j < 3; ++j) p[j] = vrts[faces[i][j]];
+		std::sort(p, p+3, [](const Vec3 &a, const Vec3 &b){ return std::lexicographical_compare(a.data, a.data+3, b.data, b.data+3); });
+		for(int j = 0; j < 3; ++j){
+			for(int k = 0; k < 3; ++k) tris[i].v[3*j+k] = p[j][k];
+		}
+	}
+	std::sort(tris.begin(), tris.end());
+	return tris;
+}
+
+/*!
+ * 1̃p[eBNzũeXg
+ * @param[in] name eXg
+ * @param[in] pos p[eBNW(3vf)
+ * @param[in] n Obh_
+ * @param[in] d Obh
+ * @param[in] h La
+ */
+static void SparseGridTest(const char *name, const vector<RXREAL> &pos, int n, double d, double h)
+{
+	int np = (int)pos.size()/3;
+	double a = KernelCoefPoly6(h, 3, 1);
+	RXREAL thr = (RXREAL)KernelPoly6(0.7*h, h, a);
+
+	// aȃObh
+	int nv[3] = {n, n, n};
+	rxSparseBrickGrid grid;
+	grid.Init(nv, Vec3(0.0), Vec3(d));
+	grid.SplatParticles(&pos[0], np, 3, (RXREAL)h, (RXREAL)1.0, KernelPoly6, a);
+
+	// l̖ȃObh
+	vector<RXREAL> field(n*n*n);
+	for(int k = 0; k < n; ++k){
+		for(int j = 0; j < n; ++j){
+			for(int i = 0; i < n; ++i){
+				field[(k*n+j)*n+i] = grid.GetValue(i, j, k);
+			}
+		}
+	}
+
+	vector<Vec3> vs, ns, vd, nd;
+	vector<rxFace> fs, fd;
+	rxMCMeshCPU mc;
+	int nc[3] = {n-1, n-1, n-1};
+	mc.CreateMeshSparse(grid, thr, vs, ns, fs);
+	mc.CreateMeshV(&field[0], Vec3(0.0), d, nc, thr, vd, nd, fd);
+
+	bool ok = (vs.size() == vd.size() && fs.size() == fd.size() && !fd.empty());
+	if(ok){
+		ok = (SparseGridTestTris(vs, fs) == SparseGridTestTris(vd, fd));
+	}
+	if(!ok) g_iNumFail++;
+
+	printf("%-12s : %d bricks, sparse %d/%d, dense %d/%d (vertices/triangles) : %s\n", name, grid.GetNumBricks(),
+		   (int)vs.size(), (int)fs.size(), (int)vd.size(), (int)fd.size(), (ok ? "ok" : "FAILED"));
+}
+
+
+/*!
+ * C֐
+ */
+int main(int argc, char *argv[])
+{
+	// ubN̊p̋߂̃p[eBN(-x,-y̗אڃubN͊mۂꂸC΂߂̃ubNmۂ)
+	{
+		RXREAL p[] = {8.7f, 8.7f, 4.0f,  2.0f, 2.0f, 2.0f};
+		SparseGridTest("corner", vector<RXREAL>(p, p+6), 17, 1.0, 1.5);
+	}
+
+	// x,y,ẑp̋߂
+	{
+		RXREAL p[] = {8.7f, 8.7f, 8.7f,  7.2f, 2.0f, 7.2f,  2.0f, 7.2f, 7.2f,  7.2f, 7.2f, 2.0f};
+		SparseGridTest("corner3", vector<RXREAL>(p, p+12), 17, 1.0, 1.5);
+	}
+
+	// ubNEt߂ɏW߂_Ȕzu
+	{
+		srand(1234);
+		vector<RXREAL> p;
+		for(int i = 0; i < 200; ++i){
+			for(int l = 0; l < 3; ++l){
+				int b = 1+rand()%2;
+				p.push_back((RXREAL)(b*RX_BRICK_SIZE+3.0*(rand()/(double)RAND_MAX-0.5)));
+			}
+		}
+		SparseGridTest("random", p, 25, 1.0, 1.5);
+	}
+
+	if(g_iNumFail){
+		printf("%d failures\n", g_iNumFail);
+		return 1;
+	}
+	return 0;
+}
@@ -21,6 +21,7 @@
 #include "rx_nnsearch.h"	// ObhɂߖTT
 
 #include "rx_sph_solid.h"
+#include "rx_solid_bvh.h"	// ő̃IuWFNgBVH
 
 #include "rx_kernel.h"
 
@@ -36,6 +37,7 @@
 #define GL_REAL GL_FLOAT
 
 // Ԍv
+//  - RXTIMERɂԂ̓vt@C(rx_profiler.h)LȂ炻ɂL^
 class rxTimerAvg;
 extern rxTimerAvg g_Time;
 
@@ -43,8 +45,8 @@ extern rxTimerAvg g_Time;
 
 #ifdef RX_USE_TIMER
 #define RXTIMER_CLEAR g_Time.ClearTime()
-#define RXTIMER_RESET g_Time.ResetTime()
-#define RXTIMER(x) g_Time.Split(x)
+#define RXTIMER_RESET (g_Time.ResetTime(), RXPROF_MARK)
+#define RXTIMER(x) (g_Time.Split(x), RXPROF_SPLIT(x))
 #define RXTIMER_PRINT g_Time.Print()
 #define RXTIMER_STRING(x) g_Time.PrintToString(x)
 #else
@@ -102,11 +104,22 @@ struct rxEnviroment
 	RXREAL ap_n;				//!< lH͂̂߂̌Wn (n)
 	RXREAL ap_q;				//!< lH͌vZ̊J[llvZpW(Lahɑ΂W, [0,1])
 
+	int num_threads;			//!< CPUvZ̃Xbh(0OpenMP̃ftHg)
+	int reorder_span;			//!< p[eBNMortonɕёւXebvԊu(0ŕёւȂ)
+	RXREAL nn_skin;				//!< ɋߖTXgg񂷂߂̃XL(Lahɑ΂W, 0Ŗ蒼)
+
+	int adaptive_dt;			//!< KIԃXebv(0 or 1, 1Ȃdt1Xebv̎ԂƂăTuXebvɕ)
+	RXREAL cfl;					//!< KIԃXebvCFL(xɑ΂W, ͂ɑ΂Ă͂1/2)
+	int max_substeps;			//!< 1Xebv̍őTuXebv
+
+	int profile;				//!< vt@CŊe̎Ԃv(0 or 1, Iresult/profile_trace.json, profile.csvɏo)
+
 	// \ʃbV
 	Vec3 mesh_boundary_cen;		//!< bVE̒S
 	Vec3 mesh_boundary_ext;		//!< bVȆ傫(eӂ̒1/2)
 	int mesh_vertex_store;		//!< _|S\Ƃ̌W
 	int mesh_max_n;				//!< MC@pObh̍ő啪
+	int mesh_sparse;			//!< MC@pObhaȃubNObhɂ(0 or 1)
 
 	rxEnviroment()
 	{
@@ -123,6 +136,7 @@ struct rxEnviroment
 		mesh_vertex_store = 10;
 		use_inlet = 0;
 		mesh_max_n = 128;
+		mesh_sparse = 0;
 
 		epsilon = 0.001;
 		eta = 0.05;
@@ -133,11 +147,42 @@ struct rxEnviroment
 		ap_k = 0.1;
 		ap_n = 4.0;
 		ap_q = 0.2;
+
+		num_threads = 0;
+		reorder_span = 0;
+		nn_skin = 0.0;
+
+		adaptive_dt = 0;
+		cfl = 0.4;
+		max_substeps = 32;
+
+		profile = 0;
 	}
 };
 
 
 
+//! Op`|SɂQ(m_hVrtsCm_hTris͈̔)
+struct rxPolygonObstacle
+{
+	int vstart, vnum;			//!< _z͈̔
+	int tstart, tnum;			//!< |Sz͈̔
+	vector<Vec3> vrts;			//!< ݒ莞̒_W(ϊ̊)
+	rxMatrix4 mat;				//!< ݂̕ϊs(ݒ莞̌`ɑ΂)
+	Vec3 vel;					//!< x(updateSolidsł̑xŕsړ)
+};
+
+//! ő̃IuWFNgɌŒ肳ꂽEp[eBN(m_hPosB͈̔)
+struct rxBoundarySet
+{
+	int solid;					//!< ő̃IuWFNg̃CfbNX(m_vSolids)
+	uint start, num;			//!< Ep[eBNz͈̔
+	vector<RXREAL> local;		//!< ő̃[JW(3, ϊ̊)
+	Vec3 cen;					//!< ݂̋Ep[eBNʒuɑΉő̏dS
+	rxMatrix4 mat;				//!< ݂̋Ep[eBNʒuɑΉő̎p
+	Vec3 minp, maxp;			//!< ݂̋Ep[eBNAABB
+};
+
 //! \ʃp[eBN
 struct rxSurfaceParticle
 {
@@ -178,13 +223,42 @@ private:
 	int m_iNumVrts;					//!< ő̃|S̒_
 	int *m_hTris;					//!< ő̃|S
 	int m_iNumTris;					//!< ő̃|S̐
+	vector<rxPolygonObstacle> m_vPolyObstacles;	//!< |SQƂ͈̔
+
+	rxSolidBVH m_SolidBVH;			//!< ő̂̕BVH
+	vector< vector<int> > m_vColBuf;	//!< ubNƂ(ő,p[eBN)̑g(calCollisionSolidp)
+	vector<int> m_vColStart;		//!< ő̂Ƃ̏Փˌp[eBN̊Jnʒu(CSR`)
+	vector<int> m_vColIdx;			//!< Փˌp[eBÑCfbNX
+	vector<RXREAL> m_vColPos;		//!< Փˌp[eBN̈ʒu
+	vector<RXREAL> m_vColPen;		//!< ő̃IuWFNgƂ̐N
+	vector<RXREAL> m_vColCp;		//!< ő̃IuWFNgƂ̏Փ˓_
 
 	// ԕiq֘A
 	rxNNGrid *m_pNNGrid;			//!< ObhɂߖTT
-	vector< vector<rxNeigh> > m_vNeighs;	//!< ߖTp[eBN
+	rxNeighList m_vNeighs;			//!< ߖTp[eBN(CSR`)
 
 	rxNNGrid *m_pNNGridB;			//!< Ep[eBNpObh
-	vector< vector<rxNeigh> > m_vNeighsB;	//!< EߖTp[eBN
+	rxNeighList m_vNeighsB;			//!< EߖTp[eBN(CSR`)
+
+	// ړE
+	vector<rxBoundarySet> m_vBoundarySets;	//!< ő̂ɌŒ肳ꂽEp[eBN̑g
+	vector<int> m_vBSet;			//!< eEp[eBN̑g(-1ȂV~[VԂ̋E)
+	vector<unsigned char> m_vBMoved;	//!< ݂̃XebvňړEp[eBN
+	vector<unsigned char> m_vBNear;	//!< ̑g̋Ep[eBNߖTɂ鋫Ep[eBN
+	vector<int> m_vBCellSet;		//!< ZƂ̋Ep[eBN̑g(-2:, -3:̑g)
+	int m_iNumBVolUpdates;			//!< ݂̃Xebvő̐ςvZEp[eBN
+
+	RXREAL m_fNeighborSkin;			//!< ߖTXg̃XL(0Ȃ甽Ƃɍ蒼)
+	vector<RXREAL> m_vNeighPos;		//!< ߖTXg쐬̃p[eBNW
+	int m_iNeighborBuilds;			//!< ݂̃Xebvł̋ߖTXg쐬
+
+	// KIԃXebv
+	bool m_bAdaptiveDt;				//!< KIԃXebvON/OFF
+	RXREAL m_fCFL;					//!< CFL
+	int m_iMaxSubsteps;				//!< 1Xebv̍őTuXebv
+	RXREAL m_fDtSub;				//!< TuXebv(̃XebvɈp, 0Ȃ疢ݒ)
+	int m_iSubsteps;				//!< ݂̃Xebvł̃TuXebv
+	vector<RXREAL> m_vAcc;			//!< ÓESɂx(calTimeStepp)
 
 
 	// qp[^
@@ -235,6 +309,23 @@ public:
 	// ߖTp[eBN
 	uint* GetNeighborList(const int &i, int &n);
 
+	// ̋ߖTXg̎g(VerletXg)
+	void SetNeighborSkin(RXREAL skin){ m_fNeighborSkin = (skin > 0.0 ? skin : 0.0); }
+	RXREAL GetNeighborSkin(void) const { return m_fNeighborSkin; }
+	int GetNeighborBuilds(void) const { return m_iNeighborBuilds; }
+
+	// KIԃXebv(Updatedt1Xebv̎ԂƂCFLŃTuXebvɕ)
+	void SetAdaptiveTimeStep(bool on, RXREAL cfl = 0.4, int max_substeps = 32)
+	{
+		m_bAdaptiveDt = on;
+		m_fCFL = (cfl > 0.0 ? cfl : 0.4);
+		m_iMaxSubsteps = (max_substeps > 0 ? max_substeps : 1);
+		m_fDtSub = 0.0;
+	}
+	bool GetAdaptiveTimeStep(void) const { return m_bAdaptiveDt; }
+	int GetSubsteps(void) const { return m_iSubsteps; }
+	RXREAL GetSubstepSize(void) const { return m_fDtSub; }
+
 public:
 	//
 	// z֐
@@ -249,9 +340,22 @@ public:
 
 	// V[̐ݒ
 	virtual void SetPolygonObstacle(const vector<Vec3> &vrts, const vector<Vec3> &nrms, const vector< vector<int> > &tris, Vec3 vel);
+	virtual void SetPolygonObstacle(const string &filename, Vec3 cen, Vec3 ext, Vec3 ang, Vec3 vel);
 	virtual void SetBoxObstacle(Vec3 cen, Vec3 ext, Vec3 ang, Vec3 vel, int flg);
 	virtual void SetSphereObstacle(Vec3 cen, double rad, Vec3 vel, int flg);
 
+	// |SQ̈ړ(ϊςQ̃|SZɊi[)
+	int GetNumPolygonObstacles(void) const { return (int)m_vPolyObstacles.size(); }
+	bool SetPolygonObstacleMatrix(int i, const rxMatrix4 &mat);
+
+	// ő̏Q̈ړ(Ep[eBNő͎̂UpdateŋEp[eBNړ)
+	int GetNumSolids(void) const { return (int)m_vSolids.size(); }
+	bool SetSolidTransform(int i, const Vec3 &pos, const rxMatrix4 &mat);
+	int GetNumBoundaryVolumeUpdates(void) const { return m_iNumBVolUpdates; }
+
+	// ő̏Q̋Ep[eBN
+	virtual void InitBoundary(void);
+
 	// zXg<->VBOԓ]
 	virtual RXREAL* GetArrayVBO(rxParticleArray type, bool d2h = true, int num = -1);
 	virtual void SetArrayVBO(rxParticleArray type, const RXREAL* data, int start, int count);
@@ -261,6 +365,7 @@ public:
 	virtual double GetImplicit(double x, double y, double z);
 	virtual void CalImplicitField(int n[3], Vec3 minp, Vec3 d, RXREAL *hF);
 	virtual void CalImplicitFieldDevice(int n[3], Vec3 minp, Vec3 d, RXREAL *dF);
+	virtual void CalImplicitFieldSparse(int n[3], Vec3 minp, Vec3 d, rxSparseBrickGrid &grid);
 
 	// SPHo
 	virtual void OutputSetting(string fn);
@@ -317,8 +422,29 @@ protected:
 	// Ep[eBN̑̐ςvZ
 	void calBoundaryVolumes(const RXREAL *bpos, RXREAL *bvol, RXREAL mass, uint n, RXREAL h);
 
+	// ړE̍XV
+	void updateSolids(RXREAL dt);
+	int updateBoundaryParticles(void);
+	void updateBoundaryVolumes(const vector<int> &idx, RXREAL h);
+	void calBoundarySetBounds(const rxBoundarySet &bs, Vec3 &minp, Vec3 &maxp);
+
+	// ϖxϓ̌vZ
+	RXREAL calDensityFluctuation(const RXREAL *pdens, RXREAL r0);
+
+	// ߖTXg̍XV(XL̈ړȂg)
+	bool updateNeighborList(RXREAL *prts, RXREAL h, bool force);
+	RXREAL calMaxDisplacement(const RXREAL *ppos, const RXREAL *ppos0);
+
+	// p[eBNz̕ёւ
+	virtual void permuteParticles(const vector<uint> &perm);
+
+	// `FbN|Cg̓o
+	virtual bool writeCheckpoint(ofstream &fout);
+	virtual bool readCheckpoint(ifstream &fin);
+
 	// ԃXebv̏C
-	RXREAL calTimeStep(RXREAL &dt, RXREAL eta_avg, const RXREAL *pfrc, const RXREAL *pvel, const RXREAL *pdens);
+	RXREAL calTimeStep(RXREAL dt, RXREAL eta_avg, RXREAL dens_var, const RXREAL *pacc, const RXREAL *pvel, const RXREAL *pdens);
+	int updateStep(RXREAL dt, RXREAL &dens_var);
 
 	// ʒuƑx̍XV
 	void integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *dens, const RXREAL *acc, 
@@ -328,12 +454,14 @@ protected:
 
 	// Փ˔
 	int calCollisionPolygon(uint grid_hash, Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt);
-	int calCollisionSolid(Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt);
+	int calCollisionSolid(RXREAL *pos, RXREAL *vel, RXREAL dt);
+	void calSolidCandidates(const RXREAL *pos, int n);
 };
 
 
 
 
+#ifndef RX_HEADLESS
 //-----------------------------------------------------------------------------
 // MARK:rxPBDSPH_GPUNX̐錾
 //  - Miles Macklin and Matthias Muller, "Position Based Fluids", Proc. SIGGRAPH 2013, 2013. 
@@ -460,6 +588,7 @@ public:
 	virtual double GetImplicit(double x, double y, double z);
 	virtual void CalImplicitField(int n[3], Vec3 minp, Vec3 d, RXREAL *hF);
 	virtual void CalImplicitFieldDevice(int n[3], Vec3 minp, Vec3 d, RXREAL *dF);
+	virtual void CalImplicitFieldSparse(int n[3], Vec3 minp, Vec3 d, rxSparseBrickGrid &grid);
 
 	// SPHo
 	virtual void OutputSetting(string fn);
@@ -513,6 +642,7 @@ protected:
 	// |S_̒
 	bool fitVertices(const Vec3 &ctr, const Vec3 &sl, vector<Vec3> &vec_set);
 };
+#endif	// #ifndef RX_HEADLESS
 
 
 
@@ -22,7 +22,12 @@
 #include <cstdio>
 #include <cassert>
 
+#ifdef _WIN32
 #include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <iostream>
 #include <fstream>
@@ -36,9 +41,11 @@
 #include <bitset>
 #include <algorithm>
 
-// OpenGL
+// OpenGL(RX_HEADLESS`ƂOpenGLgȂ)
+#ifndef RX_HEADLESS
 #include <GL/glew.h>
 #include <GL/glut.h>
+#endif
 
 // [eBeB
 #include "rx_utility.h"
@@ -47,6 +54,7 @@
 #include "rx_matrix.h"
 
 #include "rx_timer.h"
+#include "rx_profiler.h"
 
 // CUDA
 #include "rx_cu_common.cuh"
@@ -59,6 +67,13 @@ using namespace std;
 //-----------------------------------------------------------------------------
 typedef unsigned char byte;
 
+#ifndef _WIN32
+// POSIXp̃fBNg֐
+inline int _mkdir(const char *dir){ return mkdir(dir, 0755); }
+inline char* _getcwd(char *buf, int size){ return getcwd(buf, size); }
+inline int _chdir(const char *dir){ return chdir(dir); }
+#endif
+
 #define STR(x) #x
 
 #define RXFRMT(a) (boost::format("%.3f") % (a))
@@ -69,6 +84,7 @@ const string RX_DEFAULT_RESULT_DIR = "result/";
 const string RX_DEFAULT_IMAGE_DIR  = RX_DEFAULT_RESULT_DIR+"images/";
 const string RX_DEFAULT_MESH_DIR   = RX_DEFAULT_RESULT_DIR+"mesh/";
 const string RX_DEFAULT_DATA_DIR   = RX_DEFAULT_RESULT_DIR+"data/";
+const string RX_DEFAULT_SDF_DIR    = RX_DEFAULT_RESULT_DIR+"sdf/";
 
 
 //-----------------------------------------------------------------------------
@@ -264,6 +280,7 @@ inline void GetGLMatrix(matrix3x3 mat, float glmat[16])
 }
 
 
+#ifndef RX_HEADLESS
 /*!
  * 3x3s񂩂OpenGL̕ϊs擾
  * @param[in] 
@@ -289,6 +306,7 @@ inline void GetGLMatrix(RXREAL mat[9], GLfloat glmat[16])
 	glmat[14] = 0.0f; 
 	glmat[15] = 1.0f;
 }
+#endif
 
 
 /*!
@@ -400,7 +418,7 @@ static rxLog RXDOUT("log/sph.dat");
 template<class T> 
 inline bool EraseSTLVectori(vector<T> &src, int idx)
 {
-	vector<T>::iterator iter = src.begin();
+	typename vector<T>::iterator iter = src.begin();
 	int i = 0;
 	while(iter != src.end()){
 		if(i == idx){
@@ -426,7 +444,7 @@ inline bool EraseSTLVectori(vector<T> &src, int idx)
 template<class T> 
 inline bool EraseSTLVector(vector<T> &src, bool (*comp_func)(T))
 {
-	vector<T>::iterator iter = src.begin();
+	typename vector<T>::iterator iter = src.begin();
 	while(iter != src.end()){
 		if(comp_func(*iter)){
 			src.erase(iter++);
@@ -449,7 +467,7 @@ inline bool EraseSTLVector(vector<T> &src, bool (*comp_func)(T))
 template<class T1, class T2> 
 inline bool EraseSTLMap(map<T1, T2> &src, bool (*comp_func)(pair<T1, T2>))
 {
-	map<T1, T2>::iterator iter = src.begin();
+	typename map<T1, T2>::iterator iter = src.begin();
 	while(iter != src.end()){
 		if(comp_func(*iter)){
 			src.erase(iter++);
@@ -684,8 +702,9 @@ static void Dump(string fn, Type *data, int n, int d, bool rw = false, string la
  * @param[in] static_str ÓIȕobt@
  * @param[in] w,h EBhETCY
  */
-static void DrawStrings(vector<string> &static_str, int w, int h)
+static inline void DrawStrings(vector<string> &static_str, int w, int h)
 {
+#ifndef RX_HEADLESS
 	// MRK:PrintD
 	glDisable(GL_LIGHTING);
 	//glColor3f(0.0, 0.0, 0.0);
@@ -716,6 +735,7 @@ static void DrawStrings(vector<string> &static_str, int w, int h)
 	glPopMatrix();
 	glMatrixMode(GL_PROJECTION);
 	glPopMatrix();
+#endif
 }
 
 
@@ -981,7 +1001,11 @@ inline string GetExtension(const string &path)
  */
 static inline int OpenFileStream(fstream &file, const string &path, int rw = 1)
 {
-	file.open(path.c_str(), (rw & 0x01 ? ios::in : 0)|(rw & 0x02 ? ios::out : 0)|(rw & 0x04 ? ios::app : 0));
+	ios::openmode mode = (ios::openmode)0;
+	if(rw & 0x01) mode |= ios::in;
+	if(rw & 0x02) mode |= ios::out;
+	if(rw & 0x04) mode |= ios::app;
+	file.open(path.c_str(), mode);
 	if(!file || !file.is_open() || file.bad() || file.fail()){
 		return 0;
 	}
@@ -1004,7 +1028,7 @@ static int MkDir(string dir)
 			return 1;
 		}
 		else{
-			size_t pos = dir.find_last_of("\\/");
+			size_t pos = dir.find_last_of("\\/", dir.find_last_not_of("\\/"));	// ̋؂蕶͏ĐeT
 			if(pos != string::npos){	// Kw̉\L
 				int parent = MkDir(dir.substr(0, pos+1));	// efBNgċAIɍ쐬
 				if(parent){
@@ -1036,7 +1060,7 @@ inline float RxPythag(const float a, const float b)
 		   (absb == 0.0 ? 0.0 : absb*(float)sqrt((double)(1.0+(absa/absb)*(absa/absb)))));
 }
 
-static void RxSVDecomp3(float w[3], float u[9], float v[9], float eps)
+static inline void RxSVDecomp3(float w[3], float u[9], float v[9], float eps)
 {
 	bool flag;
 	int i, its, j, jj, k, l, nm;
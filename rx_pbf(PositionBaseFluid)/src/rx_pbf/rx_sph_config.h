@@ -28,7 +28,9 @@
 
 // 3Df
 #include "rx_model.h"
+#ifndef RX_HEADLESS
 #include "rx_fltk_widgets.h"
+#endif
 
 // ݒt@C
 #include "rx_atom_ini.h"
@@ -127,6 +129,13 @@ public:
 	//! SPHNX
 	void Set(rxParticleSystemBase *solver){ m_pSolver = solver; }
 
+	//! V[t@C𒼐ڎw(ReadSceneFilesgȂꍇ)
+	void SetCurrentSceneFile(const string &fn)
+	{
+		m_strCurrentScene = fn;
+		m_iCurrentSceneIdx = 0;
+	}
+
 	//! ő̃|S
 	int GetSolidPolyNum(void) const { return (int)m_vSolidPoly.size(); }
 	vector<rxPolygons>& GetSolidPolys(void){ return m_vSolidPoly; }
@@ -147,7 +156,6 @@ public:
 	{
 		rxEnviroment sph_env;
 		sph_env.use_inlet = 0;
-		int idr = 0;
 		for(int i = 0; i < n; ++i){
 			if(names[i] == "cen")      GetValueFromString(sph_env.boundary_cen, values[i], false);
 			else if(names[i] == "ext") GetValueFromString(sph_env.boundary_ext, values[i], false);
@@ -156,6 +164,7 @@ public:
 			else if(names[i] == "mass")				 sph_env.mass = atof(values[i].c_str());
 			else if(names[i] == "kernel_particles")  sph_env.kernel_particles = atof(values[i].c_str());
 			else if(names[i] == "mesh_res_max")		 sph_env.mesh_max_n = atoi(values[i].c_str());
+			else if(names[i] == "mesh_sparse")		 sph_env.mesh_sparse = atoi(values[i].c_str());
 			else if(names[i] == "inlet_boundary")	 sph_env.use_inlet = atoi(values[i].c_str());
 			else if(names[i] == "dt")				 sph_env.dt = atof(values[i].c_str());
 			else if(names[i] == "viscosity")		 sph_env.viscosity = atof(values[i].c_str());
@@ -169,6 +178,13 @@ public:
 			else if(names[i] == "ap_k")				 sph_env.ap_k = atof(values[i].c_str());
 			else if(names[i] == "ap_n")				 sph_env.ap_n = atof(values[i].c_str());
 			else if(names[i] == "ap_q")				 sph_env.ap_q = atof(values[i].c_str());
+			else if(names[i] == "num_threads")		 sph_env.num_threads = atoi(values[i].c_str());
+			else if(names[i] == "reorder_span")		 sph_env.reorder_span = atoi(values[i].c_str());
+			else if(names[i] == "neighbor_skin")	 sph_env.nn_skin = atof(values[i].c_str());
+			else if(names[i] == "adaptive_dt")		 sph_env.adaptive_dt = atoi(values[i].c_str());
+			else if(names[i] == "cfl")				 sph_env.cfl = atof(values[i].c_str());
+			else if(names[i] == "max_substeps")		 sph_env.max_substeps = atoi(values[i].c_str());
+			else if(names[i] == "profile")			 sph_env.profile = atoi(values[i].c_str());
 		}
 		if(sph_env.mesh_vertex_store < 1) sph_env.mesh_vertex_store = 1;
 
@@ -247,7 +263,7 @@ public:
 		inlet.accum = accum;
 		inlet.spacing = spacing;
 
-		int num_of_inlets = m_pSolver->AddLine(inlet);
+		m_pSolver->AddLine(inlet);
 		//((RXSPH*)m_pSolver)->AddSubParticles(g_iInletStart, count);
 		RXCOUT << "set inlet boundary : " << pos1 << "-" << pos2 << ", " << vel << endl;
 		RXCOUT << "                     span=" << span << ", up=" << up << ", accum=" << accum << ", spacing=" << spacing << endl;
@@ -262,13 +278,15 @@ public:
 	{
 		bool rel = (header.find("(r)") != string::npos);
 		Vec3 cen(0.0), ext(0.0), ang(0.0), vel(0.0);
+		int flg = 1;
 		for(int i = 0; i < n; ++i){
 			if(names[i] == "cen")      GetValueFromString(cen, values[i], rel, m_pSolver->GetCen(), 0.5*m_pSolver->GetDim());
 			else if(names[i] == "ext") GetValueFromString(ext, values[i], rel, Vec3(0.0), 0.5*m_pSolver->GetDim());
 			else if(names[i] == "ang") GetValueFromString(ang, values[i], false);
 			else if(names[i] == "vel") GetValueFromString(vel, values[i], false);
+			else if(names[i] == "particles" && atoi(values[i].c_str())) flg |= RX_OBSTACLE_PARTICLES;
 		}
-		m_pSolver->SetBoxObstacle(cen, ext, ang, vel, 1);
+		m_pSolver->SetBoxObstacle(cen, ext, ang, vel, flg);
 		RXCOUT << "set solid box : " << cen << ", " << ext << ", " << ang << endl;
 	}
 
@@ -280,21 +298,17 @@ public:
 	void SetSolidSphere(string *names, string *values, int n, string header)
 	{
 		bool rel = (header.find("(r)") != string::npos);
-		Vec3 cen(0.0), move_pos1(0.0), move_pos2(0.0), vel(0.0);
-		int  move = 0, move_start = -1;
-		double rad = 0.0, move_max_vel = 0.0, lap = 1.0;
+		Vec3 cen(0.0), vel(0.0);
+		int  flg = 1;
+		double rad = 0.0;
+		// move_pos1,move_pos2,move,move_start,move_max_vel,lap͖Ή(ǂݔ΂)
 		for(int i = 0; i < n; ++i){
 			if(names[i] == "cen")      GetValueFromString(cen, values[i], rel, m_pSolver->GetCen(), 0.5*m_pSolver->GetDim());
 			else if(names[i] == "rad") GetValueFromString(rad, values[i], rel, Vec3(0.0), 0.5*m_pSolver->GetDim());
 			else if(names[i] == "vel")  GetValueFromString(vel, values[i], false);
-			else if(names[i] == "move_pos1") GetValueFromString(move_pos1, values[i], rel, m_pSolver->GetCen(), 0.5*m_pSolver->GetDim());
-			else if(names[i] == "move_pos2") GetValueFromString(move_pos2, values[i], rel, m_pSolver->GetCen(), 0.5*m_pSolver->GetDim());
-			else if(names[i] == "move") move = atoi(values[i].c_str());
-			else if(names[i] == "move_start") move_start = atoi(values[i].c_str());
-			else if(names[i] == "move_max_vel") move_max_vel = atof(values[i].c_str());
-			else if(names[i] == "lap") lap = atof(values[i].c_str());
+			else if(names[i] == "particles" && atoi(values[i].c_str())) flg |= RX_OBSTACLE_PARTICLES;
 		}
-		m_pSolver->SetSphereObstacle(cen, rad, vel, 1);
+		m_pSolver->SetSphereObstacle(cen, rad, vel, flg);
 		RXCOUT << "set solid sphere : " << cen << ", " << rad << endl;
 	}
 
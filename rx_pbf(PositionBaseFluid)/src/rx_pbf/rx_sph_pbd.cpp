@@ -12,14 +12,72 @@
 //-----------------------------------------------------------------------------
 #include "rx_sph.h"
 
+#ifndef RX_HEADLESS
 #include "rx_cu_funcs.cuh"
+#endif
 #include "rx_cu_common.cuh"
 
 #include "rx_pcube.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// 萔
+//-----------------------------------------------------------------------------
+//! xϓ̑aƂ̃ubNTCY
+//  - ubN̕aubNɑ킹邱ƂŁCXbhɂ炸ʂɂȂ
+const int RX_REDUCTION_BLOCK = 1024;
+
+//! XP[Ot@N^CʒuCʂ̌vZɗpJ[l(RpCɑI)
+//  - ߖTqRX_KERNEL_BATCH܂Ƃ߂ăob`vZ(rx_kernel.h)
+typedef rxKernelPoly6 RxKernelW;	//!< xvZp
+typedef rxKernelSpiky RxKernelGW;	//!< zvZp
+typedef rxKernelBlock<RXREAL, RX_KERNEL_BATCH> rxNeighBlock;
+
 
 extern int g_iIterations;			//!< C
 extern double g_fEta;				//!< xϓ
+extern int g_iNeighborBuilds;		//!< ߖTXg쐬
+extern int g_iSubsteps;				//!< TuXebv
+
+
+//-----------------------------------------------------------------------------
+// ֐
+//-----------------------------------------------------------------------------
+/*!
+ * ߖTqRX_KERNEL_BATCHubN(SoA)ɋl߂
+ * @param[in] pos ߖTq̍Wz
+ * @param[in] pos0 Sq̍W
+ * @param[inout] itr ߖTXǧ݈ʒu(l߂i)
+ * @param[in] end ߖTXg̏I[
+ * @param[out] b ߖTqubN
+ * @param[in] rpad 󂫗vf𖄂߂鋗(J[l̉e͈͊O)
+ * @return ubNɋl߂q
+ */
+static inline int RxGatherNeighbors(const RXREAL *pos, const Vec3 &pos0, const rxNeigh *&itr, const rxNeigh *end, 
+									rxNeighBlock &b, RXREAL rpad)
+{
+	b.n = 0;
+	for(; itr != end && b.n < RX_KERNEL_BATCH; ++itr){
+		int j = itr->Idx;
+		if(j < 0) continue;
+
+		RXREAL x = pos0[0]-pos[DIM*j+0];
+		RXREAL y = pos0[1]-pos[DIM*j+1];
+		RXREAL z = pos0[2]-pos[DIM*j+2];
+		b.x[b.n] = x;
+		b.y[b.n] = y;
+		b.z[b.n] = z;
+		b.r[b.n] = sqrt(x*x+y*y+z*z);
+		b.idx[b.n] = j;
+		b.n++;
+	}
+	b.Pad(rpad);
+	return b.n;
+}
 
 
 //-----------------------------------------------------------------------------
@@ -35,12 +93,12 @@ rxPBDSPH::rxPBDSPH(bool use_opengl) :
 	m_hDens(0), 
 	m_hS(0), 
 	m_hDp(0), 
-	m_hSb(0), 
 	m_hPredictPos(0), 
 	m_hPredictVel(0), 
+	m_hSb(0), 
+	m_pBoundary(0), 
 	m_hVrts(0), 
-	m_hTris(0), 
-	m_pBoundary(0)
+	m_hTris(0)
 {
 	m_v3Gravity = Vec3(0.0, -9.82, 0.0);
 
@@ -52,12 +110,24 @@ rxPBDSPH::rxPBDSPH(bool use_opengl) :
 
 	m_bArtificialPressure = true;
 
+	m_fNeighborSkin = 0.0;
+	m_iNeighborBuilds = 0;
+
+	m_bAdaptiveDt = false;
+	m_fCFL = 0.4;
+	m_iMaxSubsteps = 32;
+	m_fDtSub = 0.0;
+	m_iSubsteps = 0;
+
+	m_iNumBVolUpdates = 0;
+
 	// ߖTTZ
 	m_pNNGrid = new rxNNGrid(DIM);
 	m_pNNGridB = new rxNNGrid(DIM);
 
 	m_uNumParticles = 0;
 	m_uNumBParticles = 0;
+	m_iNumVrts = 0;
 	m_iNumTris = 0;
 
 	m_iColorType = RX_RAMP;
@@ -97,7 +167,6 @@ void rxPBDSPH::Initialize(const rxEnviroment &env)
 	m_fViscosity = env.viscosity;
 
 	RXREAL h = m_fEffectiveRadius;
-	RXREAL r = m_fParticleRadius;
 
 	// J[l֐̒萔
 	m_fAw = KernelCoefPoly6(h, 3, 1);
@@ -146,6 +215,28 @@ void rxPBDSPH::Initialize(const rxEnviroment &env)
 	RXCOUT << "  dq = " << m_fApQ << endl;
 	RXCOUT << "  wq = " << wq << endl;
 
+	// CPUvZ̃Xbh
+#ifdef _OPENMP
+	if(env.num_threads > 0) omp_set_num_threads(env.num_threads);
+	RXCOUT << " threads = " << omp_get_max_threads() << endl;
+#endif
+
+	// Mortonёւ̊Ԋu
+	m_iReorderSpan = env.reorder_span;
+	RXCOUT << " reorder span = " << m_iReorderSpan << endl;
+
+	// ̋ߖTXg̃XL
+	SetNeighborSkin(env.nn_skin*m_fEffectiveRadius);
+	RXCOUT << " neighbor skin = " << m_fNeighborSkin << endl;
+
+	// KIԃXebv
+	SetAdaptiveTimeStep(env.adaptive_dt != 0, env.cfl, env.max_substeps);
+	RXCOUT << " adaptive time step : " << (m_bAdaptiveDt ? "on" : "off") << endl;
+	if(m_bAdaptiveDt){
+		RXCOUT << "  cfl = " << m_fCFL << endl;
+		RXCOUT << "  max substeps = " << m_iMaxSubsteps << endl;
+	}
+
 	//
 	// Eݒ
 	//
@@ -219,7 +310,7 @@ void rxPBDSPH::Allocate(int max_particles)
 	m_hTmp = new RXREAL[m_uMaxParticles];
 	memset(m_hTmp, 0, sizeof(RXREAL)*m_uMaxParticles);
 
-	m_vNeighs.resize(m_uMaxParticles);
+	m_vNeighs.Offset.reserve(m_uMaxParticles+1);
 
 	if(m_bUseOpenGL){
 		m_posVBO = createVBO(mem_size);	
@@ -230,7 +321,6 @@ void rxPBDSPH::Allocate(int max_particles)
 
 	// Zݒ
 	m_pNNGrid->Setup(m_v3EnvMin, m_v3EnvMax, m_fEffectiveRadius, m_uMaxParticles);
-	m_vNeighs.resize(m_uMaxParticles);
 
 	if(m_uNumBParticles){
 		Vec3 minp = m_pBoundary->GetMin()-Vec3(4.0*m_fParticleRadius);
@@ -282,21 +372,34 @@ void rxPBDSPH::Finalize(void)
 
 	if(m_hTmp) delete [] m_hTmp;
 
-	m_vNeighs.clear();
-	m_vNeighsB.clear();
+	m_vNeighs.Release();
+	m_vNeighsB.Release();
+	vector<RXREAL>().swap(m_vNeighPos);
+
+	m_vBoundarySets.clear();
+	m_vBSet.clear();
+	m_vBMoved.clear();
+	m_vBNear.clear();
+	m_vBCellSet.clear();
 
+#ifndef RX_HEADLESS
 	if(m_bUseOpenGL){
 		glDeleteBuffers(1, (const GLuint*)&m_posVBO);
 		glDeleteBuffers(1, (const GLuint*)&m_colorVBO);
 	}
+#endif
 
 	if(m_pNNGrid) delete m_pNNGrid;
-	m_vNeighs.clear();
 
 	if(m_pNNGridB) delete m_pNNGridB;
 
 	if(m_hVrts) delete [] m_hVrts;
 	if(m_hTris) delete [] m_hTris;
+	m_hVrts = 0;
+	m_hTris = 0;
+	m_iNumVrts = 0;
+	m_iNumTris = 0;
+	m_vPolyObstacles.clear();
 
 	if(m_pBoundary) delete m_pBoundary;
 
@@ -313,12 +416,22 @@ void rxPBDSPH::Finalize(void)
 
 /*!
  * SPH1Xebvi߂
+ *  - KIԃXebvONȂdt1XebvŐi߂鎞ԂƂCcalTimeStepŌ߂TuXebvŕĐi߂
  * @param[in] dt ԃXebv
  * @retval ture  vZ
  * @retval false őXebv𒴂Ă܂
  */
 bool rxPBDSPH::Update(RXREAL dt, int step)
 {
+	RXPROF_ZONE("update");
+	RXPROF_MARK;	// ȉRXTIMER̋Ԃupdate̋ԂɊ܂܂悤
+
+	// ԓIɋ߂p[eBNzł߂Ȃ悤ɕёւ
+	if(m_iReorderSpan > 0 && step > 0 && step%m_iReorderSpan == 0){
+		ReorderParticles();
+		RXTIMER("reorder");
+	}
+
 	// p[eBNǉ
 	if(!m_vInletLines.empty()){
 		int start = (m_iInletStart == -1 ? 0 : m_iInletStart);
@@ -331,23 +444,104 @@ bool rxPBDSPH::Update(RXREAL dt, int step)
 				num += count;
 			}
 		}
-		SetArrayVBO(RX_POSITION, m_hPos, start, num);
-		SetArrayVBO(RX_VELOCITY, m_hVel, start, num);
+		if(m_vIdx.empty()){
+			SetArrayVBO(RX_POSITION, m_hPos, start, num);
+			SetArrayVBO(RX_VELOCITY, m_hVel, start, num);
+		}
+		else{
+			// ёւ͒ǉ悪zŘAĂȂ̂őŜXV
+			SetArrayVBO(RX_POSITION, m_hPos, 0, m_uNumParticles);
+			SetArrayVBO(RX_VELOCITY, m_hVel, 0, m_uNumParticles);
+		}
 	}
 
 
 	assert(m_bInitialized);
+
+	// ő̏Q̈ړƋEp[eBN̍XV
+	updateSolids(dt);
+	if(updateBoundaryParticles()){
+		RXTIMER("boundary");
+	}
+
+	m_iNeighborBuilds = 0;
+	m_iSubsteps = 0;
+
+	int iter = 0;			// (TuXebv̍v)
+	RXREAL dens_var = 0.0;	// x̕U
+	if(!m_bAdaptiveDt){
+		iter = updateStep(dt, dens_var);
+		m_iSubsteps = 1;
+	}
+	else{
+		// TuXebv͈̔ : [dt/max_substeps, dt]
+		RXREAL dt_min = dt/m_iMaxSubsteps;
+		if(m_fDtSub <= 0.0 || m_fDtSub > dt){
+			m_fDtSub = RX_MAX(calTimeStep(dt, m_fEta, -1.0, m_hFrc, m_hVel, m_hDens), dt_min);
+		}
+
+		RXREAL t = 0.0;
+		while(t < dt){
+			RXREAL remain = dt-t;
+			RXREAL sub = RX_MAX(m_fDtSub, dt_min);
+			if(sub >= remain || m_iSubsteps == m_iMaxSubsteps-1){
+				sub = remain;
+			}
+			else if(sub > 0.5*remain){
+				// c莞Ԃr[ɂȂȂ悤2
+				sub = 0.5*remain;
+			}
+
+			iter += updateStep(sub, dens_var);
+			m_iSubsteps++;
+			t += sub;
+
+			// ̃TuXebv
+			m_fDtSub = calTimeStep(m_fDtSub, m_fEta, dens_var, (m_vAcc.empty() ? m_hFrc : &m_vAcc[0]), m_hVel, m_hDens);
+			m_fDtSub = RX_MIN(RX_MAX(m_fDtSub, dt_min), dt);
+		}
+	}
+
+	g_iIterations = iter;
+	g_fEta = dens_var;
+	g_iNeighborBuilds = m_iNeighborBuilds;
+	g_iSubsteps = m_iSubsteps;
+
+	SetArrayVBO(RX_POSITION, m_hPos, 0, m_uNumParticles);
+
+	SetColorVBO(m_iColorType, -1);
+
+	RXTIMER("color(vbo)");
+
+	m_fTime += dt;
+
+	return true;
+}
+
+/*!
+ * ԃXebvdtňʒuƑx1XV(ߖTTCÓCxS̔CxEʒuXV)
+ *  - KIԃXebv̂Ƃ́CcalTimeStep̂߂ɊÓESɂxm_vAccɎc
+ * @param[in] dt ԃXebv
+ * @param[out] dens_var Ō̔ł̕ϖxϓ
+ * @return 
+ */
+int rxPBDSPH::updateStep(RXREAL dt, RXREAL &dens_var)
+{
 	RXREAL h = m_fEffectiveRadius;
-	static bool init = true;
 
 	// ߖTqTpZɗqi[
-	SetParticlesToCell();
+	//  - XLݒ肳Ăh+skinŒTCȍ~̔Ŏg
+	updateNeighborList(m_hPos, h, true);
 
 	// xvZ
 	calDensity(m_hPos, m_hDens, h);
 
 	// O͍,Sɂ͏̌vZ
 	calForceExtAndVisc(m_hPos, m_hVel, m_hDens, m_hFrc, h);
+	if(m_bAdaptiveDt){
+		// ɗ͂̔z0ŏ̂ŁCcalTimeSteppɎcĂ
+		m_vAcc.assign(m_hFrc, m_hFrc+DIM*m_uNumParticles);
+	}
 
 	// \ʒuCx̌vZ
 	integrate(m_hPos, m_hVel, m_hDens, m_hFrc, m_hPredictPos, m_hPredictVel, dt);
@@ -356,10 +550,10 @@ bool rxPBDSPH::Update(RXREAL dt, int step)
 
 	// 
 	int iter = 0;	// 
-	RXREAL dens_var = 1.0;	// x̕U
+	dens_var = 1.0;
 	while(((dens_var > m_fEta) || (iter < m_iMinIterations)) && (iter < m_iMaxIterations)){
-		// ߖTqTpZɗqi[
-		SetParticlesToCell(m_hPredictPos, m_uNumParticles, m_fKernelRadius);
+		// ߖTqTpZɗqi[(\ʒüړʂXL1/2ȓȂŐߖTXgg)
+		updateNeighborList(m_hPredictPos, m_fKernelRadius, false);
 
 		// SCƃXP[Ot@N^švZ
 		calScalingFactor(m_hPredictPos, m_hDens, m_hS, h, dt);
@@ -368,7 +562,8 @@ bool rxPBDSPH::Update(RXREAL dt, int step)
 		calPositionCorrection(m_hPredictPos, m_hS, m_hDp, h, dt);	
 
 		// p[eBNʒuC
-		for(uint i = 0; i < m_uNumParticles; ++i){
+		#pragma omp parallel for
+		for(int i = 0; i < (int)m_uNumParticles; ++i){
 			for(int k = 0; k < DIM; ++k){
 				m_hPredictPos[DIM*i+k] += m_hDp[DIM*i+k];
 				m_hPredictVel[DIM*i+k] = 0.0; // integrateŏՓˏɂ邽߂0ŏ
@@ -380,24 +575,16 @@ bool rxPBDSPH::Update(RXREAL dt, int step)
 		integrate2(m_hPos, m_hVel, m_hDens, m_hFrc, m_hPredictPos, m_hPredictVel, dt);
 
 		// ϖxϓ̌vZ
-		dens_var = 0.0;
-		for(uint i = 0; i < m_uNumParticles; ++i){
-			RXREAL err = fabs(m_hDens[i]-m_fRestDens)/m_fRestDens;
-			//if(err > dens_var) dens_var = err;
-			dens_var += err;
-		}
-		dens_var /= (double)m_uNumParticles;
+		dens_var = calDensityFluctuation(m_hDens, m_fRestDens);
 
 		if(dens_var <= m_fEta && iter > m_iMinIterations) break;
 
 		iter++;
 	}
 
-	g_iIterations = iter;
-	g_fEta = dens_var;
-
 	// xEʒuXV
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		for(int k = 0; k < DIM; ++k){
 			int idx = DIM*i+k;
 			m_hVel[idx] = (m_hPredictPos[idx]-m_hPos[idx])/dt;
@@ -407,15 +594,7 @@ bool rxPBDSPH::Update(RXREAL dt, int step)
 
 	RXTIMER("update position");
 
-
-	SetArrayVBO(RX_POSITION, m_hPos, 0, m_uNumParticles);
-
-	SetColorVBO(m_iColorType, -1);
-
-	RXTIMER("color(vbo)");
-
-	init = false;
-	return true;
+	return iter;
 }
 
 /*!
@@ -435,12 +614,16 @@ RXREAL* rxPBDSPH::GetParticleDevice(void)
 {
 	if(!m_uNumParticles) return 0;
 
+#ifndef RX_HEADLESS
 	RXREAL *dPos = 0;
 	CuAllocateArray((void**)&dPos, m_uNumParticles*4*sizeof(RXREAL));
 
 	CuCopyArrayToDevice(dPos, m_hPos, 0, m_uNumParticles*4*sizeof(RXREAL));
 
 	return dPos;
+#else
+	return 0;
+#endif
 }
 
 
@@ -450,6 +633,7 @@ RXREAL* rxPBDSPH::GetParticleDevice(void)
  */
 void rxPBDSPH::SetColorVBO(int type, int picked)
 {
+#ifndef RX_HEADLESS
 	switch(type){
 	case RX_DENSITY:
 		SetColorVBOFromArray(m_hDens, 1, false, m_fRestDens);
@@ -479,7 +663,7 @@ void rxPBDSPH::SetColorVBO(int type, int picked)
 			RXREAL *data = (RXREAL*)glMapBufferARB(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
 			RXREAL *ptr = data;
 			for(uint i = 0; i < m_uNumParticles; ++i){
-				RXREAL t = i/(RXREAL)m_uNumParticles;
+				RXREAL t = GetParticleId(i)/(RXREAL)m_uNumParticles;	// ёւĂFςȂ悤ɊOIDg
 #if 0
 				*ptr++ = rand()/(RXREAL)RAND_MAX;
 				*ptr++ = rand()/(RXREAL)RAND_MAX;
@@ -497,7 +681,7 @@ void rxPBDSPH::SetColorVBO(int type, int picked)
 	default:
 		break;
 	}
-
+#endif
 }
 
 
@@ -510,7 +694,9 @@ void rxPBDSPH::SetColorVBO(int type, int picked)
  */
 void rxPBDSPH::calDensity(const RXREAL *ppos, RXREAL *pdens, RXREAL h)
 {
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	RXPROF_ZONE("density");
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 pos0;
 		pos0[0] = ppos[DIM*i+0];
 		pos0[1] = ppos[DIM*i+1];
@@ -519,7 +705,7 @@ void rxPBDSPH::calDensity(const RXREAL *ppos, RXREAL *pdens, RXREAL h)
 		pdens[i] = 0.0;
 
 		// ߖTq疧xvZ
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0) continue;
 
@@ -569,16 +755,17 @@ void rxPBDSPH::calDensity(const RXREAL *ppos, RXREAL *pdens, RXREAL h)
  */
 void rxPBDSPH::calForceExtAndVisc(const RXREAL *ppos, const RXREAL *pvel, const RXREAL *pdens, RXREAL *pfrc, RXREAL h)
 {
-	Vec3 rij, vji;
-	RXREAL r0 = m_fRestDens;
-	
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	RXPROF_ZONE("force");
+
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
+		Vec3 rij, vji;
 		Vec3 pos0, vel0;
 		pos0 = Vec3(ppos[4*i+0], ppos[4*i+1], ppos[4*i+2]);
 		vel0 = Vec3(pvel[4*i+0], pvel[4*i+1], pvel[4*i+2]);
 
 		Vec3 Fev(0.0);
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0 || i == j) continue;
 
@@ -618,123 +805,82 @@ void rxPBDSPH::calForceExtAndVisc(const RXREAL *ppos, const RXREAL *pvel, const
  */
 void rxPBDSPH::calScalingFactor(const RXREAL *ppos, RXREAL *pdens, RXREAL *pscl, RXREAL h, RXREAL dt)
 {
+	RXPROF_ZONE("scaling factor");
 	RXREAL r0 = m_fRestDens;
+	RXREAL aw = (RXREAL)m_fAw, ag = (RXREAL)m_fAg;
+	RXREAL rpad = 3.0*h;
 
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 pos0;
 		pos0[0] = ppos[DIM*i+0];
 		pos0[1] = ppos[DIM*i+1];
 		pos0[2] = ppos[DIM*i+2];
 
-		pdens[i] = 0.0;
-
-		// ߖTq疧xvZ
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
-			int j = itr->Idx;
-			if(j < 0) continue;
-
-			Vec3 pos1;
-			pos1[0] = ppos[DIM*j+0];
-			pos1[1] = ppos[DIM*j+1];
-			pos1[2] = ppos[DIM*j+2];
-
-			Vec3 rij = pos0-pos1;
-			RXREAL r = norm(rij);
+		rxNeighBlock b;
+		RXREAL w[RX_KERNEL_BATCH], gx[RX_KERNEL_BATCH], gy[RX_KERNEL_BATCH], gz[RX_KERNEL_BATCH];
 
-			// Poly6J[lŖxvZ (rho =  m Wij)
-			pdens[i] += m_fMass*m_fpW(r, h, m_fAw);
+		// ߖTq疧xƃXP[Ot@N^̕ꍀvZ
+		//  - z͋ߖTqƂ1񂾂vZCk == i̍((8))͂̑a狁߂
+		RXREAL dens = 0.0;
+		RXREAL sd = 0.0;
+		Vec3 dpi(0.0);
+		bool self = false;
+		const rxNeigh *itr = m_vNeighs.Begin(i), *end = m_vNeighs.End(i);
+		while(RxGatherNeighbors(ppos, pos0, itr, end, b, rpad)){
+			RxKernelW::W<RXREAL, RX_KERNEL_BATCH>(b.r, h, aw, w);
+			RxKernelGW::GW<RXREAL, RX_KERNEL_BATCH>(b, h, ag, gx, gy, gz);
+
+			for(int l = 0; l < b.n; ++l){
+				// Poly6J[lŖxvZ (rho =  m Wij)
+				dens += m_fMass*w[l];
+
+				Vec3 g(gx[l]/r0, gy[l]/r0, gz[l]/r0);
+				dpi += g;
+				if(b.idx[l] == i){
+					self = true;
+				}
+				else{
+					sd += norm2(g);	// k != i : |-Wik/0|^2
+				}
+			}
 		}
+		if(self) sd += norm2(dpi);	// k == i : |Wij/0|^2
 
 		// ߖTEqT
 		vector<rxNeigh> neigh;
 		GetNearestNeighborsB(pos0, neigh, h);
+		const rxNeigh *bbegin = (neigh.empty() ? 0 : &neigh[0]), *bend = bbegin+neigh.size();
 
-		// Eq̖xւ̉evZ([Akinci et al.,SIG2012]̎(6)̉Eӑ)
+		// Eq̖xƃXP[Ot@N^ւ̉evZ([Akinci et al.,SIG2012]̎(6)̉Eӑ)
+		//  - ̂̏ꍇƈċẺz̐ςƏx畡wEqꍇ̉zʃ=0*Vb߂Ďg 
+		//  - zʃ=0*VbƗ̎ʂ̔ŒPwȂEq̉e𐧌
 		RXREAL brho = 0.0;
-		for(vector<rxNeigh>::iterator itr = neigh.begin() ; itr != neigh.end(); ++itr){
-			int j = itr->Idx;
-			if(j < 0) continue;
+		itr = bbegin;
+		while(RxGatherNeighbors(m_hPosB, pos0, itr, bend, b, rpad)){
+			RxKernelW::W<RXREAL, RX_KERNEL_BATCH>(b.r, h, aw, w);
+			RxKernelGW::GW<RXREAL, RX_KERNEL_BATCH>(b, h, ag, gx, gy, gz);
 
-			Vec3 pos1;
-			pos1[0] = m_hPosB[DIM*j+0];
-			pos1[1] = m_hPosB[DIM*j+1];
-			pos1[2] = m_hPosB[DIM*j+2];
+			for(int l = 0; l < b.n; ++l){
+				int j = b.idx[l];
+				brho += m_fRestDens*m_hVolB[j]*w[l];
 
-			RXREAL r = norm(pos1-pos0);
-
-			// ̂̏ꍇƈċẺz̐ςƏx畡wEqꍇ̉zʃ=0*Vb߂Ďg 
-			brho += m_fRestDens*m_hVolB[j]*m_fpW(r, h, m_fAw);
+				RXREAL c = (m_fRestDens*m_hVolB[j]/m_fMass)/r0;
+				sd += norm2(Vec3(c*gx[l], c*gy[l], c*gz[l]));
+			}
 		}
-		pdens[i] += brho;
+		pdens[i] = dens+brho;
 
 		// xS((1))
 		RXREAL C = pdens[i]/r0-1;
 
-		// XP[Ot@N^̕ꍀvZ
-		RXREAL sd = 0.0;
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
-			int k = itr->Idx;
-			if(k < 0) continue;
-
-			Vec3 pos1;
-			pos1[0] = ppos[DIM*k+0];
-			pos1[1] = ppos[DIM*k+1];
-			pos1[2] = ppos[DIM*k+2];
-
-			Vec3 rik = pos0-pos1;
-			RXREAL r = norm(rik);
-			
-			// k == i Ƃ̑ŏ𕪂((8))
-			Vec3 dp(0.0);
-			if(k == i){
-				for(vector<rxNeigh>::iterator jtr = m_vNeighs[k].begin() ; jtr != m_vNeighs[k].end(); ++jtr){
-					int j = jtr->Idx;
-					if(j < 0) continue;
-
-					Vec3 pos2;
-					pos2[0] = ppos[DIM*j+0];
-					pos2[1] = ppos[DIM*j+1];
-					pos2[2] = ppos[DIM*j+2];
-
-					Vec3 rij = pos0-pos2;
-					RXREAL ri = norm(rij);
-
-					dp += m_fpGW(ri, h, m_fAg, rij)/r0;
-				}
-			}
-			else{
-				dp = -m_fpGW(r, h, m_fAg, rik)/r0;
-			}
-
-			sd += norm2(dp);
-		}
-
-		// Eq̃XP[Ot@N^ւ̉e
-		Vec3 dpb(0.0);
-		for(vector<rxNeigh>::iterator itr = neigh.begin() ; itr != neigh.end(); ++itr){
-			int j = itr->Idx;
-			if(j < 0) continue;
-
-			Vec3 pos1;
-			pos1[0] = m_hPosB[DIM*j+0];
-			pos1[1] = m_hPosB[DIM*j+1];
-			pos1[2] = m_hPosB[DIM*j+2];
-
-			Vec3 rij = pos0-pos1;
-			RXREAL r = norm(rij);
-
-			// zʃ=0*VbƗ̎ʂ̔ŒPwȂEq̉e𐧌
-			dpb = (m_fRestDens*m_hVolB[j]/m_fMass)*m_fpGW(r, h, m_fAg, rij)/r0;
-
-			sd += norm2(dpb);
-		}
-
 		// XP[Ot@N^̌vZ((11))
 		pscl[i] = -C/(sd+m_fEpsilon);
 	}
 
 	// Eq̃XP[Ot@N^[(̗q̕ψʗʂvZƂɎg)
-	for(uint i = 0; i < m_uNumBParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumBParticles; ++i){
 		Vec3 pos0;
 		pos0[0] = m_hPosB[DIM*i+0];
 		pos0[1] = m_hPosB[DIM*i+1];
@@ -816,7 +962,7 @@ void rxPBDSPH::calScalingFactor(const RXREAL *ppos, RXREAL *pdens, RXREAL *pscl,
 			// k == i Ƃ̑ŏ𕪂((8))
 			Vec3 dp(0.0);
 			if(k == i){
-				for(vector<rxNeigh>::iterator jtr = m_vNeighsB[k].begin() ; jtr != m_vNeighsB[k].end(); ++jtr){
+				for(rxNeigh *jtr = m_vNeighsB.Begin(k); jtr != m_vNeighsB.End(k); ++jtr){
 					int j = jtr->Idx;
 					if(j < 0) continue;
 
@@ -854,6 +1000,7 @@ void rxPBDSPH::calScalingFactor(const RXREAL *ppos, RXREAL *pdens, RXREAL *pscl,
  */
 void rxPBDSPH::calPositionCorrection(const RXREAL *ppos, const RXREAL *pscl, RXREAL *pdp, RXREAL h, RXREAL dt)
 {
+	RXPROF_ZONE("position correction");
 	RXREAL r0 = m_fRestDens;
 
 	// lH͗pp[^
@@ -861,8 +1008,11 @@ void rxPBDSPH::calPositionCorrection(const RXREAL *ppos, const RXREAL *pscl, RXR
 	RXREAL n = m_fApN;
 	RXREAL dq = m_fApQ*h;
 	RXREAL wq = m_fpW(dq, h, m_fAw);
+	RXREAL aw = (RXREAL)m_fAw, ag = (RXREAL)m_fAg;
+	RXREAL rpad = 3.0*h;
 
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 pos0;
 		pos0[0] = ppos[DIM*i+0];
 		pos0[1] = ppos[DIM*i+1];
@@ -872,72 +1022,63 @@ void rxPBDSPH::calPositionCorrection(const RXREAL *ppos, const RXREAL *pscl, RXR
 		pdp[DIM*i+1] = 0.0;
 		pdp[DIM*i+2] = 0.0;
 
+		rxNeighBlock b;
+		RXREAL w[RX_KERNEL_BATCH], gx[RX_KERNEL_BATCH], gy[RX_KERNEL_BATCH], gz[RX_KERNEL_BATCH];
+
 		// ߖTqʒuCʂvZ
+		//  - e͈͊O(r > h)̗vf̓J[llCzƂ0ɂȂ̂ŏꍇȂ
 		Vec3 dpij(0.0);
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
-			int j = itr->Idx;
-			if(j < 0) continue;
-
-			Vec3 pos1;
-			pos1[0] = ppos[DIM*j+0];
-			pos1[1] = ppos[DIM*j+1];
-			pos1[2] = ppos[DIM*j+2];
-
-			Vec3 rij = pos0-pos1;
-			RXREAL r = norm(rij);
-			
-			if(r > h) continue;
-
-			RXREAL scorr = 0.0;
-
-			if(m_bArtificialPressure){
-				// NX^Oh߂̃XP[Ot@N^
-				RXREAL ww = m_fpW(r, h, m_fAw)/wq;
+		const rxNeigh *itr = m_vNeighs.Begin(i), *end = m_vNeighs.End(i);
+		while(RxGatherNeighbors(ppos, pos0, itr, end, b, rpad)){
+			if(m_bArtificialPressure) RxKernelW::W<RXREAL, RX_KERNEL_BATCH>(b.r, h, aw, w);
+			RxKernelGW::GW<RXREAL, RX_KERNEL_BATCH>(b, h, ag, gx, gy, gz);
+
+			for(int l = 0; l < b.n; ++l){
+				int j = b.idx[l];
+
+				RXREAL scorr = 0.0;
+				if(m_bArtificialPressure){
+					// NX^Oh߂̃XP[Ot@N^
+					RXREAL ww = w[l]/wq;
+
+					// [Macklin&Muller2003]dt*dt͂ȂC
+					// [Monaghan2000]ɂ悤k*(ww/wq)^n͉x[m/s^2]ƂȂ̂ŁC
+					// Wl[m]ɂ邽߂dt^2|Ă
+					scorr = -k*pow(ww, n)*dt*dt; 
+				}
 
-				// [Macklin&Muller2003]dt*dt͂ȂC
-				// [Monaghan2000]ɂ悤k*(ww/wq)^n͉x[m/s^2]ƂȂ̂ŁC
-				// Wl[m]ɂ邽߂dt^2|Ă
-				scorr = -k*pow(ww, n)*dt*dt; 
+				// SpikyJ[lňʒuCʂvZ
+				RXREAL c = (pscl[i]+pscl[j]+scorr)/r0;
+				dpij += Vec3(c*gx[l], c*gy[l], c*gz[l]);
 			}
-
-			// SpikyJ[lňʒuCʂvZ
-			dpij += (pscl[i]+pscl[j]+scorr)*m_fpGW(r, h, m_fAg, rij)/r0;
 		}
 
 		// Ep[eBN̉eɂʒuC
 		// ߖTqT
 		vector<rxNeigh> bneigh;
 		GetNearestNeighborsB(pos0, bneigh, h);
+		const rxNeigh *bbegin = (bneigh.empty() ? 0 : &bneigh[0]), *bend = bbegin+bneigh.size();
 
 		Vec3 dpbij(0.0);
-		for(vector<rxNeigh>::iterator itr = bneigh.begin() ; itr != bneigh.end(); ++itr){
-			int j = itr->Idx;
-			if(j < 0) continue;
-
-			Vec3 pos1;
-			pos1[0] = m_hPosB[DIM*j+0];
-			pos1[1] = m_hPosB[DIM*j+1];
-			pos1[2] = m_hPosB[DIM*j+2];
-
-			Vec3 rij = pos0-pos1;
-			RXREAL r = norm(rij);
-
-			if(r > h) continue;
-
-			RXREAL scorr = 0.0;
-
-			if(m_bArtificialPressure){
-				// NX^Oh߂̃XP[Ot@N^
-				RXREAL ww = (m_fRestDens*m_hVolB[j]/m_fMass)*m_fpW(r, h, m_fAw)/wq;
+		itr = bbegin;
+		while(RxGatherNeighbors(m_hPosB, pos0, itr, bend, b, rpad)){
+			if(m_bArtificialPressure) RxKernelW::W<RXREAL, RX_KERNEL_BATCH>(b.r, h, aw, w);
+			RxKernelGW::GW<RXREAL, RX_KERNEL_BATCH>(b, h, ag, gx, gy, gz);
+
+			for(int l = 0; l < b.n; ++l){
+				int j = b.idx[l];
+
+				RXREAL scorr = 0.0;
+				if(m_bArtificialPressure){
+					// NX^Oh߂̃XP[Ot@N^
+					RXREAL ww = (m_fRestDens*m_hVolB[j]/m_fMass)*w[l]/wq;
+					scorr = -k*pow(ww, n)*dt*dt; 
+				}
 
-				// [Macklin&Muller2003]dt*dt͂ȂC
-				// [Monaghan2000]ɂ悤k*(ww/wq)^n͉x[m/s^2]ƂȂ̂ŁC
-				// Wl[m]ɂ邽߂dt^2|Ă
-				scorr = -k*pow(ww, n)*dt*dt; 
+				// SpikyJ[lňʒuCʂvZ
+				RXREAL c = (pscl[i]+m_hSb[j]+scorr)/r0;
+				dpbij += Vec3(c*gx[l], c*gy[l], c*gz[l]);
 			}
-
-			// SpikyJ[lňʒuCʂvZ
-			dpbij += (pscl[i]+m_hSb[j]+scorr)*m_fpGW(r, h, m_fAg, rij)/r0;
 		}
 
 		dpij += dpbij;
@@ -983,20 +1124,18 @@ RXREAL rxPBDSPH::calRestDensity(RXREAL h)
  */
 void rxPBDSPH::calBoundaryVolumes(const RXREAL *bpos, RXREAL *bvol, RXREAL mass, uint n, RXREAL h)
 {
-	m_vNeighsB.resize(n);
-	for(uint i = 0; i < n; ++i){
+	// ߖTq
+	m_pNNGridB->GetNNList((RXREAL*)bpos, n, m_vNeighsB, h);
+
+	#pragma omp parallel for
+	for(int i = 0; i < (int)n; ++i){
 		Vec3 pos0;
 		pos0[0] = bpos[DIM*i+0];
 		pos0[1] = bpos[DIM*i+1];
 		pos0[2] = bpos[DIM*i+2];
 
-		// ߖTq
-		vector<rxNeigh> neigh;
-		GetNearestNeighborsB(pos0, neigh, h);
-		m_vNeighsB[i] = neigh;
-
 		RXREAL mw = 0.0;
-		for(vector<rxNeigh>::iterator itr = neigh.begin() ; itr != neigh.end(); ++itr){
+		for(rxNeigh *itr = m_vNeighsB.Begin(i); itr != m_vNeighsB.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0) continue;
 
@@ -1014,61 +1153,711 @@ void rxPBDSPH::calBoundaryVolumes(const RXREAL *bpos, RXREAL *bvol, RXREAL mass,
 	}
 }
 
+/*!
+ * ő̏Q̋Ep[eBN
+ *  - IsSolidParticles()truěő̂̕\ʂɃp[eBNzuCV~[VԂ̋Ep[eBŇɒǉ
+ *  - ő̃[JWۑĂCő̂ړƂ͍̕ϊňʒuXV(updateBoundaryParticles)
+ */
+void rxPBDSPH::InitBoundary(void)
+{
+	// ς݂̌ő
+	vector<int> done(m_vSolids.size(), 0);
+	for(int k = 0; k < (int)m_vBoundarySets.size(); ++k){
+		done[m_vBoundarySets[k].solid] = 1;
+	}
+
+	// ő̂ƂɋEp[eBN
+	vector<RXREAL*> posb;
+	vector<rxBoundarySet> sets;
+	uint nadd = 0;
+	for(int i = 0; i < (int)m_vSolids.size(); ++i){
+		rxSolid *s = m_vSolids[i];
+		if(done[i] || !(s->IsSolidParticles())) continue;
+
+		RXREAL *p = 0;
+		int n = s->GenerateParticlesOnSurf(0.75*m_fParticleRadius, &p);
+		if(n <= 0){
+			if(p) delete [] p;
+			continue;
+		}
+
+		rxBoundarySet bs;
+		bs.solid = i;
+		bs.start = m_uNumBParticles+nadd;
+		bs.num = n;
+		bs.cen = s->GetPosition();
+		bs.mat = s->GetMatrix();
+		bs.local.resize(3*n);
+		for(int j = 0; j < n; ++j){
+			Vec3 lp = s->CalLocalCoord(Vec3(p[DIM*j+0], p[DIM*j+1], p[DIM*j+2]));
+			bs.local[3*j+0] = lp[0];
+			bs.local[3*j+1] = lp[1];
+			bs.local[3*j+2] = lp[2];
+		}
+
+		sets.push_back(bs);
+		posb.push_back(p);
+		nadd += n;
+	}
+	if(!nadd) return;
+
+	// Ep[eBNžɒǉ
+	uint n0 = m_uNumBParticles;
+	uint nb = n0+nadd;
+	RXREAL *pos = new RXREAL[DIM*nb];
+	if(n0) memcpy(pos, m_hPosB, sizeof(RXREAL)*DIM*n0);
+	m_vBSet.resize(nb, -1);
+	for(int k = 0; k < (int)sets.size(); ++k){
+		rxBoundarySet &bs = sets[k];
+		memcpy(pos+DIM*bs.start, posb[k], sizeof(RXREAL)*DIM*bs.num);
+		for(uint j = bs.start; j < bs.start+bs.num; ++j){
+			m_vBSet[j] = (int)m_vBoundarySets.size();
+		}
+		m_vBoundarySets.push_back(bs);
+		delete [] posb[k];
+	}
+	if(m_hPosB) delete [] m_hPosB;
+	m_hPosB = pos;
+	m_uNumBParticles = nb;
+	for(int k = 0; k < (int)m_vBoundarySets.size(); ++k){
+		calBoundarySetBounds(m_vBoundarySets[k], m_vBoundarySets[k].minp, m_vBoundarySets[k].maxp);
+	}
+
+	RXCOUT << nadd << " boundary particles are added for " << sets.size() << " obstacles." << endl;
+
+	// Zɗqo^
+	Vec3 minp = m_pBoundary->GetMin()-Vec3(4.0*m_fParticleRadius);
+	Vec3 maxp = m_pBoundary->GetMax()+Vec3(4.0*m_fParticleRadius);
+	m_pNNGridB->Setup(minp, maxp, m_fEffectiveRadius, m_uNumBParticles);
+	m_pNNGridB->SetObjectToCell(m_hPosB, m_uNumBParticles);
+
+	// Ep[eBN̑̐(ŜvẐ͂)
+	if(m_hVolB) delete [] m_hVolB;
+	m_hVolB = new RXREAL[m_uNumBParticles];
+	memset(m_hVolB, 0, sizeof(RXREAL)*m_uNumBParticles);
+	calBoundaryVolumes(m_hPosB, m_hVolB, m_fMass, m_uNumBParticles, m_fEffectiveRadius);
+
+	if(m_hSb) delete [] m_hSb;
+	m_hSb = new RXREAL[m_uNumBParticles];
+	memset(m_hSb, 0, sizeof(RXREAL)*m_uNumBParticles);
+
+	// ̑g̋Ep[eBNߖTɂ邩ǂ
+	m_vBMoved.assign(m_uNumBParticles, 0);
+	m_vBNear.assign(m_uNumBParticles, 0);
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumBParticles; ++i){
+		for(rxNeigh *itr = m_vNeighsB.Begin(i); itr != m_vNeighsB.End(i); ++itr){
+			int j = itr->Idx;
+			if(j >= 0 && m_vBSet[j] != m_vBSet[i]){
+				m_vBNear[i] = 1;
+				break;
+			}
+		}
+	}
+}
+
+/*!
+ * ő̏Q̍̉^
+ *  - ŒtOfalsěő̂𑬓xňړ
+ *  - x|SQsړ(SetPolygonObstacleMatrix)
+ * @param[in] dt ԃXebv
+ */
+void rxPBDSPH::updateSolids(RXREAL dt)
+{
+	for(int i = 0; i < (int)m_vSolids.size(); ++i){
+		if(!m_vSolids[i]->GetFix()){
+			m_vSolids[i]->RigidSimulation(dt);
+		}
+	}
+
+	// x|SQ𕽍sړ(ړQ̃|SZɊi[)
+	for(int i = 0; i < (int)m_vPolyObstacles.size(); ++i){
+		const rxPolygonObstacle &obj = m_vPolyObstacles[i];
+		if(RXFunc::IsZeroVec(obj.vel)) continue;
+
+		rxMatrix4 mat = obj.mat;
+		mat.SetTranslate(Vec3(mat(0, 3), mat(1, 3), mat(2, 3))+obj.vel*dt);
+		SetPolygonObstacleMatrix(i, mat);
+	}
+}
+
+/*!
+ * ő̏Q̈ʒuƎp̐ݒ
+ *  - Ep[eBNő̂ȂCUpdateŋEp[eBNړ
+ * @param[in] i ő̏Q̃CfbNX
+ * @param[in] pos dSW
+ * @param[in] mat ps
+ */
+bool rxPBDSPH::SetSolidTransform(int i, const Vec3 &pos, const rxMatrix4 &mat)
+{
+	if(i < 0 || i >= (int)m_vSolids.size()) return false;
+	m_vSolids[i]->SetPosition(pos);
+	m_vSolids[i]->SetMatrix(mat);
+	return true;
+}
+
+/*!
+ * ړő̂̋Ep[eBN̍XV
+ *  - Ep[eBN̈ʒu͌ő̃[JW̍̕ϊŋ߁C\ʃTvO͂Ȃ
+ *  - Z͈ړp[eBNi[(rxNNGrid::UpdateObjectToCell)
+ *  - g̋Ep[eBNm̑Έʒu͕ςȂ̂ŁC̐ςvẐ
+ *    ̑g̋Ep[eBNߖTɂ()p[eBN
+ * @return ړEp[eBN̑g̐
+ */
+int rxPBDSPH::updateBoundaryParticles(void)
+{
+	RXPROF_ZONE("boundary particles");
+	m_iNumBVolUpdates = 0;
+	if(m_vBoundarySets.empty()) return 0;
+
+	RXREAL h = m_fEffectiveRadius;
+
+	// ړg̋Ep[eBNʒu̕ϊōXV
+	vector<int> moved;
+	vector<unsigned char> moved_set(m_vBoundarySets.size(), 0);
+	vector<Vec3> mmin, mmax;	// ړŐEp[eBN܂ޔ͈
+	for(int k = 0; k < (int)m_vBoundarySets.size(); ++k){
+		rxBoundarySet &bs = m_vBoundarySets[k];
+		rxSolid *s = m_vSolids[bs.solid];
+
+		Vec3 cen = s->GetPosition();
+		rxMatrix4 mat = s->GetMatrix();
+		bool changed = !(cen == bs.cen);
+		for(int l = 0; l < 9 && !changed; ++l){
+			changed = (mat(l/3, l%3) != bs.mat(l/3, l%3));
+		}
+		if(!changed) continue;
+
+		#pragma omp parallel for
+		for(int j = 0; j < (int)bs.num; ++j){
+			Vec3 p = s->CalGlobalCoord(Vec3(bs.local[3*j+0], bs.local[3*j+1], bs.local[3*j+2]));
+			uint i = bs.start+j;
+			m_hPosB[DIM*i+0] = p[0];
+			m_hPosB[DIM*i+1] = p[1];
+			m_hPosB[DIM*i+2] = p[2];
+			m_vBMoved[i] = 1;
+		}
+
+		Vec3 minp, maxp, umin, umax;
+		calBoundarySetBounds(bs, minp, maxp);
+		for(int l = 0; l < 3; ++l){
+			umin[l] = RX_MIN(minp[l], bs.minp[l])-h;
+			umax[l] = RX_MAX(maxp[l], bs.maxp[l])+h;
+		}
+		bs.cen = cen;
+		bs.mat = mat;
+		bs.minp = minp;
+		bs.maxp = maxp;
+
+		moved.push_back(k);
+		moved_set[k] = 1;
+		mmin.push_back(umin);
+		mmax.push_back(umax);
+	}
+	if(moved.empty()) return 0;
+
+	// ZɊi[
+	m_pNNGridB->UpdateObjectToCell(m_hPosB, m_uNumBParticles, &m_vBMoved[0]);
+
+	// ZƂ̋Ep[eBN̑g
+	const rxNNGrid::rxCell &cell = m_pNNGridB->GetCellData();
+	int nb = (int)m_uNumBParticles;
+	m_vBCellSet.assign(cell.uNumCells, -2);
+	for(int ip = 0; ip < nb; ++ip){
+		int &cs = m_vBCellSet[cell.hSortedIndex[ip].hash];
+		int bs = m_vBSet[cell.hSortedIndex[ip].value];
+		cs = (cs == -2 ? bs : (cs == bs ? cs : -3));
+	}
+
+	// ̐ςvZEp[eBN̑I
+	//  - ړ : O񑼂̑gߖTɂCߖTZɑ̑g̃p[eBN
+	//  - ړĂȂ : ړg̈ړO͈͓̔ŁCO񑼂̑gߖTɂCߖTZɈړg̃p[eBN
+	vector<unsigned char> upd(nb, 0);
+	#pragma omp parallel
+	{
+		vector<uint> cells;
+		#pragma omp for
+		for(int i = 0; i < nb; ++i){
+			Vec3 pos(m_hPosB[DIM*i+0], m_hPosB[DIM*i+1], m_hPosB[DIM*i+2]);
+			int si = m_vBSet[i];
+			bool mv = (m_vBMoved[i] != 0);
+			if(!mv){
+				bool inside = false;
+				for(int l = 0; l < (int)moved.size() && !inside; ++l){
+					inside = (pos[0] >= mmin[l][0] && pos[0] <= mmax[l][0] && 
+							  pos[1] >= mmin[l][1] && pos[1] <= mmax[l][1] && 
+							  pos[2] >= mmin[l][2] && pos[2] <= mmax[l][2]);
+				}
+				if(!inside) continue;
+			}
+			if(m_vBNear[i]){
+				upd[i] = 1;
+				continue;
+			}
+
+			cells.clear();
+			m_pNNGridB->GetNeighborCells(pos, h, cells);
+			for(vector<uint>::iterator itr = cells.begin(); itr != cells.end(); ++itr){
+				int cs = m_vBCellSet[*itr];
+				if(cs == -2 || cs == si) continue;
+				if(mv || cs == -3 || (cs >= 0 && moved_set[cs])){
+					upd[i] = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	vector<int> idx;
+	for(int i = 0; i < nb; ++i){
+		if(upd[i]) idx.push_back(i);
+		m_vBMoved[i] = 0;
+	}
+	updateBoundaryVolumes(idx, h);
+	m_iNumBVolUpdates = (int)idx.size();
+
+	return (int)moved.size();
+}
+
+/*!
+ * w肵Ep[eBN̑̐ςƋߖTtO̍XV
+ *  - ̐ς̌vZcalBoundaryVolumesƓ(ߖT̉Z)
+ * @param[in] idx Ep[eBÑCfbNX
+ * @param[in] h La
+ */
+void rxPBDSPH::updateBoundaryVolumes(const vector<int> &idx, RXREAL h)
+{
+	int n = (int)idx.size();
+	#pragma omp parallel
+	{
+		vector<rxNeigh> neighs;
+		#pragma omp for
+		for(int l = 0; l < n; ++l){
+			int i = idx[l];
+			Vec3 pos0;
+			pos0[0] = m_hPosB[DIM*i+0];
+			pos0[1] = m_hPosB[DIM*i+1];
+			pos0[2] = m_hPosB[DIM*i+2];
+
+			neighs.clear();
+			m_pNNGridB->GetNN(pos0, m_hPosB, m_uNumBParticles, neighs, h);
+
+			RXREAL mw = 0.0;
+			unsigned char nflg = 0;
+			for(vector<rxNeigh>::iterator itr = neighs.begin(); itr != neighs.end(); ++itr){
+				int j = itr->Idx;
+				if(j < 0) continue;
+
+				Vec3 pos1;
+				pos1[0] = m_hPosB[DIM*j+0];
+				pos1[1] = m_hPosB[DIM*j+1];
+				pos1[2] = m_hPosB[DIM*j+2];
+
+				RXREAL r = norm(pos1-pos0);
+
+				mw += m_fMass*m_fpW(r, h, m_fAw);
+				if(m_vBSet[j] != m_vBSet[i]) nflg = 1;
+			}
+
+			m_hVolB[i] = m_fMass/mw;
+			m_vBNear[i] = nflg;
+		}
+	}
+}
+
+/*!
+ * Ep[eBN̑gAABB
+ * @param[in] bs Ep[eBN̑g
+ * @param[out] minp,maxp AABB
+ */
+void rxPBDSPH::calBoundarySetBounds(const rxBoundarySet &bs, Vec3 &minp, Vec3 &maxp)
+{
+	minp = Vec3(RX_FEQ_INF);
+	maxp = Vec3(-RX_FEQ_INF);
+	for(uint i = bs.start; i < bs.start+bs.num; ++i){
+		for(int l = 0; l < 3; ++l){
+			minp[l] = RX_MIN(minp[l], (double)m_hPosB[DIM*i+l]);
+			maxp[l] = RX_MAX(maxp[l], (double)m_hPosB[DIM*i+l]);
+		}
+	}
+}
+
+/*!
+ * ϖxϓ̌vZ
+ *  - ŒTCỸubNƂɕaɌvZCubNɑ킹
+ *  - ZXbhɈˑȂ̂ŁCʂ͏ɓɂȂ
+ * @param[in] pdens p[eBNx
+ * @param[in] r0 x
+ * @return ϖxϓ (|i-0|/0)/n
+ */
+RXREAL rxPBDSPH::calDensityFluctuation(const RXREAL *pdens, RXREAL r0)
+{
+	int n = (int)m_uNumParticles;
+	if(n == 0) return 0.0;
+
+	// ubNƂ̕a
+	int nb = (n+RX_REDUCTION_BLOCK-1)/RX_REDUCTION_BLOCK;
+	vector<double> bsum(nb, 0.0);
+
+	#pragma omp parallel for
+	for(int b = 0; b < nb; ++b){
+		int start = b*RX_REDUCTION_BLOCK;
+		int end = RX_MIN(start+RX_REDUCTION_BLOCK, n);
+
+		double s = 0.0;
+		for(int i = start; i < end; ++i){
+			s += fabs(pdens[i]-r0)/r0;
+		}
+		bsum[b] = s;
+	}
+
+	// aubNɍv
+	double dens_var = 0.0;
+	for(int b = 0; b < nb; ++b){
+		dens_var += bsum[b];
+	}
+
+	return (RXREAL)(dens_var/(double)n);
+}
+
+/*!
+ * ߖTXg̍XV
+ *  - XL0Ȃ疈Lahō蒼
+ *  - XLskinݒ肳Ăꍇh+skinŋߖTXgC쐬̍őړʂ
+ *    skin/2ȉ̊Ԃ͂g(VerletXg)
+ *  - g񂵂Xgɂhȏ㗣ꂽq܂܂邪CJ[llEz0ɂȂ̂Ōʂ͕ςȂ
+ * @param[in] prts p[eBNW
+ * @param[in] h La
+ * @param[in] force trueȂړʂɂ炸蒼
+ * @return ߖTXg蒼true
+ */
+bool rxPBDSPH::updateNeighborList(RXREAL *prts, RXREAL h, bool force)
+{
+	if(m_fNeighborSkin <= 0.0){
+		SetParticlesToCell(prts, m_uNumParticles, h);
+		m_iNeighborBuilds++;
+		return true;
+	}
+
+	if(!force && m_vNeighPos.size() == DIM*m_uNumParticles && 
+	   calMaxDisplacement(prts, &m_vNeighPos[0]) <= 0.5*m_fNeighborSkin){
+		return false;
+	}
+
+	SetParticlesToCell(prts, m_uNumParticles, h+m_fNeighborSkin);
+	m_vNeighPos.assign(prts, prts+DIM*m_uNumParticles);
+	m_iNeighborBuilds++;
+	return true;
+}
+
+/*!
+ * ߖTXg쐬̃p[eBN̍őړ
+ *  - ŒTCỸubNƂɍőlɋ߂(OpenMP2.0ɂmax_NVȂ)
+ * @param[in] ppos ݂̃p[eBNW
+ * @param[in] ppos0 ߖTXg쐬̃p[eBNW
+ * @return őړ
+ */
+RXREAL rxPBDSPH::calMaxDisplacement(const RXREAL *ppos, const RXREAL *ppos0)
+{
+	int n = (int)m_uNumParticles;
+	if(n == 0) return 0.0;
+
+	int nb = (n+RX_REDUCTION_BLOCK-1)/RX_REDUCTION_BLOCK;
+	vector<RXREAL> bmax(nb, 0.0);
+
+	#pragma omp parallel for
+	for(int b = 0; b < nb; ++b){
+		int start = b*RX_REDUCTION_BLOCK;
+		int end = RX_MIN(start+RX_REDUCTION_BLOCK, n);
+
+		RXREAL d2max = 0.0;
+		for(int i = start; i < end; ++i){
+			RXREAL dx = ppos[DIM*i+0]-ppos0[DIM*i+0];
+			RXREAL dy = ppos[DIM*i+1]-ppos0[DIM*i+1];
+			RXREAL dz = ppos[DIM*i+2]-ppos0[DIM*i+2];
+			RXREAL d2 = dx*dx+dy*dy+dz*dz;
+			if(d2 > d2max) d2max = d2;
+		}
+		bmax[b] = d2max;
+	}
+
+	RXREAL d2max = 0.0;
+	for(int b = 0; b < nb; ++b){
+		if(bmax[b] > d2max) d2max = bmax[b];
+	}
+
+	return sqrt(d2max);
+}
+
+/*!
+ * p[eBNz̕ёւ
+ *  - NẌʒuCxɉāĆCxCScaling factorCʒuCʁC\ʒuExёւ
+ *  - ߖTXg͎SetParticlesToCellō蒼̂łł͈Ȃ
+ * @param[in] perm ёւiԖڂɌperm[i]Ԗڂ̗vf
+ */
+void rxPBDSPH::permuteParticles(const vector<uint> &perm)
+{
+	rxParticleSystemBase::permuteParticles(perm);
+
+	permuteArray(m_hFrc, DIM, perm);
+	permuteArray(m_hDens, 1, perm);
+	permuteArray(m_hS, 1, perm);
+	permuteArray(m_hDp, DIM, perm);
+	permuteArray(m_hPredictPos, DIM, perm);
+	permuteArray(m_hPredictVel, DIM, perm);
+}
+
+/*!
+ * `FbN|Cgւ̃\oԂ̏
+ *  - ́CxCScaling factorCʒuCʁC\ʒuExCEp[eBNScaling factor
+ *    Q̈ʒuExEpC|SQ̕ϊsCKIԃXebṽTuXebvo
+ *    (`̓V[t@CĐݒ肳)
+ * @param[in] fout o̓t@CXg[
+ */
+bool rxPBDSPH::writeCheckpoint(ofstream &fout)
+{
+	size_t n = m_uNumParticles;
+	WriteBinaryArray(fout, m_hFrc, DIM*n);
+	WriteBinaryArray(fout, m_hDens, n);
+	WriteBinaryArray(fout, m_hS, n);
+	WriteBinaryArray(fout, m_hDp, DIM*n);
+	WriteBinaryArray(fout, m_hPredictPos, DIM*n);
+	WriteBinaryArray(fout, m_hPredictVel, DIM*n);
+
+	WriteBinary(fout, (int)(m_hSb ? 1 : 0));
+	if(m_hSb) WriteBinaryArray(fout, m_hSb, (size_t)m_uNumBParticles);
+
+	// ߖTTObh̃\[g(Z̕сC܂ߖT̉ZĊJɂ邽)
+	vector<uint> order;
+	m_pNNGrid->GetSortedOrder(order);
+	WriteBinary(fout, (uint)order.size());
+	WriteBinaryArray(fout, order.empty() ? (uint*)0 : &order[0], order.size());
+
+	// ő̏Q
+	WriteBinary(fout, (uint)m_vSolids.size());
+	for(int i = 0; i < (int)m_vSolids.size(); ++i){
+		rxSolid *s = m_vSolids[i];
+		rxMatrix4 rot = s->GetMatrix();
+		double mat[16];
+		for(int j = 0; j < 16; ++j) mat[j] = rot(j%4, j/4);	// SetMatrix(double[16])ƓD
+		WriteBinary(fout, s->Name());
+		WriteBinaryArray(fout, s->GetPosition().data, 3);
+		WriteBinaryArray(fout, s->GetVelocity().data, 3);
+		WriteBinaryArray(fout, mat, 16);
+		WriteBinary(fout, (int)(s->GetFix() ? 1 : 0));
+	}
+
+	// |SQ̕ϊs
+	WriteBinary(fout, (uint)m_vPolyObstacles.size());
+	for(int i = 0; i < (int)m_vPolyObstacles.size(); ++i){
+		double mat[16];
+		for(int j = 0; j < 16; ++j) mat[j] = m_vPolyObstacles[i].mat(j%4, j/4);
+		WriteBinaryArray(fout, mat, 16);
+	}
+
+	// KIԃXebṽTuXebv
+	WriteBinary(fout, m_fDtSub);
+
+	// ړE(Ep[eBNpObh̃\[gƋߖTtO)
+	WriteBinary(fout, (uint)m_vBoundarySets.size());
+	if(!m_vBoundarySets.empty()){
+		vector<uint> border;
+		m_pNNGridB->GetSortedOrder(border);
+		WriteBinary(fout, (uint)border.size());
+		WriteBinaryArray(fout, border.empty() ? (uint*)0 : &border[0], border.size());
+		WriteBinaryArray(fout, &m_vBNear[0], m_vBNear.size());
+	}
+
+	return (bool)fout;
+}
+
+/*!
+ * `FbN|Cg̃\oԂ̓ǂݍ
+ *  - Q̐Ǝނ݂͌̃V[ƈvĂKv
+ * @param[in] fin ̓t@CXg[
+ */
+bool rxPBDSPH::readCheckpoint(ifstream &fin)
+{
+	size_t n = m_uNumParticles;
+	ReadBinaryArray(fin, m_hFrc, DIM*n);
+	ReadBinaryArray(fin, m_hDens, n);
+	ReadBinaryArray(fin, m_hS, n);
+	ReadBinaryArray(fin, m_hDp, DIM*n);
+	ReadBinaryArray(fin, m_hPredictPos, DIM*n);
+	ReadBinaryArray(fin, m_hPredictVel, DIM*n);
+
+	// Ep[eBN(NXňʒuƑ̐ς͓ǂݍݍς)
+	if(m_hSb) delete [] m_hSb;
+	m_hSb = 0;
+	if(m_uNumBParticles){
+		m_hSb = new RXREAL[m_uNumBParticles];
+		memset(m_hSb, 0, sizeof(RXREAL)*m_uNumBParticles);
+	}
+	if(ReadBinary<int>(fin)){
+		ReadBinaryArray(fin, m_hSb, (size_t)m_uNumBParticles);
+	}
+	if(m_uNumBParticles){
+		Vec3 minp = m_pBoundary->GetMin()-Vec3(4.0*m_fParticleRadius);
+		Vec3 maxp = m_pBoundary->GetMax()+Vec3(4.0*m_fParticleRadius);
+		m_pNNGridB->Setup(minp, maxp, m_fEffectiveRadius, m_uNumBParticles);
+		m_pNNGridB->SetObjectToCell(m_hPosB, m_uNumBParticles);
+	}
+
+	// ߖTTObh̃\[g
+	vector<uint> order(ReadBinary<uint>(fin));
+	if(order.size() > m_uMaxParticles) return false;
+	ReadBinaryArray(fin, order.empty() ? (uint*)0 : &order[0], order.size());
+	m_pNNGrid->SetSortedOrder(order);
+
+	// ő̏Q
+	uint ns = ReadBinary<uint>(fin);
+	if(ns != (uint)m_vSolids.size()){
+		RXCOUT << "the number of obstacles (" << ns << ") is different from the current scene (" << m_vSolids.size() << ")." << endl;
+		return false;
+	}
+	for(int i = 0; i < (int)ns; ++i){
+		rxSolid *s = m_vSolids[i];
+		int name = ReadBinary<int>(fin);
+		if(name != s->Name()){
+			RXCOUT << "the type of obstacle " << i << " is different from the current scene." << endl;
+			return false;
+		}
+		Vec3 pos, vel;
+		double mat[16];
+		ReadBinaryArray(fin, pos.data, 3);
+		ReadBinaryArray(fin, vel.data, 3);
+		ReadBinaryArray(fin, mat, 16);
+		s->SetPosition(pos);
+		s->SetVelocity(vel);
+		s->SetMatrix(mat);
+		s->SetFix(ReadBinary<int>(fin) != 0);
+	}
+
+	// |SQ̕ϊs(ςĂ΃|S𕪊ZɊi[)
+	if(ReadBinary<uint>(fin) != (uint)m_vPolyObstacles.size()){
+		RXCOUT << "the number of polygon obstacles is different from the current scene." << endl;
+		return false;
+	}
+	for(int i = 0; i < (int)m_vPolyObstacles.size(); ++i){
+		double m[16];
+		ReadBinaryArray(fin, m, 16);
+		rxMatrix4 mat;
+		for(int j = 0; j < 16; ++j) mat(j%4, j/4) = m[j];
+		SetPolygonObstacleMatrix(i, mat);
+	}
+
+	// KIԃXebṽTuXebv
+	m_fDtSub = ReadBinary<RXREAL>(fin);
+
+	// ړE
+	if(ReadBinary<uint>(fin) != (uint)m_vBoundarySets.size()){
+		RXCOUT << "the number of obstacles with boundary particles is different from the current scene." << endl;
+		return false;
+	}
+	if(!m_vBoundarySets.empty()){
+		if(m_vBSet.size() != m_uNumBParticles) return false;
+		for(int k = 0; k < (int)m_vBoundarySets.size(); ++k){
+			rxBoundarySet &bs = m_vBoundarySets[k];
+			rxSolid *s = m_vSolids[bs.solid];
+			bs.cen = s->GetPosition();
+			bs.mat = s->GetMatrix();
+			calBoundarySetBounds(bs, bs.minp, bs.maxp);
+		}
+
+		vector<uint> border(ReadBinary<uint>(fin));
+		if(border.size() != m_uNumBParticles) return false;
+		ReadBinaryArray(fin, &border[0], border.size());
+		m_pNNGridB->SetSortedOrder(border);
+		m_pNNGridB->SetObjectToCell(m_hPosB, m_uNumBParticles);
+		ReadBinaryArray(fin, &m_vBNear[0], m_vBNear.size());
+		m_vBMoved.assign(m_uNumBParticles, 0);
+	}
+
+	return (bool)fin;
+}
+
 /*!
  * ԃXebv̏C
  *  - Ihmsen et al., "Boundary Handling and Adaptive Time-stepping for PCISPH", Proc. VRIPHYS, pp.79-88, 2010.
+ *  - őxaCő呬xvɑ΂CFL dt <= cfl*h/v, dt <= 0.5*cfl*sqrt(h/a) Ƃ
+ *  - x덷͔Ŏۂɓꂽl(ςupdateStepdens_varCő͍Ō̔ł̖x)Ŕ肵C
+ *    ő傪5.5*etaCςeta𒴂1/grow{ɏk߁C
+ *    CFLɗ]Tčő傪4.5*etaCς0.9*etaȂgrow{ɑ傫
+ *  - xɂ͈ʒuC܂߂Ȃ(PBF̈ʒuCɂ鑬xω1/dtɔႷ̂ŁC
+ *    ŎԃXebvk߂Ƃɑxω傫ȂĂ܂)
  * @param[in] dt ݂̃^CvXebv
- * @param[in] eta_avg xϓ̕([Uw)
- * @param[in] pfrc ͍ɂ͏(ۂɂ͉x)
+ * @param[in] eta_avg xϓ̕ς̋e([Uw)
+ * @param[in] dens_var ÕXebvőϖxϓ(vZȂ畉̒l)
+ * @param[in] pacc p[eBNx(ÓES)
  * @param[in] pvel p[eBNx
- * @param[in] pdens p[eBNx
+ * @param[in] pdens p[eBNx(ÕXebv̍Ō̔ł̒l)
  * @return Cꂽ^CvXebv
  */
-RXREAL rxPBDSPH::calTimeStep(RXREAL &dt, RXREAL eta_avg, const RXREAL *pfrc, const RXREAL *pvel, const RXREAL *pdens)
+RXREAL rxPBDSPH::calTimeStep(RXREAL dt, RXREAL eta_avg, RXREAL dens_var, const RXREAL *pacc, const RXREAL *pvel, const RXREAL *pdens)
 {
+	const RXREAL grow = 1.2;	// ̔{
+
+	int n = (int)m_uNumParticles;
+	if(n == 0) return dt;
+
 	RXREAL h = m_fEffectiveRadius;
 	RXREAL r0 = m_fRestDens;
-	RXREAL new_dt = dt;
 
-	// ő́Cő呬xCx΍̕ςƍőZo
-	RXREAL ft_max = 0.0;
-	RXREAL vt_max = 0.0;
-	RXREAL rerr_max = 0.0, rerr_avg = 0.0;
-	for(uint i = 0; i < m_uNumParticles; ++i){
-		Vec3 f, v;
-		for(int k = 0; k < 3; ++k){
-			f[k] = pfrc[DIM*i+k];
-			v[k] = pvel[DIM*i+k];
+	// őxCő呬xCő喧xϓZo(ubNƂɋ߂Ă獇킹)
+	int nb = (n+RX_REDUCTION_BLOCK-1)/RX_REDUCTION_BLOCK;
+	vector<RXREAL> bacc(nb, 0.0), bvel(nb, 0.0), berr(nb, 0.0);
+
+	#pragma omp parallel for
+	for(int b = 0; b < nb; ++b){
+		int start = b*RX_REDUCTION_BLOCK;
+		int end = RX_MIN(start+RX_REDUCTION_BLOCK, n);
+
+		RXREAL a2max = 0.0, v2max = 0.0, emax = 0.0;
+		for(int i = start; i < end; ++i){
+			const RXREAL *a = pacc+DIM*i;
+			const RXREAL *v = pvel+DIM*i;
+			RXREAL a2 = a[0]*a[0]+a[1]*a[1]+a[2]*a[2];
+			RXREAL v2 = v[0]*v[0]+v[1]*v[1]+v[2]*v[2];
+			RXREAL e = fabs(pdens[i]-r0)/r0;
+			if(a2 > a2max) a2max = a2;
+			if(v2 > v2max) v2max = v2;
+			if(e > emax) emax = e;
 		}
-		RXREAL ft = norm(f);
-		RXREAL vt = norm(v);
-
-		if(ft > ft_max) ft_max = ft;
-		if(vt > vt_max) vt_max = vt;
-
-		RXREAL rerr = (pdens[i]-r0)/r0;
-		if(rerr > rerr_max) rerr_max = rerr;
-		rerr_avg += rerr;
+		bacc[b] = a2max;
+		bvel[b] = v2max;
+		berr[b] = emax;
 	}
-	rerr_avg /= (RXREAL)m_uNumParticles;
 
-	ft_max = sqrt(h/ft_max);
-	vt_max = h/vt_max;
+	RXREAL a_max = 0.0, v_max = 0.0, rerr_max = 0.0;
+	for(int b = 0; b < nb; ++b){
+		if(bacc[b] > a_max) a_max = bacc[b];
+		if(bvel[b] > v_max) v_max = bvel[b];
+		if(berr[b] > rerr_max) rerr_max = berr[b];
+	}
+	a_max = RX_MAX(sqrt(a_max), (RXREAL)norm(m_v3Gravity));	// xvZłd͂͌̕
+	v_max = sqrt(v_max);
 
-	int inc = 0;
+	// CFLɂ
+	RXREAL dt_max = RX_FEQ_INF;
+	if(v_max > RX_FEQ_EPS) dt_max = RX_MIN(dt_max, m_fCFL*h/v_max);
+	dt_max = RX_MIN(dt_max, (RXREAL)(0.5*m_fCFL*sqrt(h/a_max)));
 
-	if(0.19*ft_max > dt && rerr_max < 4.5*eta_avg && rerr_avg < 0.9*eta_avg && 0.39*vt_max > dt){
-		inc = 1;
-	}
-	else{
-		if(0.2*ft_max < dt && rerr_max > 5.5*eta_avg && rerr_avg >= eta_avg && 0.4*vt_max <= dt){
-			inc = -1;
+	// x덷傫Ώk߁CCFLƖx덷ɗ]TΑ傫
+	RXREAL new_dt = dt;
+	if(dens_var >= 0.0){
+		RXREAL rerr_avg = dens_var;
+		if(rerr_max > 5.5*eta_avg || rerr_avg > eta_avg){
+			new_dt = dt/grow;
+		}
+		else if(grow*dt < dt_max && rerr_max < 4.5*eta_avg && rerr_avg < 0.9*eta_avg){
+			new_dt = grow*dt;
 		}
 	}
+	else if(grow*dt < dt_max){
+		new_dt = grow*dt;
+	}
 
-	new_dt += 0.002*inc*dt;
-
-	return new_dt;
+	return RX_MIN(new_dt, dt_max);
 }
 
 
@@ -1112,9 +1901,6 @@ static int intersectSegmentTriangle(Vec3 P0, Vec3 P1,
 
 	// 2[_ꂼقȂʂɂ邩ǂ𔻒
 	float r = -a/b;
-	Vec3 offset = Vec3(0.0);
-	float dn = 0;
-	float sign_n = 1;
 	if(a < 0){
 		return 0;
 	}
@@ -1213,38 +1999,158 @@ int rxPBDSPH::calCollisionPolygon(uint grid_hash, Vec3 &pos0, Vec3 &pos1, Vec3 &
 
 /*!
  * ő̃IuWFNgƂ̏Փ˔CՓˉ
- * @param[in] pos0 OXebv̈ʒu
- * @param[inout] pos1 Vʒu
- * @param[inout] vel x
+ *  - BVHAABBdȂő̂p[eBNő̂ƂɏW߁CGetDistanceRBatchł܂Ƃ߂ċlvZ
+ *    NĂp[eBNՓ˓_Ɉړ(ő̂̏Ԃ1qꍇƓ)
+ *  - V~[VԋE͑Sp[eBNɂčŌɏ
+ * @param[inout] pos p[eBNʒu
+ * @param[inout] vel p[eBNx
  * @param[in] dt ^CXebv
- * @return Փ˃IuWFNg̐
+ * @return Փ˂p[eBN̉א
  */
-int rxPBDSPH::calCollisionSolid(Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt)
+int rxPBDSPH::calCollisionSolid(RXREAL *pos, RXREAL *vel, RXREAL dt)
 {
+	RXPROF_ZONE("collision");
+	int n = (int)m_uNumParticles;
+	if(!n) return 0;
+
+	if((int)m_vColPen.size() < n){
+		m_vColPen.resize(n);
+		m_vColCp.resize(3*n);
+		m_vColPos.resize(3*n);
+	}
+	RXREAL *pen = &m_vColPen[0];
+	RXREAL *cp = &m_vColCp[0];
+
 	int c = 0;
-	rxCollisionInfo coli;
+	int ns = (int)m_vSolids.size();
+	if(ns){
+		// ő̂ǉE폜ꂽBVH\zCłȂΌő̂̈ړɍ킹AABBXV
+		if(m_SolidBVH.GetSolids() != m_vSolids){
+			m_SolidBVH.Build(m_vSolids);
+		}
+		else{
+			m_SolidBVH.Refit();
+		}
 
-	// ő̃IuWFNgƂ̏Փˏ
-	for(vector<rxSolid*>::iterator i = m_vSolids.begin(); i != m_vSolids.end(); ++i){
-		if((*i)->GetDistanceR(pos1, m_fParticleRadius, coli)){
-			RXREAL res = m_fRestitution;
-			res = (res > 0) ? (res*fabs(coli.Penetration())/(dt*norm(vel))) : 0.0f;
-			//vel -= (1+res)*dot(vel, coli.Normal())*coli.Normal();
-			pos1 = coli.Contact();
+		// ő̂Ƃ̏Փˌp[eBN
+		calSolidCandidates(pos, n);
+
+		for(int s = 0; s < ns; ++s){
+			int start = m_vColStart[s];
+			int m = m_vColStart[s+1]-start;
+			if(!m) continue;
+
+			const int *idx = &m_vColIdx[start];
+			RXREAL *cpos = &m_vColPos[0];
+			#pragma omp parallel for
+			for(int j = 0; j < m; ++j){
+				for(int k = 0; k < 3; ++k) cpos[3*j+k] = pos[DIM*idx[j]+k];
+			}
+
+			m_vSolids[s]->GetDistanceRBatch(cpos, 3, m, m_fParticleRadius, pen, cp);
+
+			int cs = 0;
+			#pragma omp parallel for reduction(+:cs)
+			for(int j = 0; j < m; ++j){
+				if(pen[j] <= 0){
+					for(int k = 0; k < 3; ++k) pos[DIM*idx[j]+k] = cp[3*j+k];
+					cs++;
+				}
+			}
+			c += cs;
 		}
 	}
 
 	// V~[VԋEƂ̏Փˏ
-	if(m_pBoundary->GetDistanceR(pos1, m_fParticleRadius, coli)){
-		RXREAL res = m_fRestitution;
-		res = (res > 0) ? (res*fabs(coli.Penetration())/(dt*norm(vel))) : 0.0f;
-		//vel -= (1+res)*dot(vel, coli.Normal())*coli.Normal();
-		pos1 = coli.Contact();
+	m_pBoundary->GetDistanceRBatch(pos, DIM, n, m_fParticleRadius, pen, cp);
+	int cb = 0;
+	#pragma omp parallel for reduction(+:cb)
+	for(int j = 0; j < n; ++j){
+		if(pen[j] <= 0){
+			for(int k = 0; k < 3; ++k) pos[DIM*j+k] = cp[3*j+k];
+			cb++;
+		}
 	}
+	c += cb;
+
+	RXPROF_COUNT("collisions", c);
 
 	return c;
 }
 
+/*!
+ * ő̂Ƃ̏Փˌp[eBN̒T
+ *  - p[eBN܂ޕZAABB(+p[eBNa)BVHŏdȂő̂T
+ *  - p[eBNz̓ZɕёւĂ̂ŁCZԂ͒Tʂg
+ *  - ʂ͌ő̂ƂCSR`(m_vColStart, m_vColIdx)
+ * @param[in] pos p[eBNʒu
+ * @param[in] n p[eBN
+ */
+void rxPBDSPH::calSolidCandidates(const RXREAL *pos, int n)
+{
+	int ns = m_SolidBVH.GetNumSolids();
+
+	// ubN(Xbh̐{ɂĕׂ𕪎U)
+	int nb = 1;
+#ifdef _OPENMP
+	nb = 4*omp_get_max_threads();
+#endif
+	if(nb > n) nb = n;
+	if((int)m_vColBuf.size() < nb) m_vColBuf.resize(nb);
+
+	RXREAL margin = 2.0*m_fParticleRadius;
+
+	// ubNƂ(ő,p[eBN)̑g
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int b = 0; b < nb; ++b){
+		int start = (int)(((long long)n*b)/nb);
+		int end   = (int)(((long long)n*(b+1))/nb);
+
+		vector<int> &buf = m_vColBuf[b];
+		buf.clear();
+
+		vector<int> cand;
+		uint prev = (uint)-1;
+		for(int i = start; i < end; ++i){
+			Vec3 x(pos[DIM*i+0], pos[DIM*i+1], pos[DIM*i+2]);
+			uint grid_hash = m_pNNGrid->CalGridHash(x);
+			if(grid_hash != prev){
+				Vec3 minp, maxp;
+				m_pNNGrid->CalCellBounds(grid_hash, minp, maxp);
+				cand.clear();
+				m_SolidBVH.Query(minp-Vec3(margin), maxp+Vec3(margin), cand);
+				prev = grid_hash;
+			}
+			for(int j = 0; j < (int)cand.size(); ++j){
+				buf.push_back(cand[j]);
+				buf.push_back(i);
+			}
+		}
+	}
+
+	// ő̂Ƃ̌␔̗ݐϘa
+	m_vColStart.assign(ns+1, 0);
+	for(int b = 0; b < nb; ++b){
+		const vector<int> &buf = m_vColBuf[b];
+		for(int j = 0; j < (int)buf.size(); j += 2){
+			m_vColStart[buf[j]+1]++;
+		}
+	}
+	for(int s = 0; s < ns; ++s){
+		m_vColStart[s+1] += m_vColStart[s];
+	}
+
+	// p[eBÑCfbNXő̂ƂɊi[
+	m_vColIdx.resize(m_vColStart[ns]);
+	vector<int> cur(m_vColStart.begin(), m_vColStart.end()-1);
+	for(int b = 0; b < nb; ++b){
+		const vector<int> &buf = m_vColBuf[b];
+		for(int j = 0; j < (int)buf.size(); j += 2){
+			m_vColIdx[cur[buf[j]]++] = buf[j+1];
+		}
+	}
+}
+
 /*!
  * ʒuEx̍XV
  * @param[in] pos p[eBNʒu
@@ -1257,7 +2163,8 @@ int rxPBDSPH::calCollisionSolid(Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt)
 void rxPBDSPH::integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *dens, const RXREAL *acc, 
 						  RXREAL *pos_new, RXREAL *vel_new, RXREAL dt)
 {
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 x, x_old, v, a, v_old;
 		for(int k = 0; k < 3; ++k){
 			x[k] = pos[DIM*i+k];
@@ -1281,9 +2188,6 @@ void rxPBDSPH::integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *den
 			}
 		}
 
-		// EƂ̏Փ˔
-		calCollisionSolid(x_old, x, v, dt);
-
 		// VxƈʒuōXV
 		for(int k = 0; k < 3; ++k){
 			pos_new[DIM*i+k] = x[k];
@@ -1291,6 +2195,9 @@ void rxPBDSPH::integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *den
 		}
 
 	}
+
+	// ő̃IuWFNgEEƂ̏Փ˔
+	calCollisionSolid(pos_new, vel_new, dt);
 }
 
 
@@ -1306,7 +2213,8 @@ void rxPBDSPH::integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *den
 void rxPBDSPH::integrate2(const RXREAL *pos, const RXREAL *vel, const RXREAL *dens, const RXREAL *acc, 
 						 RXREAL *pos_new, RXREAL *vel_new, RXREAL dt)
 {
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 x, x_old, v, a, v_old;
 		for(int k = 0; k < 3; ++k){
 			x[k] = pos_new[DIM*i+k];
@@ -1330,9 +2238,6 @@ void rxPBDSPH::integrate2(const RXREAL *pos, const RXREAL *vel, const RXREAL *de
 			}
 		}
 
-		// EƂ̏Փ˔
-		calCollisionSolid(x_old, x, v, dt);
-
 		// VxƈʒuōXV
 		for(int k = 0; k < 3; ++k){
 			pos_new[DIM*i+k] = x[k];
@@ -1340,6 +2245,9 @@ void rxPBDSPH::integrate2(const RXREAL *pos, const RXREAL *vel, const RXREAL *de
 		}
 
 	}
+
+	// ő̃IuWFNgEEƂ̏Փ˔
+	calCollisionSolid(pos_new, vel_new, dt);
 }
 
 
@@ -1402,15 +2310,15 @@ void rxPBDSPH::GetNearestNeighborsB(Vec3 pos, vector<rxNeigh> &neighs, RXREAL h)
  */
 void rxPBDSPH::SetParticlesToCell(RXREAL *prts, int n, RXREAL h)
 {
+	RXPROF_ZONE("neighbor search");
+	RXPROF_COUNT("neighbor builds", 1);
+
 	// Zɗqo^
 	m_pNNGrid->SetObjectToCell(prts, n);
 
 	// ߖTqT
 	if(h < 0.0) h = m_fEffectiveRadius;
-	for(int i = 0; i < (int)m_uNumParticles; i++){
-		m_vNeighs[i].clear();
-		GetNearestNeighbors(i, prts, m_vNeighs[i], h);
-	}
+	m_pNNGrid->GetNNList(prts, m_uNumParticles, m_vNeighs, h);
 }
 void rxPBDSPH::SetParticlesToCell(void)
 {
@@ -1455,7 +2363,9 @@ void rxPBDSPH::SetPolygonsToCell(void)
  */
 void rxPBDSPH::DrawCell(int i, int j, int k)
 {
+#ifndef RX_HEADLESS
 	if(m_pNNGrid) m_pNNGrid->DrawCell(i, j, k);
+#endif
 }
 
 /*!
@@ -1466,8 +2376,10 @@ void rxPBDSPH::DrawCell(int i, int j, int k)
  */
 void rxPBDSPH::DrawCells(Vec3 col, Vec3 col2, int sel)
 {
+#ifndef RX_HEADLESS
 	if(m_pNNGrid) m_pNNGrid->DrawCells(col, col2, sel, m_hPos);
 
+#endif
 }
 
 /*!
@@ -1485,39 +2397,154 @@ void rxPBDSPH::DrawObstacles(int drw)
 
 /*!
  * Op`|SɂQ
+ *  - łɐݒ肳Ă|SQ̌ɒǉCǉ|S𕪊ZɊi[
  * @param[in] vrts _
  * @param[in] nrms _@
  * @param[in] tris bV
- * @param[in] vel x
+ * @param[in] vel x(0łȂupdateSolidsŕsړ)
  */
 void rxPBDSPH::SetPolygonObstacle(const vector<Vec3> &vrts, const vector<Vec3> &nrms, const vector< vector<int> > &tris, Vec3 vel)
 {
 	int vn = (int)vrts.size();
 	int n = (int)tris.size();
 
-	if(m_hVrts) delete [] m_hVrts;
-	if(m_hTris) delete [] m_hTris;
-	m_hVrts = new RXREAL[vn*3];
-	m_hTris = new int[n*3];
+	rxPolygonObstacle obj;
+	obj.vstart = m_iNumVrts;
+	obj.vnum = vn;
+	obj.tstart = m_iNumTris;
+	obj.tnum = n;
+	obj.vrts = vrts;
+	obj.vel = vel;
+
+	// ̏Q̃|SɑĊi[
+	RXREAL *new_vrts = new RXREAL[(obj.vstart+vn)*3];
+	int *new_tris = new int[(obj.tstart+n)*3];
+	if(m_hVrts){
+		memcpy(new_vrts, m_hVrts, sizeof(RXREAL)*obj.vstart*3);
+		delete [] m_hVrts;
+	}
+	if(m_hTris){
+		memcpy(new_tris, m_hTris, sizeof(int)*obj.tstart*3);
+		delete [] m_hTris;
+	}
+	m_hVrts = new_vrts;
+	m_hTris = new_tris;
 
 	for(int i = 0; i < vn; ++i){
 		for(int j = 0; j < 3; ++j){
-			m_hVrts[3*i+j] = vrts[i][j];
+			m_hVrts[3*(obj.vstart+i)+j] = vrts[i][j];
 		}
 	}
 
 	for(int i = 0; i < n; ++i){
 		for(int j = 0; j < 3; ++j){
-			m_hTris[3*i+j] = tris[i][j];
+			m_hTris[3*(obj.tstart+i)+j] = obj.vstart+tris[i][j];
 		}
 	}
 
-	m_iNumVrts = vn;
-	m_iNumTris = n;
-	RXCOUT << "the number of triangles : " << m_iNumTris << endl;
+	m_iNumVrts += vn;
+	m_iNumTris += n;
+	m_vPolyObstacles.push_back(obj);
+	RXCOUT << "the number of triangles : " << n << " (total " << m_iNumTris << ")" << endl;
 
 	// |SߖTTObhɓo^
-	m_pNNGrid->SetPolygonsToCell(m_hVrts, m_iNumVrts, m_hTris, m_iNumTris);
+	m_pNNGrid->UpdatePolygonsInCell(m_hVrts, m_iNumVrts, m_hTris, m_iNumTris, obj.tstart, n);
+}
+
+/*!
+ * |SQ̈ړ
+ *  - ݒ莞̒_WϊsŕϊCϊO񂩂ςĂ΂̏Q̃|S𕪊ZɊi[
+ * @param[in] i |SQ̃CfbNX(SetPolygonObstacleŒǉ)
+ * @param[in] mat ݒ莞̌`ɑ΂ϊs
+ * @return |Si[true
+ */
+bool rxPBDSPH::SetPolygonObstacleMatrix(int i, const rxMatrix4 &mat)
+{
+	if(i < 0 || i >= (int)m_vPolyObstacles.size()) return false;
+
+	rxPolygonObstacle &obj = m_vPolyObstacles[i];
+	if(obj.mat == mat) return false;
+	obj.mat = mat;
+
+	#pragma omp parallel for
+	for(int j = 0; j < obj.vnum; ++j){
+		Vec3 v;
+		mat.multMatrixVec(obj.vrts[j], v);
+		for(int k = 0; k < 3; ++k){
+			m_hVrts[3*(obj.vstart+j)+k] = v[k];
+		}
+	}
+
+	m_pNNGrid->UpdatePolygonsInCell(m_hVrts, m_iNumVrts, m_hTris, m_iNumTris, obj.tstart, obj.tnum);
+
+	return true;
+}
+
+/*!
+ * t@Cǂݍ񂾎Op`|SɂQ
+ *  - _͌_𒆐SƂextɍ킹`(]ȂΏcێ)ƂC
+ *    ]angƕsړcen̓|SQ̕ϊsƂĎ
+ * @param[in] filename |St@C(OBJ)
+ * @param[in] cen SW
+ * @param[in] ext 傫(ӂ̒1/2)
+ * @param[in] ang px(IC[p)
+ * @param[in] vel x
+ */
+void rxPBDSPH::SetPolygonObstacle(const string &filename, Vec3 cen, Vec3 ext, Vec3 ang, Vec3 vel)
+{
+	if(GetExtension(filename) != "obj") return;
+
+	rxPolygons poly;
+#ifdef RX_HEADLESS
+	bool ok = RxReadOBJMesh(filename, poly.vertices, poly.faces);
+#else
+	rxOBJ obj;
+	bool ok = obj.Read(filename, poly.vertices, poly.normals, poly.faces, poly.materials, true);
+#endif
+	if(!ok || poly.vertices.empty()){
+		RXCOUT << "failed to read " << filename << endl;
+		return;
+	}
+	RXCOUT << filename << " have been read." << endl;
+	RXCOUT << " the number of vertex   : " << poly.vertices.size() << endl;
+	RXCOUT << " the number of polygon  : " << poly.faces.size() << endl;
+
+	// _𒆐SƂextɍ킹(rxPBDSPH_GPUfitVerticesCAffineVerticesƓ傫)
+	Vec3 minp, maxp;
+	FindBBox(minp, maxp, poly.vertices);
+	Vec3 ctr0 = 0.5*(maxp+minp);
+	Vec3 sl0 = 0.5*(maxp-minp);
+	Vec3 scale;
+	if(RXFunc::IsZeroVec(ang)){
+		int max_axis = ( ( (sl0[0] > sl0[1]) && (sl0[0] > sl0[2]) ) ? 0 : ( (sl0[1] > sl0[2]) ? 1 : 2 ) );
+		scale = Vec3(ext[max_axis]/sl0[max_axis]);
+	}
+	else{
+		for(int i = 0; i < 3; ++i){
+			scale[i] = (fabs(sl0[i]) < RX_FEQ_EPS ? 2.0*ext[i] : ext[i]/sl0[i]);
+		}
+	}
+	for(int i = 0; i < (int)poly.vertices.size(); ++i){
+		poly.vertices[i] = (poly.vertices[i]-ctr0)*scale;
+	}
+
+	vector< vector<int> > tris(poly.faces.size(), vector<int>(3));
+	for(int i = 0; i < (int)poly.faces.size(); ++i){
+		for(int j = 0; j < 3; ++j){
+			tris[i][j] = poly.faces[i][j];
+		}
+	}
+	SetPolygonObstacle(poly.vertices, poly.normals, tris, vel);
+
+	// ]ƕsړ(AffineVerticesƓEulerToMatrix(-ang))
+	double rot[9];
+	EulerToMatrix(-ang, rot);
+	rxMatrix4 mat;
+	for(int i = 0; i < 9; ++i){
+		mat(i/3, i%3) = rot[i];
+	}
+	mat.SetTranslate(cen);
+	SetPolygonObstacleMatrix((int)m_vPolyObstacles.size()-1, mat);
 }
 
 /*!
@@ -1526,7 +2553,7 @@ void rxPBDSPH::SetPolygonObstacle(const vector<Vec3> &vrts, const vector<Vec3> &
  * @param[in] ext {bNX̑傫(ӂ̒1/2)
  * @param[in] ang {bNX̊px(IC[p)
  * @param[in] vel x
- * @param[in] flg L/tO
+ * @param[in] flg L/tO(RX_OBSTACLE_PARTICLES܂ނȂ狫Ep[eBN)
  */
 void rxPBDSPH::SetBoxObstacle(Vec3 cen, Vec3 ext, Vec3 ang, Vec3 vel, int flg)
 {
@@ -1534,6 +2561,9 @@ void rxPBDSPH::SetBoxObstacle(Vec3 cen, Vec3 ext, Vec3 ang, Vec3 vel, int flg)
 	double m[16];
 	EulerToMatrix(m, ang[0], ang[1], ang[2]);
 	box->SetMatrix(m);
+	box->SetVelocity(vel);
+	box->SetFix(norm2(vel) < RX_FEQ_EPS);
+	box->IsSolidParticles() = ((flg & RX_OBSTACLE_PARTICLES) != 0);
 
 	m_vSolids.push_back(box);
 
@@ -1544,11 +2574,14 @@ void rxPBDSPH::SetBoxObstacle(Vec3 cen, Vec3 ext, Vec3 ang, Vec3 vel, int flg)
  * @param[in] cen ̒SW
  * @param[in] rad ̂̔a
  * @param[in] vel x
- * @param[in] flg L/tO
+ * @param[in] flg L/tO(RX_OBSTACLE_PARTICLES܂ނȂ狫Ep[eBN)
  */
 void rxPBDSPH::SetSphereObstacle(Vec3 cen, double rad, Vec3 vel, int flg)
 {
 	rxSolidSphere *sphere = new rxSolidSphere(cen, rad, 1);
+	sphere->SetVelocity(vel);
+	sphere->SetFix(norm2(vel) < RX_FEQ_EPS);
+	sphere->IsSolidParticles() = ((flg & RX_OBSTACLE_PARTICLES) != 0);
 	m_vSolids.push_back(sphere);
 }
 
@@ -1564,13 +2597,10 @@ RXREAL* rxPBDSPH::GetArrayVBO(rxParticleArray type, bool d2h, int num)
 	if(num == -1) num = m_uNumParticles;
 	RXREAL* hdata = 0;
 
-	unsigned int vbo = 0;
-
 	switch(type){
 	default:
 	case RX_POSITION:
 		hdata = m_hPos;
-		vbo = m_posVBO;
 		break;
 
 	case RX_VELOCITY:
@@ -1608,11 +2638,13 @@ void rxPBDSPH::SetArrayVBO(rxParticleArray type, const RXREAL* data, int start,
 	default:
 	case RX_POSITION:
 		{
+#ifndef RX_HEADLESS
 			if(m_bUseOpenGL){
 				glBindBuffer(GL_ARRAY_BUFFER, m_posVBO);
 				glBufferSubData(GL_ARRAY_BUFFER, start*4*sizeof(RXREAL), count*4*sizeof(RXREAL), data);
 				glBindBuffer(GL_ARRAY_BUFFER, 0);
 			}
+#endif
 		}
 		break;
 
@@ -1635,6 +2667,10 @@ double rxPBDSPH::GetImplicit(double x, double y, double z)
 
 /*!
  * p[eBNObh̉A֐lvZ
+ *  - ep[eBNeãObh_ɃJ[llZ(XvbeBO)
+ *  - p[eBNe͈͂z[̃ObhwŃ\[gĂCz̃XuƂɕɉZ
+ *    (XuԂŏݐ悪dȂȂ̂atomic͕svCZXbhɂȂ)
+ *  - vZʂ̓Obh_ł͂Ȃp[eBNɔႷ(p[eBNȂ̈0Ŗ߂邾)
  * @param[in] n Obh
  * @param[in] minp Obh̍ŏW
  * @param[in] d Obh
@@ -1642,20 +2678,126 @@ double rxPBDSPH::GetImplicit(double x, double y, double z)
  */
 void rxPBDSPH::CalImplicitField(int n[3], Vec3 minp, Vec3 d, RXREAL *hF)
 {
+	RXPROF_ZONE("implicit field");
 	int slice0 = n[0];
 	int slice1 = n[0]*n[1];
+	int np = (int)m_uNumParticles;
+	RXREAL h = m_fEffectiveRadius;
+	RXREAL h2 = h*h;
+
+	// ep[eBN̉e͈͂Ɋ܂܂Obh_̃CfbNX͈(͈͊Õp[eBNk0=-1)
+	vector<int> range(6*np);
+	#pragma omp parallel for
+	for(int p = 0; p < np; ++p){
+		int *r = &range[6*p];
+		r[4] = -1;
+		for(int l = 0; l < 3; ++l){
+			double x = m_hPos[DIM*p+l]-minp[l];
+			r[2*l]   = RX_MAX((int)ceil((x-h)/d[l]), 0);
+			r[2*l+1] = RX_MIN((int)floor((x+h)/d[l]), n[l]-1);
+			if(r[2*l] > r[2*l+1]){
+				r[4] = -1;
+				break;
+			}
+		}
+	}
+
+	// z[̃ObhwƂɃp[eBNU蕪(counting sort)
+	vector<int> start(n[2]+1, 0);
+	int kspan = 0;
+	for(int p = 0; p < np; ++p){
+		const int *r = &range[6*p];
+		if(r[4] < 0) continue;
+		start[r[4]+1]++;
+		if(r[5]-r[4] > kspan) kspan = r[5]-r[4];
+	}
+	for(int k = 0; k < n[2]; ++k) start[k+1] += start[k];
+	vector<int> sorted(start[n[2]]);
+	vector<int> cnt(start.begin(), start.end()-1);
+	for(int p = 0; p < np; ++p){
+		if(range[6*p+4] >= 0) sorted[cnt[range[6*p+4]]++] = p;
+	}
+
+	// E̊ÕObh_0(CalColorFieldƓ)
+	int vmin[3], vmax[3];
+	for(int l = 0; l < 3; ++l){
+		vmin[l] = RX_MAX((int)ceil((m_v3EnvMin[l]-minp[l])/d[l]), 0);
+		vmax[l] = RX_MIN((int)floor((m_v3EnvMax[l]-minp[l])/d[l]), n[l]-1);
+	}
 
-	for(int k = 0; k < n[2]; ++k){
-		for(int j = 0; j < n[1]; ++j){
-			for(int i = 0; i < n[0]; ++i){
-				int idx = k*slice1+j*slice0+i;
-				Vec3 pos = minp+Vec3(i, j, k)*d;
-				hF[idx] = GetImplicit(pos[0], pos[1], pos[2]);
+	// z̃XuƂɃJ[llZ
+	int nthreads = 1;
+#ifdef _OPENMP
+	nthreads = omp_get_max_threads();
+#endif
+	int ns = RX_MAX(RX_MIN(4*nthreads, n[2]), 1);
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int s = 0; s < ns; ++s){
+		int z0 = (int)((long long)n[2]*s/ns);
+		int z1 = (int)((long long)n[2]*(s+1)/ns);
+		if(z0 >= z1) continue;
+
+		memset(hF+z0*slice1, 0, (z1-z0)*slice1*sizeof(RXREAL));
+
+		for(int k0 = RX_MAX(z0-kspan, 0); k0 < z1; ++k0){
+			for(int m = start[k0]; m < start[k0+1]; ++m){
+				int p = sorted[m];
+				const int *r = &range[6*p];
+				int ks = RX_MAX(r[4], z0), ke = RX_MIN(r[5], z1-1);
+				if(ks > ke) continue;
+
+				Vec3 pos(m_hPos[DIM*p+0], m_hPos[DIM*p+1], m_hPos[DIM*p+2]);
+				for(int k = ks; k <= ke; ++k){
+					double dz = minp[2]+k*d[2]-pos[2];
+					double dz2 = dz*dz;
+					for(int j = r[2]; j <= r[3]; ++j){
+						double dy = minp[1]+j*d[1]-pos[1];
+						double dyz2 = dy*dy+dz2;
+						if(dyz2 > h2) continue;
+
+						RXREAL *f = hF+k*slice1+j*slice0;
+						for(int i = r[0]; i <= r[1]; ++i){
+							double dx = minp[0]+i*d[0]-pos[0];
+							double r2 = dx*dx+dyz2;
+							if(r2 > h2) continue;
+							f[i] += m_fMass*m_fpW(sqrt(r2), h, m_fAw);
+						}
+					}
+				}
+			}
+		}
+
+		for(int k = z0; k < z1; ++k){
+			bool kout = (k < vmin[2] || k > vmax[2]);
+			for(int j = 0; j < n[1]; ++j){
+				RXREAL *f = hF+k*slice1+j*slice0;
+				if(kout || j < vmin[1] || j > vmax[1]){
+					memset(f, 0, n[0]*sizeof(RXREAL));
+					continue;
+				}
+				for(int i = 0; i < vmin[0]; ++i) f[i] = 0;
+				for(int i = vmax[0]+1; i < n[0]; ++i) f[i] = 0;
 			}
 		}
 	}
 }
 
+/*!
+ * p[eBNaȃubNObh̉A֐lvZ
+ *  - p[eBN̉e͈͂ɂubNmۂ
+ * @param[in] n Obh
+ * @param[in] minp Obh̍ŏW
+ * @param[in] d Obh
+ * @param[out] grid A֐l
+ */
+void rxPBDSPH::CalImplicitFieldSparse(int n[3], Vec3 minp, Vec3 d, rxSparseBrickGrid &grid)
+{
+	RXPROF_ZONE("implicit field");
+	grid.Init(n, minp, d);
+	grid.SplatParticles(m_hPos, (int)m_uNumParticles, DIM, m_fEffectiveRadius, m_fMass, m_fpW, m_fAw);
+	grid.ClearOutside(m_v3EnvMin, m_v3EnvMax);
+}
+
 /*!
  * p[eBNObh̉A֐lvZ
  * @param[in] pnx,pny,pnz Obh̎w nx=2^pnx
@@ -1668,7 +2810,9 @@ void rxPBDSPH::CalImplicitFieldDevice(int n[3], Vec3 minp, Vec3 d, RXREAL *dF)
 	RXREAL *hF = new RXREAL[n[0]*n[1]*n[2]];
 
 	CalImplicitField(n, minp, d, hF);
+#ifndef RX_HEADLESS
 	CuCopyArrayToDevice(dF, hF, 0, n[0]*n[1]*n[2]*sizeof(RXREAL));
+#endif
 
 	delete [] hF;
 }
@@ -582,6 +582,8 @@ void rxPBDSPH_GPU::UpdateParams(void)
  */
 bool rxPBDSPH_GPU::Update(RXREAL dt, int step)
 {
+	RXPROF_ZONE("update");	// J[l͔񓯊ɎŝŁC܂ޏȊO̓zXg̎ԂɂȂ
+	RXPROF_MARK;
 	//RXTIMER_RESET;
 
 	// p[eBNǉ
@@ -1672,6 +1674,25 @@ void rxPBDSPH_GPU::CalImplicitFieldDevice(int n[3], Vec3 minp, Vec3 d, RXREAL *d
 }
 
 
+/*!
+ * p[eBNaȃubNObh̉A֐lvZ
+ *  - p[eBNWzXgɓ]CPUŌvZ
+ * @param[in] n Obh
+ * @param[in] minp Obh̍ŏW
+ * @param[in] d Obh
+ * @param[out] grid A֐l
+ */
+void rxPBDSPH_GPU::CalImplicitFieldSparse(int n[3], Vec3 minp, Vec3 d, rxSparseBrickGrid &grid)
+{
+	RXREAL *hPos = GetArrayVBO(RX_POSITION, true);
+	RXREAL h = m_params.EffectiveRadius;
+
+	grid.Init(n, minp, d);
+	grid.SplatParticles(hPos, (int)m_uNumParticles, DIM, h, m_params.Mass, KernelPoly6, m_params.Wpoly6);
+	grid.ClearOutside(m_v3EnvMin, m_v3EnvMax);
+}
+
+
 
 
 
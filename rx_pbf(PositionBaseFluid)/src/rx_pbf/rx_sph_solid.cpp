@@ -143,11 +143,54 @@ Vec4 rxSolid::GetImplicitG(Vec3 pos)
 	return Vec4(col.Normal(), col.Penetration()+m_fOffset);
 }
 
+/*!
+ * _ł̉A֐lƂ̌žvZ(e_͕ɌvZ)
+ * @param[in] pos vZʒu(stridevf)
+ * @param[in] stride 1_̗vf
+ * @param[in] n _
+ * @param[out] fv zƉA֐li[4xNg(0`2:z,3:l)
+ */
+void rxSolid::GetImplicitGBatch_s(void* ptr, const RXREAL *pos, int stride, int n, Vec4 *fv)
+{
+	rxSolid *solid = (rxSolid*)ptr;
+	#pragma omp parallel for
+	for(int i = 0; i < n; ++i){
+		fv[i] = solid->GetImplicitG(Vec3(pos[stride*i+0], pos[stride*i+1], pos[stride*i+2]));
+	}
+}
+
 bool rxSolid::GetDistance_s(Vec3 pos, rxCollisionInfo &col, void* x)
 {
 	return ((rxSolid*)x)->GetDistance(pos, col);
 }
 
+/*!
+ * _ł̋lvZ(e_͕ɌvZ)
+ *  - hNXŋȂǂgĂ܂Ƃ߂ČvZłꍇ̓I[o[Ch
+ * @param[in] pos vZʒu(stridevf)
+ * @param[in] stride 1_̗vf
+ * @param[in] n _
+ * @param[in] r ̔a
+ * @param[out] pen N(0ȉŏՓ,Փ˂ĂȂ_RX_FEQ_INF)
+ * @param[out] cp Փ˓_(3nvf,Փ˂ĂȂ_͌̈ʒu)
+ */
+void rxSolid::GetDistanceRBatch(const RXREAL *pos, int stride, int n, RXREAL r, RXREAL *pen, RXREAL *cp)
+{
+	#pragma omp parallel for
+	for(int i = 0; i < n; ++i){
+		const RXREAL *p = pos+stride*i;
+		rxCollisionInfo col;
+		if(GetDistanceR(Vec3(p[0], p[1], p[2]), r, col)){
+			pen[i] = (RXREAL)col.Penetration();
+			for(int k = 0; k < 3; ++k) cp[3*i+k] = (RXREAL)col.Contact()[k];
+		}
+		else{
+			pen[i] = (RXREAL)RX_FEQ_INF;
+			for(int k = 0; k < 3; ++k) cp[3*i+k] = p[k];
+		}
+	}
+}
+
 
 /*!
  * \ʃp[eBN
@@ -199,7 +242,7 @@ int rxSolid::GenerateParticlesOnSurf(RXREAL rad, RXREAL **ppos)
 		rxParticleOnSurf sp;
 
 		// p[eBNzu
-		sp.Initialize(vrts, rad, minp, maxp, rxSolid::GetImplicitG_s, this);
+		sp.Initialize(vrts, rad, minp, maxp, rxSolid::GetImplicitGBatch_s, this);
 
 		// p[eBNʒuC̍ő唽vZ񐔂Ƌe덷
 		int iter = 50;
@@ -383,8 +426,10 @@ bool rxSolidBox::GetCurvature(const Vec3 &pos, double &k)
  */
 void rxSolidBox::SetGLMatrix(void)
 {
+#ifndef RX_HEADLESS
 	glTranslatef(m_vMassCenter[0], m_vMassCenter[1], m_vMassCenter[2]);
 	glMultMatrixd(m_matRot.GetValue());
+#endif
 }
 
 /*!
@@ -393,6 +438,7 @@ void rxSolidBox::SetGLMatrix(void)
  */
 void rxSolidBox::Draw(int drw)
 {
+#ifndef RX_HEADLESS
 	glPushMatrix();
 
 	SetGLMatrix();
@@ -409,6 +455,7 @@ void rxSolidBox::Draw(int drw)
 	}
 
 	glPopMatrix();
+#endif
 }
 
 
@@ -518,8 +565,10 @@ bool rxSolidOpenBox::GetCurvature(const Vec3 &pos, double &k)
  */
 void rxSolidOpenBox::SetGLMatrix(void)
 {
+#ifndef RX_HEADLESS
 	glTranslatef(m_vMassCenter[0], m_vMassCenter[1], m_vMassCenter[2]);
 	glMultMatrixd(m_matRot.GetValue());
+#endif
 }
 
 inline void SetVerticesCube(const Vec3 &cn, const Vec3 &sl, Vec3 v[8])
@@ -615,6 +664,7 @@ inline void CreateBoxPolygon(const Vec3 &sl0, const Vec3 &sl1, const int &d,
  */
 void rxSolidOpenBox::Draw(int drw)
 {
+#ifndef RX_HEADLESS
 	glPushMatrix();
 
 	SetGLMatrix();
@@ -678,6 +728,7 @@ void rxSolidOpenBox::Draw(int drw)
 
 
 	glPopMatrix();
+#endif
 }
 
 
@@ -687,13 +738,23 @@ void rxSolidOpenBox::Draw(int drw)
 //-----------------------------------------------------------------------------
 /*!
  * lvZ(_Ƃ̋)
+ *  - \ʃp[eBNzủA֐ƂĂĝŁC̊OłƖ@Ԃ
  * @param[in] pos O[oWł̈ʒu
  * @param[out] col Ȃǂ̏(Փˏ)
- * @return 
+ * @return ̓Ȃtrue
  */
 bool rxSolidSphere::GetDistance(const Vec3 &pos, rxCollisionInfo &col)
 {
-	return GetDistanceR(pos, 0.0, col);
+	Vec3 rpos = pos-m_vMassCenter;
+	double d = m_iSgn*(norm(rpos)-m_fRadius);
+	Vec3 n = Unit(rpos);
+
+	col.Penetration() = d;
+	col.Contact() = m_vMassCenter+n*m_fRadius;
+	col.Normal() = m_iSgn*n;
+	col.Velocity() = GetVelocityAtGrobal(pos);
+
+	return (d < 0.0);
 }
 
 /*!
@@ -727,10 +788,13 @@ bool rxSolidSphere::GetDistanceR(const Vec3 &pos, const double &r, rxCollisionIn
  */
 void rxSolidSphere::SetGLMatrix(void)
 {
+#ifndef RX_HEADLESS
 	glTranslatef(m_vMassCenter[0], m_vMassCenter[1], m_vMassCenter[2]);
 	glMultMatrixd(m_matRot.GetValue());
+#endif
 }
 
+#ifndef RX_HEADLESS
 /*!
  * _S̉~̃C[t[`
  * @param rad ~̔a
@@ -809,6 +873,7 @@ void DrawWireSphere(const Vec3 &cen, const float &rad, const Vec3 &col)
 	//glutWireSphere(rad, 10, 5);
 	glPopMatrix();
 }
+#endif
 
 /*!
  * OpenGLɂ`
@@ -816,6 +881,7 @@ void DrawWireSphere(const Vec3 &cen, const float &rad, const Vec3 &col)
  */
 void rxSolidSphere::Draw(int drw)
 {
+#ifndef RX_HEADLESS
 	glPushMatrix();
 	SetGLMatrix();
 
@@ -830,6 +896,7 @@ void rxSolidSphere::Draw(int drw)
 	}
 
 	glPopMatrix();
+#endif
 }
 
 
@@ -24,6 +24,9 @@
 // SPHJ[l
 #include "rx_kernel.h"
 
+// tObh
+#include "rx_sdf.h"
+
 
 //-----------------------------------------------------------------------------
 // `E萔
@@ -129,6 +132,9 @@ public:
 		m_matRot.MakeIdentity();
 	}
 
+	//! fXgN^
+	virtual ~rxSolid(){}
+
 	//
 	// z֐
 	//
@@ -138,6 +144,8 @@ public:
 	virtual bool GetDistance(const Vec3 &pos0, const Vec3 &pos1, rxCollisionInfo &col) = 0;	//!< ֐vZ
 	virtual bool GetDistanceR(const Vec3 &pos0, const Vec3 &pos1, const double &r, rxCollisionInfo &col) = 0;
 
+	virtual void GetDistanceRBatch(const RXREAL *pos, int stride, int n, RXREAL r, RXREAL *pen, RXREAL *cp);	//!< _ł̋֐vZ
+
 	virtual bool GetCurvature(const Vec3 &pos, double &k) = 0;	//!< ֐̋ȗvZ
 
 	virtual void Draw(int drw) = 0;				//!< OpenGLł̕`
@@ -152,6 +160,7 @@ public:
 	//
 	static Vec4 GetImplicitG_s(void* ptr, double x, double y, double z);
 	inline Vec4 GetImplicitG(Vec3 pos);
+	static void GetImplicitGBatch_s(void* ptr, const RXREAL *pos, int stride, int n, Vec4 *fv);
 	static RXREAL GetImplicit_s(void* ptr, double x, double y, double z);
 	inline RXREAL GetImplicit(Vec3 pos);
 
@@ -174,6 +183,7 @@ public:
 
 	inline Vec3 GetVelocityAtGrobal(const Vec3 &pos);	//!< ̍Wľő̑x̎擾
 	inline void SetVelocity(const Vec3 &vec);			//!< 
+	inline Vec3 GetVelocity(void) const { return m_vVelocity; }	//!< ő̑x̎擾
 
 	inline bool GetFix(void) const { return m_bFix; }		//!< ŒtO̎擾
 	inline void SetFix(bool fix){ m_bFix = fix; }			//!< ŒtO̐ݒ
@@ -324,6 +334,60 @@ public:
 
 
 
+//-----------------------------------------------------------------------------
+// OBJt@C(_Ɩʂ̂)
+//-----------------------------------------------------------------------------
+/*!
+ * OBJt@C璸_ƃ|Sǂݍ
+ *  - wbhXłrxOBJ(rx_model.lib)NȂ̂łg
+ *  - p`͐ɎOp`D@CeNX`WCގ͓ǂ܂Ȃ
+ * @param[in] fn t@C
+ * @param[out] vrts _W
+ * @param[out] faces Op`|S
+ * @return ǂݍ߂true
+ */
+inline bool RxReadOBJMesh(const string &fn, vector<Vec3> &vrts, vector<rxFace> &faces)
+{
+	ifstream fin(fn.c_str());
+	if(!fin) return false;
+
+	vrts.clear();
+	faces.clear();
+
+	string buf;
+	while(getline(fin, buf)){
+		istringstream line(buf);
+		string key;
+		line >> key;
+		if(key == "v"){
+			Vec3 v;
+			line >> v[0] >> v[1] >> v[2];
+			vrts.push_back(v);
+		}
+		else if(key == "f"){
+			// "i", "i/t", "i//n", "i/t/n"̒_CfbNXg(̒l͖̑)
+			vector<int> idx;
+			string tok;
+			while(line >> tok){
+				int i = atoi(tok.substr(0, tok.find('/')).c_str());
+				idx.push_back(i < 0 ? (int)vrts.size()+i : i-1);
+			}
+			for(int j = 1; j+1 < (int)idx.size(); ++j){
+				rxFace f;
+				f.vert_idx.resize(3);
+				f[0] = idx[0];
+				f[1] = idx[j];
+				f[2] = idx[j+1];
+				faces.push_back(f);
+			}
+		}
+	}
+
+	return !vrts.empty();
+}
+
+
+
 //-----------------------------------------------------------------------------
 // rxSolidPolygon : |S
 //-----------------------------------------------------------------------------
@@ -343,6 +407,8 @@ protected:
 	double m_fMaxRad;
 	rxNNGrid *m_pNNGrid;			//!< ObhɂߖTT
 
+	rxSDFGrid m_SDF;				//!< t(ő̃[JW,t@CɃLbV)
+
 public:
 	// RXgN^ƃfXgN^
 	rxSolidPolygon(const string &fn, Vec3 cen, Vec3 ext, Vec3 ang, double h, int aspect = 1);
@@ -357,10 +423,15 @@ public:
 	virtual bool GetDistance(const Vec3 &pos0, const Vec3 &pos1, rxCollisionInfo &col);
 	virtual bool GetDistanceR(const Vec3 &pos0, const Vec3 &pos1, const double &r, rxCollisionInfo &col);
 
+	virtual void GetDistanceRBatch(const RXREAL *pos, int stride, int n, RXREAL r, RXREAL *pen, RXREAL *cp);
+
 	virtual bool GetCurvature(const Vec3 &pos, double &k);
 	virtual void Draw(int drw);
 	virtual void SetGLMatrix(void);
 
+	// t
+	const rxSDFGrid& GetSDF(void) const { return m_SDF; }
+
 	// Z
 	int  GetPolygonsInCell(int gi, int gj, int gk, set<int> &polys);
 	bool IsPolygonsInCell(int gi, int gj, int gk);
@@ -368,6 +439,8 @@ public:
 protected:
 	int getDistanceToPolygon(Vec3 x, int p, double &dist);
 
+	bool makeSDF(double dx, double band);
+
 	int readFile(const string filename, rxPolygons &polys);
 	void readOBJ(const string filename, rxPolygons &polys);
 
@@ -391,12 +464,12 @@ protected:
 inline Vec3 rxSolid::CalLocalCoord(const Vec3 &pos)
 {
 	// ̍Wő̍Wւƕϊ
-	Vec3 rpos;
-	rpos = pos-m_vMassCenter;
+	Vec3 dpos, rpos;
+	dpos = pos-m_vMassCenter;
 	//m_matRot.multMatrixVec(rpos);
-	rpos[0] = rpos[0]*m_matRot(0,0)+rpos[1]*m_matRot(1,0)+rpos[2]*m_matRot(2,0);
-	rpos[1] = rpos[0]*m_matRot(0,1)+rpos[1]*m_matRot(1,1)+rpos[2]*m_matRot(2,1);
-	rpos[2] = rpos[0]*m_matRot(0,2)+rpos[1]*m_matRot(1,2)+rpos[2]*m_matRot(2,2);
+	rpos[0] = dpos[0]*m_matRot(0,0)+dpos[1]*m_matRot(1,0)+dpos[2]*m_matRot(2,0);
+	rpos[1] = dpos[0]*m_matRot(0,1)+dpos[1]*m_matRot(1,1)+dpos[2]*m_matRot(2,1);
+	rpos[2] = dpos[0]*m_matRot(0,2)+dpos[1]*m_matRot(1,2)+dpos[2]*m_matRot(2,2);
 	return rpos;
 }
 /*!
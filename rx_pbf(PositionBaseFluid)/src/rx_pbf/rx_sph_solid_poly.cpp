@@ -2,7 +2,7 @@
   @file rx_sph_solid_poly.cpp
 	
   @brief SPHpő̒`
-		 |S+A֐(OpenVDBō쐬)
+		 |S+A֐(t,RX_USE_OPENVDB`OpenVDBō쐬)
  
   @author Makoto Fujisawa
   @date 2014-02
@@ -42,8 +42,6 @@
 #include "rx_model.h"
 
 #ifdef RX_USE_OPENVDB
-openvdb::FloatGrid::Ptr g_pGrid = 0;
-
 /*!
  * |S畄t̐
  * @param[in] poly |Sf[^
@@ -101,6 +99,7 @@ rxSolidPolygon::rxSolidPolygon(const string &fn, Vec3 cen, Vec3 ext, Vec3 ang, d
 	m_hVrts = 0; 
 	m_hTris = 0; 
 	m_iNumTris = 0;
+	m_pNNGrid = 0;
 
 	m_iSgn = 1;
 	m_iName = RXS_POLYGON;
@@ -183,6 +182,7 @@ rxSolidPolygon::rxSolidPolygon(const string &fn, Vec3 cen, Vec3 ext, Vec3 ang, d
 	// ZɃ|So^
 	m_pNNGrid->SetPolygonsToCell(m_hVrts, m_iNumVrts, m_hTris, m_iNumTris);
 	
+#ifndef RX_HEADLESS
 	// CgȂǂł̕`pɌő̃IuWFNgbVt@CۑĂ
 	string outfn = RX_DEFAULT_MESH_DIR+"solid_boundary.obj";
 	rxOBJ saver;
@@ -190,12 +190,10 @@ rxSolidPolygon::rxSolidPolygon(const string &fn, Vec3 cen, Vec3 ext, Vec3 ang, d
 	if(saver.Save(outfn, m_Poly.vertices, m_Poly.normals, m_Poly.faces, mtl)){
 		RXCOUT << "saved the mesh to " << outfn << endl;
 	}
-
-#ifdef RX_USE_OPENVDB
-	g_pGrid = 0;
-	openvdb::initialize();
-	g_pGrid = MakeSDF(m_Poly, 0.02);
 #endif
+
+	// t(bVE𑜓x̃LbVΓǂݍ)
+	makeSDF(0.5*h, 2.0*h);
 }
 
 /*!
@@ -226,42 +224,79 @@ bool rxSolidPolygon::GetDistance(const Vec3 &pos0, const Vec3 &pos1, rxCollision
 
 /*!
  * lvZ
+ *  - tő̃[JWŎQƂ̂ŁCSetPositionCSetMatrixŌő̂𓮂Ă蒼ȂĂ悢
  * @param[in] pos O[oWł̈ʒu
  * @param[in] r ̔a
  * @param[out] col Ȃǂ̏(Փˏ)
  */
 bool rxSolidPolygon::GetDistanceR(const Vec3 &pos, const double &r, rxCollisionInfo &col)
 {
-#ifdef RX_USE_OPENVDB
-	if(g_pGrid){
-		openvdb::tools::GridSampler<openvdb::FloatGrid, openvdb::tools::BoxSampler> sampler(*g_pGrid);
-		openvdb::Vec3R ijk(pos[0], pos[1], pos[2]);
-		openvdb::FloatGrid::ValueType v0;
-		v0 = sampler.wsSample(ijk);
-		col.Penetration() = -((RXREAL)(v0)+m_fOffset*2);
-
-		openvdb::FloatGrid::Accessor accessor = g_pGrid->getAccessor();
-		openvdb::Coord nijk;
-		openvdb::Vec3d npos(pos[0], pos[1], pos[2]);
-		npos = g_pGrid->worldToIndex(npos);
-		nijk[0] = int(npos[0]);
-		nijk[1] = int(npos[1]);
-		nijk[2] = int(npos[2]);
-		accessor.getValue(nijk);
-		openvdb::Vec3d nrm = openvdb::math::ISGradient<openvdb::math::CD_2ND>::result(accessor, nijk);
-		double length = nrm.length();
-		if(length > 1.0e-6){
-			nrm *= 1.0/length;
-		}
-		col.Normal() = Vec3(nrm.x(), nrm.y(), nrm.z());
-		return true;
-	}
-	else{
+	if(!m_SDF.IsValid()){
 		return GetDistanceR(pos, pos, r, col);
 	}
-#else
-	return GetDistanceR(pos, pos, r, col);
-#endif
+
+	// ͌ő̃[JWȂ̂ŁCʒu[JɕϊĎQƂCzO[oɖ߂
+	Vec3 g;
+	double d = m_iSgn*m_SDF.GetValueG(CalLocalCoord(pos), g);
+	if(d >= r){
+		return false;
+	}
+
+	Vec3 n = m_iSgn*Unit(CalGlobalCoord(g)-m_vMassCenter);
+	col.Penetration() = d-r;
+	col.Normal() = n;
+	col.Contact() = pos-n*(d-r);
+	col.Velocity() = GetVelocityAtGrobal(pos);
+
+	return true;
+}
+
+/*!
+ * _ł̋lvZ
+ *  - ő̃[JWɕϊ_ɂāCt̃ob`]ł܂Ƃ߂ċlƌz߂
+ * @param[in] pos vZʒu(stridevf)
+ * @param[in] stride 1_̗vf
+ * @param[in] n _
+ * @param[in] r ̔a
+ * @param[out] pen N(0ȉŏՓ,Փ˂ĂȂ_RX_FEQ_INF)
+ * @param[out] cp Փ˓_(3nvf,Փ˂ĂȂ_͌̈ʒu)
+ */
+void rxSolidPolygon::GetDistanceRBatch(const RXREAL *pos, int stride, int n, RXREAL r, RXREAL *pen, RXREAL *cp)
+{
+	if(!m_SDF.IsValid()){
+		rxSolid::GetDistanceRBatch(pos, stride, n, r, pen, cp);
+		return;
+	}
+	if(n <= 0) return;
+
+	// ő̃[JWɕϊĂ狗Q
+	vector<RXREAL> lpos(3*n), grd(3*n);
+	#pragma omp parallel for
+	for(int i = 0; i < n; ++i){
+		const RXREAL *p = pos+stride*i;
+		Vec3 lp = CalLocalCoord(Vec3(p[0], p[1], p[2]));
+		for(int k = 0; k < 3; ++k) lpos[3*i+k] = (RXREAL)lp[k];
+	}
+	m_SDF.GetValueGBatch(&lpos[0], 3, n, pen, &grd[0]);
+
+	#pragma omp parallel for
+	for(int i = 0; i < n; ++i){
+		const RXREAL *p = pos+stride*i;
+		RXREAL d = m_iSgn*pen[i];
+		if(d < r){
+			// zO[oWɖ߂
+			Vec3 gg = CalGlobalCoord(Vec3(grd[3*i+0], grd[3*i+1], grd[3*i+2]))-m_vMassCenter;
+			RXREAL g[3] = {(RXREAL)gg[0], (RXREAL)gg[1], (RXREAL)gg[2]};
+			RXREAL l = sqrt(g[0]*g[0]+g[1]*g[1]+g[2]*g[2]);
+			RXREAL s = (l > (RXREAL)RX_FEQ_EPS ? m_iSgn/l : (RXREAL)0);
+			pen[i] = d-r;
+			for(int k = 0; k < 3; ++k) cp[3*i+k] = p[k]-s*g[k]*(d-r);
+		}
+		else{
+			pen[i] = (RXREAL)RX_FEQ_INF;
+			for(int k = 0; k < 3; ++k) cp[3*i+k] = p[k];
+		}
+	}
 }
 
 /*!
@@ -317,6 +352,67 @@ bool rxSolidPolygon::GetDistanceR(const Vec3 &pos0, const Vec3 &pos1, const doub
 }
 
 
+/*!
+ * t̐ݒ
+ *  - ͌ő̃[JW(dS_C\z̎p)ō
+ *  - bVƉ𑜓xvZnbVlt@CɂRX_DEFAULT_SDF_DIRɃLbV
+ *  - LbVȂ΍\zĕۑ(RX_USE_OPENVDB`OpenVDB̋TvO)
+ * @param[in] dx Obh
+ * @param[in] band vZт̕
+ * @return ꂪݒłtrue
+ */
+bool rxSolidPolygon::makeSDF(double dx, double band)
+{
+	if(!m_iNumTris || dx <= 0.0) return false;
+	if(band < 2.0*dx) band = 2.0*dx;
+
+	// ő̃[JWł̒_(̓[JWŎCő̂Ă蒼Ȃ)
+	vector<RXREAL> lvrts(3*m_iNumVrts);
+	for(int i = 0; i < m_iNumVrts; ++i){
+		Vec3 lp = CalLocalCoord(Vec3(m_hVrts[3*i+0], m_hVrts[3*i+1], m_hVrts[3*i+2]));
+		for(int k = 0; k < 3; ++k) lvrts[3*i+k] = (RXREAL)lp[k];
+	}
+
+	unsigned long long hash = rxSDFGrid::CalHash(&lvrts[0], m_iNumVrts, m_hTris, m_iNumTris, dx, band);
+	string fn = rxSDFGrid::GetCacheFileName(RX_DEFAULT_SDF_DIR, hash);
+	if(m_SDF.Load(fn, hash)){
+		RXCOUT << "loaded the sdf from " << fn << endl;
+		return true;
+	}
+
+#ifdef RX_USE_OPENVDB
+	openvdb::initialize();
+	openvdb::FloatGrid::Ptr grid = MakeSDF(m_Poly, dx);
+	openvdb::tools::GridSampler<openvdb::FloatGrid, openvdb::tools::BoxSampler> sampler(*grid);
+
+	m_SDF.Allocate(m_vMin-Vec3(band+dx), m_vMax+Vec3(band+dx), dx, band);
+	m_SDF.SetHash(hash);
+	int n[3];
+	m_SDF.GetN(n);
+	#pragma omp parallel for
+	for(int k = 0; k < n[2]; ++k){
+		for(int j = 0; j < n[1]; ++j){
+			for(int i = 0; i < n[0]; ++i){
+				Vec3 p = CalGlobalCoord(m_SDF.GetNodePos(i, j, k));	// OpenVDB̃Obh͍\z̈ʒu
+				float v = sampler.wsSample(openvdb::Vec3R(p[0], p[1], p[2]));
+				m_SDF.SetNodeValue(i, j, k, RX_CLAMP(v, (float)-band, (float)band));
+			}
+		}
+	}
+#else
+	if(!m_SDF.Build(&lvrts[0], m_iNumVrts, m_hTris, m_iNumTris, dx, band)){
+		return false;
+	}
+#endif
+
+	MkDir(RX_DEFAULT_SDF_DIR);
+	if(m_SDF.Save(fn)){
+		RXCOUT << "saved the sdf to " << fn << endl;
+	}
+
+	return true;
+}
+
 /*!
  * |Sʂ܂ł̋vZ
  * @param[in] x vZW
@@ -349,8 +445,10 @@ bool rxSolidPolygon::GetCurvature(const Vec3 &pos, double &k)
  */
 void rxSolidPolygon::SetGLMatrix(void)
 {
+#ifndef RX_HEADLESS
 	glTranslatef(m_vMassCenter[0], m_vMassCenter[1], m_vMassCenter[2]);
 	glMultMatrixd(m_matRot.GetValue());
+#endif
 }
 
 /*!
@@ -359,6 +457,7 @@ void rxSolidPolygon::SetGLMatrix(void)
  */
 void rxSolidPolygon::Draw(int drw)
 {
+#ifndef RX_HEADLESS
 	glPushMatrix();
 
 	//SetGLMatrix();
@@ -369,6 +468,7 @@ void rxSolidPolygon::Draw(int drw)
 	m_Poly.Draw(drw & 14);
 
 	glPopMatrix();
+#endif
 }
 
 /*!
@@ -406,8 +506,13 @@ void rxSolidPolygon::readOBJ(const string filename, rxPolygons &polys)
 		polys.faces.clear();
 		polys.materials.clear();
 	}
+#ifdef RX_HEADLESS
+	// wbhXłrxOBJ(rx_model.lib)NȂ̂Œ_Ɩʂǂ
+	if(RxReadOBJMesh(filename, polys.vertices, polys.faces)){
+#else
 	rxOBJ obj;
 	if(obj.Read(filename, polys.vertices, polys.normals, polys.faces, polys.materials, true)){
+#endif
 		RXCOUT << filename << " have been read." << endl;
 
 		RXCOUT << " the number of vertex   : " << polys.vertices.size() << endl;
@@ -466,7 +571,6 @@ bool rxSolidPolygon::fitVertices(const Vec3 &ctr, const Vec3 &sl, vector<Vec3> &
 	
 	if(aspect){
 		int max_axis = ( ( (sl0[0] > sl0[1]) && (sl0[0] > sl0[2]) ) ? 0 : ( (sl0[1] > sl0[2]) ? 1 : 2 ) );
-		int min_axis = ( ( (sl0[0] < sl0[1]) && (sl0[0] < sl0[2]) ) ? 0 : ( (sl0[1] < sl0[2]) ? 1 : 2 ) );
 		size_conv = Vec3(sl[max_axis]/sl0[max_axis]);
 	}
 	else{
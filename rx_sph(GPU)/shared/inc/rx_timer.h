@@ -68,9 +68,16 @@
 #endif
 
 #else
-	#define RXTIME clock_t
-	inline RXTIME RX_GET_TIME(void){ return clock(); }
-	inline double RX_GET_TIME2SEC(void){ return (1.0/CLOCKS_PER_SEC); }
+	// clock()̓vZXCPUԂԂ̂ŁCOpenMPŕ񉻂ł͌oߎԂɂȂȂD
+	// PNbN(CLOCK_MONOTONIC)imbPʂŗpD
+	#define RXTIME long long
+	inline RXTIME RX_GET_TIME(void)
+	{
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return (RXTIME)t.tv_sec*1000000000LL+t.tv_nsec;
+	}
+	inline double RX_GET_TIME2SEC(void){ return 1.0e-9; }
 #endif
  
 
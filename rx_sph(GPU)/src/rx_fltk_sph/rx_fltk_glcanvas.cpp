@@ -262,6 +262,13 @@ rxFlGLWindow::~rxFlGLWindow()
 	if(m_uNrmVBO) glDeleteBuffers(1, &m_uNrmVBO);
 
 	if(m_pPS) delete m_pPS;
+
+	// vt@Cʂ̏o
+	rxProfiler &prof = rxProfiler::Get();
+	if(prof.IsEnabled() && prof.GetNumSteps()){
+		prof.WriteChromeTrace(RX_DEFAULT_RESULT_DIR+"profile_trace.json");
+		prof.WriteCSV(RX_DEFAULT_RESULT_DIR+"profile.csv");
+	}
 }
 
 
@@ -771,7 +778,9 @@ void rxFlGLWindow::Idle(void)
 	}
 	else{
 		RXTIMER_RESET;
+		rxProfiler::Get().BeginStep(m_iCurrentStep);
 		StepPS(m_fDt);
+		rxProfiler::Get().EndStep();
 	}
 
 
@@ -789,6 +798,7 @@ void rxFlGLWindow::Idle(void)
 	// ̕\ʃbV
 	//
 	if(m_bsSimuSetting.at(ID_SPH_MESH)){
+		RXPROF_ZONE("surface mesh");
 		CalMeshSPH(m_iMeshMaxN, m_fMeshThr);
 	}
 	RXTIMER("mesh mc");
@@ -1437,8 +1447,6 @@ void rxFlGLWindow::SetMeshCreation(void)
  */
 bool rxFlGLWindow::calMeshSPH_CPU(int nmax, double thr)
 {
-	m_pPS->SetParticlesToCell();
-
 	Vec3 minp = m_pPS->GetMin();
 	Vec3 maxp = m_pPS->GetMax();
 
@@ -1460,8 +1468,13 @@ bool rxFlGLWindow::calMeshSPH_CPU(int nmax, double thr)
 		m_pMCMeshCPU = new rxMCMeshCPU;
 	}
 
-	// HACK:calMeshSPH_CPU
-	//m_pMCMeshCPU->CreateMesh(GetImplicitSPH, minp, h, n, thr, m_Poly.vertices, m_Poly.normals, m_Poly.faces);
+	// p[eBNObh_̉A֐lvZ(Obh_̓Z+1)
+	int nv[3] = {n[0]+1, n[1]+1, n[2]+1};
+	vector<RXREAL> field(nv[0]*nv[1]*nv[2]);
+	m_pPS->CalImplicitField(nv, minp, Vec3(h), &field[0]);
+
+	// bV
+	m_pMCMeshCPU->CreateMeshV(&field[0], minp, h, n, thr, m_Poly.vertices, m_Poly.normals, m_Poly.faces);
 
 	m_iNumVrts = (int)m_Poly.vertices.size();
 	m_iNumTris = (int)m_Poly.faces.size();
@@ -1563,6 +1576,7 @@ void rxFlGLWindow::InitSPH(rxSPHConfig &sph_scene)
 		if(sph_scene.LoadSpaceFromFile()){
 			rxSPHEnviroment sph_env = sph_scene.GetSphEnv();
 			((RXSPH*)m_pPS)->Initialize(sph_env);
+			rxProfiler::Get().Enable(sph_env.profile != 0);
 
 			m_fDt = sph_env.dt;
 			m_iVertexStore = sph_env.mesh_vertex_store;
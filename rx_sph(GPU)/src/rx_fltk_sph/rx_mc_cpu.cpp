@@ -17,6 +17,7 @@
 #include <math.h>
 #include "rx_mc.h"
 #include "rx_mc_tables.h"
+#include "rx_profiler.h"
 
 
 
@@ -257,6 +258,7 @@ bool CalMeshImplicitCPU(RXREAL (*func)(double, double, double), Vec3 min_p, doub
 bool rxMCMeshCPU::CreateMeshV(RXREAL *field, Vec3 min_p, double h, int n[3], RXREAL threshold, 
 								  vector<Vec3> &vrts, vector<Vec3> &nrms, vector<rxFace> &face)
 {
+	RXPROF_ZONE("marching cubes");
 	if(field == NULL) return false;
 
 	RxScalarField sf;
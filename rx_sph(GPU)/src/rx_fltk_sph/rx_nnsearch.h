@@ -19,6 +19,10 @@
 #include <GL/glut.h>
 #include "rx_pcube.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 using namespace std;
 
@@ -60,6 +64,49 @@ struct rxNeigh
 };
 
 
+//-----------------------------------------------------------------------------
+//! Sp[eBN̋ߖTXg(CSR`)
+//  - ep[eBN̋ߖT1̘Azɂ܂Ƃ߂Ċi[
+//  - č\z͊mۍς݂̃̂܂܍ėp
+//-----------------------------------------------------------------------------
+struct rxNeighList
+{
+	vector<uint> Offset;				//!< ep[eBN̋ߖT̊Jnʒu(p[eBN+1)
+	vector<rxNeigh> Neighs;				//!< Sp[eBN̋ߖT
+	vector< vector<rxNeigh> > Buf;		//!< \z̕ubNƂ̈ꎞobt@
+
+	//! p[eBN
+	int Size(void) const { return Offset.empty() ? 0 : (int)Offset.size()-1; }
+
+	//! p[eBNi̋ߖT
+	int Num(int i) const { return (int)(Offset[i+1]-Offset[i]); }
+
+	//! p[eBNi̋ߖT̐擪ƏI[
+	rxNeigh* Begin(int i){ return Neighs.empty() ? 0 : &Neighs[0]+Offset[i]; }
+	rxNeigh* End(int i){ return Neighs.empty() ? 0 : &Neighs[0]+Offset[i+1]; }
+	const rxNeigh* Begin(int i) const { return Neighs.empty() ? 0 : &Neighs[0]+Offset[i]; }
+	const rxNeigh* End(int i) const { return Neighs.empty() ? 0 : &Neighs[0]+Offset[i+1]; }
+
+	//! p[eBNijԖڂ̋ߖT
+	rxNeigh& At(int i, int j){ return Neighs[Offset[i]+j]; }
+
+	//! ߖT̃NA(͉Ȃ)
+	void Clear(void)
+	{
+		Offset.assign(1, 0);
+		Neighs.clear();
+	}
+
+	//! mۍς݃܂߂ĉ
+	void Release(void)
+	{
+		vector<uint>().swap(Offset);
+		vector<rxNeigh>().swap(Neighs);
+		vector< vector<rxNeigh> >().swap(Buf);
+	}
+};
+
+
 //-----------------------------------------------------------------------------
 //! rxNNGridNX - Obh@ɂߖTT(3D)
 //-----------------------------------------------------------------------------
@@ -136,6 +183,7 @@ public:
 	// ߖT擾
 	void GetNN_Direct(Vec3 pos, RXREAL *p, uint n, vector<rxNeigh> &neighs, RXREAL h = -1.0);
 	void GetNN(Vec3 pos, RXREAL *p, uint n, vector<rxNeigh> &neighs, RXREAL h = -1.0);
+	void GetNNList(RXREAL *p, uint n, rxNeighList &nl, RXREAL h = -1.0);
 
 	// Z̃|S擾
 	int  GetPolygonsInCell(uint grid_hash, vector<int> &polys);
@@ -150,6 +198,9 @@ public:
 	uint CalGridHash(int x, int y, int z);
 	uint CalGridHash(Vec3 pos);
 
+	// Z͈̔
+	void CalCellBounds(uint grid_hash, Vec3 &minp, Vec3 &maxp);
+
 protected:
 	// ZߖTp[eBN擾
 	void getNeighborsInCell(Vec3 pos, RXREAL *p, int gi, int gj, int gk, vector<rxNeigh> &neighs, RXREAL h);
@@ -470,6 +521,69 @@ inline void rxNNGrid::GetNN(Vec3 pos, RXREAL *p, uint n, vector<rxNeigh> &neighs
 }
 
 
+/*!
+ * Sp[eBN̋ߖTqT
+ *  - p[eBNAubNɕĕɒTCʂCSR`̋ߖTXgɂ܂Ƃ߂
+ *  - ߖT̊i[̓p[eBNƂ GetNN Ɠ
+ * @param[in] p p[eBNʒu
+ * @param[in] n p[eBN
+ * @param[out] nl ߖTXg
+ * @param[in] h La
+ */
+inline void rxNNGrid::GetNNList(RXREAL *p, uint n, rxNeighList &nl, RXREAL h)
+{
+	nl.Offset.resize(n+1);
+	nl.Offset[0] = 0;
+	if(n == 0){
+		nl.Neighs.clear();
+		return;
+	}
+
+	// ubN(Xbh̐{ɂĕׂ𕪎U)
+	int nb = 1;
+#ifdef _OPENMP
+	nb = 4*omp_get_max_threads();
+#endif
+	if(nb > (int)n) nb = (int)n;
+	if((int)nl.Buf.size() < nb) nl.Buf.resize(nb);
+
+	// ubNƂɋߖTTCp[eBNi̋ߖTOffset[i+1]ɈꎞIɊi[
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int b = 0; b < nb; ++b){
+		int start = (int)(((long long)n*b)/nb);
+		int end   = (int)(((long long)n*(b+1))/nb);
+
+		vector<rxNeigh> &buf = nl.Buf[b];
+		buf.clear();
+		for(int i = start; i < end; ++i){
+			Vec3 pos;
+			pos[0] = p[m_iDim*i+0];
+			pos[1] = p[m_iDim*i+1];
+			pos[2] = p[m_iDim*i+2];
+
+			uint prev = (uint)buf.size();
+			GetNN(pos, p, n, buf, h);
+			nl.Offset[i+1] = (uint)buf.size()-prev;
+		}
+	}
+
+	// ߖT̗ݐϘaŊep[eBN̊Jnʒu߂
+	for(uint i = 0; i < n; ++i){
+		nl.Offset[i+1] += nl.Offset[i];
+	}
+	nl.Neighs.resize(nl.Offset[n]);
+
+	// ubNƂ̃obt@AzɃRs[
+	#pragma omp parallel for
+	for(int b = 0; b < nb; ++b){
+		int start = (int)(((long long)n*b)/nb);
+		const vector<rxNeigh> &buf = nl.Buf[b];
+		if(!buf.empty()){
+			memcpy(&nl.Neighs[nl.Offset[start]], &buf[0], buf.size()*sizeof(rxNeigh));
+		}
+	}
+}
+
 /*!
  * Z̗qߖTo
  * @param[in] pos TS
@@ -592,6 +706,24 @@ inline uint rxNNGrid::CalGridHash(Vec3 pos)
 	return CalGridHash(x, y, z);
 }
 
+/*!
+ * Z͈̔͂̌vZ
+ *  - [̃Zɂ͔͈͊Öʒu܂Ƃ߂(CalGridHashŃNv)̂ŁCOɂ͖ɍL
+ * @param[in] grid_hash ObhnbVl
+ * @param[out] minp,maxp Z̍ŏEőW
+ */
+inline void rxNNGrid::CalCellBounds(uint grid_hash, Vec3 &minp, Vec3 &maxp)
+{
+	int g[3];
+	g[0] = grid_hash%m_iGridSize[0];
+	g[1] = (grid_hash/m_iGridSize[0])%m_iGridSize[1];
+	g[2] = grid_hash/(m_iGridSize[0]*m_iGridSize[1]);
+	for(int k = 0; k < 3; ++k){
+		minp[k] = (g[k] == 0 ? -RX_FEQ_INF : m_v3EnvMin[k]+g[k]*m_fCellWidth[k]);
+		maxp[k] = (g[k] == m_iGridSize[k]-1 ? RX_FEQ_INF : m_v3EnvMin[k]+(g[k]+1)*m_fCellWidth[k]);
+	}
+}
+
 
 //-----------------------------------------------------------------------------
 // OpenGL`
@@ -313,7 +313,7 @@ int rxParticleSystemBase::addParticles(int &start, rxInletLine line, int attr)
 			}
 
 			for(int k = 0; k < 3; ++k){
-				m_hPos[DIM*index+k] = line.pos1[k]+rel[k]/l*(i+0.5)*spacing+(RX_FRAND()*2.0f-1.0f)*jitter;
+				m_hPos[DIM*index+k] = line.pos1[k]+rel[k]/l*(i+0.5)*spacing+(frand()*2.0f-1.0f)*jitter;
 				m_hVel[DIM*index+k] = line.vel[k];
 			}
 			if(DIM == 4){
@@ -415,6 +415,7 @@ RXREAL rxParticleSystemBase::SetColorVBOFromArray(RXREAL *hVal, int d, bool use_
  */
 int rxParticleSystemBase::OutputParticles(string fn)
 {
+	RXPROF_ZONE("output particles");
 	ofstream fout;
 	fout.open(fn.c_str(), ios::out|ios::binary);
 	if(!fout){
@@ -449,6 +450,7 @@ int rxParticleSystemBase::OutputParticles(string fn)
  */
 int rxParticleSystemBase::InputParticles(string fn)
 {
+	RXPROF_ZONE("input particles");
 	ifstream fin;
 	fin.open(fn.c_str(), ios::in|ios::binary);
 	if(!fin){
@@ -477,3 +479,155 @@ int rxParticleSystemBase::InputParticles(string fn)
 	
 	return 1;
 }
+
+
+/*!
+ * `FbN|Cg̕ۑ
+ *  - p[eBN̈ʒuExECCƗ̏ԁCƃXebvoCiŏoC
+ *    hNX̏ԂwriteCheckpointŒǉ
+ *  - V[̐ÓIȐݒ(Ě`CQ̎ނƑ傫C|S)͊܂܂Ȃ̂ŁC
+ *    ĊJ͓V[ݒ肵ĂLoadCheckpointĂ
+ * @param[in] fn o̓t@C
+ * @param[in] step ݂̃Xebv
+ * @return ۑłtrue
+ */
+bool rxParticleSystemBase::SaveCheckpoint(const string &fn, int step)
+{
+	RXPROF_ZONE("save checkpoint");
+	ofstream fout;
+	fout.open(fn.c_str(), ios::out|ios::binary);
+	if(!fout){
+		RXCOUT << fn << " couldn't open." << endl;
+		return false;
+	}
+
+	uint n = m_uNumParticles;
+
+	fout.write("RXCP", 4);
+	WriteBinary(fout, RX_CHECKPOINT_VERSION);
+	WriteBinary(fout, (uint)DIM);
+	WriteBinary(fout, (uint)sizeof(RXREAL));
+	WriteBinary(fout, m_uMaxParticles);
+	WriteBinary(fout, n);
+	WriteBinary(fout, m_fTime);
+	WriteBinary(fout, step);
+
+	// C
+	WriteBinary(fout, m_iInletStart);
+	WriteBinary(fout, m_uRandState);
+	WriteBinary(fout, (uint)m_vInletLines.size());
+	for(int i = 0; i < (int)m_vInletLines.size(); ++i){
+		const rxInletLine &l = m_vInletLines[i];
+		WriteBinaryArray(fout, l.pos1.data, 3);
+		WriteBinaryArray(fout, l.pos2.data, 3);
+		WriteBinaryArray(fout, l.vel.data, 3);
+		WriteBinaryArray(fout, l.up.data, 3);
+		WriteBinary(fout, l.accum);
+		WriteBinary(fout, l.span);
+		WriteBinary(fout, l.spacing);
+	}
+
+	// p[eBN
+	m_hPos = GetArrayVBO(RX_POSITION);
+	m_hVel = GetArrayVBO(RX_VELOCITY);
+	WriteBinaryArray(fout, m_hPos, (size_t)DIM*n);
+	WriteBinaryArray(fout, m_hVel, (size_t)DIM*n);
+	WriteBinary(fout, (int)(m_hAttr ? 1 : 0));
+	if(m_hAttr) WriteBinaryArray(fout, m_hAttr, (size_t)n);
+
+	// hNX̏
+	if(!writeCheckpoint(fout)){
+		RXCOUT << fn << " : couldn't save the solver state." << endl;
+		return false;
+	}
+
+	fout.write("RXCP", 4);
+	fout.close();
+
+	RXCOUT << "saved the checkpoint to " << fn << " (step " << step << ")" << endl;
+
+	return true;
+}
+
+/*!
+ * `FbN|Cg̍ĊJ
+ *  - InitializeƓV[̐ݒsɌĂ
+ * @param[in] fn `FbN|Cgt@C
+ * @param[out] step ۑ̃Xebv(Updateɓnl)
+ * @return ǂݍ߂true
+ */
+bool rxParticleSystemBase::LoadCheckpoint(const string &fn, int &step)
+{
+	RXPROF_ZONE("load checkpoint");
+	ifstream fin;
+	fin.open(fn.c_str(), ios::in|ios::binary);
+	if(!fin){
+		RXCOUT << fn << " couldn't find." << endl;
+		return false;
+	}
+
+	char magic[4];
+	fin.read(magic, 4);
+	if(strncmp(magic, "RXCP", 4) != 0 || ReadBinary<uint>(fin) != RX_CHECKPOINT_VERSION){
+		RXCOUT << fn << " is not a checkpoint file." << endl;
+		return false;
+	}
+	if(ReadBinary<uint>(fin) != (uint)DIM || ReadBinary<uint>(fin) != (uint)sizeof(RXREAL)){
+		RXCOUT << fn << " : the data type is different from the current build." << endl;
+		return false;
+	}
+
+	uint maxp = ReadBinary<uint>(fin);
+	uint n = ReadBinary<uint>(fin);
+	if(n > m_uMaxParticles || maxp > m_uMaxParticles){
+		RXCOUT << fn << " : the max. number of particles (" << maxp << ") exceeds the current setting (" << m_uMaxParticles << ")." << endl;
+		return false;
+	}
+	m_fTime = ReadBinary<RXREAL>(fin);
+	step = ReadBinary<int>(fin);
+
+	// C
+	m_iInletStart = ReadBinary<int>(fin);
+	m_uRandState = ReadBinary<unsigned long long>(fin);
+	m_vInletLines.resize(ReadBinary<uint>(fin));
+	for(int i = 0; i < (int)m_vInletLines.size(); ++i){
+		rxInletLine &l = m_vInletLines[i];
+		ReadBinaryArray(fin, l.pos1.data, 3);
+		ReadBinaryArray(fin, l.pos2.data, 3);
+		ReadBinaryArray(fin, l.vel.data, 3);
+		ReadBinaryArray(fin, l.up.data, 3);
+		l.accum = ReadBinary<int>(fin);
+		l.span = ReadBinary<int>(fin);
+		l.spacing = ReadBinary<double>(fin);
+	}
+
+	// p[eBN
+	m_uNumParticles = n;
+	ReadBinaryArray(fin, m_hPos, (size_t)DIM*n);
+	ReadBinaryArray(fin, m_hVel, (size_t)DIM*n);
+	if(ReadBinary<int>(fin)){
+		if(!m_hAttr) return false;
+		ReadBinaryArray(fin, m_hAttr, (size_t)n);
+	}
+
+	// hNX̏
+	if(!fin || !readCheckpoint(fin)){
+		RXCOUT << fn << " : couldn't restore the solver state." << endl;
+		return false;
+	}
+
+	fin.read(magic, 4);
+	if(!fin || strncmp(magic, "RXCP", 4) != 0){
+		RXCOUT << fn << " is broken." << endl;
+		return false;
+	}
+	fin.close();
+
+	SetArrayVBO(RX_POSITION, m_hPos, 0, m_uNumParticles);
+	SetArrayVBO(RX_VELOCITY, m_hVel, 0, m_uNumParticles);
+	SetColorVBO(m_iColorType);
+
+	RXCOUT << "restored the checkpoint from " << fn << " (step " << step << ", " << n << " particles)" << endl;
+
+	return true;
+}
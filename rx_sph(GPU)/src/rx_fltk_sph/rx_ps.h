@@ -21,6 +21,8 @@
 
 #include "rx_sph_solid.h"
 
+#include "rx_mesh.h"	// ReadBinary
+
 //#include <helper_functions.h>
 
 
@@ -31,6 +33,30 @@
 const int DIM = 4;
 const int RX_MAX_STEPS = 100000;
 
+const uint RX_CHECKPOINT_VERSION = 1;
+
+
+//-----------------------------------------------------------------------------
+// oCio(`FbN|Cgp,ǂݍ݂rx_mesh.hReadBinaryg)
+//-----------------------------------------------------------------------------
+template<class T> 
+inline void WriteBinary(ofstream &file, const T &data)
+{
+	file.write((const char*)&data, sizeof(T));
+}
+
+template<class T> 
+inline void WriteBinaryArray(ofstream &file, const T *data, size_t n)
+{
+	if(n && data) file.write((const char*)data, n*sizeof(T));
+}
+
+template<class T> 
+inline void ReadBinaryArray(ifstream &file, T *data, size_t n)
+{
+	if(n && data) file.read((char*)data, n*sizeof(T));
+}
+
 
 //-----------------------------------------------------------------------------
 // p[eBNC
@@ -126,6 +152,7 @@ protected:
 
 	vector<rxInletLine> m_vInletLines;	//!< C
 	int m_iInletStart;		//!< p[eBNǉJnCfbNX
+	unsigned long long m_uRandState;	//!< p[eBN̈ʒu̗h炬p̏(`FbN|Cgɕۑ)
 
 
 protected:
@@ -149,6 +176,7 @@ public:
 		m_bCalAnisotropic = false;
 		m_iInletStart = -1;
 		m_fTmpMax = 1.0;
+		SetRandomSeed(0);
 	}
 
 	//! fXgN^
@@ -175,6 +203,9 @@ public:
 	void SetDamping(RXREAL x){ m_fDamping = x; }	//!< ő̋Eł̔
 	void SetGravity(RXREAL x){ m_v3Gravity = Vec3(0.0, x, 0.0); }	//!< d
 
+	//! p[eBNp̎
+	void SetRandomSeed(uint seed){ m_uRandState = 0x9E3779B97F4A7C15ULL^(unsigned long long)seed; }
+
 	// p[eBNVBO
 	unsigned int GetCurrentReadBuffer() const { return m_posVBO; }
 	unsigned int GetColorBuffer()	   const { return m_colorVBO; }
@@ -245,9 +276,29 @@ public:
 	int OutputParticles(string fn);
 	int InputParticles(string fn);
 
+	// `FbN|Cg(vZ̒fƍĊJ)
+	bool SaveCheckpoint(const string &fn, int step);
+	bool LoadCheckpoint(const string &fn, int &step);
+
 protected:
+	// hNX̃V~[VԂ̓o(SaveCheckpoint/LoadCheckpointĂ΂)
+	virtual bool writeCheckpoint(ofstream &fout){ return true; }
+	virtual bool readCheckpoint(ifstream &fin){ return true; }
+
 	int  addParticles(int &start, rxInletLine line, int attr = 0);
 
+	/*!
+	 * [0,1]̈l(xorshift64*)
+	 *  - rand()ƈďԂ\o̂ŁC`FbN|CgĊJĂɂȂ
+	 */
+	double frand(void)
+	{
+		m_uRandState ^= m_uRandState >> 12;
+		m_uRandState ^= m_uRandState << 25;
+		m_uRandState ^= m_uRandState >> 27;
+		return (double)((m_uRandState*0x2545F4914F6CDD1DULL) >> 11)/(double)((1ULL << 53)-1);
+	}
+
 	uint createVBO(uint size)
 	{
 		GLuint vbo;
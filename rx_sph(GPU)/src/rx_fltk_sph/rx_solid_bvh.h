@@ -0,0 +1,264 @@
+/*!
+  @file rx_solid_bvh.h
+
+  @brief ő̃IuWFNg̃oEfBO{[Kw(BVH)
+		 - eő̂GetMin/GetMax(pɂ]l)AABBƂ񕪖
+		 - ő̂ǉE폜ꂽƂ\zCړƂ͖؂̌`ۂ܂AABBXV(refit)
+		 - Փ˔ŁCp[eBN(܂ޕZ)ƏdȂő̂o߂Ɏg
+
+  @date   2026-10
+*/
+
+
+#ifndef _RX_SOLID_BVH_H_
+#define _RX_SOLID_BVH_H_
+
+
+//-----------------------------------------------------------------------------
+// CN[ht@C
+//-----------------------------------------------------------------------------
+// STL
+#include <vector>
+#include <algorithm>
+
+#include "rx_sph_solid.h"
+
+
+//-----------------------------------------------------------------------------
+// `
+//-----------------------------------------------------------------------------
+using namespace std;
+
+//! tm[hɊi[őő̐
+const int RX_BVH_LEAF_SIZE = 2;
+
+
+//-----------------------------------------------------------------------------
+// ő̃IuWFNgBVH
+//-----------------------------------------------------------------------------
+class rxSolidBVH
+{
+	//! BVHm[h(num > 0Ȃtm[hŁCm_vIdx[start]`[start+num-1]̌ő̂)
+	struct rxBVHNode
+	{
+		Vec3 minp, maxp;
+		int left, right;
+		int start, num;
+	};
+
+protected:
+	vector<rxBVHNode> m_vNodes;				//!< m[h(em[h͎qm[hOɕ)
+	vector<int> m_vIdx;						//!< tm[h̏ɕׂő̂̃CfbNX
+	vector<rxSolid*> m_vSolids;				//!< ő̃IuWFNg
+	vector<Vec3> m_vMin, m_vMax;			//!< eő̂AABB
+
+public:
+	rxSolidBVH(){}
+
+	int GetNumSolids(void) const { return (int)m_vSolids.size(); }
+	const vector<rxSolid*>& GetSolids(void) const { return m_vSolids; }
+	int GetNumNodes(void) const { return (int)m_vNodes.size(); }
+
+	/*!
+	 * BVH̍\z
+	 *  - őAABB̒S̕тōłɒl2Ă
+	 * @param[in] solids ő̃IuWFNg
+	 */
+	void Build(const vector<rxSolid*> &solids)
+	{
+		int n = (int)solids.size();
+		m_vSolids = solids;
+		m_vMin.resize(n);
+		m_vMax.resize(n);
+		m_vIdx.resize(n);
+		m_vNodes.clear();
+		for(int i = 0; i < n; ++i){
+			CalSolidBounds(m_vSolids[i], m_vMin[i], m_vMax[i]);
+			m_vIdx[i] = i;
+		}
+		if(n){
+			m_vNodes.reserve(2*n);
+			buildNode(0, n);
+		}
+	}
+
+	/*!
+	 * ő̂̈ړɍ킹AABBXV(؂̌`͕ςȂ)
+	 * @return AABBωő̂true
+	 */
+	bool Refit(void)
+	{
+		bool moved = false;
+		for(int i = 0; i < (int)m_vSolids.size(); ++i){
+			Vec3 minp, maxp;
+			CalSolidBounds(m_vSolids[i], minp, maxp);
+			if(!(minp == m_vMin[i]) || !(maxp == m_vMax[i])){
+				m_vMin[i] = minp;
+				m_vMax[i] = maxp;
+				moved = true;
+			}
+		}
+		if(!moved) return false;
+
+		// qm[h͐em[hɂ̂ŁC납珇ɍXV
+		for(int i = (int)m_vNodes.size()-1; i >= 0; --i){
+			rxBVHNode &nd = m_vNodes[i];
+			if(nd.num){
+				calLeafBounds(nd);
+			}
+			else{
+				const rxBVHNode &l = m_vNodes[nd.left];
+				const rxBVHNode &r = m_vNodes[nd.right];
+				for(int k = 0; k < 3; ++k){
+					nd.minp[k] = RX_MIN(l.minp[k], r.minp[k]);
+					nd.maxp[k] = RX_MAX(l.maxp[k], r.maxp[k]);
+				}
+			}
+		}
+		return true;
+	}
+
+	/*!
+	 * AABBƏdȂő̂̒T
+	 * @param[in] minp,maxp TAABB
+	 * @param[out] solids dȂő̂̃CfbNX(ǉĂ)
+	 * @return ő̐
+	 */
+	int Query(const Vec3 &minp, const Vec3 &maxp, vector<int> &solids) const
+	{
+		if(m_vNodes.empty()) return 0;
+
+		int cnt = 0;
+		int stack[64];
+		int sp = 0;
+		stack[sp++] = 0;
+		while(sp){
+			const rxBVHNode &nd = m_vNodes[stack[--sp]];
+			if(!overlap(nd.minp, nd.maxp, minp, maxp)) continue;
+
+			if(nd.num){
+				for(int j = nd.start; j < nd.start+nd.num; ++j){
+					int s = m_vIdx[j];
+					if(overlap(m_vMin[s], m_vMax[s], minp, maxp)){
+						solids.push_back(s);
+						cnt++;
+					}
+				}
+			}
+			else{
+				stack[sp++] = nd.left;
+				stack[sp++] = nd.right;
+			}
+		}
+		return cnt;
+	}
+
+	/*!
+	 * ő̂AABB(psɂ]܂)
+	 *  - GetMin/GetMax͉]lĂȂ̂ŁCdS̔as̐ΒlŕϊčL
+	 *    (s̍sEǂ̌ŎgĂ܂ނ悤ɗ̑傫Ƃ)
+	 * @param[in] s ő̃IuWFNg
+	 * @param[out] minp,maxp AABB
+	 */
+	static void CalSolidBounds(rxSolid *s, Vec3 &minp, Vec3 &maxp)
+	{
+		Vec3 c = s->GetPosition();
+		Vec3 smin = s->GetMin(), smax = s->GetMax();
+		Vec3 e;
+		for(int k = 0; k < 3; ++k){
+			e[k] = RX_MAX(fabs(smin[k]-c[k]), fabs(smax[k]-c[k]));
+		}
+
+		rxMatrix4 m = s->GetMatrix();
+		for(int k = 0; k < 3; ++k){
+			double er = 0.0, ec = 0.0;
+			for(int l = 0; l < 3; ++l){
+				er += fabs(m(k, l))*e[l];
+				ec += fabs(m(l, k))*e[l];
+			}
+			double r = RX_MAX(er, ec);
+			minp[k] = c[k]-r;
+			maxp[k] = c[k]+r;
+		}
+	}
+
+protected:
+	static bool overlap(const Vec3 &amin, const Vec3 &amax, const Vec3 &bmin, const Vec3 &bmax)
+	{
+		return (amin[0] <= bmax[0] && amax[0] >= bmin[0] &&
+				amin[1] <= bmax[1] && amax[1] >= bmin[1] &&
+				amin[2] <= bmax[2] && amax[2] >= bmin[2]);
+	}
+
+	void calLeafBounds(rxBVHNode &nd) const
+	{
+		nd.minp = m_vMin[m_vIdx[nd.start]];
+		nd.maxp = m_vMax[m_vIdx[nd.start]];
+		for(int j = nd.start+1; j < nd.start+nd.num; ++j){
+			int s = m_vIdx[j];
+			for(int k = 0; k < 3; ++k){
+				nd.minp[k] = RX_MIN(nd.minp[k], m_vMin[s][k]);
+				nd.maxp[k] = RX_MAX(nd.maxp[k], m_vMax[s][k]);
+			}
+		}
+	}
+
+	//! SWkŔr(nth_elementp)
+	struct rxCenterLess
+	{
+		const vector<Vec3> *vmin, *vmax;
+		int axis;
+		bool operator()(int a, int b) const
+		{
+			return ((*vmin)[a][axis]+(*vmax)[a][axis]) < ((*vmin)[b][axis]+(*vmax)[b][axis]);
+		}
+	};
+
+	/*!
+	 * m_vIdx[start]`[end-1]̌ő̂m[h쐬
+	 * @return m[hԍ
+	 */
+	int buildNode(int start, int end)
+	{
+		int idx = (int)m_vNodes.size();
+		m_vNodes.push_back(rxBVHNode());
+
+		rxBVHNode nd;
+		nd.start = start;
+		nd.num = end-start;
+		nd.left = nd.right = -1;
+		calLeafBounds(nd);
+
+		if(nd.num > RX_BVH_LEAF_SIZE){
+			// ő̒S͈̔͂łLŕ
+			Vec3 cmin(RX_FEQ_INF), cmax(-RX_FEQ_INF);
+			for(int j = start; j < end; ++j){
+				Vec3 c = 0.5*(m_vMin[m_vIdx[j]]+m_vMax[m_vIdx[j]]);
+				for(int k = 0; k < 3; ++k){
+					cmin[k] = RX_MIN(cmin[k], c[k]);
+					cmax[k] = RX_MAX(cmax[k], c[k]);
+				}
+			}
+			Vec3 ext = cmax-cmin;
+			int axis = (ext[0] > ext[1] ? (ext[0] > ext[2] ? 0 : 2) : (ext[1] > ext[2] ? 1 : 2));
+
+			int mid = (start+end)/2;
+			rxCenterLess cmp;
+			cmp.vmin = &m_vMin;
+			cmp.vmax = &m_vMax;
+			cmp.axis = axis;
+			nth_element(m_vIdx.begin()+start, m_vIdx.begin()+mid, m_vIdx.begin()+end, cmp);
+
+			nd.num = 0;
+			nd.left = buildNode(start, mid);
+			nd.right = buildNode(mid, end);
+		}
+
+		m_vNodes[idx] = nd;
+		return idx;
+	}
+};
+
+
+
+#endif // #ifndef _RX_SOLID_BVH_H_
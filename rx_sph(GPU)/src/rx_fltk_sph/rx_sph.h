@@ -19,6 +19,7 @@
 #include "rx_nnsearch.h"	// ObhɂߖTT
 
 #include "rx_sph_solid.h"
+#include "rx_solid_bvh.h"	// ő̃IuWFNgBVH
 
 #include "rx_cu_common.cuh"
 
@@ -32,6 +33,7 @@
 #define GL_REAL GL_FLOAT
 
 // Ԍv
+//  - RXTIMERɂԂ̓vt@C(rx_profiler.h)LȂ炻ɂL^
 class rxTimerAvg;
 extern rxTimerAvg g_Time;
 
@@ -39,8 +41,8 @@ extern rxTimerAvg g_Time;
 
 #ifdef RX_USE_TIMER
 #define RXTIMER_CLEAR g_Time.ClearTime()
-#define RXTIMER_RESET g_Time.ResetTime()
-#define RXTIMER(x) g_Time.Split(x)
+#define RXTIMER_RESET (g_Time.ResetTime(), RXPROF_MARK)
+#define RXTIMER(x) (g_Time.Split(x), RXPROF_SPLIT(x))
 #define RXTIMER_PRINT g_Time.Print()
 #define RXTIMER_STRING(x) g_Time.PrintToString(x)
 #else
@@ -71,6 +73,8 @@ struct rxSPHEnviroment
 	int mesh_vertex_store;		//!< _|S\Ƃ̌W
 	int mesh_max_n;				//!< MC@pObh̍ő啪
 
+	int profile;				//!< vt@CŊe̎Ԃv(0 or 1, Iresult/profile_trace.json, profile.csvɏo)
+
 	rxSPHEnviroment()
 	{
 		max_particles = 50000;
@@ -84,6 +88,8 @@ struct rxSPHEnviroment
 		mesh_vertex_store = 10;
 		use_inlet = 0;
 		mesh_max_n = 128;
+
+		profile = 0;
 	}
 };
 
@@ -126,6 +132,15 @@ private:
 	// EEő
 	rxSolid *m_pBoundary;			//!< V~[VԂ̋E
 	vector<rxSolid*> m_vSolids;		//!< ő̕
+	rxSolidBVH m_SolidBVH;			//!< ő̂̕BVH
+	vector< vector<int> > m_vColBuf;	//!< ubNƂ(ő,p[eBN)̑g(calCollisionSolidp)
+	vector<int> m_vColStart;		//!< ő̂Ƃ̏Փˌp[eBN̊Jnʒu(CSR`)
+	vector<int> m_vColIdx;			//!< Փˌp[eBÑCfbNX
+	vector<RXREAL> m_vColPos;		//!< Փˌp[eBN̈ʒu
+	vector<RXREAL> m_vColPen;		//!< ő̃IuWFNgƂ̐N
+	vector<RXREAL> m_vColCp;		//!< ő̃IuWFNgƂ̏Փ˓_
+	vector<RXREAL> m_vColNrm;		//!< ő̃IuWFNg̏Փ˓_ł̖@
+	vector<int> m_vColNext;			//!< Zڂp[eBNɒׂő(-1Ȃ⃊Xgŏ)
 	RXREAL *m_hVrts;				//!< ő̃|S̒_
 	int m_iNumVrts;					//!< ő̃|S̒_
 	int *m_hTris;					//!< ő̃|S
@@ -133,7 +148,7 @@ private:
 
 	// ԕiq֘A
 	rxNNGrid *m_pNNGrid;			//!< ObhɂߖTT
-	vector< vector<rxNeigh> > m_vNeighs;	//!< ߖTp[eBN
+	rxNeighList m_vNeighs;			//!< ߖTp[eBN(CSR`)
 
 	// qp[^
 	uint m_iKernelParticles;		//!< J[l̃p[eBN
@@ -262,9 +277,15 @@ protected:
 	void integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *frc, 
 				   RXREAL *pos_new, RXREAL *vel_new, RXREAL dt);
 
+	// `FbN|Cg̓o
+	virtual bool writeCheckpoint(ofstream &fout);
+	virtual bool readCheckpoint(ifstream &fin);
+
 	// Փ˔
 	int calCollisionPolygon(uint grid_hash, Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt);
-	int calCollisionSolid(Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt);
+	int calCollisionSolid(RXREAL *pos, RXREAL *vel, RXREAL dt);
+	void calCollisionResponse(RXREAL *pos, RXREAL *vel, RXREAL pen, const RXREAL *cp, const RXREAL *nrm, RXREAL dt);
+	void calSolidCandidates(const RXREAL *pos, int n);
 };
 
 
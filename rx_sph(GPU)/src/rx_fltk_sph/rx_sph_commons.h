@@ -62,6 +62,7 @@
 #include "rx_matrix.h"
 
 #include "rx_timer.h"
+#include "rx_profiler.h"
 
 // CUDA
 #include "rx_cu_common.cuh"
@@ -205,6 +205,7 @@ public:
 			else if(names[i] == "inlet_boundary")	sph_env.use_inlet = atoi(values[i].c_str());
 			else if(names[i] == "dt")				sph_env.dt = atof(values[i].c_str());
 			else if(names[i] == "init_vertex_store")sph_env.mesh_vertex_store = atoi(values[i].c_str());
+			else if(names[i] == "profile")			sph_env.profile = atoi(values[i].c_str());
 		}
 		if(sph_env.mesh_vertex_store < 1) sph_env.mesh_vertex_store = 1;
 
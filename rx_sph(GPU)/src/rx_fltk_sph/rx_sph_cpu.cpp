@@ -16,6 +16,17 @@
 
 #include "rx_pcube.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//-----------------------------------------------------------------------------
+// 萔
+//-----------------------------------------------------------------------------
+//! ٕJ[lvZŋUšŗLl܂Ƃ߂čs
+const int RX_EIGEN_BATCH = 8;
+
 
 //-----------------------------------------------------------------------------
 // rxSPHNX̎
@@ -194,7 +205,7 @@ void rxSPH::Allocate(int max_particles)
 	m_hRMatrix = new RXREAL[m_uMaxParticles*9];
 	m_hG = new RXREAL[m_uMaxParticles*9];
 
-	m_vNeighs.resize(m_uMaxParticles);
+	m_vNeighs.Offset.reserve(m_uMaxParticles+1);
 
 	if(m_bUseOpenGL){
 		m_posVBO = createVBO(mem_size);	
@@ -205,7 +216,6 @@ void rxSPH::Allocate(int max_particles)
 
 	// Zݒ
 	m_pNNGrid->Setup(m_v3EnvMin, m_v3EnvMax, m_fEffectiveRadius, m_uMaxParticles);
-	m_vNeighs.resize(m_uMaxParticles);
 
 	m_bInitialized = true;
 }
@@ -237,7 +247,7 @@ void rxSPH::Finalize(void)
 	if(m_hRMatrix) delete [] m_hRMatrix;
 	if(m_hG) delete [] m_hG;
 
-	m_vNeighs.clear();
+	m_vNeighs.Release();
 
 	if(m_bUseOpenGL){
 		glDeleteBuffers(1, (const GLuint*)&m_posVBO);
@@ -245,7 +255,6 @@ void rxSPH::Finalize(void)
 	}
 
 	if(m_pNNGrid) delete m_pNNGrid;
-	m_vNeighs.clear();
 
 	if(m_hVrts) delete [] m_hVrts;
 	if(m_hTris) delete [] m_hTris;
@@ -271,6 +280,9 @@ void rxSPH::Finalize(void)
  */
 bool rxSPH::Update(RXREAL dt, int step)
 {
+	RXPROF_ZONE("update");
+	RXPROF_MARK;	// ȉRXTIMER̋Ԃupdate̋ԂɊ܂܂悤
+
 	// p[eBNǉ
 	if(!m_vInletLines.empty()){
 		int start = (m_iInletStart == -1 ? 0 : m_iInletStart);
@@ -439,6 +451,7 @@ void rxSPH::SetColorVBO(int type)
  */
 void rxSPH::calDensity(void)
 {
+	RXPROF_ZONE("density");
 	// MRK:calDensity
 	RXREAL r0 = m_fInitDens;
 	RXREAL h = m_fEffectiveRadius;
@@ -452,7 +465,7 @@ void rxSPH::calDensity(void)
 		m_hDens[i] = 0.0;
 
 		// ߖTq
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0) continue;
 
@@ -479,6 +492,7 @@ void rxSPH::calDensity(void)
  */
 void rxSPH::calForce(void)
 {
+	RXPROF_ZONE("force");
 	Vec3 rij, vji;
 	RXREAL h = m_fEffectiveRadius;
 	RXREAL r0 = m_fInitDens;
@@ -501,7 +515,7 @@ void rxSPH::calForce(void)
 		RXREAL prsi = m_hPres[i]/(m_hDens[i]*m_hDens[i]);
 
 		Vec3 pfrc(0.0), vfrc(0.0);
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0 || i == j) continue;
 
@@ -568,7 +582,7 @@ void rxSPH::calNormal(void)
 		Vec3 nrm(0.0);
 
 		// ߖTq
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0 || i == j) continue;
 
@@ -771,38 +785,227 @@ int rxSPH::calCollisionPolygon(uint grid_hash, Vec3 &pos0, Vec3 &pos1, Vec3 &vel
 
 /*!
  * ő̃IuWFNgƂ̏Փ˔CՓˉ
- * @param[in] pos0 OXebv̈ʒu
- * @param[inout] pos1 Vʒu
- * @param[inout] vel x
+ *  - ő̂ƂɏՓˌp[eBN̋l܂Ƃ߂ČvZ(GetDistanceRBatch)
+ *  - ő͓̂o^ɏ̂ŁCǑő̂œꂽʒuŎ̌ő̂𒲂ׂ
+ *  - Փ˂ŕʂ̃Zɉoꂽp[eBN͌⃊XggȂ̂ŁC
+ *    ȍ~̌ő̂BVHŒTȂ1ׂ
+ * @param[inout] pos p[eBNʒu
+ * @param[inout] vel p[eBNx
  * @param[in] dt ^CXebv
- * @return Փ˃IuWFNg̐
+ * @return Փ˂p[eBN
  */
-int rxSPH::calCollisionSolid(Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt)
+int rxSPH::calCollisionSolid(RXREAL *pos, RXREAL *vel, RXREAL dt)
 {
+	int n = (int)m_uNumParticles;
+	if(!n) return 0;
+
+	if((int)m_vColPen.size() < n){
+		m_vColPen.resize(n);
+		m_vColCp.resize(3*n);
+		m_vColNrm.resize(3*n);
+		m_vColPos.resize(3*n);
+	}
+	m_vColNext.assign(n, -1);
+	RXREAL *pen = &m_vColPen[0];
+	RXREAL *cp = &m_vColCp[0];
+	RXREAL *nrm = &m_vColNrm[0];
+	int *next = &m_vColNext[0];
+
 	int c = 0;
-	rxCollisionInfo coli;
+	int ns = (int)m_vSolids.size();
+	if(ns){
+		// ő̂ǉE폜ꂽBVH\zCłȂΌő̂̈ړɍ킹AABBXV
+		if(m_SolidBVH.GetSolids() != m_vSolids){
+			m_SolidBVH.Build(m_vSolids);
+		}
+		else{
+			m_SolidBVH.Refit();
+		}
 
-	// ő̃IuWFNgƂ̏Փˏ
-	for(vector<rxSolid*>::iterator i = m_vSolids.begin(); i != m_vSolids.end(); ++i){
-		if((*i)->GetDistanceR(pos1, m_fParticleRadius, coli)){
-			RXREAL res = m_fDamping;
-			res = (res > 0) ? (res*fabs(coli.Penetration())/(dt*norm(vel))) : 0.0f;
-			vel -= (1+res)*dot(vel, coli.Normal())*coli.Normal();
-			pos1 = coli.Contact();
+		// ő̂Ƃ̏Փˌp[eBN
+		calSolidCandidates(pos, n);
+
+		for(int s = 0; s < ns; ++s){
+			int start = m_vColStart[s];
+			int m = m_vColStart[s+1]-start;
+			if(!m) continue;
+
+			const int *idx = &m_vColIdx[start];
+			RXREAL *cpos = &m_vColPos[0];
+			#pragma omp parallel for
+			for(int j = 0; j < m; ++j){
+				for(int k = 0; k < 3; ++k) cpos[3*j+k] = pos[DIM*idx[j]+k];
+			}
+
+			m_vSolids[s]->GetDistanceRBatch(cpos, 3, m, m_fParticleRadius, pen, cp, nrm);
+
+			int cs = 0;
+			#pragma omp parallel for reduction(+:cs)
+			for(int j = 0; j < m; ++j){
+				int i = idx[j];
+				if(pen[j] <= 0 && next[i] < 0){
+					calCollisionResponse(pos+DIM*i, vel+DIM*i, pen[j], cp+3*j, nrm+3*j, dt);
+					cs++;
+
+					// ʂ̃Zɉoꂽ玟̌ő̂ʂɏ
+					Vec3 x0(cpos[3*j], cpos[3*j+1], cpos[3*j+2]), x1(pos[DIM*i], pos[DIM*i+1], pos[DIM*i+2]);
+					if(m_pNNGrid->CalGridHash(x1) != m_pNNGrid->CalGridHash(x0)){
+						next[i] = s+1;
+					}
+				}
+			}
+			c += cs;
+		}
+
+		// Zڂp[eBN̎čő̂Ƃ̏Փˏ
+		//  - pos(p[eBNa)AABBdȂő̂o^ɒׁCՓ˂邽тɒT
+		int cm = 0;
+		#pragma omp parallel for reduction(+:cm) schedule(dynamic, 64)
+		for(int i = 0; i < n; ++i){
+			if(next[i] < 0) continue;
+
+			RXREAL *p = pos+DIM*i;
+			vector<int> cand;
+			rxCollisionInfo coli;
+			int s0 = next[i];
+			while(s0 < ns){
+				Vec3 x(p[0], p[1], p[2]);
+				cand.clear();
+				m_SolidBVH.Query(x-Vec3(2.0*m_fParticleRadius), x+Vec3(2.0*m_fParticleRadius), cand);
+				sort(cand.begin(), cand.end());
+
+				int hit = -1;
+				for(int j = 0; j < (int)cand.size(); ++j){
+					if(cand[j] < s0) continue;
+					if(m_vSolids[cand[j]]->GetDistanceR(x, m_fParticleRadius, coli)){
+						RXREAL ccp[3], cn[3];
+						for(int k = 0; k < 3; ++k){
+							ccp[k] = (RXREAL)coli.Contact()[k];
+							cn[k] = (RXREAL)coli.Normal()[k];
+						}
+						calCollisionResponse(p, vel+DIM*i, (RXREAL)coli.Penetration(), ccp, cn, dt);
+						cm++;
+						hit = cand[j];
+						break;
+					}
+				}
+				if(hit < 0) break;
+				s0 = hit+1;
+			}
 		}
+		c += cm;
 	}
 
 	// V~[VԋEƂ̏Փˏ
-	if(m_pBoundary->GetDistanceR(pos1, m_fParticleRadius, coli)){
-		RXREAL res = m_fDamping;
-		res = (res > 0) ? (res*fabs(coli.Penetration())/(dt*norm(vel))) : 0.0f;
-		vel -= (1+res)*dot(vel, coli.Normal())*coli.Normal();
-		pos1 = coli.Contact();
+	m_pBoundary->GetDistanceRBatch(pos, DIM, n, m_fParticleRadius, pen, cp, nrm);
+	int cb = 0;
+	#pragma omp parallel for reduction(+:cb)
+	for(int j = 0; j < n; ++j){
+		if(pen[j] <= 0){
+			calCollisionResponse(pos+DIM*j, vel+DIM*j, pen[j], cp+3*j, nrm+3*j, dt);
+			cb++;
+		}
 	}
+	c += cb;
 
 	return c;
 }
 
+/*!
+ * ő̃IuWFNgƂ̏Փˉ
+ *  - @̑x𔽓](m_fDampingŐNʂɉĔ߂)CʒuՓ˓_Ɉڂ
+ * @param[inout] pos p[eBNʒu(3vf)
+ * @param[inout] vel p[eBNx(3vf)
+ * @param[in] pen N
+ * @param[in] cp Փ˓_
+ * @param[in] nrm Փ˓_ł̖@
+ * @param[in] dt ^CXebv
+ */
+void rxSPH::calCollisionResponse(RXREAL *pos, RXREAL *vel, RXREAL pen, const RXREAL *cp, const RXREAL *nrm, RXREAL dt)
+{
+	Vec3 v(vel[0], vel[1], vel[2]);
+	Vec3 n(nrm[0], nrm[1], nrm[2]);
+
+	RXREAL res = m_fDamping;
+	res = (res > 0) ? (res*fabs(pen)/(dt*norm(v))) : 0.0f;
+	v -= (1+res)*dot(v, n)*n;
+
+	for(int k = 0; k < 3; ++k){
+		pos[k] = cp[k];
+		vel[k] = v[k];
+	}
+}
+
+/*!
+ * ő̂Ƃ̏Փˌp[eBN̒T
+ *  - p[eBN܂ޕZAABB(+p[eBNa)BVHŏdȂő̂T
+ *  - Z̃p[eBNԂ͒Tʂg
+ *  - ʂ͌ő̂ƂCSR`(m_vColStart, m_vColIdx)
+ * @param[in] pos p[eBNʒu
+ * @param[in] n p[eBN
+ */
+void rxSPH::calSolidCandidates(const RXREAL *pos, int n)
+{
+	int ns = m_SolidBVH.GetNumSolids();
+
+	// ubN(Xbh̐{ɂĕׂ𕪎U)
+	int nb = 4*omp_get_max_threads();
+	if(nb > n) nb = n;
+	if((int)m_vColBuf.size() < nb) m_vColBuf.resize(nb);
+
+	RXREAL margin = 2.0*m_fParticleRadius;
+
+	// ubNƂ(ő,p[eBN)̑g
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int b = 0; b < nb; ++b){
+		int start = (int)(((long long)n*b)/nb);
+		int end   = (int)(((long long)n*(b+1))/nb);
+
+		vector<int> &buf = m_vColBuf[b];
+		buf.clear();
+
+		vector<int> cand;
+		uint prev = (uint)-1;
+		for(int i = start; i < end; ++i){
+			Vec3 x(pos[DIM*i+0], pos[DIM*i+1], pos[DIM*i+2]);
+			uint grid_hash = m_pNNGrid->CalGridHash(x);
+			if(grid_hash != prev){
+				Vec3 minp, maxp;
+				m_pNNGrid->CalCellBounds(grid_hash, minp, maxp);
+				cand.clear();
+				m_SolidBVH.Query(minp-Vec3(margin), maxp+Vec3(margin), cand);
+				prev = grid_hash;
+			}
+			for(int j = 0; j < (int)cand.size(); ++j){
+				buf.push_back(cand[j]);
+				buf.push_back(i);
+			}
+		}
+	}
+
+	// ő̂Ƃ̌␔̗ݐϘa
+	m_vColStart.assign(ns+1, 0);
+	for(int b = 0; b < nb; ++b){
+		const vector<int> &buf = m_vColBuf[b];
+		for(int j = 0; j < (int)buf.size(); j += 2){
+			m_vColStart[buf[j]+1]++;
+		}
+	}
+	for(int s = 0; s < ns; ++s){
+		m_vColStart[s+1] += m_vColStart[s];
+	}
+
+	// p[eBÑCfbNXő̂ƂɊi[
+	m_vColIdx.resize(m_vColStart[ns]);
+	vector<int> cur(m_vColStart.begin(), m_vColStart.end()-1);
+	for(int b = 0; b < nb; ++b){
+		const vector<int> &buf = m_vColBuf[b];
+		for(int j = 0; j < (int)buf.size(); j += 2){
+			m_vColIdx[cur[buf[j]]++] = buf[j+1];
+		}
+	}
+}
+
 /*!
  * ʒuEx̍XV
  * @param[in] pos p[eBNʒu
@@ -815,7 +1018,10 @@ int rxSPH::calCollisionSolid(Vec3 &pos0, Vec3 &pos1, Vec3 &vel, RXREAL dt)
 void rxSPH::integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *frc, 
 					  RXREAL *pos_new, RXREAL *vel_new, RXREAL dt)
 {
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	RXPROF_ZONE("integrate/collision");
+
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 x, x_old, v, f, v_old;
 		for(int k = 0; k < 3; ++k){
 			x[k] = pos[DIM*i+k];
@@ -839,16 +1045,78 @@ void rxSPH::integrate(const RXREAL *pos, const RXREAL *vel, const RXREAL *frc,
 			}
 		}
 
-		// EƂ̏Փ˔
-		calCollisionSolid(x_old, x, v, dt);
-
 		// VxƈʒuōXV
 		for(int k = 0; k < 3; ++k){
 			pos_new[DIM*i+k] = x[k];
 			vel_new[DIM*i+k] = v[k];
 		}
+	}
 
+	// ő̃IuWFNgCEƂ̏Փ˔
+	calCollisionSolid(pos_new, vel_new, dt);
+}
+
+/*!
+ * `FbN|Cgւ̃\oԂ̏o
+ *  - xĆC͖͂XebvʒuvZ邪CĊJ̕`(F)̂߂ɕۑĂ
+ *  - Q͈ʒuExEpo(`̓V[t@CĐݒ肳)
+ * @param[in] fout o̓t@CXg[
+ */
+bool rxSPH::writeCheckpoint(ofstream &fout)
+{
+	size_t n = m_uNumParticles;
+	WriteBinaryArray(fout, m_hFrc, DIM*n);
+	WriteBinaryArray(fout, m_hDens, n);
+	WriteBinaryArray(fout, m_hPres, n);
+
+	// ő̏Q
+	WriteBinary(fout, (uint)m_vSolids.size());
+	for(int i = 0; i < (int)m_vSolids.size(); ++i){
+		rxSolid *s = m_vSolids[i];
+		rxMatrix4 rot = s->GetMatrix();
+		double mat[16];
+		for(int j = 0; j < 16; ++j) mat[j] = rot(j%4, j/4);	// SetMatrix(double[16])Ɠ
+		WriteBinaryArray(fout, s->GetPosition().data, 3);
+		WriteBinaryArray(fout, s->GetVelocity().data, 3);
+		WriteBinaryArray(fout, mat, 16);
+		WriteBinary(fout, (int)(s->GetFix() ? 1 : 0));
 	}
+
+	return (bool)fout;
+}
+
+/*!
+ * `FbN|Cg̃\oԂ̓ǂݍ
+ *  - Q݂̐͌̃V[ƈvĂKv
+ * @param[in] fin ̓t@CXg[
+ */
+bool rxSPH::readCheckpoint(ifstream &fin)
+{
+	size_t n = m_uNumParticles;
+	ReadBinaryArray(fin, m_hFrc, DIM*n);
+	ReadBinaryArray(fin, m_hDens, n);
+	ReadBinaryArray(fin, m_hPres, n);
+
+	// ő̏Q
+	uint ns = ReadBinary<uint>(fin);
+	if(ns != (uint)m_vSolids.size()){
+		RXCOUT << "the number of obstacles (" << ns << ") is different from the current scene (" << m_vSolids.size() << ")." << endl;
+		return false;
+	}
+	for(int i = 0; i < (int)ns; ++i){
+		rxSolid *s = m_vSolids[i];
+		Vec3 pos, vel;
+		double mat[16];
+		ReadBinaryArray(fin, pos.data, 3);
+		ReadBinaryArray(fin, vel.data, 3);
+		ReadBinaryArray(fin, mat, 16);
+		s->SetPosition(pos);
+		s->SetVelocity(vel);
+		s->SetMatrix(mat);
+		s->SetFix(ReadBinary<int>(fin) != 0);
+	}
+
+	return (bool)fin;
 }
 
 
@@ -876,7 +1144,7 @@ void rxSPH::DetectSurfaceParticles(void)
 
 	for(uint i = 0; i < m_uNumParticles; ++i){
 		double d = CalDistToNormalizedMassCenter(i);
-		int nn_num = (int)m_vNeighs[i].size();
+		int nn_num = m_vNeighs.Num(i);
 
 		// fobOp
 		//m_hTmp[i] = (RXREAL)d;
@@ -914,7 +1182,7 @@ double rxSPH::CalDistToNormalizedMassCenter(const int i)
 
 	Vec3 pos0 = Vec3(m_hPos[DIM*i+0], m_hPos[DIM*i+1], m_hPos[DIM*i+2]);
 
-	for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+	for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 		int j = itr->Idx;
 		if(j < 0 && i == j) continue;
 
@@ -1016,7 +1284,7 @@ void rxSPH::CalNormal(void)
 		Vec3 nrm(0.0);
 
 		// ߖTq
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0 || i == j) continue;
 
@@ -1054,7 +1322,7 @@ void rxSPH::CalNormalFromDensity(void)
 		Vec3 nrm(0.0);
 
 		// ߖTq
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0 || i == j) continue;
 
@@ -1127,15 +1395,15 @@ void rxSPH::GetNearestNeighbors(Vec3 pos, vector<rxNeigh> &neighs, RXREAL h)
  */
 void rxSPH::SetParticlesToCell(RXREAL *prts, int n, RXREAL h)
 {
+	RXPROF_ZONE("neighbor search");
+	RXPROF_COUNT("neighbor builds", 1);
+
 	// Zɗqo^
 	m_pNNGrid->SetObjectToCell(prts, n);
 
 	// ߖTqT
 	if(h < 0.0) h = m_fEffectiveRadius;
-	for(int i = 0; i < (int)m_uNumParticles; i++){
-		m_vNeighs[i].clear();
-		GetNearestNeighbors(i, prts, m_vNeighs[i], h);
-	}
+	m_pNNGrid->GetNNList(prts, m_uNumParticles, m_vNeighs, h);
 }
 void rxSPH::SetParticlesToCell(void)
 {
@@ -1402,6 +1670,10 @@ double rxSPH::GetImplicit(double x, double y, double z)
 
 /*!
  * p[eBNObh̉A֐lvZ
+ *  - ep[eBNeãObh_ɃJ[llZ(XvbeBO)
+ *  - p[eBNe͈͂z[̃ObhwŃ\[gĂCz̃XuƂɕɉZ
+ *    (XuԂŏݐ悪dȂȂ̂atomic͕svCZXbhɂȂ)
+ *  - vZʂ̓Obh_ł͂Ȃp[eBNɔႷ(p[eBNȂ̈0Ŗ߂邾)
  * @param[in] n Obh
  * @param[in] minp Obh̍ŏW
  * @param[in] d Obh
@@ -1409,15 +1681,106 @@ double rxSPH::GetImplicit(double x, double y, double z)
  */
 void rxSPH::CalImplicitField(int n[3], Vec3 minp, Vec3 d, RXREAL *hF)
 {
+	RXPROF_ZONE("implicit field");
 	int slice0 = n[0];
 	int slice1 = n[0]*n[1];
+	int np = (int)m_uNumParticles;
+	RXREAL h = m_fEffectiveRadius;
+	RXREAL h2 = h*h;
+
+	// ep[eBN̉e͈͂Ɋ܂܂Obh_̃CfbNX͈(͈͊Õp[eBNk0=-1)
+	vector<int> range(6*np);
+	#pragma omp parallel for
+	for(int p = 0; p < np; ++p){
+		int *r = &range[6*p];
+		r[4] = -1;
+		for(int l = 0; l < 3; ++l){
+			double x = m_hPos[DIM*p+l]-minp[l];
+			r[2*l]   = RX_MAX((int)ceil((x-h)/d[l]), 0);
+			r[2*l+1] = RX_MIN((int)floor((x+h)/d[l]), n[l]-1);
+			if(r[2*l] > r[2*l+1]){
+				r[4] = -1;
+				break;
+			}
+		}
+	}
+
+	// z[̃ObhwƂɃp[eBNU蕪(counting sort)
+	vector<int> start(n[2]+1, 0);
+	int kspan = 0;
+	for(int p = 0; p < np; ++p){
+		const int *r = &range[6*p];
+		if(r[4] < 0) continue;
+		start[r[4]+1]++;
+		if(r[5]-r[4] > kspan) kspan = r[5]-r[4];
+	}
+	for(int k = 0; k < n[2]; ++k) start[k+1] += start[k];
+	vector<int> sorted(start[n[2]]);
+	vector<int> cnt(start.begin(), start.end()-1);
+	for(int p = 0; p < np; ++p){
+		if(range[6*p+4] >= 0) sorted[cnt[range[6*p+4]]++] = p;
+	}
 
-	for(int k = 0; k < n[2]; ++k){
-		for(int j = 0; j < n[1]; ++j){
-			for(int i = 0; i < n[0]; ++i){
-				int idx = k*slice1+j*slice0+i;
-				Vec3 pos = minp+Vec3(i, j, k)*d;
-				hF[idx] = GetImplicit(pos[0], pos[1], pos[2]);
+	// E̊ÕObh_0(CalColorFieldƓ)
+	int vmin[3], vmax[3];
+	for(int l = 0; l < 3; ++l){
+		vmin[l] = RX_MAX((int)ceil((m_v3EnvMin[l]-minp[l])/d[l]), 0);
+		vmax[l] = RX_MIN((int)floor((m_v3EnvMax[l]-minp[l])/d[l]), n[l]-1);
+	}
+
+	// z̃XuƂɃJ[llZ
+	int nthreads = 1;
+#ifdef _OPENMP
+	nthreads = omp_get_max_threads();
+#endif
+	int ns = RX_MAX(RX_MIN(4*nthreads, n[2]), 1);
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int s = 0; s < ns; ++s){
+		int z0 = (int)((long long)n[2]*s/ns);
+		int z1 = (int)((long long)n[2]*(s+1)/ns);
+		if(z0 >= z1) continue;
+
+		memset(hF+z0*slice1, 0, (z1-z0)*slice1*sizeof(RXREAL));
+
+		for(int k0 = RX_MAX(z0-kspan, 0); k0 < z1; ++k0){
+			for(int m = start[k0]; m < start[k0+1]; ++m){
+				int p = sorted[m];
+				const int *r = &range[6*p];
+				int ks = RX_MAX(r[4], z0), ke = RX_MIN(r[5], z1-1);
+				if(ks > ke) continue;
+
+				Vec3 pos(m_hPos[DIM*p+0], m_hPos[DIM*p+1], m_hPos[DIM*p+2]);
+				for(int k = ks; k <= ke; ++k){
+					double dz = minp[2]+k*d[2]-pos[2];
+					double dz2 = dz*dz;
+					for(int j = r[2]; j <= r[3]; ++j){
+						double dy = minp[1]+j*d[1]-pos[1];
+						double dyz2 = dy*dy+dz2;
+						if(dyz2 > h2) continue;
+
+						RXREAL *f = hF+k*slice1+j*slice0;
+						for(int i = r[0]; i <= r[1]; ++i){
+							double dx = minp[0]+i*d[0]-pos[0];
+							double r2 = dx*dx+dyz2;
+							if(r2 > h2) continue;
+							RXREAL q = h2-r2;
+							f[i] += m_fMass*m_fWpoly6*q*q*q;
+						}
+					}
+				}
+			}
+		}
+
+		for(int k = z0; k < z1; ++k){
+			bool kout = (k < vmin[2] || k > vmax[2]);
+			for(int j = 0; j < n[1]; ++j){
+				RXREAL *f = hF+k*slice1+j*slice0;
+				if(kout || j < vmin[1] || j > vmax[1]){
+					memset(f, 0, n[0]*sizeof(RXREAL));
+					continue;
+				}
+				for(int i = 0; i < vmin[0]; ++i) f[i] = 0;
+				for(int i = vmax[0]+1; i < n[0]; ++i) f[i] = 0;
 			}
 		}
 	}
@@ -1723,12 +2086,73 @@ void RxSVDecomp3(float w[3], float u[9], float v[9], float eps)
 	}
 }
 
+/*!
+ * Ώ3x3šŗLl(Rr@,XC[v񐔌Œ)
+ *  - N̍sSoA`ł܂Ƃ߂ď
+ *  - ɂ镪򂪂Ȃ̂ŁCs(l)̃[v̓RpCɂxNg
+ *  - 3x3̑Ώ̍sȂ5XC[vxfloatx܂Ŏ
+ * @param[inout] a Ώ̍s(a[3*r+c][l] : lԖڂ̍srsc)DvZ̑ΊpvfŗLl
+ * @param[out] v ŗLxNg(v[3*r+c][l] : cڂΊpvfa[4*c][l]ɑΉŗLxNg)
+ * @param[in] sweeps XC[v
+ */
+template<int N>
+inline void RxJacobiEigen3Batch(float a[9][N], float v[9][N], int sweeps = 5)
+{
+	for(int k = 0; k < 9; ++k){
+		for(int l = 0; l < N; ++l){
+			v[k][l] = (k%4 == 0 ? 1.0f : 0.0f);
+		}
+	}
+
+	static const int P[3] = {0, 0, 1};
+	static const int Q[3] = {1, 2, 2};
+	for(int sw = 0; sw < sweeps; ++sw){
+		for(int m = 0; m < 3; ++m){
+			int p = P[m], q = Q[m], r = 3-p-q;
+			for(int l = 0; l < N; ++l){
+				float apq = a[3*p+q][l];
+				float app = a[3*p+p][l];
+				float aqq = a[3*q+q][l];
+
+				// apq0ɂ](apq0ɋ߂Ƃt0ɋ߂ÂŔUȂ)
+				float d = 2.0f*apq;
+				d = (fabs(d) > 1.0e-30f ? d : 1.0e-30f);
+				float theta = (aqq-app)/d;
+				float t = 1.0f/(fabs(theta)+sqrt(theta*theta+1.0f));
+				t = (theta >= 0.0f ? t : -t);
+				float c = 1.0f/sqrt(t*t+1.0f);
+				float s = t*c;
+
+				a[3*p+p][l] = app-t*apq;
+				a[3*q+q][l] = aqq+t*apq;
+				a[3*p+q][l] = a[3*q+p][l] = 0.0f;
+
+				float arp = a[3*r+p][l];
+				float arq = a[3*r+q][l];
+				a[3*r+p][l] = a[3*p+r][l] = c*arp-s*arq;
+				a[3*r+q][l] = a[3*q+r][l] = s*arp+c*arq;
+
+				for(int k = 0; k < 3; ++k){
+					float vkp = v[3*k+p][l];
+					float vkq = v[3*k+q][l];
+					v[3*k+p][l] = c*vkp-s*vkq;
+					v[3*k+q][l] = s*vkp+c*vkq;
+				}
+			}
+		}
+	}
+}
+
 /*!
  * Anisotropic kerneľvZ
  *  - J. Yu and G. Turk, Reconstructing Surfaces of Particle-Based Fluids Using Anisotropic Kernels, SCA2010. 
+ *  - ߖTT͌̈ʒu1񂾂sCʒuł̋UvZɂߖTXgg
+ *    (ɂړʂ͋ߖTԂłقړȂ̂ŁCߖT̓ւ͏d݂ق0̉e͈͂̒[łNȂ)
+ *  - UšŗLlRX_EIGEN_BATCH܂Ƃ߂ăRr@ōs
  */
 void rxSPH::CalAnisotropicKernel(void)
 {
+	RXPROF_ZONE("anisotropic kernel");
 	// MARK:CalAnisotropicKernel
 	if(m_uNumParticles == 0) return;
 
@@ -1743,7 +2167,8 @@ void rxSPH::CalAnisotropicKernel(void)
 	RXREAL lambda = 0.9;
 
 	// XVʒǔvZ
-	for(uint i = 0; i < m_uNumParticles; ++i){
+	#pragma omp parallel for
+	for(int i = 0; i < (int)m_uNumParticles; ++i){
 		Vec3 pos0;
 		pos0[0] = m_hPos[4*i+0];
 		pos0[1] = m_hPos[4*i+1];
@@ -1752,7 +2177,7 @@ void rxSPH::CalAnisotropicKernel(void)
 		// ߖTq
 		Vec3 posw(0.0);
 		RXREAL sumw = 0.0f;
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
+		for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
 			int j = itr->Idx;
 			if(j < 0) continue;
 
@@ -1779,177 +2204,154 @@ void rxSPH::CalAnisotropicKernel(void)
 		m_hUpPos[DIM*i+0] = (1-lambda)*m_hPos[DIM*i+0]+lambda*m_hPosW[DIM*i+0];
 		m_hUpPos[DIM*i+1] = (1-lambda)*m_hPos[DIM*i+1]+lambda*m_hPosW[DIM*i+1];
 		m_hUpPos[DIM*i+2] = (1-lambda)*m_hPos[DIM*i+2]+lambda*m_hPosW[DIM*i+2];
-
-		//m_hUpPos[DIM*i+0] = m_hPos[DIM*i+0];
-		//m_hUpPos[DIM*i+1] = m_hPos[DIM*i+1];
-		//m_hUpPos[DIM*i+2] = m_hPos[DIM*i+2];
 	}
 
-	SetParticlesToCell(m_hUpPos, m_uNumParticles, h);
-
-	// covariance matrix̌vZ
-	for(uint i = 0; i < m_uNumParticles; ++i){
-		Vec3 xi;
-		xi[0] = m_hUpPos[4*i+0];
-		xi[1] = m_hUpPos[4*i+1];
-		xi[2] = m_hUpPos[4*i+2];
-
-		Vec3 xiw(0.0);
-		RXREAL sumw = 0.0f;
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
-			int j = itr->Idx;
-			if(j < 0) continue;
-
-			Vec3 xj;
-			xj[0] = m_hUpPos[4*j+0];
-			xj[1] = m_hUpPos[4*j+1];
-			xj[2] = m_hUpPos[4*j+2];
-
-			RXREAL r = sqrt(itr->Dist2);
-			
-			if(r < h){
-				RXREAL q = 1-r/h;
-				RXREAL wij = q*q*q;
-				xiw += xj*wij;
-				sumw += wij;
+	// covariance matrix̌vZƌŗLl
+	int nb = (m_uNumParticles+RX_EIGEN_BATCH-1)/RX_EIGEN_BATCH;
+	#pragma omp parallel for schedule(dynamic, 16)
+	for(int b = 0; b < nb; ++b){
+		int start = b*RX_EIGEN_BATCH;
+		int num = RX_MIN((int)m_uNumParticles-start, RX_EIGEN_BATCH);
+
+		float c[9][RX_EIGEN_BATCH], u[9][RX_EIGEN_BATCH];
+		int nn[RX_EIGEN_BATCH];
+
+		for(int l = 0; l < RX_EIGEN_BATCH; ++l){
+			// 󂫃[͒PʍsŖ߂
+			if(l >= num){
+				for(int k = 0; k < 9; ++k) c[k][l] = (k%4 == 0 ? 1.0f : 0.0f);
+				nn[l] = 0;
+				continue;
 			}
-		}
-
-		xiw /= sumw;
-
-		matrix3x3 c;
-		for(int k = 0; k < 3; ++k){
-			c.e[k].x = 0.0;
-			c.e[k].y = 0.0;
-			c.e[k].z = 0.0;
-		}
-
-		int n = 0;
-		sumw = 0.0f;
-		for(vector<rxNeigh>::iterator itr = m_vNeighs[i].begin() ; itr != m_vNeighs[i].end(); ++itr){
-			int j = itr->Idx;
-			if(j < 0) continue;
-
-			Vec3 xj;
-			xj[0] = m_hUpPos[4*j+0];
-			xj[1] = m_hUpPos[4*j+1];
-			xj[2] = m_hUpPos[4*j+2];
-
-			RXREAL r = sqrt(itr->Dist2);
-
-			if(r < h){
-				RXREAL q = 1-r/h;
-				RXREAL wij = q*q*q;
-
-				Vec3 dxj = xj-xiw;
 
-				for(int k = 0; k < 3; ++k){
-					c.e[k].x += wij*dxj[k]*dxj[0];
-					c.e[k].y += wij*dxj[k]*dxj[1];
-					c.e[k].z += wij*dxj[k]*dxj[2];
+			int i = start+l;
+			Vec3 xi;
+			xi[0] = m_hUpPos[4*i+0];
+			xi[1] = m_hUpPos[4*i+1];
+			xi[2] = m_hUpPos[4*i+2];
+
+			// dݕtςƋU1̑ŌvZ
+			//  - xȋΈʒud w d d^T/w - m m^T (m = w d/w) Ƃ
+			RXREAL sumw = 0.0f;
+			RXREAL m[3] = {0.0f, 0.0f, 0.0f};
+			RXREAL s[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+			int n = 0;
+			for(rxNeigh *itr = m_vNeighs.Begin(i); itr != m_vNeighs.End(i); ++itr){
+				int j = itr->Idx;
+				if(j < 0) continue;
+
+				RXREAL dx = m_hUpPos[4*j+0]-xi[0];
+				RXREAL dy = m_hUpPos[4*j+1]-xi[1];
+				RXREAL dz = m_hUpPos[4*j+2]-xi[2];
+				RXREAL r = sqrt(dx*dx+dy*dy+dz*dz);
+
+				if(r < h){
+					RXREAL q = 1-r/h;
+					RXREAL wij = q*q*q;
+
+					m[0] += wij*dx; m[1] += wij*dy; m[2] += wij*dz;
+					s[0] += wij*dx*dx; s[1] += wij*dx*dy; s[2] += wij*dx*dz;
+					s[3] += wij*dy*dy; s[4] += wij*dy*dz; s[5] += wij*dz*dz;
+					sumw += wij;
+
+					n++;
 				}
-
-				sumw += wij;
-
-				n++;
 			}
-		}
 
-		for(int k = 0; k < 3; ++k){
-			c.e[k].x /= sumw;
-			c.e[k].y /= sumw;
-			c.e[k].z /= sumw;
+			for(int k = 0; k < 3; ++k) m[k] /= sumw;
+			c[0][l] = s[0]/sumw-m[0]*m[0];
+			c[1][l] = c[3][l] = s[1]/sumw-m[0]*m[1];
+			c[2][l] = c[6][l] = s[2]/sumw-m[0]*m[2];
+			c[4][l] = s[3]/sumw-m[1]*m[1];
+			c[5][l] = c[7][l] = s[4]/sumw-m[1]*m[2];
+			c[8][l] = s[5]/sumw-m[2]*m[2];
+			nn[l] = n;
 		}
 
-		// ْl
-		float w[3], u[9], v[9];
-		for(int k = 0; k < 3; ++k){
-			u[k*3+0] = c.e[k].x;
-			u[k*3+1] = c.e[k].y;
-			u[k*3+2] = c.e[k].z;
-		}
+		// ŗLl(ŗLl͑ΊpvfCŗLxNgůe)
+		RxJacobiEigen3Batch<RX_EIGEN_BATCH>(c, u);
 
-		RxSVDecomp3(w, u, v, 1.0e-10);
-		
-		// ŗLl
-		Vec3 sigma;
-		for(int j = 0; j < 3; ++j){
-			sigma[j] = w[j];
-		}
+		for(int l = 0; l < num; ++l){
+			int i = start+l;
 
-		// ŗLxNg(]sR)
-		rxMatrix3 R;
-		for(int j = 0; j < 3; ++j){
-			for(int k = 0; k < 3; ++k){
-				R(k, j) = u[k*3+j];
+			// ŗLl(ْlƓΒl̍~ɕׂ)
+			int idx[3] = {0, 1, 2};
+			Vec3 sigma;
+			for(int j = 0; j < 3; ++j){
+				sigma[j] = fabs(c[4*j][l]);
 			}
-		}
+			if(sigma[idx[0]] < sigma[idx[1]]) RX_SWAP(idx[0], idx[1]);
+			if(sigma[idx[1]] < sigma[idx[2]]) RX_SWAP(idx[1], idx[2]);
+			if(sigma[idx[0]] < sigma[idx[1]]) RX_SWAP(idx[0], idx[1]);
+			sigma = Vec3(sigma[idx[0]], sigma[idx[1]], sigma[idx[2]]);
 
-		// fobOpɒlҔ
-		for(int j = 0; j < 3; ++j){
-			m_hEigen[3*i+j] = sigma[j];
-		}
-		for(int j = 0; j < 3; ++j){
-			for(int k = 0; k < 3; ++k){
-				m_hRMatrix[9*i+3*j+k] = R(j, k);
+			// ŗLxNg(]sR)
+			rxMatrix3 R;
+			for(int j = 0; j < 3; ++j){
+				for(int k = 0; k < 3; ++k){
+					R(k, j) = u[3*k+idx[j]][l];
+				}
 			}
-		}
 
-		
-		int ne = 10;//m_params.KernelParticles*0.8;
-		RXREAL ks = 1400;
-		RXREAL kn = 0.5;
-		RXREAL kr = 4.0;
-		if(n > ne){
-			for(int j = 1; j < 3; ++j){
-				sigma[j] = RX_MAX(sigma[j], sigma[0]/kr);
+			// fobOpɒlҔ
+			for(int j = 0; j < 3; ++j){
+				m_hEigen[3*i+j] = sigma[j];
 			}
-			sigma *= ks;
-		}
-		else{
 			for(int j = 0; j < 3; ++j){
-				sigma[j] = kn*1.0;
+				for(int k = 0; k < 3; ++k){
+					m_hRMatrix[9*i+3*j+k] = R(j, k);
+				}
 			}
-		}
-
 
-		// J[lό`sG
-		rxMatrix3 G;
-		for(int j = 0; j < 3; ++j){
-			for(int k = 0; k < 3; ++k){
-				RXREAL x = 0;
-				for(int l = 0; l < 3; ++l){
-					//x += m_hRMatrix[9*i+3*j+l]*m_hRMatrix[9*i+3*k+l]/m_hEigen[3*i+l];
-					x += R(j, l)*R(k, l)/sigma[l];
+			int ne = 10;//m_params.KernelParticles*0.8;
+			RXREAL ks = 1400;
+			RXREAL kn = 0.5;
+			RXREAL kr = 4.0;
+			if(nn[l] > ne){
+				for(int j = 1; j < 3; ++j){
+					sigma[j] = RX_MAX(sigma[j], sigma[0]/kr);
+				}
+				sigma *= ks;
+			}
+			else{
+				for(int j = 0; j < 3; ++j){
+					sigma[j] = kn*1.0;
 				}
-				
-				G(j, k) = x;
-				//m_hG[9*i+3*j+k] = x;
 			}
-		}
 
-		double max_diag = -1.0e10;
-		for(int j = 0; j < 3; ++j){
-			for(int k = 0; k < 3; ++k){
-				if(G(j, k) > max_diag) max_diag = G(j, k);
+			// J[lό`sG
+			rxMatrix3 G;
+			for(int j = 0; j < 3; ++j){
+				for(int k = 0; k < 3; ++k){
+					RXREAL x = 0;
+					for(int o = 0; o < 3; ++o){
+						x += R(j, o)*R(k, o)/sigma[o];
+					}
+					G(j, k) = x;
+				}
 			}
-		}
 
-		for(int j = 0; j < 3; ++j){
-			for(int k = 0; k < 3; ++k){
-				G(j, k) /= max_diag;
+			double max_diag = -1.0e10;
+			for(int j = 0; j < 3; ++j){
+				for(int k = 0; k < 3; ++k){
+					if(G(j, k) > max_diag) max_diag = G(j, k);
+				}
 			}
-		}
-				
-		G = G.Inverse();
 
+			for(int j = 0; j < 3; ++j){
+				for(int k = 0; k < 3; ++k){
+					G(j, k) /= max_diag;
+				}
+			}
+					
+			G = G.Inverse();
 
-		for(int j = 0; j < 3; ++j){
-			for(int k = 0; k < 3; ++k){
-				m_hG[9*i+3*j+k] = G(j, k);
+			for(int j = 0; j < 3; ++j){
+				for(int k = 0; k < 3; ++k){
+					m_hG[9*i+3*j+k] = G(j, k);
+				}
 			}
 		}
-
 	}
 }
 
@@ -431,6 +431,8 @@ void rxSPH_GPU::UpdateParams(void)
  */
 bool rxSPH_GPU::Update(RXREAL dt, int step)
 {
+	RXPROF_ZONE("update");	// J[l͔񓯊ɎŝŁC܂ޏȊO̓zXg̎ԂɂȂ
+	RXPROF_MARK;
 	//RXTIMER_RESET;
 
 	// p[eBNǉ
@@ -102,6 +102,40 @@ bool AABB_point_dist(const Vec3 &spos, const double &r, const int &sgn,
 }
 
 
+//-----------------------------------------------------------------------------
+// MARK:rxSolidNX̎
+//-----------------------------------------------------------------------------
+/*!
+ * _ł̋lvZ(e_͕ɌvZ)
+ *  - hNXŋȂǂgĂ܂Ƃ߂ČvZłꍇ̓I[o[Ch
+ * @param[in] pos vZʒu(stridevf)
+ * @param[in] stride 1_̗vf
+ * @param[in] n _
+ * @param[in] r ̔a
+ * @param[out] pen N(0ȉŏՓ,Փ˂ĂȂ_RX_FEQ_INF)
+ * @param[out] cp Փ˓_(3nvf,Փ˂ĂȂ_͌̈ʒu)
+ * @param[out] nrm Փ˓_ł̖@(3nvf,0ȂvZȂ)
+ */
+void rxSolid::GetDistanceRBatch(const RXREAL *pos, int stride, int n, RXREAL r, RXREAL *pen, RXREAL *cp, RXREAL *nrm)
+{
+	#pragma omp parallel for
+	for(int i = 0; i < n; ++i){
+		const RXREAL *p = pos+stride*i;
+		rxCollisionInfo col;
+		if(GetDistanceR(Vec3(p[0], p[1], p[2]), r, col)){
+			pen[i] = (RXREAL)col.Penetration();
+			for(int k = 0; k < 3; ++k) cp[3*i+k] = (RXREAL)col.Contact()[k];
+			if(nrm) for(int k = 0; k < 3; ++k) nrm[3*i+k] = (RXREAL)col.Normal()[k];
+		}
+		else{
+			pen[i] = (RXREAL)RX_FEQ_INF;
+			for(int k = 0; k < 3; ++k) cp[3*i+k] = p[k];
+			if(nrm) for(int k = 0; k < 3; ++k) nrm[3*i+k] = 0;
+		}
+	}
+}
+
+
 //-----------------------------------------------------------------------------
 // MARK:rxSolidBoxNX̎
 //-----------------------------------------------------------------------------
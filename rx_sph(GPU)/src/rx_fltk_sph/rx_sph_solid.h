@@ -112,6 +112,8 @@ public:
 	virtual Vec3 GetMin(void) = 0;
 	virtual Vec3 GetMax(void) = 0;
 
+	virtual void GetDistanceRBatch(const RXREAL *pos, int stride, int n, RXREAL r, RXREAL *pen, RXREAL *cp, RXREAL *nrm = 0);	//!< _ł̋֐vZ
+
 
 	//
 	// 擾Eݒ֐
@@ -128,6 +130,7 @@ public:
 
 	inline Vec3 GetVelocityAtGrobal(const Vec3 &pos);	//!< ̍Wľő̑x̎擾
 	inline void SetVelocity(const Vec3 &vec);			//!< 
+	inline Vec3 GetVelocity(void) const { return m_vVelocity; }	//!< ő̑x̎擾
 
 	inline bool GetFix(void) const { return m_bFix; }		//!< ŒtO̎擾
 	inline void SetFix(bool fix){ m_bFix = fix; }			//!< ŒtO̐ݒ